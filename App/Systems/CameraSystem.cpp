@@ -28,7 +28,7 @@ namespace nv
         auto entityHandle = CreateEntity(RES_ID_NULL, RES_ID_NULL, pDebugName);
         auto cameraEntity = gEntityManager.GetEntity(entityHandle);
         auto comp = cameraEntity->Add<CameraComponent>();
-        cameraEntity->GetTransform().mPosition = { 0, 0, -15 };
+        cameraEntity->GetTransformMut().mPosition = { 0, 0, -15 };
         comp->mCamera.SetParams(CameraDesc{ .mWidth = (float)graphics::gWindow->GetWidth(), .mHeight = (float)gWindow->GetHeight() });
         comp->mCamera.UpdateViewProjection();
         return entityHandle;
@@ -50,7 +50,7 @@ namespace nv
         float speedMultiplier = 3.f;
         float mouseSpeed = 0.005f;
 
-        auto transform = gEntityManager.GetEntity(cameraEntity)->GetTransform();
+        auto transform = gEntityManager.GetEntity(cameraEntity)->GetTransformMut();
         Camera& camera = component->mCamera;
         camera.SetPreviousViewProjection();
 
@@ -119,8 +119,8 @@ namespace nv
         auto transform = player->GetTransform();
         
         Entity* camera = gEntityManager.GetEntity(camHandle);
-        auto camTransform = camera->GetTransform();
-        auto& camComponent = camera->Get<CameraComponent>()->mCamera;
+        auto camTransform = camera->GetTransformMut();
+        auto& camComponent = camera->GetMut<CameraComponent>()->mCamera;
         camComponent.SetPreviousViewProjection();
         camTransform.mPosition.x = transform.mPosition.x + 3;
         camTransform.mPosition.y = transform.mPosition.z + 1;
@@ -140,7 +140,7 @@ namespace nv
         if (isDebugUIEnabled)
         {
             graphics::SetActiveCamera(mEditorCamera);
-            auto comp = gEntityManager.GetEntity(mEditorCamera)->Get<CameraComponent>();
+            auto comp = gEntityManager.GetEntity(mEditorCamera)->GetMut<CameraComponent>();
             EditorCameraUpdate(deltaTime, comp, mEditorCamera, mPrevPos);
             mPrevPos = { (float)input::GetInputState().mMouse.GetLastState().x,  (float)input::GetInputState().mMouse.GetLastState().y };
         }
@@ -154,5 +154,11 @@ namespace nv
     void CameraSystem::Destroy()
     {
     }
+
+    void CameraSystem::DeclareAccess(SystemAccess& access) const
+    {
+        // Moves the editor camera and follows the player
+        access.Write<Position, Rotation, Scale, CameraComponent>();
+    }
 }
 
@@ -10,6 +10,7 @@
 #include <Engine/Component.h>
 #include <Engine/EventSystem.h>
 #include <Engine/JobSystem.h>
+#include <Engine/Query.h>
 
 
 #include <Input/Input.h>
@@ -19,8 +20,12 @@
 #include <DebugUI/DebugUIPass.h>
 #include "EntityCommon.h"
 #include <Math/Collision.h>
+#include <Memory/Allocator.h>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
 
 namespace nv
 {
@@ -34,12 +39,19 @@ namespace nv
     FrameRecordState mFrameRecordState = FRAME_RECORD_STOPPED;
     ecs::Entity* entity;
 
+    // Serialized pools are charged to the FrameRecord budget
+    using FrameString = std::basic_string<char, std::char_traits<char>, TaggedStlAllocator<char>>;
+    using FrameOutStream = std::basic_ostringstream<char, std::char_traits<char>, TaggedStlAllocator<char>>;
+    using FrameInStream = std::basic_istringstream<char, std::char_traits<char>, TaggedStlAllocator<char>>;
+
     struct FrameData
     {
-        std::stringstream mStream;
+        // Pools written since the previous push, PopFrame looks further down the stack for the others
+        std::vector<std::pair<StringID, FrameString>> mPools;
     };
 
     std::vector<FrameData> gFrameStack;
+    std::unordered_map<StringID, uint32_t> gPushedVersions;  // Pool version when it was last pushed
 
     void PushFrame();
     bool PopFrame();
@@ -71,16 +83,16 @@ namespace nv
 
         entity = gEntityManager.GetEntity(playerEntity);
 
-        auto pos = entity->Get<Position>();
+        auto pos = entity->GetMut<Position>();
         pos->mPosition.x += 1.f;
 
         auto transform = entity->GetTransform();
-        gEntityManager.GetEntity(entity1)->GetTransform().mPosition.x -= 1;
-        gEntityManager.GetEntity(entity1)->GetTransform().mPosition.z += 1;
-        gEntityManager.GetEntity(floor)->GetTransform().mPosition.y = -1;
+        gEntityManager.GetEntity(entity1)->GetTransformMut().mPosition.x -= 1;
+        gEntityManager.GetEntity(entity1)->GetTransformMut().mPosition.z += 1;
+        gEntityManager.GetEntity(floor)->GetTransformMut().mPosition.y = -1;
 
         constexpr float floorScale = 10.f;
-        gEntityManager.GetEntity(floor)->GetTransform().mScale = nv::float3(floorScale, floorScale, floorScale);
+        gEntityManager.GetEntity(floor)->GetTransformMut().mScale = nv::float3(floorScale, floorScale, floorScale);
     }
 
     void TestJob(void* data)
@@ -91,29 +103,44 @@ namespace nv
 
     Handle<jobs::Job> sJobHandle = Null<jobs::Job>();
 
+    static void TransformBounds(math::BoundingBox& bounds, const graphics::components::Renderable& renderable, const Transform& transform)
+    {
+        auto pMesh = graphics::gResourceManager->GetMesh(renderable.mMesh);
+        if(!pMesh->HasBones())
+            pMesh->GetBoundingBox().mBounding.Transform(bounds.mBounding, math::Load(transform.GetTransformMatrix()));
+        else
+        {
+            bounds.mBounding.Center = transform.mPosition;
+        }
+    }
+
     void DriverSystem::Update(float deltaTime, float totalTime)
     {
         using namespace input;
 
-        gEntityManager.ForEachEntity([](Entity* entity)
+        // Create bounding box for entities that have renderable component
+        // if they don't have one. They're placed right away, the transform
+        // may be older than what the bounds pass below looks at.
+        const uint32_t version = GetComponentVersion();
+        const ComponentPool<Position>* pPositions = gComponentManager.GetPool<Position>();
+        const ComponentPool<Rotation>* pRotations = gComponentManager.GetPool<Rotation>();
+        const ComponentPool<Scale>* pScales = gComponentManager.GetPool<Scale>();
+        Query<const graphics::components::Renderable, Without<math::BoundingBox>>().ForEach([&](Handle<Entity> handle, const graphics::components::Renderable& renderable)
         {
-            using namespace graphics;
-            using namespace graphics::components;
+            if (renderable.mMesh.IsNull())
+                return;
 
-            // Create bounding box for entities that have renderable component
-            // if they don't have one
-            if(entity->Has<Renderable>() && !entity->Has<BoundingBox>())
+            auto pMesh = graphics::gResourceManager->GetMesh(renderable.mMesh);
+            if (pMesh)
             {
-                auto renderable = entity->Get<Renderable>();
-                if (renderable->mMesh.IsNull())
-                    return;
-
-                auto pMesh = gResourceManager->GetMesh(renderable->mMesh);
-                if (pMesh)
-                {
-                    auto pBox = entity->Add<math::BoundingBox>();
-                    *pBox = pMesh->GetBoundingBox();
-                }
+                auto pBox = gEntityManager.GetEntity(handle)->Add<math::BoundingBox>();
+                *pBox = pMesh->GetBoundingBox();
+
+                const Position* pPosition = pPositions ? pPositions->Find(handle) : nullptr;
+                const Rotation* pRotation = pRotations ? pRotations->Find(handle) : nullptr;
+                const Scale* pScale = pScales ? pScales->Find(handle) : nullptr;
+                if (pPosition && pRotation && pScale)
+                    TransformBounds(*pBox, renderable, { pPosition->mPosition, pRotation->mRotation, pScale->mScale });
             }
         });
 
@@ -124,30 +151,21 @@ namespace nv
 
         if (sJobHandle.IsNull())
         {
-            sJobHandle = jobs::Execute(TestJob);
+            sJobHandle = jobs::Execute(TestJob, jobs::JobPriority::LongRunning);
         }
 
-        auto pPool = gComponentManager.GetPool<math::BoundingBox>();
-        EntityComponents<math::BoundingBox> comps;
-        pPool->GetEntityComponents(comps);
-        
-        for (uint32_t i = 0; i < comps.Size(); ++i)
+        // Only the entities that moved since the last update
+        Query<math::BoundingBox, const graphics::components::Renderable, const Position, const Rotation, const Scale,
+            Changed<Position, Rotation, Scale>> boundsQuery(mBoundsVersion);
+        mBoundsVersion = version;
+        boundsQuery.ForEach([](math::BoundingBox& bounds, const graphics::components::Renderable& renderable, const Position& position, const Rotation& rotation, const Scale& scale)
         {
-            auto pEntity = comps[i].mpEntity;
-            auto transform = pEntity->GetTransform();
-            auto meshHandle = pEntity->Get<graphics::components::Renderable>()->mMesh;
-            auto pMesh = graphics::gResourceManager->GetMesh(meshHandle);
-            if(!pMesh->HasBones())
-                pMesh->GetBoundingBox().mBounding.Transform(comps[i].mpComponent->mBounding, math::Load(transform.GetTransformMatrix()));
-            else
-            {
-                comps[i].mpComponent->mBounding.Center = transform.mPosition;
-            }
-        }
+            TransformBounds(bounds, renderable, { position.mPosition, rotation.mRotation, scale.mScale });
+        });
 
         if (mFrameRecordState != FRAME_RECORD_REWINDING)
         {
-            auto transform = entity->GetTransform();
+            auto transform = entity->GetTransformMut();
             transform.mPosition.y = sin(totalTime * 2.f);
         }
 
@@ -206,11 +224,21 @@ namespace nv
 
     void PushFrame()
     {
+        // The bottom frame has every pool, the ones above only what changed
+        const bool bFirst = gFrameStack.empty();
         FrameData& frame = gFrameStack.emplace_back();
         const auto& componentPools = gComponentManager.GetAllPools();
-        for (auto& pool : componentPools)
+        for (auto& [compId, pool] : componentPools)
         {
-            pool.second->SerializeForFrame(frame.mStream);
+            const uint32_t version = pool->GetVersion();
+            auto it = gPushedVersions.find(compId);
+            if (!bFirst && it != gPushedVersions.end() && it->second == version)
+                continue;
+
+            FrameOutStream stream(std::ios_base::out, TaggedStlAllocator<char>(kMemBudgetFrameRecord));
+            pool->SerializeForFrame(stream);
+            frame.mPools.emplace_back(compId, std::move(stream).str());
+            gPushedVersions[compId] = version;
         }
     }
 
@@ -219,18 +247,36 @@ namespace nv
         if (gFrameStack.empty())
             return false;
 
-        FrameData& frame = gFrameStack.back();
         const auto& componentPools = gComponentManager.GetAllPools();
-        for (auto& pool : componentPools)
+        for (auto& [compId, pool] : componentPools)
         {
-            pool.second->DeserializeForFrame(frame.mStream);
+            // Newest copy at or below the popped frame, none if the pool came after all of them
+            for (auto frame = gFrameStack.rbegin(); frame != gFrameStack.rend(); ++frame)
+            {
+                auto it = std::find_if(frame->mPools.begin(), frame->mPools.end(), [compId](const auto& data) { return data.first == compId; });
+                if (it != frame->mPools.end())
+                {
+                    FrameInStream stream(it->second);
+                    pool->DeserializeForFrame(stream);
+                    break;
+                }
+            }
         }
 
         gFrameStack.pop_back();
+
+        // Restoring wrote every pool, the next push stores them all again
+        gPushedVersions.clear();
         return true;
     }
 
     void DriverSystem::Destroy()
     {
     }
+
+    void DriverSystem::DeclareAccess(SystemAccess& access) const
+    {
+        // Adds bounding boxes directly and records or rewinds every pool
+        access.Exclusive();
+    }
 }
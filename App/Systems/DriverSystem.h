@@ -12,6 +12,8 @@ namespace nv
         void Init() override;
         void Update(float deltaTime, float totalTime) override;
         void Destroy() override;
+        void DeclareAccess(SystemAccess& access) const override;
     private:
+        uint32_t mBoundsVersion = 0;    // Component version of the last bounds update
     };
 }
@@ -8,6 +8,7 @@
 #include <Math/Collision.h>
 #include <Engine/Transform.h>
 #include <Engine/Instance.h>
+#include <Engine/Query.h>
 
 namespace nv
 {
@@ -66,24 +67,23 @@ namespace nv
 
     void FramePreSystem::Update(float deltaTime, float totalTime)
     {
-        auto positions = ecs::gComponentManager.GetComponents<Position>();
-        auto scales = ecs::gComponentManager.GetComponents<Scale>();
-        auto rotations = ecs::gComponentManager.GetComponents<Rotation>();
-        auto prevTransforms = ecs::gComponentManager.GetComponents<PrevTransform>();
-
-        for (size_t i = 0; i < positions.Size(); ++i)
+        // The others still hold what they were copied from
+        const uint32_t version = ecs::GetComponentVersion();
+        ecs::Query<const Position, const Rotation, const Scale, PrevTransform, ecs::Changed<Position, Rotation, Scale>> query(mVersion);
+        mVersion = version;
+        query.ForEach([](const Position& pos, const Rotation& rotation, const Scale& scale, PrevTransform& prevTransform)
         {
-            auto pos = &positions[i];
-            auto scale = &scales[i];
-            auto rotation = &rotations[i];
-
-            PrevTransform prevTransform = { pos->mPosition, rotation->mRotation, scale->mScale };
-            prevTransforms[i] = prevTransform;
-        }
+            prevTransform = { pos.mPosition, rotation.mRotation, scale.mScale };
+        });
     }
 
     void FramePreSystem::Destroy()
     {
     }
 
+    void FramePreSystem::DeclareAccess(SystemAccess& access) const
+    {
+        access.Read<Position, Rotation, Scale>().Write<PrevTransform>();
+    }
+
 }
@@ -32,6 +32,8 @@ namespace nv
         void Init() override;
         void Update(float deltaTime, float totalTime) override;
         void Destroy() override;
+        void DeclareAccess(SystemAccess& access) const override;
     private:
+        uint32_t mVersion = 0;  // Component version of the last copy
     };
 }
\ No newline at end of file
@@ -41,7 +41,6 @@ namespace nv
     };
 
     Handle<Entity> gpPlayerEntity = Null<Entity>();
-    PlayerComponent* gpPlayerComponent = nullptr;
     FrameRecordState gFrameState = FRAME_RECORD_STOPPED;
 
     constexpr float DegToRags(float x)
@@ -59,15 +58,15 @@ namespace nv
         mPlayerEntity = CreateEntity(ID("Mesh/male.fbx"), ID("Male"), "Player");
         gpPlayerEntity = mPlayerEntity;
         auto playerEntity = gEntityManager.GetEntity(mPlayerEntity);
-        gpPlayerComponent = playerEntity->Add<PlayerComponent>();
-        auto transform = playerEntity->GetTransform();
+        playerEntity->Add<PlayerComponent>();
+        auto transform = playerEntity->GetTransformMut();
         transform.mScale = float3(0.01f, 0.01f, 0.01f);
 
         auto rotation = XMQuaternionRotationAxis(XMVectorSet(0, 1, 0, 0), DegToRags(270));
         math::Store(rotation, transform.mRotation);
 
-        playerEntity->Get<AnimationComponent>()->mCurrentAnimationIndex = 1;
-        playerEntity->Get<AnimationComponent>()->mIsPlaying = true;
+        playerEntity->GetMut<AnimationComponent>()->mCurrentAnimationIndex = 1;
+        playerEntity->GetMut<AnimationComponent>()->mIsPlaying = true;
         gEventBus.Subscribe(this, &PlayerController::OnFrameRecordStateChange);
     }
 
@@ -96,11 +95,12 @@ namespace nv
         auto epsilon = VectorSet(FLT_EPSILON, FLT_EPSILON, FLT_EPSILON, FLT_EPSILON);
 
         Entity* entity = gEntityManager.GetEntity(mPlayerEntity);
-        auto anim = entity->Get<AnimationComponent>();
+        auto anim = entity->GetMut<AnimationComponent>();
+        auto player = entity->GetMut<PlayerComponent>();   // Not kept, writes through a stored pointer are invisible to the frame recorder
 
-        auto transform = entity->GetTransform();
-        const float speed = gpPlayerComponent->mSpeed;
-        auto velocity = Load(gpPlayerComponent->mVelocity);
+        auto transform = entity->GetTransformMut();
+        const float speed = player->mSpeed;
+        auto velocity = Load(player->mVelocity);
         auto maxVelocity = VectorSet(speed, speed * JUMP_MULTIPLIER, speed, speed);
         auto currentPos = Load(transform.mPosition);
 
@@ -112,7 +112,7 @@ namespace nv
         // TODO: Use Velocity instead of manipulating speed directly. 
         // Apply terms to velocity and then position = position + velocity * time;
         PlayerState state = PLAYER_STATE_IDLE;
-        PlayerState prevState = gpPlayerComponent->mPlayerState;
+        PlayerState prevState = player->mPlayerState;
 
         if (IsKeyDown(Keys::Space) && AreNearEqual(transform.mPosition.y, 0.f))
         {
@@ -140,7 +140,7 @@ namespace nv
         currentPos = currentPos + velocity * deltaTime;
 
         Store(currentPos, transform.mPosition);
-        Store(velocity, gpPlayerComponent->mVelocity);
+        Store(velocity, player->mVelocity);
 
         float lDot = XMVectorGetX(Vector3Dot(velocity, left));
         float rDot = XMVectorGetX(Vector3Dot(velocity, right));
@@ -156,14 +156,14 @@ namespace nv
             state = PLAYER_STATE_JUMP;
         }
 
-        gpPlayerComponent->mPlayerState = state;
+        player->mPlayerState = state;
 
         anim->mAnimationSpeed = 1.f;
-        switch (gpPlayerComponent->mPlayerState)
+        switch (player->mPlayerState)
         {
         case PLAYER_STATE_IDLE:
             anim->mCurrentAnimationIndex = 1;
-            gpPlayerComponent->mVelocity.y = 0.f;
+            player->mVelocity.y = 0.f;
             break;
         case PLAYER_STATE_JUMP:
             anim->mAnimationSpeed = 0.8f;
@@ -173,7 +173,7 @@ namespace nv
             break;
         case PLAYER_STATE_RUNNING:
             anim->mCurrentAnimationIndex = 3;
-            gpPlayerComponent->mVelocity.y = 0.f;
+            player->mVelocity.y = 0.f;
             break;
         }
 
@@ -181,6 +181,11 @@ namespace nv
             anim->mTotalTime = 0.f;
     }
 
+    void PlayerController::DeclareAccess(SystemAccess& access) const
+    {
+        access.Write<Position, Rotation, Scale, AnimationComponent, PlayerComponent>();
+    }
+
     void PlayerController::Destroy()
     {
     }
@@ -17,6 +17,7 @@ namespace nv
         void Init() override;
         void Update(float deltaTime, float totalTime) override;
         void Destroy() override;
+        void DeclareAccess(SystemAccess& access) const override;
 
         void OnFrameRecordStateChange(FrameRecordEvent* pEvent);
 
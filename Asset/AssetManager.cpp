@@ -10,8 +10,11 @@
 #include <Lib/ConcurrentQueue.h>
 
 #include <Engine/JobSystem.h>
+#include <Engine/Task.h>
 #include <Engine/Log.h>
 #include <Engine/EventSystem.h>
+#include <Memory/Memory.h>
+#include <Memory/LargePageAllocator.h>
 
 #include <IO/Utility.h>
 #include <IO/File.h>
@@ -22,6 +25,7 @@
 #include <Types/Serializers.h>
 #include <Types/ConfigAsset.h>
 
+#include <condition_variable>
 #include <fstream>
 #include <filesystem>
 #include <mutex>
@@ -60,6 +64,18 @@ namespace nv::asset
         return ASSET_INVALID;
     }
 
+    // Asset buffers count against the Assets budget until they go back through the untyped Free.
+    // Big ones (packages, textures, meshes) get large pages, the rest still comes from the system heap.
+    static Byte* AllocAssetBuffer(size_t size)
+    {
+        return (Byte*)AllocTagged(kMemBudgetAssets, LargePageAllocator::gPtr, size);
+    }
+
+    static void FreeAssetBuffer(void* pBuffer)
+    {
+        Free(pBuffer, LargePageAllocator::gPtr);
+    }
+
     std::string GetNormalizedBuildPath(const std::string& path)
     {
         const char* replaceEmpty = "";
@@ -92,14 +108,14 @@ namespace nv::asset
                 // Update the asset
                 if (asset)
                 {
-                    Free(asset->GetData());
+                    FreeAssetBuffer(asset->GetData());
                     asset->SetBuffer(nullptr, 0);
 
                     std::ostringstream sstream;
                     cereal::BinaryOutputArchive archive(sstream);
                     archive(StringDB::Get());
                     auto data = sstream.str();
-                    auto pBuffer = (Byte*)Alloc(data.size());
+                    auto pBuffer = AllocAssetBuffer(data.size());
                     memcpy(pBuffer, data.c_str(), data.size());
                     asset->SetData({ data.size(), pBuffer });
                     asset->SetState(STATE_LOADED);
@@ -123,7 +139,7 @@ namespace nv::asset
             archive(StringDB::Get());
 
             auto data = sstream.str();
-            auto pBuffer = (Byte*)Alloc(data.size());
+            auto pBuffer = AllocAssetBuffer(data.size());
             memcpy(pBuffer, data.c_str(), data.size());
             asset->SetData({ data.size(), pBuffer });
             asset->SetState(STATE_LOADED);
@@ -285,7 +301,7 @@ namespace nv::asset
                 return true;
 
             size_t size = io::GetFileSize(path);
-            Byte* pBuffer = (Byte*)Alloc(size);
+            Byte* pBuffer = AllocAssetBuffer(size);
 
             asset->SetState(STATE_LOADING);
             AssetData data = { size, pBuffer };
@@ -301,6 +317,52 @@ namespace nv::asset
             return LoadAssetFromFile(asset, path.c_str());
         }
 
+        void ReadAsset(Asset* asset, AssetID id, const char* path)
+        {
+            size_t size = io::GetFileSize(path);
+            Byte* pBuffer = AllocAssetBuffer(size);
+
+            asset->SetState(STATE_LOADING);
+            AssetData data = { size, pBuffer };
+            bool result = io::ReadFile(path, data.mData, (uint32_t)size);
+            asset->Set(id, data);
+            asset->SetState(result ? STATE_LOADED : STATE_ERROR);
+            if (result)
+                log::Info("[Asset] Load {}: OK", path);
+            else
+                log::Error("[Asset] Load {}: ERROR", path);
+        }
+
+        // Hands the read's callbacks, and those of callers that found it in flight, to the main thread
+        void FinishLoad(Asset* asset, AssetID id, AssetLoadCallback callback)
+        {
+            std::vector<AssetLoadCallback> waiting;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                auto it = mWaitingCallbacks.find(id.mId);
+                if (it != mWaitingCallbacks.end())
+                {
+                    waiting = std::move(it->second);
+                    mWaitingCallbacks.erase(it);
+                }
+            }
+            mLoadCondVar.notify_all();
+
+            if (callback)
+                mCallbacks.Push({ std::move(callback), asset });
+            for (auto& waitingCallback : waiting)
+                mCallbacks.Push({ std::move(waitingCallback), asset });
+        }
+
+        // Everything the read needs lives in the coroutine frame, path is copied
+        // since the path map can rehash while the read is queued.
+        Task<> ReadAssetAsync(Asset* asset, AssetID id, std::string path, AssetLoadCallback callback)
+        {
+            co_await jobs::Schedule(jobs::JobPriority::LongRunning);
+            ReadAsset(asset, id, path.c_str());
+            FinishLoad(asset, id, std::move(callback));
+        }
+
         virtual Handle<Asset> LoadAsset(AssetID id, AssetLoadCallback callback, bool wait) override
         {
 #if NV_ASSET_DEBUG_LOADER
@@ -311,32 +373,29 @@ namespace nv::asset
                 if(!asset)
                     return Null<Asset>();
 
-                if (asset->GetState() != STATE_LOADED && asset->GetState() != STATE_ERROR)
+                // Only the first caller reads, the others chain their callback to it or wait for it
+                std::unique_lock<std::mutex> lock(mMutex);
+                const LoadState state = asset->GetState();
+                if (state == STATE_LOADING)
                 {
-                    const auto& path = mAssetPathMap[id.mId];
-                    size_t size = io::GetFileSize(path.c_str());
-                    Byte* pBuffer = (Byte*)Alloc(size);
-
-                    auto loadAsset = [&](void* ctx)
-                    {
-                        asset->SetState(STATE_LOADING);
-                        AssetData data = { size, pBuffer };
-                        bool result = io::ReadFile(path.c_str(), data.mData, (uint32_t)size);
-                        asset->Set(id, data);
-                        asset->SetState(result ? STATE_LOADED : STATE_ERROR);
-                        if (result)
-                            log::Info("[Asset] Load {}: OK", path.c_str());
-                        else
-                            log::Error("[Asset] Load {}: ERROR", path.c_str());
-
-                        if (callback)
-                            mCallbacks.Push({ callback, asset });
-                    };
+                    if (callback)
+                        mWaitingCallbacks[id.mId].push_back(std::move(callback));
+                    if (wait)
+                        mLoadCondVar.wait(lock, [asset]() { return asset->GetState() != STATE_LOADING; });
+                }
+                else if (state != STATE_LOADED && state != STATE_ERROR)
+                {
+                    asset->SetState(STATE_LOADING);
+                    std::string path = mAssetPathMap[id.mId];
+                    lock.unlock();
 
                     if (wait)
-                        loadAsset(nullptr);
+                    {
+                        ReadAsset(asset, id, path.c_str());
+                        FinishLoad(asset, id, std::move(callback));
+                    }
                     else
-                        jobs::Execute(loadAsset);
+                        ReadAssetAsync(asset, id, std::move(path), std::move(callback)).Detach();
                 }
 
                 return it->second;
@@ -352,7 +411,7 @@ namespace nv::asset
             {
                 if (pAsset->GetState() == STATE_LOADED)
                 {
-                    Free(pAsset->GetData());
+                    FreeAssetBuffer(pAsset->GetData());
                     pAsset->SetData({ 0, nullptr });
                     pAsset->SetState(STATE_UNLOADED);
                     return;
@@ -551,7 +610,7 @@ namespace nv::asset
                 }
 
                 writeCacheFile(cacheEntries);
-            }, &result);
+            }, jobs::JobPriority::LongRunning, &result);
 
             return handle;
         }
@@ -559,7 +618,7 @@ namespace nv::asset
         void DeallocateAsset(Asset* asset)
         {
             if (asset)
-                Free(asset->GetData());
+                FreeAssetBuffer(asset->GetData());
 
             asset->SetBuffer(nullptr, 0);
         }
@@ -575,11 +634,9 @@ namespace nv::asset
 
         virtual void Tick() override
         {
-            while (!mCallbacks.IsEmpty())
-            {
-                auto callback = mCallbacks.Pop();
+            CallbackData callback;
+            while (mCallbacks.TryPop(callback))
                 callback.mCallback(callback.mAsset);
-            }
         }
 
         virtual void Reload(const char* file) override
@@ -598,14 +655,14 @@ namespace nv::asset
             if(assetType == ASSET_SHADER)
             {
                 size_t size = io::GetFileSize(file);
-                Byte* pBuffer = (Byte*)Alloc(size);
+                Byte* pBuffer = AllocAssetBuffer(size);
                 AssetData data = { size, pBuffer };
                 bool result = io::ReadFile(file, data.mData, (uint32_t)size);
 
                 std::ostringstream sstream;
                 ShaderAsset shader;
                 shader.Export(data, path.data(), sstream);
-                Free(pBuffer);
+                FreeAssetBuffer(pBuffer);
 
                 auto buffer = sstream.str();
                 if (buffer.empty())
@@ -614,7 +671,7 @@ namespace nv::asset
                     return;
                 }
 
-                pBuffer = (Byte*)Alloc(buffer.size());
+                pBuffer = AllocAssetBuffer(buffer.size());
                 memcpy(pBuffer, buffer.c_str(), buffer.size());
                 data = { buffer.size(), pBuffer };
 
@@ -738,7 +795,7 @@ namespace nv::asset
            
             if (header.mSizeBytes != 0)
             {
-                void* pBuffer = Alloc(header.mSizeBytes);
+                void* pBuffer = AllocAssetBuffer(header.mSizeBytes);
                 //istream.seekg(header.mSizeBytes, std::ios::cur);
                 istream.read((char*)pBuffer, header.mSizeBytes); // TODO: Seek forward mSizeBytes and store istream.tellg() offset in a map
                 header.mOffset = istream.tellg();
@@ -760,6 +817,8 @@ namespace nv::asset
         HashMap<uint64_t, std::string>      mAssetPathMap;
 #endif
         std::mutex                          mMutex;
+        std::condition_variable             mLoadCondVar;       // Signaled when a load finishes, waiters hold mMutex
+        HashMap<uint64_t, std::vector<AssetLoadCallback>> mWaitingCallbacks; // Callers that found the asset loading, by id
         std::vector<std::string>            mPackageFiles;
         ConcurrentQueue<CallbackData>       mCallbacks;
     };
@@ -781,6 +840,16 @@ namespace nv::asset
         return gpAssetManager;
     }
 
+    Task<Asset*> LoadAsset(AssetID id)
+    {
+        co_await jobs::Schedule(jobs::JobPriority::LongRunning);
+        gpAssetManager->LoadAsset(id, nullptr, true);
+        Asset* asset = gpAssetManager->GetAsset(id);
+
+        co_await jobs::Schedule();
+        co_return asset && asset->GetState() == STATE_LOADED ? asset : nullptr;
+    }
+
     class AssetPackage
     {
     public:
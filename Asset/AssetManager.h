@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Lib/Handle.h>
+#include <Engine/Task.h>
 #include <functional>
 
 namespace nv::jobs
@@ -44,4 +45,8 @@ namespace nv::asset
     void            InitAssetManager(const char* assetPath);
     void            DestroyAssetManager();
     IAssetManager*  GetAssetManager();
+
+    // Reads the asset on the long running lane and resumes the awaiting task on a worker.
+    // Null if the id is unknown or the read failed.
+    Task<Asset*>    LoadAsset(AssetID id);
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "Context.h"
 #include "Memory/Memory.h"
 #include "Memory/Allocator.h"
+#include "Memory/FrameAllocator.h"
+#include "Memory/LargePageAllocator.h"
 #include <Engine/System.h>
 #include <Engine/JobSystem.h>
 #include <Asset.h>
@@ -19,7 +21,10 @@ namespace nv
 
     void InitContext(Instance* pInstance, const char* pDataPath, Context* pContext)
     {
+        InitSystemAllocator(NV_USE_TLSF_ALLOCATOR ? SystemAllocatorBackend::Tlsf : SystemAllocatorBackend::Malloc, NV_TLSF_POOL_SIZE);
         InitMemoryTracker();
+        InitMemoryBudgets();
+        LargePageAllocator::gPtr->SetDesc({ .mMode = NV_USE_EXPLICIT_LARGE_PAGES ? platform::LargePageMode::Explicit : platform::LargePageMode::Transparent });
         pContext->mpMemTracker = GetMemoryTracker();
         pContext->mpInstance = pInstance;
         pContext->mpSystemManager = &gSystemManager;
@@ -44,6 +49,7 @@ namespace nv
         MemTracker::gPtr = nullptr;
         pContext->mpInstance = nullptr;
         jobs::DestroyJobSystem();
+        FrameAllocator::gPtr->Destroy(); // No workers left to allocate from it
         asset::DestroyAssetManager();
     }
 
@@ -4,6 +4,9 @@ namespace nv
 {
     constexpr uint32_t  NV_JOB_WORKER_THREAD_COUNT = 4;
     constexpr char      NV_DATA_PATH[] = "\\Build";
+    constexpr bool      NV_USE_TLSF_ALLOCATOR = false; // Route global new/delete through a TlsfAllocator
+    constexpr size_t    NV_TLSF_POOL_SIZE = 64 * 1024 * 1024;
+    constexpr bool      NV_USE_EXPLICIT_LARGE_PAGES = false; // Locked large pages for big buffers instead of transparent ones, needs OS setup
 
     class MemTracker;
     class SystemAllocator;
@@ -0,0 +1,308 @@
+#include "pch.h"
+
+#include <Engine/Archetype.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <mutex>
+
+namespace nv::ecs
+{
+    namespace
+    {
+        struct ComponentTypeRegistry
+        {
+            std::mutex              mMutex;
+            std::atomic<uint32_t>   mCount = 0;
+            ComponentTypeInfo       mTypes[kMaxArchetypeComponents];
+        };
+
+        ComponentTypeRegistry& GetRegistry()
+        {
+            static ComponentTypeRegistry sRegistry;
+            return sRegistry;
+        }
+
+        constexpr size_t AlignUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+    }
+
+    uint32_t RegisterComponentType(const ComponentTypeInfo& info)
+    {
+        ComponentTypeRegistry& registry = GetRegistry();
+        std::scoped_lock lock(registry.mMutex);
+
+        // Same type registered from another module
+        const uint32_t count = registry.mCount.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (registry.mTypes[i].mId == info.mId)
+                return i;
+        }
+
+        assert(count < kMaxArchetypeComponents);
+        assert(info.mAlignment <= kArchetypeColumnAlignment);
+        registry.mTypes[count] = info;
+        registry.mCount.store(count + 1, std::memory_order_release);
+        return count;
+    }
+
+    const ComponentTypeInfo& GetComponentTypeInfo(uint32_t typeIndex)
+    {
+        ComponentTypeRegistry& registry = GetRegistry();
+        assert(typeIndex < registry.mCount.load(std::memory_order_acquire));
+        return registry.mTypes[typeIndex];
+    }
+
+    Archetype::Archetype(ComponentMask mask) :
+        mMask(mask)
+    {
+        size_t rowSize = sizeof(Handle<Entity>);
+        for (ComponentMask bits = mask; bits; bits &= bits - 1)
+        {
+            const uint32_t typeIndex = (uint32_t)std::countr_zero(bits);
+            mTypes.push_back(typeIndex);
+            rowSize += GetComponentTypeInfo(typeIndex).mSize;
+        }
+
+        // Each column may lose up to a cache line to alignment
+        const size_t padding = kArchetypeColumnAlignment * (mTypes.size() + 1);
+        mChunkCapacity = (uint32_t)((kArchetypeChunkSize - padding) / rowSize);
+        assert(mChunkCapacity > 0); // Components too big for a chunk
+
+        size_t offset = AlignUp(mChunkCapacity * sizeof(Handle<Entity>), kArchetypeColumnAlignment);
+        for (uint32_t typeIndex : mTypes)
+        {
+            mOffsets[typeIndex] = (uint32_t)offset;
+            offset = AlignUp(offset + mChunkCapacity * GetComponentTypeInfo(typeIndex).mSize, kArchetypeColumnAlignment);
+        }
+        assert(offset <= kArchetypeChunkSize);
+    }
+
+    size_t Archetype::GetEntityCount() const
+    {
+        return mChunks.empty() ? 0 : (mChunks.size() - 1) * mChunkCapacity + mChunks.back().mCount;
+    }
+
+    ArchetypeStorage::ArchetypeStorage(IAllocator* allocator) :
+        mAllocator(allocator)
+    {
+        assert(mAllocator);
+    }
+
+    ArchetypeStorage::~ArchetypeStorage()
+    {
+        Clear();
+
+        for (Archetype* pArchetype : mArchetypes)
+            Free<Archetype>(pArchetype, mAllocator);
+        for (ArchetypeChunk& chunk : mFreeChunks)
+            mAllocator->Free(chunk.mpMemory);
+    }
+
+    void* ArchetypeStorage::GetComponent(Handle<Entity> entity, uint32_t typeIndex) const
+    {
+        const EntityRecord* pRecord = FindRecord(entity);
+        if (!pRecord || !pRecord->mpArchetype->Has(typeIndex))
+            return nullptr;
+
+        const Archetype& archetype = *pRecord->mpArchetype;
+        const ArchetypeChunk& chunk = archetype.mChunks[pRecord->mChunk];
+        return archetype.GetColumn(chunk, typeIndex) + (size_t)pRecord->mRow * GetComponentTypeInfo(typeIndex).mSize;
+    }
+
+    ComponentMask ArchetypeStorage::GetMask(Handle<Entity> entity) const
+    {
+        const EntityRecord* pRecord = FindRecord(entity);
+        return pRecord ? pRecord->mpArchetype->mMask : 0;
+    }
+
+    void ArchetypeStorage::RemoveEntity(Handle<Entity> entity)
+    {
+        if (!FindRecord(entity))
+            return;
+
+        EntityRecord& record = mRecords[entity.mIndex];
+        MoveEntity(entity, record, nullptr);
+    }
+
+    void ArchetypeStorage::Clear()
+    {
+        for (Archetype* pArchetype : mArchetypes)
+        {
+            for (ArchetypeChunk& chunk : pArchetype->mChunks)
+            {
+                for (uint32_t typeIndex : pArchetype->mTypes)
+                {
+                    const ComponentTypeInfo& info = GetComponentTypeInfo(typeIndex);
+                    Byte* pColumn = pArchetype->GetColumn(chunk, typeIndex);
+                    for (uint32_t row = 0; row < chunk.mCount; ++row)
+                        info.mpDestroy(pColumn + (size_t)row * info.mSize);
+                }
+
+                chunk.mCount = 0;
+                mFreeChunks.push_back(chunk);
+            }
+            pArchetype->mChunks.clear();
+        }
+
+        mRecords.clear();
+        mEntityCount = 0;
+    }
+
+    void* ArchetypeStorage::AddComponent(Handle<Entity> entity, uint32_t typeIndex)
+    {
+        assert(!entity.IsNull());
+        if (entity.mIndex >= mRecords.size())
+            mRecords.resize(std::max<size_t>(entity.mIndex + 1, mRecords.size() * 2));
+
+        // A row left behind by an older entity with the same index is dropped
+        EntityRecord& record = mRecords[entity.mIndex];
+        if (record.mpArchetype && record.mGeneration != entity.mGeneration)
+            MoveEntity(entity, record, nullptr);
+
+        Archetype* pSource = record.mpArchetype;
+        Archetype* pTarget = pSource ? pSource->mpAddEdges[typeIndex] : nullptr;
+        if (!pTarget)
+        {
+            pTarget = GetArchetype((pSource ? pSource->mMask : 0) | (ComponentMask(1) << typeIndex));
+            if (pSource)
+                pSource->mpAddEdges[typeIndex] = pTarget;
+        }
+
+        MoveEntity(entity, record, pTarget);
+        const ArchetypeChunk& chunk = pTarget->mChunks[record.mChunk];
+        return pTarget->GetColumn(chunk, typeIndex) + (size_t)record.mRow * GetComponentTypeInfo(typeIndex).mSize;
+    }
+
+    void ArchetypeStorage::RemoveComponent(Handle<Entity> entity, uint32_t typeIndex)
+    {
+        if (!FindRecord(entity))
+            return;
+
+        EntityRecord& record = mRecords[entity.mIndex];
+        Archetype* pSource = record.mpArchetype;
+        if (!pSource->Has(typeIndex))
+            return;
+
+        Archetype* pTarget = pSource->mpRemoveEdges[typeIndex];
+        const ComponentMask mask = pSource->mMask & ~(ComponentMask(1) << typeIndex);
+        if (!pTarget && mask != 0)
+        {
+            pTarget = GetArchetype(mask);
+            pSource->mpRemoveEdges[typeIndex] = pTarget;
+        }
+
+        MoveEntity(entity, record, pTarget);
+    }
+
+    const ArchetypeStorage::EntityRecord* ArchetypeStorage::FindRecord(Handle<Entity> entity) const
+    {
+        if (entity.mIndex >= mRecords.size())
+            return nullptr;
+
+        const EntityRecord& record = mRecords[entity.mIndex];
+        return record.mpArchetype && record.mGeneration == entity.mGeneration ? &record : nullptr;
+    }
+
+    Archetype* ArchetypeStorage::GetArchetype(ComponentMask mask)
+    {
+        auto it = mArchetypeMap.find(mask);
+        if (it != mArchetypeMap.end())
+            return it->second;
+
+        Archetype* pArchetype = Alloc<Archetype>(mAllocator, mask);
+        mArchetypes.push_back(pArchetype);
+        mArchetypeMap[mask] = pArchetype;
+        return pArchetype;
+    }
+
+    // Moves the components both archetypes have, destroys the ones the target lacks and leaves the
+    // target's extra ones unconstructed. A null target removes the entity.
+    void ArchetypeStorage::MoveEntity(Handle<Entity> entity, EntityRecord& record, Archetype* pTarget)
+    {
+        uint32_t chunkIndex = 0;
+        uint32_t row = 0;
+        if (pTarget)
+        {
+            if (pTarget->mChunks.empty() || pTarget->mChunks.back().mCount == pTarget->mChunkCapacity)
+                pTarget->mChunks.push_back(AllocateChunk());
+
+            chunkIndex = (uint32_t)pTarget->mChunks.size() - 1;
+            ArchetypeChunk& chunk = pTarget->mChunks.back();
+            row = chunk.mCount++;
+            pTarget->GetEntities(chunk)[row] = entity;
+        }
+
+        Archetype* pSource = record.mpArchetype;
+        if (pSource)
+        {
+            const ArchetypeChunk& source = pSource->mChunks[record.mChunk];
+            for (uint32_t typeIndex : pSource->mTypes)
+            {
+                const ComponentTypeInfo& info = GetComponentTypeInfo(typeIndex);
+                Byte* pSrc = pSource->GetColumn(source, typeIndex) + (size_t)record.mRow * info.mSize;
+                if (pTarget && pTarget->Has(typeIndex))
+                    info.mpMove(pTarget->GetColumn(pTarget->mChunks[chunkIndex], typeIndex) + (size_t)row * info.mSize, pSrc);
+                else
+                    info.mpDestroy(pSrc);
+            }
+
+            RemoveRow(*pSource, record.mChunk, record.mRow);
+        }
+
+        mEntityCount += (pTarget != nullptr) - (pSource != nullptr);
+        record.mpArchetype = pTarget;
+        record.mGeneration = pTarget ? entity.mGeneration : 0;
+        record.mChunk = chunkIndex;
+        record.mRow = row;
+    }
+
+    // The row's components are already gone, the archetype's last row is moved into it
+    void ArchetypeStorage::RemoveRow(Archetype& archetype, uint32_t chunkIndex, uint32_t row)
+    {
+        const uint32_t lastChunkIndex = (uint32_t)archetype.mChunks.size() - 1;
+        ArchetypeChunk& last = archetype.mChunks[lastChunkIndex];
+        const uint32_t lastRow = last.mCount - 1;
+
+        if (chunkIndex != lastChunkIndex || row != lastRow)
+        {
+            ArchetypeChunk& chunk = archetype.mChunks[chunkIndex];
+            for (uint32_t typeIndex : archetype.mTypes)
+            {
+                const ComponentTypeInfo& info = GetComponentTypeInfo(typeIndex);
+                info.mpMove(archetype.GetColumn(chunk, typeIndex) + (size_t)row * info.mSize,
+                    archetype.GetColumn(last, typeIndex) + (size_t)lastRow * info.mSize);
+            }
+
+            const Handle<Entity> moved = archetype.GetEntities(last)[lastRow];
+            archetype.GetEntities(chunk)[row] = moved;
+            mRecords[moved.mIndex].mChunk = chunkIndex;
+            mRecords[moved.mIndex].mRow = row;
+        }
+
+        if (--last.mCount == 0)
+        {
+            mFreeChunks.push_back(last);
+            archetype.mChunks.pop_back();
+        }
+    }
+
+    ArchetypeChunk ArchetypeStorage::AllocateChunk()
+    {
+        if (!mFreeChunks.empty())
+        {
+            ArchetypeChunk chunk = mFreeChunks.back();
+            mFreeChunks.pop_back();
+            return chunk;
+        }
+
+        ArchetypeChunk chunk;
+        chunk.mpMemory = mAllocator->Allocate(kArchetypeChunkSize + kArchetypeColumnAlignment);
+        chunk.mpData = (Byte*)AlignUp((uintptr_t)chunk.mpMemory, kArchetypeColumnAlignment);
+        return chunk;
+    }
+}
@@ -0,0 +1,204 @@
+#ifndef NV_ENGINE_ARCHETYPE
+#define NV_ENGINE_ARCHETYPE
+
+#pragma once
+
+#include <Lib/Handle.h>
+#include <Lib/Map.h>
+#include <Lib/StringHash.h>
+#include <Memory/Allocator.h>
+#include <Engine/Component.h>
+
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace nv::ecs
+{
+    struct Entity;
+
+    constexpr size_t   kArchetypeChunkSize = 16 * 1024;
+    constexpr size_t   kArchetypeColumnAlignment = 64;  // Columns start on a cache line
+    constexpr uint32_t kMaxArchetypeComponents = 64;    // Component types told apart, one ComponentMask bit each
+
+    using ComponentMask = uint64_t;
+
+    // Enough to move a component between chunks without knowing its type
+    struct ComponentTypeInfo
+    {
+        StringID    mId = 0;
+        uint32_t    mSize = 0;
+        uint32_t    mAlignment = 0;
+        void        (*mpMove)(void* pDst, void* pSrc) = nullptr;    // Move constructs pDst and destroys pSrc
+        void        (*mpDestroy)(void* ptr) = nullptr;
+    };
+
+    // Returns the type's index in the process wide registry, the same one when registered twice.
+    uint32_t                    RegisterComponentType(const ComponentTypeInfo& info);
+    const ComponentTypeInfo&    GetComponentTypeInfo(uint32_t typeIndex);
+
+    template<typename TComp>
+    uint32_t GetComponentTypeIndex()
+    {
+        static const uint32_t sIndex = RegisterComponentType(ComponentTypeInfo
+        {
+            .mId = GetComponentID<TComp>(),
+            .mSize = sizeof(TComp),
+            .mAlignment = alignof(TComp),
+            .mpMove = [](void* pDst, void* pSrc)
+            {
+                new (pDst) TComp(std::move(*(TComp*)pSrc));
+                ((TComp*)pSrc)->~TComp();
+            },
+            .mpDestroy = [](void* ptr) { ((TComp*)ptr)->~TComp(); },
+        });
+        return sIndex;
+    }
+
+    template<typename... TComps>
+    ComponentMask GetComponentMask()
+    {
+        return ((ComponentMask(1) << GetComponentTypeIndex<TComps>()) | ... | ComponentMask(0));
+    }
+
+    struct ArchetypeChunk
+    {
+        Byte*       mpData = nullptr;       // kArchetypeChunkSize bytes, kArchetypeColumnAlignment aligned
+        void*       mpMemory = nullptr;     // As returned by the allocator
+        uint32_t    mCount = 0;
+    };
+
+    // Entities with exactly the same set of components. Their components live in chunks of
+    // kArchetypeChunkSize holding one column per type plus a column of entity handles, so a
+    // system reading a few of them walks each column front to back. All chunks but the last
+    // are full.
+    class Archetype
+    {
+    public:
+        Archetype(ComponentMask mask);
+
+        Archetype(const Archetype&) = delete;
+        Archetype& operator=(const Archetype&) = delete;
+
+        ComponentMask   GetMask() const { return mMask; }
+        bool            Has(uint32_t typeIndex) const { return (mMask >> typeIndex) & 1; }
+        bool            HasAll(ComponentMask mask) const { return (mMask & mask) == mask; }
+
+        uint32_t        GetChunkCapacity() const { return mChunkCapacity; }
+        uint32_t        GetChunkCount() const { return (uint32_t)mChunks.size(); }
+        const ArchetypeChunk& GetChunk(uint32_t index) const { return mChunks[index]; }
+        size_t          GetEntityCount() const;
+
+        Handle<Entity>* GetEntities(const ArchetypeChunk& chunk) const { return (Handle<Entity>*)chunk.mpData; }
+        Byte*           GetColumn(const ArchetypeChunk& chunk, uint32_t typeIndex) const { return chunk.mpData + mOffsets[typeIndex]; }
+
+        template<typename TComp>
+        TComp* GetColumn(const ArchetypeChunk& chunk) const
+        {
+            const uint32_t typeIndex = GetComponentTypeIndex<TComp>();
+            return Has(typeIndex) ? (TComp*)GetColumn(chunk, typeIndex) : nullptr;
+        }
+
+    private:
+        ComponentMask               mMask;
+        uint32_t                    mChunkCapacity = 0;
+        std::vector<uint32_t>       mTypes;                                 // Type indices, ascending
+        std::vector<ArchetypeChunk> mChunks;
+        uint32_t                    mOffsets[kMaxArchetypeComponents] = {}; // Column offset by type index
+        Archetype*                  mpAddEdges[kMaxArchetypeComponents] = {};   // Archetype with one type more
+        Archetype*                  mpRemoveEdges[kMaxArchetypeComponents] = {};
+
+        friend class ArchetypeStorage;
+    };
+
+    // Components grouped by archetype, keyed by entity handle. A record per handle index gives
+    // an entity's archetype, chunk and row with one array lookup. Adding or removing a component
+    // moves the entity's row to the archetype of its new component set, and the last row of the
+    // old archetype is swapped into the hole, so component pointers are only good until the next
+    // Add, Remove or RemoveEntity. Not thread safe.
+    // A standalone store: Entity, ComponentManager, Query and the frame recorder only see the
+    // per type ComponentPools, nothing put here shows up through them.
+    //
+    //  ArchetypeStorage storage;
+    //  storage.Add<Position>(entity)->mPosition = float3(1, 0, 0);
+    //  storage.Add<Rotation>(entity);              // Moves the entity to (Position, Rotation)
+    //  Position* pPos = storage.Get<Position>(entity);
+    class ArchetypeStorage
+    {
+    public:
+        ArchetypeStorage(IAllocator* allocator = SystemAllocator::gPtr);
+        ~ArchetypeStorage();
+
+        ArchetypeStorage(const ArchetypeStorage&) = delete;
+        ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+
+        // Returns the existing component if the entity already has one.
+        template<typename TComp, typename ...Args>
+        TComp* Add(Handle<Entity> entity, Args&&... args)
+        {
+            if (TComp* pExisting = Get<TComp>(entity))
+                return pExisting;
+
+            void* pSlot = AddComponent(entity, GetComponentTypeIndex<TComp>());
+            return new (pSlot) TComp(std::forward<Args>(args)...);
+        }
+
+        template<typename TComp>
+        void Remove(Handle<Entity> entity)
+        {
+            RemoveComponent(entity, GetComponentTypeIndex<TComp>());
+        }
+
+        // nullptr if the entity doesn't have one.
+        template<typename TComp>
+        TComp* Get(Handle<Entity> entity) const
+        {
+            return (TComp*)GetComponent(entity, GetComponentTypeIndex<TComp>());
+        }
+
+        template<typename TComp>
+        bool Has(Handle<Entity> entity) const
+        {
+            return GetComponent(entity, GetComponentTypeIndex<TComp>()) != nullptr;
+        }
+
+        void*   GetComponent(Handle<Entity> entity, uint32_t typeIndex) const;
+        ComponentMask GetMask(Handle<Entity> entity) const;
+
+        // Destroys the entity's components, the handle can be reused afterwards.
+        void    RemoveEntity(Handle<Entity> entity);
+        void    Clear();
+
+        // Every archetype made so far, empty ones included. Only grows.
+        const std::vector<Archetype*>& GetArchetypes() const { return mArchetypes; }
+        size_t  GetEntityCount() const { return mEntityCount; }
+
+    private:
+        struct EntityRecord
+        {
+            Archetype*  mpArchetype = nullptr;
+            uint32_t    mGeneration = 0;        // Of the handle the row belongs to
+            uint32_t    mChunk = 0;
+            uint32_t    mRow = 0;
+        };
+
+        void*           AddComponent(Handle<Entity> entity, uint32_t typeIndex);
+        void            RemoveComponent(Handle<Entity> entity, uint32_t typeIndex);
+        const EntityRecord* FindRecord(Handle<Entity> entity) const;
+
+        Archetype*      GetArchetype(ComponentMask mask);
+        void            MoveEntity(Handle<Entity> entity, EntityRecord& record, Archetype* pTarget);
+        void            RemoveRow(Archetype& archetype, uint32_t chunkIndex, uint32_t row);
+        ArchetypeChunk  AllocateChunk();
+
+        IAllocator*                 mAllocator;
+        std::vector<Archetype*>     mArchetypes;
+        HashMap<ComponentMask, Archetype*> mArchetypeMap;
+        std::vector<EntityRecord>   mRecords;           // By handle index
+        std::vector<ArchetypeChunk> mFreeChunks;
+        size_t                      mEntityCount = 0;
+    };
+}
+
+#endif // !NV_ENGINE_ARCHETYPE
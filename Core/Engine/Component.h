@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 namespace nv::ecs
@@ -13,6 +14,16 @@ namespace nv::ecs
         }
     };
 
+    enum class ComponentStorage : uint8_t
+    {
+        Contiguous,     // ContiguousPool, handles are looked up in a hash map
+        SparseSet,      // SparseSetPool, handles are looked up in a paged array
+    };
+
+    // Pool a component type is kept in, specialize it to pick another for one type
+    template<typename TComp>
+    constexpr ComponentStorage kComponentStorage = ComponentStorage::Contiguous;
+
     template<typename TComp>
     constexpr std::string_view GetComponentName()
     {
@@ -30,4 +41,24 @@ namespace nv::ecs
         compName.remove_prefix(prefix.size());
         return ID(compName);
     }
+
+    enum class ComponentAccess : uint8_t
+    {
+        Read,
+        Write,
+        Structural,     // Adds or removes the component
+    };
+
+#if NV_ENABLE_SYSTEM_VALIDATION
+    // Asserts the system running on this thread declared the access in its SystemAccess
+    void ValidateComponentAccess(StringID id, std::string_view name, ComponentAccess access);
+#endif
+
+    template<typename TComp>
+    inline void ValidateAccess(ComponentAccess access)
+    {
+#if NV_ENABLE_SYSTEM_VALIDATION
+        ValidateComponentAccess(GetComponentID<TComp>(), GetComponentName<TComp>(), access);
+#endif
+    }
 }
\ No newline at end of file
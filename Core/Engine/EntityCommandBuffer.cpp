@@ -0,0 +1,174 @@
+#include "pch.h"
+
+#include <Engine/EntityCommandBuffer.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace nv::ecs
+{
+    namespace
+    {
+        struct ThreadBufferCache
+        {
+            uint32_t                mQueueId = 0;
+            EntityCommandBuffer*    mpBuffer = nullptr;
+        };
+
+        std::atomic<uint32_t>           gNextQueueId = 1;
+        thread_local ThreadBufferCache  tBufferCache;
+    }
+
+    EntityCommandQueue gEntityCommands;
+
+    Handle<Entity> EntityCommandBuffer::Create(uint64_t sortKey, Handle<Entity> parent)
+    {
+        const uint32_t createIndex = (uint32_t)mCreated.size();
+        mCreated.push_back(Null<Entity>());
+        mCommands.push_back({ .mSortKey = sortKey, .mEntity = parent, .mType = CommandType::Create, .mCreateIndex = createIndex });
+
+        Handle<Entity> placeholder;
+        placeholder.mIndex = createIndex;
+        placeholder.mGeneration = kPlaceholderGeneration;
+        return placeholder;
+    }
+
+    void EntityCommandBuffer::Destroy(uint64_t sortKey, Handle<Entity> entity)
+    {
+        Record(sortKey, entity, CommandType::Destroy, nullptr, nullptr, nullptr);
+    }
+
+    void EntityCommandBuffer::Record(uint64_t sortKey, Handle<Entity> entity, CommandType type, void* pData, ApplyFn pApply, DestroyFn pDestroy)
+    {
+        assert(!IsPlaceholder(entity) || entity.mIndex < mCreated.size()); // Placeholder from another buffer
+        mCommands.push_back({ .mSortKey = sortKey, .mEntity = entity, .mType = type, .mpData = pData, .mpApply = pApply, .mpDestroy = pDestroy });
+    }
+
+    Handle<Entity> EntityCommandBuffer::Resolve(Handle<Entity> entity) const
+    {
+        if (!IsPlaceholder(entity))
+            return entity;
+
+        // Still null only for a Create whose parent is created after it
+        assert(!mCreated[entity.mIndex].IsNull());
+        return mCreated[entity.mIndex];
+    }
+
+    void EntityCommandBuffer::Play(const Command& command)
+    {
+        const Handle<Entity> entity = Resolve(command.mEntity);
+        switch (command.mType)
+        {
+        case CommandType::Create:
+            mCreated[command.mCreateIndex] = gEntityManager.Create(entity);
+            break;
+        case CommandType::Destroy:
+            if (gEntityManager.GetEntity(entity))
+                gEntityManager.Remove(entity);
+            break;
+        default:
+            if (Entity* pEntity = gEntityManager.GetEntity(entity))
+                command.mpApply(*pEntity, command.mpData);
+            break;
+        }
+    }
+
+    void EntityCommandBuffer::Clear()
+    {
+        for (const Command& command : mCommands)
+        {
+            if (command.mpDestroy)
+                command.mpDestroy(command.mpData);
+        }
+
+        mCommands.clear();
+        mCreated.clear();
+        mData.Reset();
+    }
+
+    EntityCommandQueue::EntityCommandQueue() :
+        mId(gNextQueueId.fetch_add(1, std::memory_order_relaxed))
+    {
+    }
+
+    EntityCommandQueue::~EntityCommandQueue()
+    {
+        for (ThreadBuffer& buffer : mBuffers)
+            Free<EntityCommandBuffer>(buffer.mpBuffer);
+    }
+
+    EntityCommandBuffer& EntityCommandQueue::GetBuffer()
+    {
+        if (tBufferCache.mQueueId == mId)
+            return *tBufferCache.mpBuffer;
+
+        std::scoped_lock lock(mMutex);
+        const std::thread::id thread = std::this_thread::get_id();
+        auto it = std::find_if(mBuffers.begin(), mBuffers.end(), [thread](const ThreadBuffer& buffer) { return buffer.mThread == thread; });
+        EntityCommandBuffer* pBuffer = it != mBuffers.end() ? it->mpBuffer : nullptr;
+        if (!pBuffer)
+        {
+            pBuffer = Alloc<EntityCommandBuffer>();
+            mBuffers.push_back({ thread, pBuffer });
+        }
+
+        tBufferCache = { mId, pBuffer };
+        return *pBuffer;
+    }
+
+    void EntityCommandQueue::Playback()
+    {
+        std::scoped_lock lock(mMutex);
+
+        struct Entry
+        {
+            uint64_t mSortKey;
+            uint32_t mBuffer;
+            uint32_t mCommand;
+
+            bool operator<(const Entry& rhs) const
+            {
+                return mSortKey != rhs.mSortKey ? mSortKey < rhs.mSortKey :
+                    mBuffer != rhs.mBuffer ? mBuffer < rhs.mBuffer : mCommand < rhs.mCommand;
+            }
+        };
+
+        std::vector<Entry> order;
+        for (uint32_t b = 0; b < (uint32_t)mBuffers.size(); ++b)
+        {
+            const auto& commands = mBuffers[b].mpBuffer->mCommands;
+            for (uint32_t c = 0; c < (uint32_t)commands.size(); ++c)
+                order.push_back({ commands[c].mSortKey, b, c });
+        }
+
+        if (order.empty())
+            return;
+
+        // Threads register in any order, the buffer index only breaks ties a key shouldn't have
+        std::sort(order.begin(), order.end());
+
+        // Creates first, so every placeholder has its entity whatever key used it
+        for (const Entry& entry : order)
+        {
+            EntityCommandBuffer& buffer = *mBuffers[entry.mBuffer].mpBuffer;
+            if (buffer.mCommands[entry.mCommand].mType == EntityCommandBuffer::CommandType::Create)
+                buffer.Play(buffer.mCommands[entry.mCommand]);
+        }
+
+        for (const Entry& entry : order)
+        {
+            EntityCommandBuffer& buffer = *mBuffers[entry.mBuffer].mpBuffer;
+            if (buffer.mCommands[entry.mCommand].mType != EntityCommandBuffer::CommandType::Create)
+                buffer.Play(buffer.mCommands[entry.mCommand]);
+        }
+
+        for (ThreadBuffer& buffer : mBuffers)
+            buffer.mpBuffer->Clear();
+    }
+
+    bool EntityCommandQueue::IsEmpty() const
+    {
+        std::scoped_lock lock(mMutex);
+        return std::all_of(mBuffers.begin(), mBuffers.end(), [](const ThreadBuffer& buffer) { return buffer.mpBuffer->mCommands.empty(); });
+    }
+}
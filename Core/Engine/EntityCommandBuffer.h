@@ -0,0 +1,187 @@
+#ifndef NV_ENGINE_ENTITYCOMMANDBUFFER
+#define NV_ENGINE_ENTITYCOMMANDBUFFER
+
+#pragma once
+
+#include <Engine/EntityComponent.h>
+#include <Memory/Allocator.h>
+
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace nv::ecs
+{
+    constexpr size_t   kEntityCommandDataChunkSize = 16 * 1024;
+    constexpr uint32_t kPlaceholderGeneration = ~0u;   // Entity handles returned by EntityCommandBuffer::Create
+
+    // Structural changes recorded by one thread, applied later by EntityCommandQueue::Playback.
+    // Every command carries a sort key, e.g. the query chunk it came from. Playback runs the
+    // commands by key and, within a key, in the order they were recorded, so a key must only
+    // be used by one job. Create returns a placeholder handle that only this buffer's later
+    // commands can refer to, it becomes a real entity on playback.
+    class EntityCommandBuffer
+    {
+    public:
+        EntityCommandBuffer() :
+            mData(kEntityCommandDataChunkSize)
+        {}
+
+        EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+        EntityCommandBuffer& operator=(const EntityCommandBuffer&) = delete;
+
+        ~EntityCommandBuffer() { Clear(); }
+
+        Handle<Entity>  Create(uint64_t sortKey, Handle<Entity> parent = Null<Entity>());
+        void            Destroy(uint64_t sortKey, Handle<Entity> entity);
+
+        // Assigned comp, added default constructed first unless the entity already has one.
+        // Dropped if the entity is gone by then.
+        template<typename TComp>
+        void Add(uint64_t sortKey, Handle<Entity> entity, TComp comp = TComp())
+        {
+            Record(sortKey, entity, CommandType::Add, Store(std::move(comp)), &AddComponent<TComp>, &DestroyData<TComp>);
+        }
+
+        template<typename TComp>
+        void Remove(uint64_t sortKey, Handle<Entity> entity)
+        {
+            Record(sortKey, entity, CommandType::Remove, nullptr, &RemoveComponent<TComp>, nullptr);
+        }
+
+        // Overwrites the component, dropped if the entity doesn't have one by then.
+        template<typename TComp>
+        void Set(uint64_t sortKey, Handle<Entity> entity, TComp comp)
+        {
+            Record(sortKey, entity, CommandType::Set, Store(std::move(comp)), &SetComponent<TComp>, &DestroyData<TComp>);
+        }
+
+        size_t GetCommandCount() const { return mCommands.size(); }
+
+        static bool IsPlaceholder(Handle<Entity> entity) { return entity.mGeneration == kPlaceholderGeneration; }
+
+    private:
+        enum class CommandType : uint8_t
+        {
+            Create,
+            Destroy,
+            Add,
+            Remove,
+            Set,
+        };
+
+        using ApplyFn = void (*)(Entity& entity, void* pData);
+        using DestroyFn = void (*)(void* pData);
+
+        struct Command
+        {
+            uint64_t        mSortKey;
+            Handle<Entity>  mEntity;        // The parent for Create
+            CommandType     mType;
+            uint32_t        mCreateIndex;   // Placeholder index for Create
+            void*           mpData;         // Component for Add and Set, in mData
+            ApplyFn         mpApply;
+            DestroyFn       mpDestroy;
+        };
+
+        template<typename TComp>
+        void* Store(TComp&& comp)
+        {
+            void* pData = mData.Allocate(sizeof(TComp), alignof(TComp));
+            return new (pData) TComp(std::move(comp));
+        }
+
+        template<typename TComp>
+        static void AddComponent(Entity& entity, void* pData)
+        {
+            ComponentPool<TComp>* pPool = gComponentManager.GetPool<TComp>();
+            TComp* pComp = pPool ? pPool->Find(entity.mHandle) : nullptr;
+            if (pComp)
+                pPool->MarkChanged(entity.mHandle);
+            *(pComp ? pComp : entity.Add<TComp>()) = std::move(*(TComp*)pData);
+        }
+
+        template<typename TComp>
+        static void RemoveComponent(Entity& entity, void*)
+        {
+            entity.Remove<TComp>();
+        }
+
+        template<typename TComp>
+        static void SetComponent(Entity& entity, void* pData)
+        {
+            ComponentPool<TComp>* pPool = gComponentManager.GetPool<TComp>();
+            if (TComp* pComp = pPool ? pPool->Find(entity.mHandle) : nullptr)
+            {
+                pPool->MarkChanged(entity.mHandle);
+                *pComp = std::move(*(TComp*)pData);
+            }
+        }
+
+        template<typename TComp>
+        static void DestroyData(void* pData)
+        {
+            ((TComp*)pData)->~TComp();
+        }
+
+        void            Record(uint64_t sortKey, Handle<Entity> entity, CommandType type, void* pData, ApplyFn pApply, DestroyFn pDestroy);
+        Handle<Entity>  Resolve(Handle<Entity> entity) const;
+        void            Play(const Command& command);
+        void            Clear();
+
+        std::vector<Command>        mCommands;
+        std::vector<Handle<Entity>> mCreated;       // Entity made for each placeholder, filled by playback
+        ArenaAllocator              mData;
+
+        friend class EntityCommandQueue;
+    };
+
+    // Hands every recording thread its own EntityCommandBuffer, so jobs never contend on one.
+    // Playback applies all of them on the main thread once the jobs are done, creates first,
+    // then everything else by sort key, so the result doesn't depend on which worker ran what.
+    // SystemManager plays gEntityCommands back after each system's update.
+    //
+    //  query.ForEachChunk([](const auto& chunk)
+    //  {
+    //      EntityCommandBuffer& commands = gEntityCommands.GetBuffer();
+    //      chunk.ForEach([&](Handle<Entity> entity, const Health& health)
+    //      {
+    //          if (health.mValue <= 0.f)
+    //              commands.Destroy(chunk.GetIndex(), entity);
+    //      });
+    //  });
+    class EntityCommandQueue
+    {
+    public:
+        EntityCommandQueue();
+        ~EntityCommandQueue();
+
+        EntityCommandQueue(const EntityCommandQueue&) = delete;
+        EntityCommandQueue& operator=(const EntityCommandQueue&) = delete;
+
+        // The calling thread's buffer. Don't hold it across a wait, the job may resume on another thread.
+        EntityCommandBuffer& GetBuffer();
+
+        // Main thread, with nothing recording.
+        void    Playback();
+        bool    IsEmpty() const;
+
+    private:
+        struct ThreadBuffer
+        {
+            std::thread::id         mThread;
+            EntityCommandBuffer*    mpBuffer;
+        };
+
+        mutable std::mutex          mMutex;
+        std::vector<ThreadBuffer>   mBuffers;
+        uint32_t                    mId;        // Tells the thread local cache apart from earlier queues at the same address
+    };
+
+    extern EntityCommandQueue gEntityCommands;
+}
+
+#endif // !NV_ENGINE_ENTITYCOMMANDBUFFER
@@ -40,6 +40,23 @@ namespace nv::ecs
     ComponentManager gComponentManager;
     EntityManager    gEntityManager;
     std::unordered_map<std::string, StringID> gComponentNames;
+    std::atomic<uint32_t> gComponentVersion = 1;     // 0 is older than every write
+
+#if NV_ENABLE_SYSTEM_VALIDATION
+    // The typed calls know their name, these only have the id
+    static void ValidateAccessById(StringID compId, ComponentAccess access)
+    {
+        std::string_view name = "component";
+        for (const auto& [compName, id] : gComponentNames)
+        {
+            if (id == compId)
+                name = compName;
+        }
+        ValidateComponentAccess(compId, name, access);
+    }
+#else
+    static void ValidateAccessById(StringID, ComponentAccess) {}
+#endif
 
     void EntityManager::Init()
     {
@@ -77,6 +94,13 @@ namespace nv::ecs
 
     void EntityManager::Remove(Handle<Entity> entity)
     {
+        // Left in their pools, the components would still be joined by queries and drawn
+        for (const auto& [compId, handle] : gComponentManager.GetEntityComponentMap(entity))
+        {
+            if (IComponentPool* pPool = gComponentManager.GetPool(compId))
+                pPool->RemoveEntity(entity);
+        }
+
         mEntities.Remove(entity);
         gComponentManager.RemoveEntityComponentMap(entity);
     }
@@ -134,11 +158,24 @@ namespace nv::ecs
         scale->mScale = transform.mScale;
     }
 
-    TransformRef Entity::GetTransform() const
+    Transform Entity::GetTransform() const
     {
         auto pos = Get<Position>();
         auto rot = Get<Rotation>();
         auto scale = Get<Scale>();
+        return Transform
+        { 
+            .mPosition = pos->mPosition, 
+            .mRotation = rot->mRotation, 
+            .mScale = scale->mScale 
+        };
+    }
+
+    TransformRef Entity::GetTransformMut() const
+    {
+        auto pos = GetMut<Position>();
+        auto rot = GetMut<Rotation>();
+        auto scale = GetMut<Scale>();
         return TransformRef
         { 
             .mPosition = pos->mPosition, 
@@ -147,20 +184,31 @@ namespace nv::ecs
         };
     }
 
-    IComponent* Entity::Get(StringID compId) const
+    const IComponent* Entity::Get(StringID compId) const
     {
-        auto compMap = gComponentManager.GetEntityComponentMap(mHandle);
+        ValidateAccessById(compId, ComponentAccess::Read);
+        auto& compMap = gComponentManager.GetEntityComponentMap(mHandle);
+        auto comp = compMap.at(compId);
+        return gComponentManager.GetPool(compId)->GetComponent(comp);
+    }
+
+    IComponent* Entity::GetMut(StringID compId) const
+    {
+        ValidateAccessById(compId, ComponentAccess::Write);
+        auto& compMap = gComponentManager.GetEntityComponentMap(mHandle);
         auto comp = compMap.at(compId);
         IComponentPool* pool = gComponentManager.GetPool(compId);
+        pool->MarkChanged(mHandle);
         return pool->GetComponent(comp);
     }
 
+    // Hands out mutable pointers for the editor, so every component is counted as changed
     void Entity::GetComponents(std::unordered_map<StringID, IComponent*>& outComponents) const
     {
         auto& compMap = gComponentManager.GetEntityComponentMap(mHandle);
         for (auto comp : compMap)
         {
-            IComponent* component = Get(comp.first);
+            IComponent* component = GetMut(comp.first);
             outComponents[comp.first] = component;
         }
     }
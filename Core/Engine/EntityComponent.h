@@ -17,6 +17,10 @@
 #include <cereal/types/vector.hpp>
 #include <cereal/cereal.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
 namespace nv::ecs
 {
     struct Entity;
@@ -106,6 +110,11 @@ namespace nv::ecs
             TComp* mpComponent;
         };
 
+        EntityComponents(IAllocator* allocator = nullptr) :
+            mEntities(allocator),
+            mComponents(allocator)
+        {}
+
         nv::Vector<Handle<Entity>> mEntities;
         nv::Vector<TComp*> mComponents;
 
@@ -114,6 +123,14 @@ namespace nv::ecs
         Instance operator[](size_t idx) const;
     };
 
+    // Components are stamped with this when they're handed out mutably, see Changed<T> in
+    // Query.h. SystemManager advances it before each schedule level, so everything a level
+    // writes shares one version and a later level's writes are always newer.
+    extern std::atomic<uint32_t> gComponentVersion;
+
+    inline uint32_t GetComponentVersion() { return gComponentVersion.load(std::memory_order_relaxed); }
+    inline uint32_t AdvanceComponentVersion() { return gComponentVersion.fetch_add(1, std::memory_order_relaxed) + 1; }
+
     class IComponentPool 
     {
     public:
@@ -137,6 +154,8 @@ namespace nv::ecs
         virtual void                DeserializeForFrame(std::istream& istream) = 0;
         virtual void                Serialize(std::ostream& ostream) = 0;
         virtual void                Deserialize(std::istream& istream) = 0;
+        virtual uint32_t            GetVersion() const = 0;
+        virtual void                MarkChanged(Handle<Entity> entity) = 0;
 
         template<typename TComp>
         IComponent* GetComponent(Handle<TComp> handle)
@@ -202,6 +221,10 @@ namespace nv::ecs
         {
             Handle<TComp> handle = mComponents.Create();
             mEntityMap[entity.mHandle] = handle;
+            mOwners.push_back(entity);
+            mVersions.push_back(GetComponentVersion());
+            SetDenseIndex(entity, (uint32_t)mOwners.size() - 1);
+            RaiseVersion(mVersions.back());
             return handle.mHandle;
         }
 
@@ -209,9 +232,72 @@ namespace nv::ecs
         {
             Handle<TComp> h;
             h.mHandle = handle;
+            if (!mComponents.IsValid(h))
+                return;
+
+            // The pool moves its last component into the hole, the owners follow
+            const uint32_t index = (uint32_t)(mComponents.GetAsDerived(h) - mComponents.Span().mData);
+            const uint32_t lastIndex = (uint32_t)mOwners.size() - 1;
             mComponents.Remove(h);
+
+            const Handle<Entity> removed = mOwners[index];
+            if (mDenseIndices[removed.mIndex] == index)
+                mDenseIndices[removed.mIndex] = kInvalidDenseIndex;
+
+            if (index != lastIndex)
+            {
+                const Handle<Entity> moved = mOwners[lastIndex];
+                mOwners[index] = moved;
+                mVersions[index] = mVersions[lastIndex];
+                if (mDenseIndices[moved.mIndex] == lastIndex)
+                    mDenseIndices[moved.mIndex] = index;
+            }
+            mOwners.pop_back();
+            mVersions.pop_back();
+            RaiseVersion(GetComponentVersion());
+        }
+
+        // The entity's component, nullptr if it has none. An array lookup, no hashing.
+        TComp* Find(Handle<Entity> entity) const
+        {
+            const uint32_t index = FindIndex(entity);
+            return index != kInvalidDenseIndex ? &mComponents.Span()[index] : nullptr;
+        }
+
+        bool Contains(Handle<Entity> entity) const { return Find(entity) != nullptr; }
+
+        // Component version the entity's component was last written at, 0 if it has none
+        uint32_t GetVersion(Handle<Entity> entity) const
+        {
+            const uint32_t index = FindIndex(entity);
+            return index != kInvalidDenseIndex ? mVersions[index] : 0;
         }
 
+        // Newest version any component in the pool was written or removed at
+        virtual uint32_t GetVersion() const override
+        {
+            return mVersion.load(std::memory_order_relaxed);
+        }
+
+        // Stamps the entity's component with the current version, for writes that bypass
+        // Entity::Get and mutable queries
+        virtual void MarkChanged(Handle<Entity> entity) override
+        {
+            const uint32_t index = FindIndex(entity);
+            if (index != kInvalidDenseIndex)
+                SetVersion(index, GetComponentVersion());
+        }
+
+        // By component index, for Query
+        void SetVersion(uint32_t index, uint32_t version)
+        {
+            mVersions[index] = version;
+            RaiseVersion(version);
+        }
+
+        // Entity of each component, in the same order as Span()
+        const std::vector<Handle<Entity>>& GetOwners() const { return mOwners; }
+
         constexpr Span<TComp> Span() const
         {
             return mComponents.Span();
@@ -219,8 +305,12 @@ namespace nv::ecs
 
         virtual void RemoveEntity(Handle<Entity> entity) override
         {
-            auto handle = mEntityMap[entity.mHandle];
-            mEntityMap.erase(entity.mHandle);
+            auto it = mEntityMap.find(entity.mHandle);
+            if (it == mEntityMap.end())
+                return;
+
+            const Handle<TComp> handle = it->second;
+            mEntityMap.erase(it);
             Remove(handle.mHandle);
         }
 
@@ -234,6 +324,13 @@ namespace nv::ecs
             archive(GetComponentID<TComp>());
             archive(mComponents.Size());
             archive(binary_data(span.begin(), static_cast<std::size_t>(span.Size()) * sizeof(TComp)));
+
+            // The handles and owners too, the count may differ by the time the frame is restored
+            std::vector<Handle<TComp>> handles(mComponents.Size());
+            for (size_t i = 0; i < handles.size(); ++i)
+                handles[i] = mComponents.GetHandle(i);
+            archive(binary_data(handles.data(), handles.size() * sizeof(Handle<TComp>)));
+            archive(mEntityMap);
         }
 
         virtual void DeserializeForFrame(std::istream& istream) override
@@ -250,8 +347,13 @@ namespace nv::ecs
 
             void* buffer = Alloc(size * sizeof(TComp));
             archive(binary_data(buffer, static_cast<std::size_t>(size) * sizeof(TComp)));
-            mComponents.CopyToPool((TComp*)buffer, size);
+            std::vector<Handle<TComp>> handles(size);
+            archive(binary_data(handles.data(), handles.size() * sizeof(Handle<TComp>)));
+            mComponents.CopyToPool((TComp*)buffer, handles.data(), size);
             Free(buffer);
+
+            archive(mEntityMap);
+            RebuildOwners();
         }
 
         virtual void Serialize(std::ostream& ostream) override
@@ -269,23 +371,81 @@ namespace nv::ecs
             Serializer::Deserialize(mComponents, istream);
             cereal::BinaryInputArchive archive(istream);
             archive(mEntityMap);
+            RebuildOwners();
         }
 
         void GetEntityComponents(EntityComponents<TComp>& outEntityComponents) const
         {
-            for (auto e : mEntityMap)
+            nv::Span<TComp> span = mComponents.Span();
+            outEntityComponents.mEntities.Grow(mOwners.size());
+            outEntityComponents.mComponents.Grow(mOwners.size());
+            for (size_t i = 0; i < mOwners.size(); ++i)
             {
-                auto handle = Handle<Entity>{};
-                TComp* const pComp = (TComp * const)mComponents.GetAsDerived(e.second);
-                handle.mHandle = e.first;
-                outEntityComponents.mEntities.Push(handle);
-                outEntityComponents.mComponents.Push(pComp);
+                outEntityComponents.mEntities.Push(mOwners[i]);
+                outEntityComponents.mComponents.Push(&span[i]);
             }
         }
 
     private:
-        ContiguousPool<TComp>   mComponents;
+        static constexpr uint32_t kInvalidDenseIndex = ~0u;
+
+        uint32_t FindIndex(Handle<Entity> entity) const
+        {
+            if (entity.mIndex >= mDenseIndices.size())
+                return kInvalidDenseIndex;
+
+            const uint32_t index = mDenseIndices[entity.mIndex];
+            return index != kInvalidDenseIndex && mOwners[index] == entity ? index : kInvalidDenseIndex;
+        }
+
+        // Jobs of one level may race here, but they all store the same version
+        void RaiseVersion(uint32_t version)
+        {
+            if (mVersion.load(std::memory_order_relaxed) < version)
+                mVersion.store(version, std::memory_order_relaxed);
+        }
+
+        void SetDenseIndex(Handle<Entity> entity, uint32_t index)
+        {
+            if (entity.mIndex >= mDenseIndices.size())
+                mDenseIndices.resize(std::max<size_t>(entity.mIndex + 1, mDenseIndices.size() * 2), kInvalidDenseIndex);
+            mDenseIndices[entity.mIndex] = index;
+        }
+
+        void RebuildOwners()
+        {
+            mOwners.assign(mComponents.Size(), Handle<Entity>());
+            mDenseIndices.clear();
+
+            const TComp* pData = mComponents.Span().mData;
+            for (auto& [entityHandle, handle] : mEntityMap)
+            {
+                if (!mComponents.IsValid(handle))
+                    continue;
+
+                Handle<Entity> entity;
+                entity.mHandle = entityHandle;
+                const uint32_t index = (uint32_t)(mComponents.GetAsDerived(handle) - pData);
+                mOwners[index] = entity;
+                SetDenseIndex(entity, index);
+            }
+
+            const uint32_t version = GetComponentVersion();
+            mVersions.assign(mOwners.size(), version);
+            RaiseVersion(version);
+        }
+
+        // Reserved up front, so the TComp* handed out by Entity::Add survive the pool growing
+        using Storage = std::conditional_t<kComponentStorage<TComp> == ComponentStorage::SparseSet,
+            SparseSetPool<TComp, TComp, kPoolInitDefaultSize, PoolBackend::Virtual>,
+            ContiguousPool<TComp, TComp, kPoolInitDefaultSize, PoolBackend::Virtual>>;
+
+        Storage                 mComponents;
         EntityComponentMap      mEntityMap;
+        std::vector<Handle<Entity>> mOwners;        // By component index
+        std::vector<uint32_t>   mDenseIndices;      // Component index by entity index
+        std::vector<uint32_t>   mVersions;          // Write version by component index
+        std::atomic<uint32_t>   mVersion = 0;       // Newest of mVersions, or of a removal
 
         friend class ComponentManager;
     };
@@ -391,6 +551,7 @@ namespace nv::ecs
         template<typename TComp, typename ...Args>
         TComp* Add(Args&&... args)
         {
+            ValidateAccess<TComp>(ComponentAccess::Structural);
             auto compName = GetComponentName<TComp>();
             constexpr StringID compId = GetComponentID<TComp>();
             gComponentNames[std::string(compName)] = compId;
@@ -408,6 +569,7 @@ namespace nv::ecs
         template<typename TComp>
         void Remove()
         {
+            ValidateAccess<TComp>(ComponentAccess::Structural);
             auto compName = GetComponentName<TComp>();
             constexpr StringID compId = GetComponentID<TComp>();
             gComponentNames[std::string(compName)] = compId;
@@ -416,28 +578,38 @@ namespace nv::ecs
 
             ComponentPool<TComp>* pool = gComponentManager.GetPool<TComp>();
             pool->RemoveEntity(mHandle);
+            gComponentManager.GetEntityComponentMap(mHandle).erase(compId);
         }
 
         IComponent* Add(StringID compId);
 
         void AttachTransform(const Transform& transform = Transform());
-        TransformRef GetTransform() const;
+        Transform GetTransform() const;
+        TransformRef GetTransformMut() const;
 
         template<typename TComp>
-        TComp* Get() const
+        const TComp* Get() const
         {
-            constexpr StringID compId = GetComponentID<TComp>();
-            auto& compMap = gComponentManager.GetEntityComponentMap(mHandle);
-            auto comp = compMap.at(compId);
-            ComponentPool<TComp>* pool = gComponentManager.GetPool<TComp>();
-            return pool->GetComponent(comp)->As<TComp>();
+            ValidateAccess<TComp>(ComponentAccess::Read);
+            return Find<TComp>();
+        }
+
+        // Counted as a write by Changed<T> queries, whether or not anything is assigned
+        template<typename TComp>
+        TComp* GetMut() const
+        {
+            ValidateAccess<TComp>(ComponentAccess::Write);
+            gComponentManager.GetPool<TComp>()->MarkChanged(mHandle);
+            return Find<TComp>();
         }
 
-        IComponent* Get(StringID compId) const;
+        const IComponent* Get(StringID compId) const;
+        IComponent* GetMut(StringID compId) const;
 
         template<typename TComp>
         bool Has() const
         {
+            ValidateAccess<TComp>(ComponentAccess::Read);
             constexpr StringID compId = GetComponentID<TComp>();
             auto& compMap = gComponentManager.GetEntityComponentMap(mHandle);
             auto comp = compMap.find(compId);
@@ -451,6 +623,16 @@ namespace nv::ecs
         template<class Archive>
         void serialize(Archive& archive) { archive(mParent, mHandle); }
 
+    private:
+        template<typename TComp>
+        TComp* Find() const
+        {
+            constexpr StringID compId = GetComponentID<TComp>();
+            auto& compMap = gComponentManager.GetEntityComponentMap(mHandle);
+            auto comp = compMap.at(compId);
+            return gComponentManager.GetPool<TComp>()->GetComponent(comp)->As<TComp>();
+        }
+
     public:
         Handle<Entity> mParent;
         Handle<Entity> mHandle;
@@ -486,7 +668,7 @@ namespace nv::ecs
         }
 
     private:
-        Pool<Entity>            mEntities;
+        Pool<Entity, Entity, kPoolInitDefaultSize, PoolBackend::Virtual> mEntities;
         Handle<Entity>          mRoot;
 
         UnorderedMap<std::string, Handle<Entity>> mEntityNames;
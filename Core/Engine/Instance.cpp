@@ -12,6 +12,7 @@
 #include <Input/InputSystem.h>
 #include <Input/Input.h>
 #include <Debug/Profiler.h>
+#include <Memory/FrameAllocator.h>
 
 #include <thread>
 #include <mutex>
@@ -47,6 +48,7 @@ namespace nv
         {
             NV_FRAME_MARK();
             NV_FRAME("MainThread");
+            FrameAllocator::gPtr->BeginFrame();
             gTimer.Tick();
             {
                 NV_EVENT("App/Update");
@@ -1,56 +1,43 @@
 #pragma once
 
 #include <Lib/Vector.h>
-#include <atomic>
-#include <functional>
+#include <Lib/InlineFunction.h>
 
 namespace nv::jobs
 {
+    // Bytes of captured state a job can carry without allocating.
+    constexpr size_t kJobInlineStorageSize = 64;
+
+    enum class JobPriority : uint8_t
+    {
+        Critical,       // Frame critical, runs before any other queued work
+        Normal,
+        Background,     // Only picked up when workers have nothing else to do
+        LongRunning,    // Blocking or long lived (file IO, render thread, export), runs on its own threads
+    };
+
     class Job
     {
     public:
-        using Fn = std::function<void(void*)>;
-
-        Job(Fn func) :
-            mFunction(func),
-            mArgs(nullptr)
-        {}
+        using Fn = InlineFunction<void(void*), kJobInlineStorageSize>;
 
         Job(Fn&& func) :
             mFunction(std::move(func)),
             mArgs(nullptr)
         {}
 
-        Job(Fn func, void* args) :
-            mFunction(func),
+        Job(Fn&& func, void* args) :
+            mFunction(std::move(func)),
             mArgs(args)
         {}
 
-        Job(const Job& job)
-        {
-            mFunction = job.mFunction;
-            mArgs = job.mArgs;
-        }
-
         Job() :
             mFunction(nullptr),
             mArgs(nullptr)
         {}
 
-        Job& operator=(const Fn& fn)
-        {
-            mFunction = fn;
-            return *this;
-        }
-
-        Job& operator=(const Job& job)
-        {
-            mFunction = job.mFunction;
-            mArgs = job.mArgs;
-            mDependencies = job.mDependencies;
-            mIsFinished.store(job.mIsFinished);
-            return *this;
-        }
+        Job(Job&&) = default;
+        Job& operator=(Job&&) = default;
 
         void Invoke()
         {
@@ -58,14 +45,9 @@ namespace nv::jobs
                 mFunction(mArgs);
         }
 
-        bool IsFinished() const
+        void SetFunction(Fn&& fn)
         {
-            return mIsFinished.load();
-        }
-
-        void SetFunction(Fn fn)
-        {
-            mFunction = fn;
+            mFunction = std::move(fn);
         }
 
         constexpr void SetArgs(void* args)
@@ -78,12 +60,17 @@ namespace nv::jobs
             mDependencies = dependencies;
         }
 
+        constexpr void SetPriority(JobPriority priority)
+        {
+            mPriority = priority;
+        }
+
     protected:
-        Fn mFunction;
-        void* mArgs;
-        std::atomic<bool>   mIsFinished = false;
+        Fn                  mFunction;
+        void*               mArgs;
         Span<Handle<Job>>   mDependencies = {};
+        JobPriority         mPriority = JobPriority::Normal;
 
         friend class JobSystem;
     };
-}
\ No newline at end of file
+}
@@ -2,207 +2,859 @@
 
 #include <Engine/JobSystem.h>
 #include <Engine/Job.h>
+#include <Engine/Task.h>
 
-#include <Lib/Pool.h>
-#include <Lib/ConcurrentQueue.h>
+#include <Lib/MPMCQueue.h>
+#include <Lib/WorkStealingQueue.h>
 #include <Lib/Format.h>
 
 #include <Debug/Profiler.h>
 
-#include <Windows.h>
+#include <Platform/Fiber.h>
+#include <Platform/Thread.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if defined(_MSC_VER)
+#define NV_NOINLINE __declspec(noinline)
+#else
+#define NV_NOINLINE __attribute__((noinline))
+#endif
 
 namespace nv::jobs
 {
     IJobSystem* gJobSystem = nullptr;
 
-#if NV_PLATFORM_WINDOWS
-    static void SetThreadAffinity_Win32(const wchar_t* name, HANDLE handle, uint32_t coreIndex)
+    // Index of the worker owning the current thread, -1 for non worker threads.
+    static thread_local int32_t tlsWorkerIndex = -1;
+    static thread_local uint32_t tlsRandomState = 1;
+    static thread_local uint32_t tlsJobDepth = 0;
+
+    // A fiber can be resumed on another thread, and a thread local address the compiler
+    // cached across the switch would still point at the old one. Read them through these.
+    NV_NOINLINE static int32_t GetWorkerIndex() { return tlsWorkerIndex; }
+    NV_NOINLINE static uint32_t& GetRandomState() { return tlsRandomState; }
+
+    // Work stealing scheduler:
+    // Every worker owns a Chase-Lev deque. Jobs enqueued from a worker go to its
+    // own deque (LIFO, cache warm), jobs enqueued from any other thread go through
+    // the shared injection queue. Idle workers steal from random victims and park
+    // on a condition variable once they've spun for a while without finding work.
+    // Critical jobs go through a shared queue every worker checks first, background
+    // jobs through one checked only after stealing failed. Long running jobs never
+    // touch the workers, they run on a separate pool that grows when all of its
+    // threads are busy.
+    //
+    // Jobs live in a fixed array of slots that is never resized or locked. Free slot
+    // indices circulate through a lock-free ring, a slot goes back to it as soon as its
+    // job finishes. Handles carry the slot generation so stale handles read as finished.
+    //
+    // Fiber mode: workers run their loop on pooled fibers instead of their own stack.
+    // A job waiting on an unfinished handle parks its fiber, the worker carries on with
+    // a fresh one, and a critical continuation of the awaited job puts the parked fiber
+    // on the ready queue so any worker can resume it. When the pool runs dry, waits
+    // fall back to helping.
+    class JobSystem : public IJobSystem
     {
-        DWORD_PTR affinityMask = 1ull << coreIndex;
-        DWORD_PTR affinity_result = SetThreadAffinityMask(handle, affinityMask);
+        using JobQueue = WorkStealingQueue<Handle<Job>>;
+        using InjectionQueue = MPMCQueue<Handle<Job>, kMaxJobsInFlight>;
+        using FreeSlotQueue = MPMCQueue<uint32_t, kMaxJobsInFlight>;
 
-        HRESULT hr = SetThreadDescription(handle, name);
-        SetThreadPriority(handle, THREAD_PRIORITY_ABOVE_NORMAL);
-    }
-#endif
+        static constexpr uint32_t kSpinCountBeforePark = 64;
+        static constexpr uint32_t kMaxLongRunningThreads = 16;
 
-    class JobSystem : public IJobSystem
-    {
-    public:
-        JobSystem(uint32_t threadCount):
-            mThreadCount(threadCount),
-            mIsRunning(false),
-            mJobs(),
-            mQueue(),
-            mConditionVar(),
-            mMutex(),
-            mThreads(threadCount)
+        static constexpr uint32_t kMaxFibers = 512;
+        static constexpr size_t kFiberStackSize = 128 * 1024;
+
+        using FiberQueue = MPMCQueue<uint32_t, kMaxFibers>;
+
+        // Dependencies a job can wait on directly, wider fan-ins are folded into join jobs.
+        static constexpr uint32_t kMaxInlineDependencies = 4;
+
+        static constexpr uint32_t kSlotFree = 0;
+        static constexpr uint32_t kSlotActive = 1;
+
+        // Continuation list links: (slot index, edge index) + 1
+        static constexpr uint32_t kLinkEmpty = 0;
+        static constexpr uint32_t kLinkClosed = ~0u;
+
+        struct alignas(64) JobSlot
         {
-            mJobs.Init();
-        }
+            std::atomic<uint64_t>   mStamp = 0;                 // Generation << 32 | state
+            std::atomic<uint64_t>   mContinuations = 0;         // Generation << 32 | head link
+            std::atomic<uint32_t>   mPendingDependencies = 0;
+            uint32_t                mEdges[kMaxInlineDependencies] = {}; // Next links in the dependencies' continuation lists
+            JobPriority             mPriority = JobPriority::Normal;
+            void*                   mArgs = nullptr;
+            Job::Fn                 mFunction;
+        };
+
+        static_assert(sizeof(JobSlot) <= 128, "Keep job slots within two cache lines");
+
+        enum class FiberAction : uint8_t
+        {
+            None,
+            Release,    // Put the fiber we came from back in the pool
+            Wait,       // Resume the fiber we came from once mWaitHandle has finished
+        };
 
-        void Poll()
+        struct JobFiber
         {
-            mConditionVar.notify_one();
-            std::this_thread::yield();
-        }
+            platform::Fiber*    mpFiber = nullptr;
+            JobSystem*          mpJobSystem = nullptr;
+            uint32_t            mIndex = 0;
+        };
+
+        // Per worker thread, only touched by the thread currently holding that worker index
+        struct alignas(64) FiberWorker
+        {
+            platform::Fiber*    mpThreadFiber = nullptr;
+            JobFiber*           mpCurrent = nullptr;
+            FiberAction         mAction = FiberAction::None; // Left for whichever fiber runs next
+            JobFiber*           mpActionFiber = nullptr;
+            Handle<Job>         mWaitHandle;
+        };
+
+        static constexpr uint64_t MakeStamp(uint32_t generation, uint32_t value) { return ((uint64_t)generation << 32) | value; }
+        static constexpr uint32_t StampGeneration(uint64_t stamp) { return (uint32_t)(stamp >> 32); }
+        static constexpr uint32_t StampValue(uint64_t stamp) { return (uint32_t)stamp; }
+
+        static constexpr uint32_t MakeLink(uint32_t index, uint32_t edge) { return (index * kMaxInlineDependencies + edge) + 1; }
 
-        Handle<Job> AllocateJob(Job&& job)
+        static Handle<Job> MakeHandle(uint32_t index, uint32_t generation)
         {
-            std::unique_lock<NV_LOCKABLE(std::mutex)> lock(mJobPoolMutex);
-            Handle<Job> handle = mJobs.Create();
-            auto mInstance = mJobs.Get(handle);
-            *mInstance = std::move(job);
-            mCurrentJobs.push_back(handle);
+            Handle<Job> handle;
+            handle.mIndex = index;
+            handle.mGeneration = generation;
             return handle;
         }
 
-        void RemoveJob(Handle<Job> handle)
+    public:
+        JobSystem(uint32_t threadCount, const JobSystemDesc& desc):
+            mThreadCount(threadCount),
+            mPlacement(desc.mPlacement),
+            mbUseFibers(desc.mbUseFibers),
+            mIsRunning(false),
+            mSlots(std::make_unique<JobSlot[]>(kMaxJobsInFlight)),
+            mInjectionQueue(std::make_unique<InjectionQueue>()),
+            mCriticalQueue(std::make_unique<InjectionQueue>()),
+            mBackgroundQueue(std::make_unique<InjectionQueue>()),
+            mLongRunningQueue(std::make_unique<InjectionQueue>()),
+            mFreeSlots(std::make_unique<FreeSlotQueue>()),
+            mActiveJobs(0),
+            mQueuedJobs(0),
+            mSleepingWorkers(0),
+            mSleepCondVar(),
+            mSleepMutex(),
+            mThreads(threadCount),
+            mBusyLongRunningThreads(0)
         {
-            std::unique_lock<NV_LOCKABLE(std::mutex)> lock(mJobPoolMutex);
-            mJobs.Remove(handle);
+            mWorkerQueues.reserve(threadCount);
+            for (uint32_t i = 0; i < threadCount; ++i)
+                mWorkerQueues.emplace_back(std::make_unique<JobQueue>());
+
+            for (uint32_t i = 0; i < kMaxJobsInFlight; ++i)
+                ReleaseSlot(i);
         }
 
         void GarbageCollect() override
         {
-            std::unique_lock<NV_LOCKABLE(std::mutex)> lock(mJobPoolMutex);
-            auto it = mCurrentJobs.begin();
-            while (it != mCurrentJobs.end())
-            {
-                auto* pJob = mJobs.Get(*it);
-                if (!pJob || pJob->IsFinished())
-                {
-                    mJobs.Remove(*it);
-                    it = mCurrentJobs.erase(it);
-                }
-                else
-                    ++it;
-            }
+            // Nothing to do, slots are recycled as soon as their job finishes.
         }
 
         virtual Handle<Job> Enqueue(Job&& job) override
         {
-            Handle<Job> handle = AllocateJob(std::move(job));
-            mQueue.Push(handle);
-            mConditionVar.notify_one();
+            Handle<Job> dependencies[kMaxInlineDependencies];
+            const uint32_t dependencyCount = GatherDependencies(job.mDependencies, dependencies);
+
+            const uint32_t index = AllocateSlot();
+            if (job.mPriority == JobPriority::LongRunning)
+                mActiveJobs.fetch_sub(1, std::memory_order_seq_cst); // May never finish, Wait() doesn't cover them
+
+            JobSlot& slot = mSlots[index];
+            const uint32_t generation = StampGeneration(slot.mStamp.load(std::memory_order_relaxed));
+
+            slot.mFunction = std::move(job.mFunction);
+            slot.mArgs = job.mArgs;
+            slot.mPriority = job.mPriority;
+            slot.mPendingDependencies.store(dependencyCount + 1, std::memory_order_relaxed); // +1 until registration is done
+            slot.mContinuations.store(MakeStamp(generation, kLinkEmpty), std::memory_order_release);
+
+            // Finished or recycled dependencies count as satisfied
+            uint32_t satisfied = 1;
+            for (uint32_t i = 0; i < dependencyCount; ++i)
+            {
+                if (!AddContinuation(dependencies[i], index, i))
+                    satisfied++;
+            }
+
+            const Handle<Job> handle = MakeHandle(index, generation);
+            if (slot.mPendingDependencies.fetch_sub(satisfied, std::memory_order_acq_rel) == satisfied)
+                PushReady(handle, job.mPriority);
+
             return handle;
         }
 
         virtual void Wait(Handle<Job> handle) override
         {
-            if (!mJobs.IsValid(handle)) 
+            if (mbUseFibers && SuspendUntilFinished(handle))
                 return;
 
-            auto job = mJobs.GetAsDerived(handle);
-            while (!job->IsFinished())
+            // Workers help instead of blocking so nested fork/join can't run out of threads.
+            // The own deque is popped first, which is where the awaited children usually are.
+            while (!IsFinished(handle))
             {
-                Poll();
+                const int32_t workerIndex = GetWorkerIndex(); // Changes if a helped job suspends
+                Handle<Job> pending;
+                if (workerIndex >= 0 && TryGetJob(workerIndex, pending))
+                    RunJob(pending);
+                else
+                    std::this_thread::yield();
             }
         }
 
         virtual void Wait() override
         {
-            while (!mQueue.IsEmpty())
+            assert(GetWorkerIndex() < 0); // Would wait on the calling job itself
+            while (mActiveJobs.load(std::memory_order_acquire) > 0)
             {
-                Poll();
+                std::this_thread::yield();
             }
+        }
+
+        virtual bool RunPendingJob() override
+        {
+            Handle<Job> handle;
+            if (!TryGetJob(GetWorkerIndex(), handle))
+                return false;
 
-            mJobs.Destroy();
+            RunJob(handle);
+            return true;
         }
 
-        virtual bool IsFinished(Handle<Job> handle) override
+        virtual uint32_t GetWorkerCount() const override
         {
-            const bool bIsValid = mJobs.IsValid(handle);
-            if (!bIsValid)
-                return true;
+            return mThreadCount;
+        }
 
-            const Job* const pJob = mJobs.GetAsDerived(handle);
-            if (!pJob || pJob->IsFinished())
+        virtual bool IsFinished(Handle<Job> handle) override
+        {
+            if (handle.IsNull() || handle.mIndex >= kMaxJobsInFlight)
                 return true;
 
-            return false;
+            const uint64_t stamp = mSlots[handle.mIndex].mStamp.load(std::memory_order_acquire);
+            return StampGeneration(stamp) != handle.mGeneration || StampValue(stamp) == kSlotFree;
         }
 
         void Stop()
         {
-            mIsRunning = false;
-            mConditionVar.notify_all(); // Unblock all threads and stop
+            {
+                std::unique_lock<std::mutex> lock(mSleepMutex);
+                std::unique_lock<std::mutex> longRunningLock(mLongRunningMutex);
+                mIsRunning = false;
+            }
+            mSleepCondVar.notify_all(); // Unblock all threads and stop
+            mLongRunningCondVar.notify_all();
         }
 
         void Start()
         {
-            SetThreadAffinity_Win32(L"NVMainThread", GetCurrentThread(), 0);
+            const auto& topology = platform::GetCpuTopology();
+            mWorkerCores = platform::GetThreadPlacement(topology, mPlacement);
+
+            platform::SetCurrentThreadName("NVMainThread"); // Not pinned, ReserveCoreZero only keeps the workers off its core
+
             mIsRunning = true;
 
-            auto worker = [&]()
+            if (mbUseFibers)
+                InitFibers();
+
+            auto worker = [&](uint32_t workerIndex)
             {
-                const auto threadId = std::hash<std::jthread::id>{}(std::this_thread::get_id());
-                const auto jobThreadName = nv::Format("NovaWorker-{:x}", threadId);
+                tlsWorkerIndex = (int32_t)workerIndex;
+                tlsRandomState = workerIndex * 0x9E3779B9u + 1;
+                const auto jobThreadName = nv::Format("NovaWorker-{}", workerIndex);
                 NV_THREAD(jobThreadName.c_str());
+
+                platform::SetCurrentThreadName(jobThreadName.c_str());
+                if (!mWorkerCores.empty())
+                    platform::SetCurrentThreadAffinity(mWorkerCores[workerIndex % mWorkerCores.size()]);
+                platform::RaiseCurrentThreadPriority();
+
+                if (mbUseFibers)
+                {
+                    // The loop runs on pooled fibers, we're only back here once stopped
+                    FiberWorker& fiberWorker = mFiberWorkers[workerIndex];
+                    fiberWorker.mpThreadFiber = platform::ConvertThreadToFiber();
+                    platform::SwitchFiber(fiberWorker.mpThreadFiber, fiberWorker.mpCurrent->mpFiber);
+
+                    platform::ConvertFiberToThread(fiberWorker.mpThreadFiber);
+                    fiberWorker.mpThreadFiber = nullptr;
+                    tlsWorkerIndex = -1;
+                    return;
+                }
+
+                uint32_t spinCount = 0;
+
                 while (mIsRunning)
                 {
-                    NV_FRAME("NovaJobThread");
+                    Handle<Job> handle;
+                    if (TryGetJob((int32_t)workerIndex, handle))
                     {
-                        NV_EVENT("JobSys/WaitForNewJob");
-                        std::unique_lock<std::mutex> lock(mMutex);
-                        if (!mIsRunning)
-                            break;
-
-                        mConditionVar.wait(lock, [&]
-                            {
-                                return !mIsRunning || !mQueue.IsEmpty(); // TODO: Condition may not be needed as Execute() notifies this wait() anyway?
-                            });
+                        NV_FRAME("NovaJobThread");
+                        RunJob(handle);
+                        spinCount = 0;
+                        continue;
                     }
 
-                    while (!mQueue.IsEmpty())
+                    if (++spinCount < kSpinCountBeforePark)
                     {
-                        auto jobHandle = mQueue.Pop();
-                        auto job = mJobs.Get(jobHandle);
-                        if (job)
-                        {
-                            job->Invoke();
-                            job->mIsFinished.store(true);
-                        }
+                        std::this_thread::yield();
+                        continue;
                     }
+
+                    NV_EVENT("JobSys/WaitForNewJob");
+                    Park();
+                    spinCount = 0;
                 }
+
+                tlsWorkerIndex = -1;
             };
 
             for (uint32_t i = 0; i < mThreadCount; ++i)
-            {
-                mThreads[i] = std::jthread(worker);
-
-#ifdef _WIN32 // Credits: https://wickedengine.net/2018/11/24/simple-job-system-using-standard-c/#comments
-                // Do Windows-specific thread setup:
-                HANDLE handle = (HANDLE)mThreads[i].native_handle();
-                SetThreadAffinity_Win32(L"Nova-Worker", handle, i);
-#endif // _WIN32
-            }
+                mThreads[i] = std::jthread(worker, i);
         }
 
         ~JobSystem()
         {
             Stop();
-            Wait();
             for (auto& thread : mThreads)
-                thread.join();
-            mJobs.Destroy();
+            {
+                if (thread.joinable())
+                    thread.join();
+            }
+
+            // No new long running threads get spawned once stopped
+            for (auto& thread : mLongRunningThreads)
+            {
+                if (thread.joinable())
+                    thread.join();
+            }
+
+            if (mFibers)
+            {
+                for (uint32_t i = 0; i < kMaxFibers; ++i)
+                    platform::DestroyFiber(mFibers[i].mpFiber);
+            }
+        }
+
+    private:
+        uint32_t AllocateSlot()
+        {
+            uint32_t index = 0;
+            while (!mFreeSlots->TryPop(index))
+            {
+                // Every slot is in flight, help drain the ring or back off
+                NV_EVENT("JobSys/RingFull");
+                Handle<Job> handle;
+                const int32_t workerIndex = GetWorkerIndex();
+                if (workerIndex >= 0 && TryGetJob(workerIndex, handle))
+                    RunJob(handle);
+                else
+                    std::this_thread::yield();
+            }
+
+            JobSlot& slot = mSlots[index];
+            uint32_t generation = StampGeneration(slot.mStamp.load(std::memory_order_relaxed)) + 1;
+            if (generation == 0)
+                generation = 1; // 0 is the null handle
+
+            slot.mStamp.store(MakeStamp(generation, kSlotActive), std::memory_order_release);
+            mActiveJobs.fetch_add(1, std::memory_order_seq_cst);
+            return index;
+        }
+
+        void ReleaseSlot(uint32_t index)
+        {
+            // Can only fail for a moment while a consumer is halfway through popping
+            // the cell we need, there's always room for every slot.
+            while (!mFreeSlots->TryPush(index))
+                std::this_thread::yield();
+        }
+
+        uint32_t GatherDependencies(Span<Handle<Job>> dependencies, Handle<Job> (&outDependencies)[kMaxInlineDependencies])
+        {
+            if (dependencies.Size() <= kMaxInlineDependencies)
+            {
+                for (size_t i = 0; i < dependencies.Size(); ++i)
+                    outDependencies[i] = dependencies[i];
+                return (uint32_t)dependencies.Size();
+            }
+
+            // Split into kMaxInlineDependencies groups, each one joined by an empty job
+            const size_t groupSize = (dependencies.Size() + kMaxInlineDependencies - 1) / kMaxInlineDependencies;
+            uint32_t count = 0;
+            for (size_t start = 0; start < dependencies.Size(); start += groupSize)
+            {
+                const size_t end = std::min(start + groupSize, dependencies.Size());
+                Span<Handle<Job>> group = dependencies.Slice(start, end);
+                if (group.Size() == 1)
+                {
+                    outDependencies[count++] = group[0];
+                    continue;
+                }
+
+                Job join;
+                join.SetDependences(group);
+                outDependencies[count++] = Enqueue(std::move(join));
+            }
+
+            return count;
+        }
+
+        // Pushes an edge of the job in slot 'index' onto the dependency's continuation list.
+        // Returns false if the dependency has already finished.
+        bool AddContinuation(Handle<Job> dependency, uint32_t index, uint32_t edge)
+        {
+            if (dependency.IsNull() || dependency.mIndex >= kMaxJobsInFlight)
+                return false;
+
+            JobSlot& dependencySlot = mSlots[dependency.mIndex];
+            JobSlot& slot = mSlots[index];
+            const uint64_t newHead = MakeStamp(dependency.mGeneration, MakeLink(index, edge));
+
+            // The generation in the head stops us from linking into a recycled slot
+            uint64_t head = dependencySlot.mContinuations.load(std::memory_order_acquire);
+            while (StampGeneration(head) == dependency.mGeneration && StampValue(head) != kLinkClosed)
+            {
+                slot.mEdges[edge] = StampValue(head);
+                if (dependencySlot.mContinuations.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_acquire))
+                    return true;
+            }
+
+            return false;
+        }
+
+        // workerIndex is -1 when called from a non worker thread, which can only steal
+        bool TryGetJob(int32_t workerIndex, Handle<Job>& outHandle)
+        {
+            bool bFound = mCriticalQueue->TryPop(outHandle);
+
+            if (!bFound && workerIndex >= 0)
+                bFound = mWorkerQueues[workerIndex]->Pop(outHandle);
+
+            if (!bFound)
+                bFound = mInjectionQueue->TryPop(outHandle);
+
+            // Random victim, then sweep the rest so a single busy worker is always found
+            uint32_t& randomState = GetRandomState();
+            for (uint32_t i = 0; !bFound && i < mThreadCount; ++i)
+            {
+                randomState ^= randomState << 13;
+                randomState ^= randomState >> 17;
+                randomState ^= randomState << 5;
+                const uint32_t victim = (randomState + i) % mThreadCount;
+                if ((int32_t)victim == workerIndex)
+                    continue;
+
+                bFound = mWorkerQueues[victim]->Steal(outHandle);
+            }
+
+            if (!bFound)
+                bFound = mBackgroundQueue->TryPop(outHandle);
+
+            if (bFound)
+                mQueuedJobs.fetch_sub(1, std::memory_order_seq_cst);
+
+            return bFound;
+        }
+
+        void RunJob(Handle<Job> handle)
+        {
+            JobSlot& slot = mSlots[handle.mIndex];
+            if (slot.mFunction)
+            {
+                ++tlsJobDepth;
+                slot.mFunction(slot.mArgs);
+                --tlsJobDepth;
+            }
+            slot.mFunction.Reset();
+            const bool bCounted = slot.mPriority != JobPriority::LongRunning;
+
+            // Close the continuation list so late dependents see this job as done,
+            // then hand the slot back before waking them up
+            const uint64_t head = slot.mContinuations.exchange(MakeStamp(handle.mGeneration, kLinkClosed), std::memory_order_acq_rel);
+            slot.mStamp.store(MakeStamp(handle.mGeneration, kSlotFree), std::memory_order_release);
+            ReleaseSlot(handle.mIndex);
+
+            uint32_t link = StampValue(head);
+            while (link != kLinkEmpty)
+            {
+                const uint32_t continuationIndex = (link - 1) / kMaxInlineDependencies;
+                const uint32_t edge = (link - 1) % kMaxInlineDependencies;
+                JobSlot& continuation = mSlots[continuationIndex];
+
+                // Read everything we need before the continuation can run and recycle its slot
+                link = continuation.mEdges[edge];
+                const uint32_t generation = StampGeneration(continuation.mStamp.load(std::memory_order_relaxed));
+
+                const JobPriority priority = continuation.mPriority;
+
+                if (continuation.mPendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    PushReady(MakeHandle(continuationIndex, generation), priority);
+            }
+
+            if (bCounted)
+                mActiveJobs.fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+        void PushReady(Handle<Job> handle, JobPriority priority)
+        {
+            if (priority == JobPriority::LongRunning)
+            {
+                PushLongRunning(handle);
+                return;
+            }
+
+            mQueuedJobs.fetch_add(1, std::memory_order_seq_cst);
+
+            const int32_t workerIndex = GetWorkerIndex();
+            if (priority == JobPriority::Critical)
+                PushShared(*mCriticalQueue, handle);
+            else if (priority == JobPriority::Background)
+                PushShared(*mBackgroundQueue, handle);
+            else if (workerIndex < 0 || !mWorkerQueues[workerIndex]->Push(handle))
+                PushShared(*mInjectionQueue, handle);
+
+            WakeWorker();
+        }
+
+        void PushShared(InjectionQueue& queue, Handle<Job> handle)
+        {
+            // Holds as many entries as there are slots, so this can't stay full
+            while (!queue.TryPush(handle))
+                std::this_thread::yield();
+        }
+
+        void PushLongRunning(Handle<Job> handle)
+        {
+            PushShared(*mLongRunningQueue, handle);
+
+            std::unique_lock<std::mutex> lock(mLongRunningMutex);
+            const size_t idleThreads = mLongRunningThreads.size() - mBusyLongRunningThreads;
+            if (idleThreads < mLongRunningQueue->Size() && mLongRunningThreads.size() < kMaxLongRunningThreads && mIsRunning)
+            {
+                const uint32_t threadIndex = (uint32_t)mLongRunningThreads.size();
+                mLongRunningThreads.emplace_back([this, threadIndex]() { LongRunningThread(threadIndex); });
+            }
+            else
+                mLongRunningCondVar.notify_one();
+        }
+
+        void LongRunningThread(uint32_t threadIndex)
+        {
+            const auto threadName = nv::Format("NovaLongRun-{}", threadIndex);
+            NV_THREAD(threadName.c_str());
+            platform::SetCurrentThreadName(threadName.c_str());
+
+            std::unique_lock<std::mutex> lock(mLongRunningMutex);
+            while (true)
+            {
+                // Pops only happen under the lock, pushes check the idle count under it
+                Handle<Job> handle;
+                if (mLongRunningQueue->TryPop(handle))
+                {
+                    mBusyLongRunningThreads++;
+                    lock.unlock();
+                    RunJob(handle);
+                    lock.lock();
+                    mBusyLongRunningThreads--;
+                    continue;
+                }
+
+                if (!mIsRunning)
+                    break;
+
+                mLongRunningCondVar.wait(lock);
+            }
+        }
+
+        void Park()
+        {
+            std::unique_lock<std::mutex> lock(mSleepMutex);
+            mSleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+            mSleepCondVar.wait(lock, [&]
+                {
+                    return !mIsRunning || mQueuedJobs.load(std::memory_order_seq_cst) > 0;
+                });
+            mSleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void WakeWorker()
+        {
+            // mQueuedJobs is incremented before this check, and a parking worker
+            // registers itself before checking mQueuedJobs, so a wake up can't be lost.
+            if (mSleepingWorkers.load(std::memory_order_seq_cst) > 0)
+            {
+                std::unique_lock<std::mutex> lock(mSleepMutex);
+                mSleepCondVar.notify_one();
+            }
+        }
+
+        void InitFibers()
+        {
+            // Leave at least as many fibers for suspended jobs as there are workers
+            if (mThreadCount * 2 > kMaxFibers || !mFiberStacks.Init(kMaxFibers, kFiberStackSize))
+            {
+                mbUseFibers = false;
+                return;
+            }
+
+            mFibers = std::make_unique<JobFiber[]>(kMaxFibers);
+            mFreeFibers = std::make_unique<FiberQueue>();
+            mReadyFibers = std::make_unique<FiberQueue>();
+            mFiberWorkers = std::vector<FiberWorker>(mThreadCount);
+
+            for (uint32_t i = 0; i < kMaxFibers; ++i)
+            {
+                JobFiber& fiber = mFibers[i];
+                fiber.mpJobSystem = this;
+                fiber.mIndex = i;
+                fiber.mpFiber = platform::CreateFiber(mFiberStacks.GetStack(i), mFiberStacks.GetStackSize(), FiberMain, &fiber);
+
+                // The first ones are where the workers start, the pool can be drained before they do
+                if (i < mThreadCount)
+                    mFiberWorkers[i].mpCurrent = &fiber;
+                else
+                    ReleaseFiber(&fiber);
+            }
+        }
+
+        static void FiberMain(void* pUserData)
+        {
+            JobFiber* pFiber = (JobFiber*)pUserData;
+            pFiber->mpJobSystem->FiberLoop(pFiber);
+        }
+
+        // Worker loop in fiber mode. Every switch can land us on another thread, so
+        // anything thread specific is looked up again through the NV_NOINLINE helpers.
+        void FiberLoop(JobFiber* pSelf)
+        {
+            for (;;)
+            {
+                CompleteFiberSwitch();
+
+                uint32_t spinCount = 0;
+                while (mIsRunning)
+                {
+                    if (JobFiber* pReady = PopReadyFiber())
+                    {
+                        // The resumed fiber puts this one back in the pool
+                        SwitchToFiber(pSelf, pReady, FiberAction::Release);
+                        CompleteFiberSwitch();
+                        spinCount = 0;
+                        continue;
+                    }
+
+                    if (RunNextJob())
+                    {
+                        spinCount = 0;
+                        continue;
+                    }
+
+                    if (++spinCount < kSpinCountBeforePark)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    NV_EVENT("JobSys/WaitForNewJob");
+                    Park();
+                    spinCount = 0;
+                }
+
+                SwitchToThreadFiber(pSelf);
+            }
+        }
+
+        NV_NOINLINE bool RunNextJob()
+        {
+            Handle<Job> handle;
+            if (!TryGetJob(GetWorkerIndex(), handle))
+                return false;
+
+            NV_FRAME("NovaJobThread");
+            RunJob(handle);
+            return true;
+        }
+
+        // Returns false if the calling job can't be suspended, the caller helps instead
+        NV_NOINLINE bool SuspendUntilFinished(Handle<Job> handle)
+        {
+            const int32_t workerIndex = GetWorkerIndex();
+            if (workerIndex < 0)
+                return false;
+
+            JobFiber* pSelf = mFiberWorkers[workerIndex].mpCurrent;
+            if (!pSelf)
+                return false;
+
+            if (IsFinished(handle))
+                return true;
+
+            // Usually the awaited job is the child we just pushed. Running it here costs
+            // no more stack than a plain call and saves two switches.
+            Handle<Job> top;
+            if (mWorkerQueues[workerIndex]->Pop(top))
+            {
+                if (top == handle)
+                {
+                    mQueuedJobs.fetch_sub(1, std::memory_order_seq_cst);
+                    RunJob(top);
+                    if (IsFinished(handle))
+                        return true;
+                }
+                else
+                    mWorkerQueues[workerIndex]->Push(top); // Only the owner pushes, there's room for it
+            }
+
+            JobFiber* pNext = AcquireFiber();
+            if (!pNext)
+                return false;
+
+            NV_EVENT("JobSys/SuspendFiber");
+            SwitchToFiber(pSelf, pNext, FiberAction::Wait, handle);
+            CompleteFiberSwitch();
+            return true;
+        }
+
+        NV_NOINLINE void SwitchToFiber(JobFiber* pSelf, JobFiber* pNext, FiberAction action, Handle<Job> waitHandle = {})
+        {
+            FiberWorker& worker = mFiberWorkers[GetWorkerIndex()];
+            worker.mAction = action;
+            worker.mpActionFiber = pSelf;
+            worker.mWaitHandle = waitHandle;
+            worker.mpCurrent = pNext;
+            platform::SwitchFiber(pSelf->mpFiber, pNext->mpFiber);
+        }
+
+        NV_NOINLINE void SwitchToThreadFiber(JobFiber* pSelf)
+        {
+            FiberWorker& worker = mFiberWorkers[GetWorkerIndex()];
+            worker.mpCurrent = nullptr;
+            platform::SwitchFiber(pSelf->mpFiber, worker.mpThreadFiber);
+        }
+
+        // Runs on the fiber we switched to, the one we came from is fully suspended by now
+        NV_NOINLINE void CompleteFiberSwitch()
+        {
+            FiberWorker& worker = mFiberWorkers[GetWorkerIndex()];
+            const FiberAction action = worker.mAction;
+            JobFiber* pFiber = worker.mpActionFiber;
+            Handle<Job> waitHandle = worker.mWaitHandle;
+            worker.mAction = FiberAction::None;
+
+            if (action == FiberAction::Release)
+                ReleaseFiber(pFiber);
+            else if (action == FiberAction::Wait)
+            {
+                Job resume([this, pFiber](void*) { PushReadyFiber(pFiber); });
+                resume.SetDependences(Span<Handle<Job>>(&waitHandle, 1));
+                resume.SetPriority(JobPriority::Critical);
+                Enqueue(std::move(resume));
+            }
+        }
+
+        JobFiber* AcquireFiber()
+        {
+            uint32_t index = 0;
+            return mFreeFibers->TryPop(index) ? &mFibers[index] : nullptr;
+        }
+
+        void ReleaseFiber(JobFiber* pFiber)
+        {
+            while (!mFreeFibers->TryPush(pFiber->mIndex))
+                std::this_thread::yield();
+        }
+
+        void PushReadyFiber(JobFiber* pFiber)
+        {
+            mQueuedJobs.fetch_add(1, std::memory_order_seq_cst);
+            while (!mReadyFibers->TryPush(pFiber->mIndex))
+                std::this_thread::yield();
+
+            WakeWorker();
+        }
+
+        JobFiber* PopReadyFiber()
+        {
+            uint32_t index = 0;
+            if (!mReadyFibers->TryPop(index))
+                return nullptr;
+
+            mQueuedJobs.fetch_sub(1, std::memory_order_seq_cst);
+            return &mFibers[index];
         }
 
     private:
+        // Over-aligned, let aligned new handle these
+        using JobQueuePtr = std::unique_ptr<JobQueue>;
+        using JobSlotArray = std::unique_ptr<JobSlot[]>;
+        using InjectionQueuePtr = std::unique_ptr<InjectionQueue>;
+        using FreeSlotQueuePtr = std::unique_ptr<FreeSlotQueue>;
+        using FiberQueuePtr = std::unique_ptr<FiberQueue>;
+        using JobFiberArray = std::unique_ptr<JobFiber[]>;
+
         uint32_t                        mThreadCount;
+        platform::ThreadPlacement       mPlacement;
+        bool                            mbUseFibers;
+        std::vector<platform::LogicalCore> mWorkerCores; // Worker i runs on mWorkerCores[i % size], empty when unpinned
         std::atomic_bool                mIsRunning;
-        Pool<Job>                       mJobs;
-        ConcurrentQueue<Handle<Job>>    mQueue;
-        std::condition_variable         mConditionVar;
-        std::mutex                      mMutex;
-        NV_MUTEX(std::mutex,            mJobPoolMutex);
+        JobSlotArray                    mSlots;
+        std::vector<JobQueuePtr>        mWorkerQueues;
+        InjectionQueuePtr               mInjectionQueue;
+        InjectionQueuePtr               mCriticalQueue;
+        InjectionQueuePtr               mBackgroundQueue;
+        InjectionQueuePtr               mLongRunningQueue;
+        FreeSlotQueuePtr                mFreeSlots;
+        std::atomic<int64_t>            mActiveJobs; // Allocated and not finished, includes held jobs but not long running ones
+        std::atomic<int64_t>            mQueuedJobs;
+        std::atomic<uint32_t>           mSleepingWorkers;
+        std::condition_variable         mSleepCondVar;
+        std::mutex                      mSleepMutex;
         std::vector<std::jthread>       mThreads;
-        std::vector<Handle<Job>>        mCurrentJobs;
+        std::vector<std::jthread>       mLongRunningThreads;
+        std::condition_variable         mLongRunningCondVar;
+        std::mutex                      mLongRunningMutex;
+        size_t                          mBusyLongRunningThreads;
+        platform::FiberStackPool        mFiberStacks;
+        JobFiberArray                   mFibers;
+        FiberQueuePtr                   mFreeFibers;
+        FiberQueuePtr                   mReadyFibers; // Suspended fibers whose wait is over
+        std::vector<FiberWorker>        mFiberWorkers;
     };
 
     void InitJobSystem(uint32_t threads)
     {
-        gJobSystem = Alloc<JobSystem>(SystemAllocator::gPtr, threads);
+        InitJobSystem(JobSystemDesc{ .mWorkerCount = threads });
+    }
+
+    void InitJobSystem(const JobSystemDesc& desc)
+    {
+        uint32_t threads = desc.mWorkerCount;
+        if (threads == 0)
+        {
+            // One worker per core the placement leaves us, the main thread keeps its own core
+            const auto& topology = platform::GetCpuTopology();
+            if (desc.mPlacement == platform::ThreadPlacement::ReserveCoreZero)
+                threads = (uint32_t)platform::GetThreadPlacement(topology, desc.mPlacement).size();
+            else
+                threads = (uint32_t)topology.mLogicalCores.size() - 1;
+        }
+
+        gJobSystem = Alloc<JobSystem>(SystemAllocator::gPtr, std::max(threads, 1u), desc);
         auto jobSystem = (JobSystem*)gJobSystem;
         jobSystem->Start();
     }
@@ -212,11 +864,13 @@ namespace nv::jobs
         auto jobSystem = (JobSystem*)gJobSystem;
         jobSystem->Stop();
         Free<JobSystem>(jobSystem);
+        gJobSystem = nullptr;
+        ReleaseTaskFramePool(); // No job is left to resume a task
     }
 
     Handle<Job> Execute(Job::Fn&& job)
     {
-        return gJobSystem->Enqueue(job);
+        return gJobSystem->Enqueue(std::move(job));
     }
 
     Handle<Job> Execute(Job::Fn&& job, void* context)
@@ -225,6 +879,21 @@ namespace nv::jobs
         return gJobSystem->Enqueue(std::move(j));
     }
 
+    Handle<Job> Execute(Job::Fn&& job, JobPriority priority, void* context)
+    {
+        Job j(std::move(job), context);
+        j.SetPriority(priority);
+        return gJobSystem->Enqueue(std::move(j));
+    }
+
+    Handle<Job> Execute(Job::Fn&& job, Span<Handle<Job>> dependencies, void* context, JobPriority priority)
+    {
+        Job j(std::move(job), context);
+        j.SetDependences(dependencies);
+        j.SetPriority(priority);
+        return gJobSystem->Enqueue(std::move(j));
+    }
+
     void Wait(Handle<Job> handle)
     {
         if(handle.IsNull())
@@ -243,8 +912,71 @@ namespace nv::jobs
         return gJobSystem->IsFinished(handle);
     }
 
+    bool RunPendingJob()
+    {
+        return gJobSystem->RunPendingJob();
+    }
+
+    uint32_t GetWorkerCount()
+    {
+        return gJobSystem->GetWorkerCount();
+    }
+
+    uint32_t GetJobDepth()
+    {
+        return tlsJobDepth;
+    }
+
     void GarbageCollect()
     {
         gJobSystem->GarbageCollect();
     }
-}
\ No newline at end of file
+
+    JobGraph::Node JobGraph::Add(Job::Fn&& job, std::initializer_list<Node> dependencies, void* context)
+    {
+        const Node node = (Node)mNodes.size();
+        NodeDesc& desc = mNodes.emplace_back();
+        desc.mFunction = std::move(job);
+        desc.mContext = context;
+        for (Node dependency : dependencies)
+            AddDependency(node, dependency);
+
+        return node;
+    }
+
+    void JobGraph::AddDependency(Node node, Node dependency)
+    {
+        assert(dependency < node); // Dependencies must be added first
+        mNodes[node].mDependencies.push_back(dependency);
+    }
+
+    Handle<Job> JobGraph::Submit()
+    {
+        assert(!mbSubmitted); // The functions are gone, it would run empty jobs
+        mbSubmitted = true;
+
+        mHandles.clear();
+        mHandles.reserve(mNodes.size());
+
+        std::vector<Handle<Job>> dependencies;
+        for (NodeDesc& node : mNodes)
+        {
+            dependencies.clear();
+            for (Node dependency : node.mDependencies)
+                dependencies.push_back(mHandles[dependency]);
+
+            Span<Handle<Job>> span = { dependencies.data(), dependencies.size() };
+            mHandles.push_back(Execute(std::move(node.mFunction), span, node.mContext));
+        }
+
+        Span<Handle<Job>> all = { mHandles.data(), mHandles.size() };
+        return Execute([](void*) {}, all);
+    }
+
+    void JobGraph::Clear()
+    {
+        mNodes.clear();
+        mHandles.clear();
+        mbSubmitted = false;
+    }
+}
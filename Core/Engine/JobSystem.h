@@ -2,11 +2,20 @@
 
 #include <Lib/Vector.h>
 #include <Engine/Job.h>
+#include <Platform/Thread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 namespace nv::jobs
 {
     class Job;
 
+    // Size of the job ring. Submitting while this many jobs are unfinished
+    // blocks until slots free up (workers run queued jobs meanwhile).
+    constexpr uint32_t kMaxJobsInFlight = 16384;
+
     class IJobSystem
     {
     public:
@@ -15,23 +24,200 @@ namespace nv::jobs
         virtual void        Wait() = 0;
         virtual bool        IsFinished(Handle<Job> job) = 0;
         virtual void        GarbageCollect() = 0;
+        virtual bool        RunPendingJob() = 0;
+        virtual uint32_t    GetWorkerCount() const = 0;
 
         virtual ~IJobSystem() {}
     };
 
     extern IJobSystem* gJobSystem;
 
+    struct JobSystemDesc
+    {
+        uint32_t                    mWorkerCount = 0; // 0: one worker per core the placement leaves free
+        platform::ThreadPlacement   mPlacement = platform::ThreadPlacement::ReserveCoreZero;
+        bool                        mbUseFibers = false; // Run jobs on pooled fibers so waiting in a job suspends it instead of nesting
+    };
+
     void InitJobSystem(uint32_t threads);
+    void InitJobSystem(const JobSystemDesc& desc);
     void DestroyJobSystem();
     void GarbageCollect();
 
     Handle<Job> Execute(Job::Fn&& job);
     Handle<Job> Execute(Job::Fn&& job, void* context);
+    Handle<Job> Execute(Job::Fn&& job, JobPriority priority, void* context = nullptr);
 
-    // Note: Only wait from the main thread. Waiting from within 
-    // a job or worker thread will deadlock the job system. 
+    // Job is held by the scheduler until all dependencies have finished.
+    Handle<Job> Execute(Job::Fn&& job, Span<Handle<Job>> dependencies, void* context = nullptr, JobPriority priority = JobPriority::Normal);
+
+    // Waiting on a handle from a job is fine: the worker keeps running other
+    // queued jobs (its own children first) until the handle has finished.
+    // With fibers enabled the waiting job is suspended instead and resumed,
+    // possibly on another worker, once the handle finishes.
+    // Other threads just yield until then.
     void        Wait(Handle<Job> handle);
+
+    // Waits for every job in flight except long running ones, which may never finish.
+    // Main thread only, a job would wait on itself.
     void        Wait();
     bool        IsFinished(Handle<Job> handle);
-    
+
+    // Runs one queued job on the calling thread. Returns false if there was nothing to run.
+    bool        RunPendingJob();
+    uint32_t    GetWorkerCount();
+
+    // Jobs the calling thread is inside of, the ones it runs while waiting included.
+    // Not tracked across fiber switches.
+    uint32_t    GetJobDepth();
+
+    // Describes a DAG of jobs up front, e.g. a frame's animation -> bounds -> render data
+    // chain, and submits it in one go. Nodes can only depend on nodes added before them,
+    // so insertion order is always a valid topological order.
+    class JobGraph
+    {
+    public:
+        using Node = uint32_t;
+
+        Node        Add(Job::Fn&& job, std::initializer_list<Node> dependencies = {}, void* context = nullptr);
+        void        AddDependency(Node node, Node dependency);
+
+        // Enqueues every node and returns a job that finishes once the whole graph has.
+        // Once only, the node functions are moved into the jobs. Clear and Add again to resubmit.
+        Handle<Job> Submit();
+        Handle<Job> GetHandle(Node node) const { return mHandles.at(node); }
+
+        size_t      Size() const { return mNodes.size(); }
+        void        Clear();
+
+    private:
+        struct NodeDesc
+        {
+            Job::Fn             mFunction;
+            void*               mContext = nullptr;
+            std::vector<Node>   mDependencies;
+        };
+
+        std::vector<NodeDesc>       mNodes;
+        std::vector<Handle<Job>>    mHandles;
+        bool                        mbSubmitted = false;
+    };
+
+    namespace detail
+    {
+        // Picks a grain that gives every worker a handful of chunks to balance with.
+        inline size_t GetParallelGrain(size_t count, size_t grain)
+        {
+            constexpr size_t kChunksPerThread = 8;
+            if (grain > 0)
+                return grain;
+
+            const size_t threadCount = (size_t)GetWorkerCount() + 1;
+            return std::max<size_t>(1, count / (threadCount * kChunksPerThread));
+        }
+
+        template<typename TFunc>
+        void InvokeRange(TFunc& func, size_t begin, size_t end)
+        {
+            if constexpr (std::is_invocable_v<TFunc&, size_t, size_t>)
+                func(begin, end);
+            else
+            {
+                for (size_t i = begin; i < end; ++i)
+                    func(i);
+            }
+        }
+
+        template<typename TFunc>
+        struct ParallelForState
+        {
+            TFunc&              mFunc;
+            size_t              mGrain;
+            std::atomic<size_t> mPending = 0;
+
+            // Keeps splitting off the upper half for thieves and runs the last grain itself.
+            void Run(size_t begin, size_t end)
+            {
+                while (end - begin > mGrain)
+                {
+                    const size_t mid = begin + (end - begin) / 2;
+                    mPending.fetch_add(1, std::memory_order_relaxed);
+                    Execute([this, mid, end](void*)
+                    {
+                        Run(mid, end);
+                        mPending.fetch_sub(1, std::memory_order_release);
+                    });
+                    end = mid;
+                }
+
+                InvokeRange(mFunc, begin, end);
+            }
+        };
+
+        template<typename T, typename TMap, typename TReduce>
+        struct ParallelReduceState
+        {
+            TMap&       mMap;
+            TReduce&    mReduce;
+            size_t      mGrain;
+
+            // Fork/join: the right half goes to the job system, the left half recurses
+            // in place and both are combined once the right half is done.
+            T Run(size_t begin, size_t end)
+            {
+                if (end - begin <= mGrain)
+                    return mMap(begin, end);
+
+                const size_t mid = begin + (end - begin) / 2;
+                T right = {};
+                std::atomic<bool> bRightDone = false;
+                Execute([this, mid, end, &right, &bRightDone](void*)
+                {
+                    right = Run(mid, end);
+                    bRightDone.store(true, std::memory_order_release);
+                });
+
+                T left = Run(begin, mid);
+                while (!bRightDone.load(std::memory_order_acquire))
+                {
+                    if (!RunPendingJob())
+                        std::this_thread::yield();
+                }
+
+                return mReduce(left, right);
+            }
+        };
+    }
+
+    // Runs func over [begin, end) split into chunks of about 'grain' items, 0 picks a grain
+    // from the worker count. func is either func(size_t index) or func(size_t start, size_t end).
+    // The range is split recursively so idle workers steal big halves first, and the calling
+    // thread runs a chunk and then other queued jobs until the loop is done.
+    template<typename TFunc>
+    void ParallelFor(size_t begin, size_t end, size_t grain, TFunc&& func)
+    {
+        if (begin >= end)
+            return;
+
+        detail::ParallelForState<std::remove_reference_t<TFunc>> state = { func, detail::GetParallelGrain(end - begin, grain) };
+        state.Run(begin, end);
+
+        while (state.mPending.load(std::memory_order_acquire) > 0)
+        {
+            if (!RunPendingJob())
+                std::this_thread::yield();
+        }
+    }
+
+    // Maps each chunk with map(size_t start, size_t end) -> T and combines partial results
+    // with reduce(T, T) -> T. Returns identity for an empty range.
+    template<typename T, typename TMap, typename TReduce>
+    T ParallelReduce(size_t begin, size_t end, size_t grain, T identity, TMap&& map, TReduce&& reduce)
+    {
+        if (begin >= end)
+            return identity;
+
+        detail::ParallelReduceState<T, std::remove_reference_t<TMap>, std::remove_reference_t<TReduce>> state = { map, reduce, detail::GetParallelGrain(end - begin, grain) };
+        return reduce(identity, state.Run(begin, end));
+    }
 }
\ No newline at end of file
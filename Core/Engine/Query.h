@@ -0,0 +1,281 @@
+#ifndef NV_ENGINE_QUERY
+#define NV_ENGINE_QUERY
+
+#pragma once
+
+#include <Engine/EntityComponent.h>
+#include <Engine/JobSystem.h>
+
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace nv::ecs
+{
+    constexpr size_t kQueryChunkSize = 256;    // Rows per ForEachChunk job
+
+    // Query term matching entities that don't have TComp.
+    template<typename TComp>
+    struct Without {};
+
+    // Query term matching entities with any of TComps written at or after the version the
+    // query was made with, see GetComponentVersion. Several Changed terms match like one.
+    template<typename... TComps>
+    struct Changed {};
+
+    namespace detail
+    {
+        template<typename... Ts>
+        struct TypeList {};
+
+        // Sorts the terms of a query into the components it yields, the ones it filters out
+        // and the ones it checks for changes
+        template<typename TIncludes, typename TExcludes, typename TChanged, typename... TTerms>
+        struct SplitQueryTerms
+        {
+            using Includes = TIncludes;
+            using Excludes = TExcludes;
+            using Changed = TChanged;
+        };
+
+        template<typename... TIncludes, typename... TExcludes, typename... TChanged, typename TComp, typename... TRest>
+        struct SplitQueryTerms<TypeList<TIncludes...>, TypeList<TExcludes...>, TypeList<TChanged...>, Without<TComp>, TRest...> :
+            SplitQueryTerms<TypeList<TIncludes...>, TypeList<TExcludes..., TComp>, TypeList<TChanged...>, TRest...> {};
+
+        template<typename... TIncludes, typename... TExcludes, typename... TChanged, typename... TComps, typename... TRest>
+        struct SplitQueryTerms<TypeList<TIncludes...>, TypeList<TExcludes...>, TypeList<TChanged...>, Changed<TComps...>, TRest...> :
+            SplitQueryTerms<TypeList<TIncludes...>, TypeList<TExcludes...>, TypeList<TChanged..., TComps...>, TRest...> {};
+
+        template<typename... TIncludes, typename... TExcludes, typename... TChanged, typename TComp, typename... TRest>
+        struct SplitQueryTerms<TypeList<TIncludes...>, TypeList<TExcludes...>, TypeList<TChanged...>, TComp, TRest...> :
+            SplitQueryTerms<TypeList<TIncludes..., TComp>, TypeList<TExcludes...>, TypeList<TChanged...>, TRest...> {};
+
+        template<typename TIncludes, typename TExcludes, typename TChanged>
+        class QueryImpl;
+
+        template<typename... TComps, typename... TExcluded, typename... TChanged>
+        class QueryImpl<TypeList<TComps...>, TypeList<TExcluded...>, TypeList<TChanged...>>
+        {
+            static_assert(sizeof...(TComps) > 0, "A query needs a component to iterate");
+
+            using Pools = std::tuple<ComponentPool<std::remove_const_t<TComps>>*...>;
+            using ExcludedPools = std::tuple<ComponentPool<TExcluded>*...>;
+            using ChangedPools = std::tuple<ComponentPool<TChanged>*...>;
+            using Indices = std::index_sequence_for<TComps...>;
+
+            static constexpr bool kWrites = (!std::is_const_v<TComps> || ...);
+
+        public:
+            // A slice of the query's rows, handed to one ForEachChunk job.
+            class Chunk
+            {
+            public:
+                size_t GetIndex() const { return mIndex; }
+
+                template<typename TFunc>
+                void ForEach(TFunc&& func) const
+                {
+                    mpQuery->ForEachRow(mBegin, mEnd, func, Indices{});
+                }
+
+            private:
+                Chunk(const QueryImpl* pQuery, size_t index, size_t begin, size_t end) :
+                    mpQuery(pQuery), mIndex(index), mBegin(begin), mEnd(end) {}
+
+                const QueryImpl*    mpQuery;
+                size_t              mIndex;
+                size_t              mBegin;
+                size_t              mEnd;
+
+                friend class QueryImpl;
+            };
+
+            // sinceVersion only matters with Changed terms, a GetComponentVersion from before
+            // the writes to look for. 0 matches everything.
+            explicit QueryImpl(uint32_t sinceVersion = 0) :
+                mPools(gComponentManager.GetPool<std::remove_const_t<TComps>>()...),
+                mExcludedPools(gComponentManager.GetPool<TExcluded>()...),
+                mChangedPools(gComponentManager.GetPool<TChanged>()...),
+                mVersion(GetComponentVersion()),
+                mSinceVersion(sinceVersion)
+            {
+                (ValidateAccess<std::remove_const_t<TComps>>(std::is_const_v<TComps> ? ComponentAccess::Read : ComponentAccess::Write), ...);
+                (ValidateAccess<TExcluded>(ComponentAccess::Read), ...);
+                (ValidateAccess<TChanged>(ComponentAccess::Read), ...);
+                SelectDriver(Indices{});
+
+                // Nothing to walk if none of the pools was written since
+                if constexpr (sizeof...(TChanged) > 0)
+                {
+                    if (!std::apply([sinceVersion](auto*... pPools) { return ((pPools && pPools->GetVersion() >= sinceVersion) || ...); }, mChangedPools))
+                        mDriverCount = 0;
+                }
+            }
+
+            // Upper bound on the rows, the size of the smallest included pool
+            size_t GetMaxCount() const { return mDriverCount; }
+
+            // Calls func(Handle<Entity>, TComps&...) or func(TComps&...) once per match.
+            template<typename TFunc>
+            void ForEach(TFunc&& func) const
+            {
+                ForEachRow(0, mDriverCount, func, Indices{});
+            }
+
+            // Splits the rows into chunks run on the job system, func(const Chunk&) walks its
+            // chunk with chunk.ForEach. An entity is in one chunk only, so writes to its own
+            // components don't race. Returns once every chunk is done.
+            template<typename TFunc>
+            void ForEachChunk(TFunc&& func, size_t chunkSize = kQueryChunkSize) const
+            {
+                assert(chunkSize > 0);
+                const size_t chunkCount = (mDriverCount + chunkSize - 1) / chunkSize;
+                jobs::ParallelFor(0, chunkCount, 1, [&](size_t index)
+                {
+                    const Chunk chunk(this, index, index * chunkSize, std::min(mDriverCount, (index + 1) * chunkSize));
+                    func(chunk);
+                });
+            }
+
+            // Packs the matches into slots [0, count), in the order ForEach visits them, using the job
+            // system. allocate(size_t count) runs on the calling thread once the count is known, then
+            // func(size_t slot, Handle<Entity>, TComps&...) fills each slot from a worker. Matches are
+            // counted per chunk first, so every chunk knows where its slots start. Returns the count.
+            template<typename TAllocate, typename TFunc>
+            size_t Gather(TAllocate&& allocate, TFunc&& func, size_t chunkSize = kQueryChunkSize) const
+            {
+                assert(chunkSize > 0);
+                const size_t chunkCount = (mDriverCount + chunkSize - 1) / chunkSize;
+                std::vector<size_t> offsets(chunkCount + 1, 0);
+                jobs::ParallelFor(0, chunkCount, 1, [&](size_t index)
+                {
+                    size_t count = 0;
+                    ForEachRow(index * chunkSize, std::min(mDriverCount, (index + 1) * chunkSize), [&count](TComps&...) { ++count; }, Indices{});
+                    offsets[index + 1] = count;
+                });
+
+                for (size_t i = 0; i < chunkCount; ++i)
+                    offsets[i + 1] += offsets[i];
+
+                const size_t count = offsets[chunkCount];
+                allocate(count);
+                if (count == 0)
+                    return 0;
+
+                jobs::ParallelFor(0, chunkCount, 1, [&](size_t index)
+                {
+                    size_t slot = offsets[index];
+                    ForEachRow(index * chunkSize, std::min(mDriverCount, (index + 1) * chunkSize), [&](Handle<Entity> entity, TComps&... components)
+                    {
+                        func(slot++, entity, components...);
+                    }, Indices{});
+                });
+                return count;
+            }
+
+        private:
+            // Walks the smallest pool and looks the entity up in the others
+            template<size_t... Is>
+            void SelectDriver(std::index_sequence<Is...>)
+            {
+                if (!(std::get<Is>(mPools) && ...))
+                    return;
+
+                mDriverCount = ~size_t(0);
+                ((std::get<Is>(mPools)->Size() < mDriverCount ? (mDriver = Is, mDriverCount = std::get<Is>(mPools)->Size()) : 0), ...);
+                GetOwners(Indices{});
+            }
+
+            template<size_t... Is>
+            void GetOwners(std::index_sequence<Is...>)
+            {
+                ((Is == mDriver ? (mpOwners = std::get<Is>(mPools)->GetOwners().data(), 0) : 0), ...);
+            }
+
+            template<size_t I>
+            auto* GetComponent(Handle<Entity> entity, size_t row) const
+            {
+                using TComp = std::tuple_element_t<I, std::tuple<TComps...>>;
+                auto* pPool = std::get<I>(mPools);
+                return I == mDriver ? (TComp*)&pPool->Span()[row] : (TComp*)pPool->Find(entity);
+            }
+
+            bool IsExcluded(Handle<Entity> entity) const
+            {
+                return std::apply([entity](auto*... pPools) { return ((pPools && pPools->Contains(entity)) || ... || false); }, mExcludedPools);
+            }
+
+            bool IsChanged(Handle<Entity> entity) const
+            {
+                if constexpr (sizeof...(TChanged) == 0)
+                    return true;
+                else
+                    return std::apply([this, entity](auto*... pPools) { return ((pPools && pPools->GetVersion(entity) >= mSinceVersion) || ...); }, mChangedPools);
+            }
+
+            // Mutable components are stamped as written once they're handed out
+            template<size_t... Is>
+            void MarkChanged(const std::tuple<TComps*...>& components, std::index_sequence<Is...>) const
+            {
+                ((std::is_const_v<TComps> ? void() : std::get<Is>(mPools)->SetVersion((uint32_t)(std::get<Is>(components) - std::get<Is>(mPools)->Span().mData), mVersion)), ...);
+            }
+
+            template<typename TFunc, size_t... Is>
+            void ForEachRow(size_t begin, size_t end, TFunc&& func, std::index_sequence<Is...>) const
+            {
+                for (size_t row = begin; row < end; ++row)
+                {
+                    const Handle<Entity> entity = mpOwners[row];
+                    const std::tuple<TComps*...> components = { GetComponent<Is>(entity, row)... };
+                    if (!(std::get<Is>(components) && ...) || IsExcluded(entity) || !IsChanged(entity))
+                        continue;
+
+                    if constexpr (kWrites)
+                        MarkChanged(components, Indices{});
+
+                    if constexpr (std::is_invocable_v<TFunc&, Handle<Entity>, TComps&...>)
+                        func(entity, *std::get<Is>(components)...);
+                    else
+                        func(*std::get<Is>(components)...);
+                }
+            }
+
+            Pools                   mPools;
+            ExcludedPools           mExcludedPools;
+            ChangedPools            mChangedPools;
+            uint32_t                mVersion;           // Stamped on the mutable components handed out
+            uint32_t                mSinceVersion;
+            size_t                  mDriver = 0;
+            size_t                  mDriverCount = 0;
+            const Handle<Entity>*   mpOwners = nullptr;
+        };
+    }
+
+    // Joins the component pools of the listed types, resolved once when the query is made. It
+    // walks the smallest pool and finds each entity's other components with an array lookup,
+    // skipping entities that miss one or have a Without<T> type. const types are handed out
+    // as const references, the others are stamped as written when handed out.
+    //
+    //  ecs::Query<Position, const Rotation, Without<Hidden>> query;
+    //  query.ForEach([](Handle<Entity> entity, Position& position, const Rotation& rotation) { ... });
+    //
+    // Changed<T> terms keep only what was written since a version the caller kept from its last
+    // run. The check is inclusive, so a system sees its own writes once more on its next run and
+    // shouldn't filter on components it writes itself.
+    //
+    //  const uint32_t version = ecs::GetComponentVersion();
+    //  ecs::Query<const Position, Changed<Position>> moved(mLastVersion);
+    //  mLastVersion = version;
+    //
+    // Adding or removing components of the included types while iterating isn't allowed,
+    // and a query made before a pool is created never sees it.
+    template<typename... TTerms>
+    using Query = detail::QueryImpl<
+        typename detail::SplitQueryTerms<detail::TypeList<>, detail::TypeList<>, detail::TypeList<>, TTerms...>::Includes,
+        typename detail::SplitQueryTerms<detail::TypeList<>, detail::TypeList<>, detail::TypeList<>, TTerms...>::Excludes,
+        typename detail::SplitQueryTerms<detail::TypeList<>, detail::TypeList<>, detail::TypeList<>, TTerms...>::Changed>;
+}
+
+#endif // !NV_ENGINE_QUERY
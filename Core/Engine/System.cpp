@@ -1,13 +1,113 @@
 #include "pch.h"
 #include "System.h"
 #include <Debug/Profiler.h>
+#include <Engine/EntityCommandBuffer.h>
+#include <Engine/JobSystem.h>
+#include <Engine/Log.h>
 #include <Lib/Format.h>
 
+#include <algorithm>
+#include <thread>
+
 namespace nv
 {
     SystemManager gSystemManager;
     SystemManager* SystemManager::gPtr = &gSystemManager;
 
+    namespace
+    {
+        constexpr uint32_t kUnscheduled = ~0u;
+
+#if NV_ENABLE_SYSTEM_VALIDATION
+        struct RunningSystem
+        {
+            const SystemAccess* mpAccess = nullptr;
+            const char*         mpName = "";
+            uint32_t            mJobDepth = 0;
+        };
+
+        thread_local RunningSystem tRunningSystem;
+#endif
+
+        bool Contains(const std::vector<StringID>& ids, StringID id)
+        {
+            return std::find(ids.begin(), ids.end(), id) != ids.end();
+        }
+    }
+
+#if NV_ENABLE_SYSTEM_VALIDATION
+    void ecs::ValidateComponentAccess(StringID id, std::string_view name, ComponentAccess access)
+    {
+        // Jobs this thread picks up while the system waits could belong to anyone
+        const RunningSystem& running = tRunningSystem;
+        if (!running.mpAccess || running.mpAccess->IsExclusive() || running.mJobDepth != jobs::GetJobDepth())
+            return;
+
+        bool bDeclared = false;
+        const char* pAction = "";
+        switch (access)
+        {
+        case ComponentAccess::Read:
+            bDeclared = running.mpAccess->CanRead(id);
+            pAction = "reads";
+            break;
+        case ComponentAccess::Write:
+            bDeclared = running.mpAccess->CanWrite(id);
+            pAction = "writes";
+            break;
+        case ComponentAccess::Structural:
+            pAction = "adds or removes";
+            break;
+        }
+
+        if (!bDeclared)
+        {
+            log::Error("System {} {} {} without declaring it", running.mpName, pAction, name);
+            assert(false && "Undeclared component access, see SystemAccess");
+        }
+    }
+#endif
+
+    bool SystemAccess::CanRead(StringID component) const
+    {
+        return Contains(mReads, component) || Contains(mWrites, component);
+    }
+
+    bool SystemAccess::CanWrite(StringID component) const
+    {
+        return Contains(mWrites, component);
+    }
+
+    bool SystemAccess::ConflictsWith(const SystemAccess& other) const
+    {
+        if (IsExclusive() || other.IsExclusive())
+            return true;
+
+        for (StringID id : mWrites)
+        {
+            if (other.CanRead(id))
+                return true;
+        }
+
+        for (StringID id : other.mWrites)
+        {
+            if (Contains(mReads, id))
+                return true;
+        }
+
+        return false;
+    }
+
+    void SystemAccess::Clear()
+    {
+        mReads.clear();
+        mWrites.clear();
+        mAfter.clear();
+        mbDeclared = false;
+        mbExclusive = false;
+        mbMainThread = false;
+    }
+
     void SystemManager::InitSystems()
     {
         NV_EVENT("Systems/Init");
@@ -23,11 +123,133 @@ namespace nv
     {
         NV_EVENT("Systems/Update");
         std::unique_lock<std::mutex> lock(mSysMutex);
-        for (auto id : mInsertOrder)
+        BuildSchedule();
+
+        size_t begin = 0;
+        while (begin < mOrder.size())
         {
-            auto& system = mSystems.at(id);
-            system->Update(deltaTime, totalTime);
+            const uint32_t level = mSchedule[mOrder[begin]].mLevel;
+            size_t end = begin + 1;
+            while (end < mOrder.size() && mSchedule[mOrder[end]].mLevel == level)
+                ++end;
+
+            // Writes of this level come after everything earlier levels did, for Changed<T>
+            ecs::AdvanceComponentVersion();
+            RunLevel(&mOrder[begin], end - begin, deltaTime, totalTime);
+
+            // Structural changes the level's jobs deferred, the next level sees them
+            ecs::gEntityCommands.Playback();
+            begin = end;
+        }
+    }
+
+    // Puts every system one level past the systems before it that it conflicts with or runs
+    // after. Systems on a level don't conflict and run at the same time.
+    void SystemManager::BuildSchedule()
+    {
+        const size_t count = mInsertOrder.Size();
+        mSchedule.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            ScheduledSystem& system = mSchedule[i];
+            system.mId = mInsertOrder[i];
+            system.mpSystem = mSystems.at(system.mId).Get();
+            system.mAccess.Clear();
+            system.mpSystem->DeclareAccess(system.mAccess);
+            system.mLevel = kUnscheduled;
+        }
+
+        const auto isReady = [this](const ScheduledSystem& system)
+        {
+            return std::all_of(system.mAccess.mAfter.begin(), system.mAccess.mAfter.end(), [this](StringID id)
+            {
+                auto it = std::find_if(mSchedule.begin(), mSchedule.end(), [id](const ScheduledSystem& other) { return other.mId == id; });
+                return it == mSchedule.end() || it->mLevel != kUnscheduled;
+            });
+        };
+
+        // Insertion order, except that a system waits for the ones it runs after
+        mOrder.clear();
+        while (mOrder.size() < count)
+        {
+            size_t next = count;
+            for (size_t i = 0; i < count && next == count; ++i)
+            {
+                if (mSchedule[i].mLevel == kUnscheduled && isReady(mSchedule[i]))
+                    next = i;
+            }
+
+            if (next == count)
+            {
+                assert(false && "Cycle in SystemAccess::After");
+                next = std::find_if(mSchedule.begin(), mSchedule.end(), [](const ScheduledSystem& system) { return system.mLevel == kUnscheduled; }) - mSchedule.begin();
+            }
+
+            ScheduledSystem& system = mSchedule[next];
+            uint32_t level = 0;
+            for (uint32_t index : mOrder)
+            {
+                const ScheduledSystem& previous = mSchedule[index];
+                if (system.mAccess.ConflictsWith(previous.mAccess) || Contains(system.mAccess.mAfter, previous.mId))
+                    level = std::max(level, previous.mLevel + 1);
+            }
+
+            system.mLevel = level;
+            mOrder.push_back((uint32_t)next);
+        }
+
+        std::stable_sort(mOrder.begin(), mOrder.end(), [this](uint32_t a, uint32_t b) { return mSchedule[a].mLevel < mSchedule[b].mLevel; });
+    }
+
+    void SystemManager::RunLevel(const uint32_t* pOrder, size_t count, float deltaTime, float totalTime)
+    {
+        if (count == 1)
+        {
+            RunSystem(mSchedule[pOrder[0]], deltaTime, totalTime);
+            return;
         }
+
+        mJobs.clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            const ScheduledSystem* pSystem = &mSchedule[pOrder[i]];
+            if (!pSystem->mAccess.IsMainThread())
+                mJobs.push_back(jobs::Execute([this, pSystem, deltaTime, totalTime](void*) { RunSystem(*pSystem, deltaTime, totalTime); }));
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const ScheduledSystem& system = mSchedule[pOrder[i]];
+            if (system.mAccess.IsMainThread())
+                RunSystem(system, deltaTime, totalTime);
+        }
+
+        // Helps out instead of blocking, jobs::Wait only yields on this thread
+        for (Handle<jobs::Job> job : mJobs)
+        {
+            while (!jobs::IsFinished(job))
+            {
+                if (!jobs::RunPendingJob())
+                    std::this_thread::yield();
+            }
+        }
+    }
+
+    void SystemManager::RunSystem(const ScheduledSystem& system, float deltaTime, float totalTime)
+    {
+#if NV_ENABLE_SYSTEM_VALIDATION
+        const RunningSystem previous = tRunningSystem;
+        tRunningSystem = { .mpAccess = &system.mAccess, .mJobDepth = jobs::GetJobDepth() };
+#if NV_ENABLE_SYSTEM_NAMES
+        tRunningSystem.mpName = mSystemNames.at(system.mId).c_str();
+#endif
+#endif
+
+        system.mpSystem->Update(deltaTime, totalTime);
+
+#if NV_ENABLE_SYSTEM_VALIDATION
+        tRunningSystem = previous;
+#endif
     }
 
     void SystemManager::DestroySystems()
@@ -8,7 +8,9 @@
 #include <Lib/StringHash.h>
 #include <Lib/Pool.h>
 #include <Lib/ScopedPtr.h>
+#include <Engine/Component.h>
 #include <mutex>
+#include <vector>
 
 namespace nv
 {
@@ -19,6 +21,75 @@ namespace nv
     constexpr bool ENABLE_SYSTEM_NAMES = false;
 #endif
 
+    namespace jobs
+    {
+        class Job;
+    }
+
+    // What a system touches in its Update, so SystemManager can run the ones that don't conflict
+    // side by side on the job system. Two systems conflict if one writes a component the other
+    // reads or writes, or if either is exclusive. Conflicting systems keep their insertion order,
+    // After<T> moves a system behind T. A system that declares nothing runs exclusive.
+    // With NV_ENABLE_SYSTEM_VALIDATION the queries and Entity calls made from Update are
+    // checked against it, Entity::Get needs Read and Entity::GetMut needs Write.
+    //
+    //  void DeclareAccess(SystemAccess& access) const override
+    //  {
+    //      access.Read<Position>().Write<Velocity>().After<InputSystem>();
+    //  }
+    class SystemAccess
+    {
+    public:
+        template<typename... TComps>
+        SystemAccess& Read()
+        {
+            mbDeclared = true;
+            (mReads.push_back(ecs::GetComponentID<TComps>()), ...);
+            return *this;
+        }
+
+        template<typename... TComps>
+        SystemAccess& Write()
+        {
+            mbDeclared = true;
+            (mWrites.push_back(ecs::GetComponentID<TComps>()), ...);
+            return *this;
+        }
+
+        template<typename... TSystems>
+        SystemAccess& After()
+        {
+            mbDeclared = true;
+            (mAfter.push_back(TypeNameID<TSystems>()), ...);
+            return *this;
+        }
+
+        // Adds or removes components directly, or touches state other systems read, and runs
+        // on its own. Deferring the changes through ecs::gEntityCommands avoids this.
+        SystemAccess& Exclusive() { mbDeclared = true; mbExclusive = true; return *this; }
+
+        // Runs on the thread calling UpdateSystems, other systems may still run next to it.
+        SystemAccess& MainThread() { mbDeclared = true; mbMainThread = true; return *this; }
+
+        bool IsExclusive() const { return !mbDeclared || mbExclusive; }
+        bool IsMainThread() const { return IsExclusive() || mbMainThread; }
+        bool CanRead(StringID component) const;
+        bool CanWrite(StringID component) const;
+        bool ConflictsWith(const SystemAccess& other) const;
+
+        void Clear();
+
+    private:
+        std::vector<StringID>   mReads;
+        std::vector<StringID>   mWrites;
+        std::vector<StringID>   mAfter;
+        bool                    mbDeclared = false;
+        bool                    mbExclusive = false;
+        bool                    mbMainThread = false;
+
+        friend class SystemManager;
+    };
+
     class ISystem
     {
     public:
@@ -27,6 +98,9 @@ namespace nv
         virtual void Destroy() {};
         virtual void OnReload() {};
 
+        // Called every frame before the systems are scheduled
+        virtual void DeclareAccess(SystemAccess& access) const {}
+
         virtual ~ISystem() {}
     private:
     };
@@ -96,7 +170,22 @@ namespace nv
         static SystemManager* gPtr;
 
     private:
+        struct ScheduledSystem
+        {
+            StringID        mId;
+            ISystem*        mpSystem;
+            SystemAccess    mAccess;
+            uint32_t        mLevel;
+        };
+
+        void BuildSchedule();
+        void RunLevel(const uint32_t* pOrder, size_t count, float deltaTime, float totalTime);
+        void RunSystem(const ScheduledSystem& system, float deltaTime, float totalTime);
+
         nv::Vector<StringID>                        mInsertOrder;
+        std::vector<ScheduledSystem>                mSchedule;      // Rebuilt every frame, in insertion order
+        std::vector<uint32_t>                       mOrder;         // Indices into mSchedule by level
+        std::vector<Handle<jobs::Job>>              mJobs;
         HashMap<StringID, ScopedPtr<ISystem, true>> mSystems;
         mutable std::mutex                          mSysMutex; // Committing a grave sin, but const functions need mutex lock for safety
 #if NV_ENABLE_SYSTEM_NAMES
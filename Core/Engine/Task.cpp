@@ -0,0 +1,108 @@
+#include "pch.h"
+
+#include <Engine/Task.h>
+#include <Memory/Allocator.h>
+#include <Lib/MPMCQueue.h>
+
+namespace nv::jobs
+{
+    static std::atomic<IAllocator*> gpTaskFrameAllocator = nullptr;
+
+    void SetTaskFrameAllocator(IAllocator* pAllocator)
+    {
+        gpTaskFrameAllocator.store(pAllocator, std::memory_order_release);
+    }
+
+    IAllocator* GetTaskFrameAllocator()
+    {
+        return gpTaskFrameAllocator.load(std::memory_order_acquire);
+    }
+}
+
+namespace nv::detail
+{
+    // Frames are recycled per power of two size class, a task chain allocates and
+    // frees a handful of similar sized frames per step so the caches stay warm.
+    // Anything bigger than the largest class goes straight to the system allocator.
+    constexpr uint32_t kTaskFrameSizeClasses = 5;
+    constexpr size_t   kTaskFrameMinSize = 256;
+    constexpr uint32_t kTaskFramesPerClass = 256;
+    constexpr uint32_t kTaskFrameUnpooled = ~0u;
+
+    struct alignas(16) TaskFrameHeader
+    {
+        IAllocator* mpAllocator;    // null if the frame belongs to the pool
+        uint32_t    mSizeClass;
+    };
+
+    static MPMCQueue<void*, kTaskFramesPerClass> gTaskFramePool[kTaskFrameSizeClasses];
+
+    static uint32_t GetTaskFrameSizeClass(size_t size)
+    {
+        size_t classSize = kTaskFrameMinSize;
+        for (uint32_t sizeClass = 0; sizeClass < kTaskFrameSizeClasses; ++sizeClass, classSize <<= 1)
+        {
+            if (size <= classSize)
+                return sizeClass;
+        }
+
+        return kTaskFrameUnpooled;
+    }
+
+    void* AllocateTaskFrame(size_t size)
+    {
+        size += sizeof(TaskFrameHeader);
+
+        TaskFrameHeader* pHeader = nullptr;
+        if (IAllocator* pAllocator = jobs::GetTaskFrameAllocator())
+        {
+            pHeader = (TaskFrameHeader*)pAllocator->Allocate(size);
+            pHeader->mpAllocator = pAllocator;
+            pHeader->mSizeClass = kTaskFrameUnpooled;
+            return pHeader + 1;
+        }
+
+        const uint32_t sizeClass = GetTaskFrameSizeClass(size);
+        if (sizeClass == kTaskFrameUnpooled)
+            pHeader = (TaskFrameHeader*)SystemAllocator::gPtr->Allocate(size);
+        else
+        {
+            void* pFrame = nullptr;
+            if (gTaskFramePool[sizeClass].TryPop(pFrame))
+                pHeader = (TaskFrameHeader*)pFrame;
+            else
+                pHeader = (TaskFrameHeader*)SystemAllocator::gPtr->Allocate(kTaskFrameMinSize << sizeClass);
+        }
+
+        assert(pHeader);
+        pHeader->mpAllocator = nullptr;
+        pHeader->mSizeClass = sizeClass;
+        return pHeader + 1;
+    }
+
+    void FreeTaskFrame(void* pFrame)
+    {
+        TaskFrameHeader* pHeader = (TaskFrameHeader*)pFrame - 1;
+        if (pHeader->mpAllocator)
+        {
+            pHeader->mpAllocator->Free(pHeader);
+            return;
+        }
+
+        if (pHeader->mSizeClass == kTaskFrameUnpooled || !gTaskFramePool[pHeader->mSizeClass].TryPush((void*)pHeader))
+            SystemAllocator::gPtr->Free(pHeader);
+    }
+}
+
+namespace nv::jobs
+{
+    void ReleaseTaskFramePool()
+    {
+        for (auto& pool : nv::detail::gTaskFramePool)
+        {
+            void* pFrame = nullptr;
+            while (pool.TryPop(pFrame))
+                SystemAllocator::gPtr->Free(pFrame);
+        }
+    }
+}
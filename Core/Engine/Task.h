@@ -0,0 +1,263 @@
+#ifndef NV_ENGINE_TASK
+#define NV_ENGINE_TASK
+
+#pragma once
+
+#include <Engine/JobSystem.h>
+
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace nv
+{
+    class IAllocator;
+
+    namespace jobs
+    {
+        // Coroutine frames come from a size class pool by default. Frames record the
+        // allocator they came from, so swapping it while tasks are alive is fine.
+        // nullptr restores the pool.
+        void        SetTaskFrameAllocator(IAllocator* pAllocator);
+        IAllocator* GetTaskFrameAllocator();
+
+        // Frees the frames cached by the default pool.
+        void        ReleaseTaskFramePool();
+    }
+
+    template<typename T>
+    class Task;
+
+    namespace detail
+    {
+        void*   AllocateTaskFrame(size_t size);
+        void    FreeTaskFrame(void* pFrame);
+
+        struct TaskPromiseBase
+        {
+            struct FinalAwaiter
+            {
+                bool await_ready() const noexcept { return false; }
+                void await_resume() const noexcept {}
+
+                template<typename TPromise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<TPromise> handle) noexcept
+                {
+                    TaskPromiseBase& promise = handle.promise();
+                    if (promise.mContinuation)
+                        return promise.mContinuation;
+
+                    if (promise.mbDetached)
+                        handle.destroy();
+                    else if (std::atomic<bool>* pDone = promise.mpDone)
+                        pDone->store(true, std::memory_order_release); // Frame can be gone after this
+
+                    return std::noop_coroutine();
+                }
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter        final_suspend() const noexcept { return {}; }
+            void                unhandled_exception() const noexcept { assert(false); std::terminate(); }
+
+            static void* operator new(size_t size) { return AllocateTaskFrame(size); }
+            static void  operator delete(void* pFrame) { FreeTaskFrame(pFrame); }
+
+            std::coroutine_handle<>     mContinuation;
+            std::atomic<bool>*          mpDone = nullptr;
+            bool                        mbDetached = false;
+        };
+
+        template<typename T>
+        struct TaskPromise : TaskPromiseBase
+        {
+            Task<T>         get_return_object() noexcept;
+
+            template<typename TValue>
+            void            return_value(TValue&& value) { mValue.emplace(std::forward<TValue>(value)); }
+
+            T               TakeResult() { assert(mValue); return std::move(*mValue); }
+
+            std::optional<T> mValue;
+        };
+
+        template<>
+        struct TaskPromise<void> : TaskPromiseBase
+        {
+            Task<void>      get_return_object() noexcept;
+            void            return_void() const noexcept {}
+            void            TakeResult() const noexcept {}
+        };
+    }
+
+    // Lazily started, move only coroutine. Nothing runs until the task is awaited,
+    // detached or waited on, and the awaiting coroutine is resumed by the task itself
+    // (symmetric transfer) on whatever thread it finished on, no callbacks involved.
+    //
+    //  Task<Mesh*> LoadMesh(AssetID id)
+    //  {
+    //      Asset* pAsset = co_await asset::LoadAsset(id); // IO lane
+    //      co_await jobs::Schedule();                     // back on a worker
+    //      co_return Build(pAsset);
+    //  }
+    template<typename T = void>
+    class Task
+    {
+    public:
+        using promise_type = detail::TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Task() = default;
+        explicit Task(Handle handle) : mHandle(handle) {}
+
+        Task(Task&& other) noexcept : mHandle(std::exchange(other.mHandle, nullptr)) {}
+        Task& operator=(Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                mHandle = std::exchange(other.mHandle, nullptr);
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task() { Reset(); }
+
+        bool IsValid() const { return (bool)mHandle; }
+        bool IsDone() const { return mHandle && mHandle.done(); }
+
+        // Starts the task on the calling thread and lets it free itself once it finishes.
+        void Detach()
+        {
+            assert(mHandle);
+            Handle handle = std::exchange(mHandle, nullptr);
+            handle.promise().mbDetached = true;
+            handle.resume();
+        }
+
+        auto operator co_await() && noexcept
+        {
+            struct Awaiter
+            {
+                Handle mHandle;
+
+                bool await_ready() const noexcept { return !mHandle || mHandle.done(); }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+                {
+                    mHandle.promise().mContinuation = awaiting;
+                    return mHandle;
+                }
+
+                T await_resume() { return mHandle.promise().TakeResult(); }
+            };
+
+            assert(mHandle);
+            return Awaiter{ mHandle };
+        }
+
+    private:
+        void Reset()
+        {
+            if (mHandle)
+            {
+                assert(!mHandle.promise().mpDone || mHandle.done()); // Destroying a task someone waits on
+                mHandle.destroy();
+                mHandle = nullptr;
+            }
+        }
+
+        template<typename TResult>
+        friend TResult SyncWait(Task<TResult>&& task);
+
+        Handle mHandle = nullptr;
+    };
+
+    namespace detail
+    {
+        template<typename T>
+        inline Task<T> TaskPromise<T>::get_return_object() noexcept
+        {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept
+        {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+    }
+
+    // Runs the task from plain code and blocks until it is done. The calling thread keeps
+    // running queued jobs meanwhile, so tasks hopping back onto workers can't starve it.
+    template<typename T>
+    T SyncWait(Task<T>&& task)
+    {
+        assert(task.mHandle);
+        std::atomic<bool> bDone = false;
+        task.mHandle.promise().mpDone = &bDone;
+        task.mHandle.resume();
+
+        while (!bDone.load(std::memory_order_acquire))
+        {
+            if (!jobs::RunPendingJob())
+                std::this_thread::yield();
+        }
+
+        return task.mHandle.promise().TakeResult();
+    }
+
+    namespace jobs
+    {
+        // co_await Schedule() moves the coroutine onto the job system, it resumes
+        // inside a job of the given priority (LongRunning for blocking IO).
+        inline auto Schedule(JobPriority priority = JobPriority::Normal)
+        {
+            struct Awaiter
+            {
+                JobPriority mPriority;
+
+                bool await_ready() const noexcept { return false; }
+                void await_resume() const noexcept {}
+
+                void await_suspend(std::coroutine_handle<> handle) const
+                {
+                    Execute([handle](void*) { handle.resume(); }, mPriority);
+                }
+            };
+
+            return Awaiter{ priority };
+        }
+
+        // Resumes the coroutine in a job once dependency has finished,
+        // without blocking a worker in the meantime.
+        inline auto Schedule(Handle<Job> dependency, JobPriority priority = JobPriority::Normal)
+        {
+            struct Awaiter
+            {
+                Handle<Job> mDependency;
+                JobPriority mPriority;
+
+                bool await_ready() const { return IsFinished(mDependency); }
+                void await_resume() const noexcept {}
+
+                void await_suspend(std::coroutine_handle<> handle) const
+                {
+                    // The awaiter lives in the frame, which can be resumed before Execute returns
+                    Handle<Job> dependency = mDependency;
+                    Execute([handle](void*) { handle.resume(); }, Span<Handle<Job>>(&dependency, 1), nullptr, mPriority);
+                }
+            };
+
+            return Awaiter{ dependency, priority };
+        }
+    }
+}
+
+#endif // !NV_ENGINE_TASK
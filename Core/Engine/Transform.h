@@ -51,4 +51,13 @@ namespace nv
     {
         float4 mRotation;
     };
+
+    // Looked up by handle on every Entity::Get<T> and GetTransform
+    namespace ecs
+    {
+        template<> constexpr ComponentStorage kComponentStorage<Position> = ComponentStorage::SparseSet;
+        template<> constexpr ComponentStorage kComponentStorage<Rotation> = ComponentStorage::SparseSet;
+        template<> constexpr ComponentStorage kComponentStorage<Scale> = ComponentStorage::SparseSet;
+        template<> constexpr ComponentStorage kComponentStorage<PrevTransform> = ComponentStorage::SparseSet;
+    }
 }
\ No newline at end of file
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <queue>
 
 namespace nv
 {
+    // Unbounded, mutex protected queue. Prefer MPMCQueue or SPSCQueue (bounded,
+    // lock-free) on hot paths, this one is for queues that must never reject an item.
     template<typename T>
     class ConcurrentQueue
     {
@@ -16,20 +19,28 @@ namespace nv
 
         T           Pop(bool wait = false);
         void        Pop(T& val, bool wait = false);
-        void        PopUnsafe(T& val) { val = std::move(mQueue.front()); mQueue.pop(); }
+        bool        TryPop(T& val);
+        void        PopUnsafe(T& val) { val = std::move(mQueue.front()); mQueue.pop(); UpdateIsEmpty(); } // Caller holds Lock()
+
+        // Reference stays valid until the front item is popped
         const T&    Peek();
-        size_t      Size() const { return mQueue.size(); }
+        size_t      Size() const;
 
+        // Lock free hint, a pop right after can still come back empty
         bool        IsEmpty() const;
+
+        // Only PopUnsafe is allowed while locked, every other call takes the lock itself
         void        Lock() { mMutex.lock(); }
-        void        Unlock() { mMutex.unlock(); }   
+        void        Unlock() { mMutex.unlock(); }
     private:
         using UniqueLock = std::unique_lock<std::mutex>;
 
-        std::mutex              mMutex;
+        void        UpdateIsEmpty() { mbIsEmpty.store(mQueue.empty(), std::memory_order_release); }
+
+        mutable std::mutex      mMutex;
         std::condition_variable mConditionVar;
         std::queue<T>           mQueue;
-        std::atomic_bool        mbIsEmpty = true;
+        std::atomic_bool        mbIsEmpty = true; // Only written with mMutex held
     };
 
     template<typename T>
@@ -37,11 +48,10 @@ namespace nv
     {
         {
             UniqueLock lock(mMutex);
-            mQueue.push(val);
-            lock.unlock();
+            mQueue.push(std::move(val));
+            UpdateIsEmpty();
         }
 
-        mbIsEmpty.store(false);
         mConditionVar.notify_one();
     }
 
@@ -51,10 +61,9 @@ namespace nv
         {
             UniqueLock lock(mMutex);
             mQueue.push(val);
-            lock.unlock();
+            UpdateIsEmpty();
         }
 
-        mbIsEmpty.store(false);
         mConditionVar.notify_one();
     }
 
@@ -64,10 +73,9 @@ namespace nv
         {
             UniqueLock lock(mMutex);
             mQueue.push(std::move(val));
-            lock.unlock();
+            UpdateIsEmpty();
         }
 
-        mbIsEmpty.store(false);
         mConditionVar.notify_one();
     }
 
@@ -75,17 +83,17 @@ namespace nv
     inline T ConcurrentQueue<T>::Pop(bool wait)
     {
         UniqueLock lock(mMutex);
-        while (IsEmpty() && wait)
+        while (mQueue.empty() && wait)
         {
             mConditionVar.wait(lock);
         }
 
-        if (IsEmpty())
+        if (mQueue.empty())
             return T();
 
-        auto val = mQueue.front();
+        auto val = std::move(mQueue.front());
         mQueue.pop();
-        mbIsEmpty.store(mQueue.empty());
+        UpdateIsEmpty();
         return val;
     }
 
@@ -93,28 +101,49 @@ namespace nv
     inline void ConcurrentQueue<T>::Pop(T& val, bool wait)
     {
         UniqueLock lock(mMutex);
-        while (IsEmpty() && wait)
+        while (mQueue.empty() && wait)
         {
             mConditionVar.wait(lock);
         }
 
-        if (IsEmpty())
+        if (mQueue.empty())
             return;
 
         val = std::move(mQueue.front());
         mQueue.pop();
-        mbIsEmpty.store(mQueue.empty());
+        UpdateIsEmpty();
+    }
+
+    template<typename T>
+    inline bool ConcurrentQueue<T>::TryPop(T& val)
+    {
+        UniqueLock lock(mMutex);
+        if (mQueue.empty())
+            return false;
+
+        val = std::move(mQueue.front());
+        mQueue.pop();
+        UpdateIsEmpty();
+        return true;
     }
 
     template<typename T>
     inline const T& ConcurrentQueue<T>::Peek()
     {
+        UniqueLock lock(mMutex);
         return mQueue.front();
     }
 
+    template<typename T>
+    inline size_t ConcurrentQueue<T>::Size() const
+    {
+        UniqueLock lock(mMutex);
+        return mQueue.size();
+    }
+
     template<typename T>
     inline bool ConcurrentQueue<T>::IsEmpty() const
     {
-        return mbIsEmpty.load();
+        return mbIsEmpty.load(std::memory_order_acquire);
     }
-}
\ No newline at end of file
+}
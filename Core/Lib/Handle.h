@@ -4,6 +4,8 @@
 
 namespace nv
 {
+    enum class PoolBackend : uint8_t;
+
     template<typename T>
     struct Handle
     {
@@ -30,10 +32,10 @@ namespace nv
             mIndex(index),
             mGeneration(gen) {}
 
-        template<typename U, typename Gen, uint32_t>
+        template<typename U, typename Gen, uint32_t, PoolBackend>
         friend class Pool;
 
-        template<typename U, typename Gen, uint32_t>
+        template<typename U, typename Gen, uint32_t, PoolBackend>
         friend class ContiguousPool;
     };
 
@@ -0,0 +1,125 @@
+#ifndef NV_INLINE_FUNCTION
+#define NV_INLINE_FUNCTION
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace nv
+{
+    constexpr size_t kInlineFunctionDefaultSize = 64;
+
+    template<typename TSignature, size_t TCapacity = kInlineFunctionDefaultSize>
+    class InlineFunction;
+
+    // Move only std::function replacement that never allocates. The callable is
+    // stored in a fixed inline buffer, anything larger fails to compile, so capture
+    // by reference or pass a pointer to the state instead.
+    template<typename TReturn, typename... TArgs, size_t TCapacity>
+    class InlineFunction<TReturn(TArgs...), TCapacity>
+    {
+        struct Ops
+        {
+            TReturn (*mInvoke)(void* pStorage, TArgs&&... args);
+            void    (*mMove)(void* pDest, void* pSource);
+            void    (*mDestroy)(void* pStorage);
+        };
+
+        template<typename TFunc>
+        static constexpr Ops kOps =
+        {
+            [](void* pStorage, TArgs&&... args) -> TReturn { return (*(TFunc*)pStorage)(std::forward<TArgs>(args)...); },
+            [](void* pDest, void* pSource) { new (pDest) TFunc(std::move(*(TFunc*)pSource)); ((TFunc*)pSource)->~TFunc(); },
+            [](void* pStorage) { ((TFunc*)pStorage)->~TFunc(); }
+        };
+
+    public:
+        static constexpr size_t kCapacity = TCapacity;
+
+        InlineFunction() = default;
+        InlineFunction(std::nullptr_t) {}
+
+        template<typename TFunc, typename = std::enable_if_t<!std::is_same_v<std::decay_t<TFunc>, InlineFunction>>>
+        InlineFunction(TFunc&& func)
+        {
+            using TStored = std::decay_t<TFunc>;
+            static_assert(sizeof(TStored) <= TCapacity, "Callable is too large for the inline buffer, capture less or capture a pointer");
+            static_assert(alignof(TStored) <= alignof(std::max_align_t), "Callable is over-aligned");
+            static_assert(std::is_invocable_r_v<TReturn, TStored&, TArgs...>, "Callable doesn't match the signature");
+
+            if constexpr (std::is_pointer_v<TStored> || std::is_member_pointer_v<TStored>)
+            {
+                if (!func)
+                    return;
+            }
+
+            new (mStorage) TStored(std::forward<TFunc>(func));
+            mpOps = &kOps<TStored>;
+        }
+
+        InlineFunction(InlineFunction&& other) noexcept
+        {
+            MoveFrom(other);
+        }
+
+        InlineFunction& operator=(InlineFunction&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                MoveFrom(other);
+            }
+            return *this;
+        }
+
+        InlineFunction& operator=(std::nullptr_t)
+        {
+            Reset();
+            return *this;
+        }
+
+        InlineFunction(const InlineFunction&) = delete;
+        InlineFunction& operator=(const InlineFunction&) = delete;
+
+        ~InlineFunction()
+        {
+            Reset();
+        }
+
+        TReturn operator()(TArgs... args) const
+        {
+            return mpOps->mInvoke((void*)mStorage, std::forward<TArgs>(args)...);
+        }
+
+        explicit operator bool() const { return mpOps != nullptr; }
+
+        void Reset()
+        {
+            if (mpOps)
+            {
+                mpOps->mDestroy(mStorage);
+                mpOps = nullptr;
+            }
+        }
+
+    private:
+        void MoveFrom(InlineFunction& other)
+        {
+            if (other.mpOps)
+            {
+                other.mpOps->mMove(mStorage, other.mStorage);
+                mpOps = other.mpOps;
+                other.mpOps = nullptr;
+            }
+        }
+
+    private:
+        alignas(std::max_align_t) std::byte mStorage[TCapacity];
+        const Ops*                          mpOps = nullptr;
+    };
+}
+
+#endif // !NV_INLINE_FUNCTION
@@ -0,0 +1,124 @@
+#ifndef NV_MPMC_QUEUE
+#define NV_MPMC_QUEUE
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace nv
+{
+    // Bounded lock-free multi producer, multi consumer ring.
+    // Every cell carries a sequence number telling producers and consumers
+    // whose turn it is, so a push or pop is a single CAS on the shared index.
+    // Move only types are fine, a popped cell keeps the moved-from value until reused.
+    // Reference: Dmitry Vyukov - "Bounded MPMC queue" (1024cores.net)
+    template<typename T, uint32_t TCapacity>
+    class MPMCQueue
+    {
+        static_assert((TCapacity & (TCapacity - 1)) == 0, "Capacity must be a power of two");
+        static_assert(std::is_default_constructible_v<T> && std::is_move_assignable_v<T>, "T must be default constructible and move assignable");
+
+        static constexpr size_t kMask = TCapacity - 1;
+
+    public:
+        MPMCQueue() :
+            mEnqueuePos(0),
+            mDequeuePos(0)
+        {
+            for (size_t i = 0; i < TCapacity; ++i)
+                mCells[i].mSequence.store(i, std::memory_order_relaxed);
+        }
+
+        MPMCQueue(const MPMCQueue&) = delete;
+        MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+        // Returns false when the queue is full, item is left untouched. It can also look
+        // full for a moment while a consumer is halfway through popping the cell we need.
+        bool TryPush(T&& item)
+        {
+            size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+            Cell* pCell = nullptr;
+            for (;;)
+            {
+                pCell = &mCells[pos & kMask];
+                const size_t sequence = pCell->mSequence.load(std::memory_order_acquire);
+                const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+                if (diff == 0)
+                {
+                    if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+
+            pCell->mData = std::move(item);
+            pCell->mSequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool TryPush(const T& item)
+        {
+            T copy = item;
+            return TryPush(std::move(copy));
+        }
+
+        // Returns false when the queue is empty, outItem is left untouched.
+        bool TryPop(T& outItem)
+        {
+            size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+            Cell* pCell = nullptr;
+            for (;;)
+            {
+                pCell = &mCells[pos & kMask];
+                const size_t sequence = pCell->mSequence.load(std::memory_order_acquire);
+                const intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+                if (diff == 0)
+                {
+                    if (mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = mDequeuePos.load(std::memory_order_relaxed);
+            }
+
+            outItem = std::move(pCell->mData);
+            pCell->mSequence.store(pos + kMask + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Approximate while other threads are pushing or popping
+        size_t Size() const
+        {
+            const size_t enqueuePos = mEnqueuePos.load(std::memory_order_relaxed);
+            const size_t dequeuePos = mDequeuePos.load(std::memory_order_relaxed);
+            return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+        }
+
+        bool IsEmpty() const { return Size() == 0; }
+
+        static constexpr uint32_t Capacity() { return TCapacity; }
+
+    private:
+        static constexpr size_t kCacheLineSize = 64;
+
+        struct Cell
+        {
+            std::atomic<size_t> mSequence;
+            T                   mData;
+        };
+
+        alignas(kCacheLineSize) Cell                mCells[TCapacity];
+        alignas(kCacheLineSize) std::atomic<size_t> mEnqueuePos;
+        alignas(kCacheLineSize) std::atomic<size_t> mDequeuePos;
+    };
+}
+
+#endif // !NV_MPMC_QUEUE
@@ -1,15 +1,27 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <type_traits>
 #include "Vector.h"
 #include <Lib/Util.h>
 #include <Lib/Map.h>
+#include <Lib/VirtualArray.h>
+#include <Platform/VirtualMemory.h>
 
 namespace nv
 {
     constexpr uint32_t kPoolInitDefaultSize = 4;
+    constexpr size_t   kPoolVirtualReserveSize = kVirtualArrayDefaultReserve;
+    constexpr uint32_t kSparsePageSize = 4096;     // SparseSetPool slots per page
 
-    template<typename T, typename TDerived = T, uint32_t InitPoolCount = kPoolInitDefaultSize>
+    enum class PoolBackend : uint8_t
+    {
+        Heap,       // Grows by reallocating and copying, pointers only stay valid until the next growth
+        Virtual,    // Reserves kPoolVirtualReserveSize of address space and commits pages as it grows, never moves
+    };
+
+    template<typename T, typename TDerived = T, uint32_t InitPoolCount = kPoolInitDefaultSize, PoolBackend Backend = PoolBackend::Heap>
     class Pool
     {
     public:
@@ -29,9 +41,23 @@ namespace nv
             mFreeIndices.reserve(kDefaultPoolCount);
         }
 
+        // Also called again after Destroy, which keeps the grown capacity, so start over from the default
         void Init()
         {
-            mBuffer = (TDerived*)SystemAllocator::gPtr->Allocate(sizeof(TDerived) * kDefaultPoolCount);
+            if constexpr (Backend == PoolBackend::Virtual)
+            {
+                if (!mBuffer)
+                    mBuffer = (TDerived*)platform::ReserveVirtualMemory(kPoolVirtualReserveSize);
+                const bool bCommitted = platform::CommitVirtualMemory(mBuffer, sizeof(TDerived) * kDefaultPoolCount);
+                assert(mBuffer && bCommitted);
+            }
+            else
+            {
+                if (mBuffer)
+                    SystemAllocator::gPtr->Free(mBuffer);
+                mBuffer = (TDerived*)SystemAllocator::gPtr->Allocate(sizeof(TDerived) * kDefaultPoolCount);
+            }
+            mCapacity = kDefaultPoolCount;
             mGenerations.resize(kDefaultPoolCount);
             mFreeIndices.reserve(kDefaultPoolCount);
             memset(mGenerations.data(), 0, mGenerations.size() * sizeof(uint32_t));
@@ -52,7 +78,9 @@ namespace nv
 
         ~Pool() 
         {
-            if (mBuffer)
+            if constexpr (Backend == PoolBackend::Virtual)
+                platform::ReleaseVirtualMemory(mBuffer, kPoolVirtualReserveSize);
+            else if (mBuffer)
                 SystemAllocator::gPtr->Free(mBuffer);
             mBuffer = nullptr;
         }
@@ -127,7 +155,7 @@ namespace nv
 
         Handle<T> Insert(TDerived&& data)
         {
-            return Create(data);
+            return Create(std::move(data));
         }
 
         constexpr Span<TDerived> Slice(size_t start, size_t end) const
@@ -198,11 +226,21 @@ namespace nv
                 auto oldCapacity = mCapacity;
                 mCapacity *= 2;
                 mCapacity = mCapacity >= requestSize ? mCapacity : (uint32_t)requestSize;
-                void* pBuffer = SystemAllocator::gPtr->Allocate(sizeof(TDerived) * mCapacity);// , mBuffer);
-                memcpy(pBuffer, mBuffer, oldCapacity * sizeof(TDerived));
-                if (mBuffer)
-                    SystemAllocator::gPtr->Free(mBuffer);
-                mBuffer = (TDerived*)pBuffer;
+                if constexpr (Backend == PoolBackend::Virtual)
+                {
+                    // Same address, only the new pages get committed
+                    assert(mCapacity * sizeof(TDerived) <= kPoolVirtualReserveSize);
+                    const bool bCommitted = platform::CommitVirtualMemory(mBuffer + oldCapacity, (mCapacity - oldCapacity) * sizeof(TDerived));
+                    assert(bCommitted);
+                }
+                else
+                {
+                    void* pBuffer = SystemAllocator::gPtr->Allocate(sizeof(TDerived) * mCapacity);// , mBuffer);
+                    memcpy(pBuffer, mBuffer, oldCapacity * sizeof(TDerived));
+                    if (mBuffer)
+                        SystemAllocator::gPtr->Free(mBuffer);
+                    mBuffer = (TDerived*)pBuffer;
+                }
 
                 mGenerations.resize(mCapacity);
             }
@@ -225,17 +263,19 @@ namespace nv
 
     // Gauranteed to have elements contiguously in memory. Useful for iterating.
     // More expensive to look up handle since it uses a map internally. 
-    template<typename T, typename TDerived = T, uint32_t InitPoolCount = kPoolInitDefaultSize>
+    // A handle's index is a slot with its own generation, the map takes it to
+    // the item's dense index, so moving an item never changes its handle.
+    template<typename T, typename TDerived = T, uint32_t InitPoolCount = kPoolInitDefaultSize, PoolBackend Backend = PoolBackend::Heap>
     class ContiguousPool
     {
+        using Storage = std::conditional_t<Backend == PoolBackend::Virtual, VirtualArray<TDerived>, std::vector<TDerived>>;
+
     public:
         ContiguousPool() :
             mCapacity(InitPoolCount)
         {
-            mGenerations.resize(InitPoolCount);
+            mGenerations.resize(InitPoolCount, 1);
             mPool.reserve(InitPoolCount);
-            for (auto& val : mGenerations)
-                val = 0;
         }
 
         void Init() {}
@@ -244,13 +284,24 @@ namespace nv
         template<typename ...Args>
         Handle<T> Create(Args&&... args)
         {
+            uint32_t slot = 0;
+            if (!mFreeSlots.empty())
+            {
+                slot = mFreeSlots.back();
+                mFreeSlots.pop_back();
+            }
+            else
+            {
+                slot = mSlotCount++;
+                GrowIfNeeded(mSlotCount);
+            }
+
             Handle<T> handle;
-            GrowIfNeeded();
-            handle.mIndex = (uint32_t)mPool.size();
+            handle.mIndex = slot;
+            handle.mGeneration = mGenerations[slot];
             mPool.emplace_back(nv::Forward<Args>(args)...);
-            
-            handle.mGeneration = mGenerations[handle.mIndex];
-            mHandleIndexMap[handle.mHandle] = handle.mIndex;
+            mHandleIndexMap[handle.mHandle] = (uint32_t)mPool.size() - 1;
+            mDenseHandles.push_back(handle.mHandle);
 
             return handle;
         }
@@ -262,7 +313,7 @@ namespace nv
 
         Handle<T> Insert(TDerived&& data)
         {
-            return Create(data);
+            return Create(std::move(data));
         }
 
         constexpr Span<TDerived> Span() const
@@ -274,12 +325,7 @@ namespace nv
 
         constexpr bool IsValid(Handle<T> handle) const
         {
-            auto it = mHandleIndexMap.find(handle.mHandle);
-            if (it == mHandleIndexMap.end())
-                return false;
-
-            const uint32_t idx = it->second;
-            return handle.mGeneration == mGenerations[idx];
+            return mHandleIndexMap.find(handle.mHandle) != mHandleIndexMap.end();
         }
 
         constexpr T* Get(Handle<T> handle) const
@@ -315,50 +361,305 @@ namespace nv
 
             const uint32_t idx = mHandleIndexMap.at(handle.mHandle);
             const uint32_t lastIdx = (uint32_t)mPool.size() - 1;
-            const auto lastHandle = Handle<T>(lastIdx, mGenerations[lastIdx]);
-
-            std::swap(mPool[idx], mPool[lastIdx]);
-            std::swap(mGenerations[idx], mGenerations[lastIdx]);
-            TDerived& val = mPool.back();
+            if (idx != lastIdx)
+            {
+                mPool[idx] = std::move(mPool[lastIdx]);
+                mDenseHandles[idx] = mDenseHandles[lastIdx];
+                mHandleIndexMap[mDenseHandles[idx]] = idx;
+            }
             mPool.pop_back();
-
-            val.~TDerived();
-            mGenerations[lastIdx]++;
-            
-            mHandleIndexMap[lastHandle.mHandle] = idx;
+            mDenseHandles.pop_back();
             mHandleIndexMap.erase(handle.mHandle);
+
+            // The slot's generation, not the moved item's. 0 is the null generation
+            uint32_t& generation = mGenerations[handle.mIndex];
+            generation = generation + 1 == 0 ? 1 : generation + 1;
+            mFreeSlots.push_back(handle.mIndex);
+        }
+
+        // Handle of the item at a dense index
+        Handle<T> GetHandle(size_t idx) const
+        {
+            Handle<T> handle;
+            handle.mHandle = mDenseHandles[idx];
+            return handle;
         }
 
-        void CopyToPool(TDerived* pData, size_t count)
+        // Replaces the items with pData, each under the handle it was copied out with.
+        // Handles live before the copy and not in pHandles stop being valid.
+        void CopyToPool(const TDerived* pData, const Handle<T>* pHandles, size_t count)
         {
+            for (uint64_t dense : mDenseHandles)
+            {
+                Handle<T> handle;
+                handle.mHandle = dense;
+                uint32_t& generation = mGenerations[handle.mIndex];
+                generation = generation + 1 == 0 ? 1 : generation + 1;
+            }
+
             mPool.resize(count/*, true*/);
             memcpy(mPool.data(), pData, count * sizeof(TDerived));
+
+            mHandleIndexMap.clear();
+            for (uint32_t i = 0; i < (uint32_t)count; ++i)
+                mHandleIndexMap[pHandles[i].mHandle] = i;
+            RebuildSlots();
         }
 
     private:
+        // Slot generations grow with the slots handed out, not with the items
         void GrowIfNeeded(size_t requestedSize)
         {
-            if (requestedSize >= mCapacity)
+            if (requestedSize > mGenerations.size())
             {
                 mCapacity = mCapacity * 2;
                 mCapacity = mCapacity >= requestedSize ? mCapacity : (uint32_t)requestedSize;
-                mGenerations.resize(mCapacity/*, true*/);
-                for (uint32_t i = (uint32_t)mPool.size(); i < mCapacity; ++i)
-                    mGenerations[i] = 0;
+                mGenerations.resize(mCapacity, 1);
             }
         }
 
-        void GrowIfNeeded()
+        // After deserializing, the map is all that says which slots are taken
+        void RebuildSlots()
         {
-            GrowIfNeeded(mPool.size() + 1);
+            mDenseHandles.assign(mPool.size(), 0);
+            mSlotCount = 0;
+            for (const auto& [handle, index] : mHandleIndexMap)
+            {
+                Handle<T> h;
+                h.mHandle = handle;
+                if (index < mDenseHandles.size())
+                    mDenseHandles[index] = handle;
+                mSlotCount = std::max(mSlotCount, h.mIndex + 1);
+            }
+
+            GrowIfNeeded(mSlotCount);
+            std::vector<bool> used(mSlotCount, false);
+            for (const auto& [handle, index] : mHandleIndexMap)
+            {
+                Handle<T> h;
+                h.mHandle = handle;
+                used[h.mIndex] = true;
+                mGenerations[h.mIndex] = h.mGeneration;
+            }
+
+            mFreeSlots.clear();
+            for (uint32_t slot = mSlotCount; slot-- > 0;)
+            {
+                if (!used[slot])
+                    mFreeSlots.push_back(slot);
+            }
         }
 
     private:
         uint32_t                mCapacity;
-        std::vector<TDerived>    mPool;
-        std::vector<uint32_t>    mGenerations;
+        Storage                  mPool;
+        std::vector<uint32_t>    mGenerations;      // By slot
 
         UnorderedMap<uint64_t, uint32_t> mHandleIndexMap;
+        std::vector<uint64_t>    mDenseHandles;     // Handle of the item at each dense index
+        std::vector<uint32_t>    mFreeSlots;
+        uint32_t                 mSlotCount = 0;    // Slots handed out so far, free ones included
+
+        friend class Serializer;
+    };
+
+    // Same interface and semantics as ContiguousPool: items stay contiguous and are swap-removed.
+    // A handle's index is a slot in a paged sparse array holding the item's dense index and
+    // generation, so a lookup is two array reads instead of a hash. Pages are allocated as slots
+    // are first used and never move, freed slots are reused with a new generation.
+    template<typename T, typename TDerived = T, uint32_t InitPoolCount = kPoolInitDefaultSize, PoolBackend Backend = PoolBackend::Heap>
+    class SparseSetPool
+    {
+        using Storage = std::conditional_t<Backend == PoolBackend::Virtual, VirtualArray<TDerived>, std::vector<TDerived>>;
+
+        static constexpr uint32_t kInvalidDense = ~0u;
+
+        struct SparseEntry
+        {
+            uint32_t mDense;        // Index in mPool, kInvalidDense while the slot is free
+            uint32_t mGeneration;
+        };
+
+    public:
+        SparseSetPool()
+        {
+            mPool.reserve(InitPoolCount);
+            mDenseSlots.reserve(InitPoolCount);
+        }
+
+        SparseSetPool(const SparseSetPool&) = delete;
+        SparseSetPool& operator=(const SparseSetPool&) = delete;
+
+        ~SparseSetPool()
+        {
+            for (SparseEntry* pPage : mPages)
+                SystemAllocator::gPtr->Free(pPage);
+        }
+
+        void Init() {}
+        void Destroy() {}
+
+        template<typename ...Args>
+        Handle<T> Create(Args&&... args)
+        {
+            uint32_t slot = 0;
+            if (!mFreeSlots.empty())
+            {
+                slot = mFreeSlots.back();
+                mFreeSlots.pop_back();
+            }
+            else
+            {
+                slot = mSlotCount++;
+                if (slot >= mPages.size() * kSparsePageSize)
+                    AddPage();
+            }
+
+            SparseEntry& entry = GetEntry(slot);
+            entry.mDense = (uint32_t)mPool.size();
+            mPool.emplace_back(nv::Forward<Args>(args)...);
+            mDenseSlots.push_back(slot);
+
+            Handle<T> handle;
+            handle.mIndex = slot;
+            handle.mGeneration = entry.mGeneration;
+            return handle;
+        }
+
+        Handle<T> Insert(const TDerived& data)
+        {
+            return Create(data);
+        }
+
+        Handle<T> Insert(TDerived&& data)
+        {
+            return Create(std::move(data));
+        }
+
+        constexpr Span<TDerived> Span() const
+        {
+            auto pData = mPool.data();
+            auto pTData = (TDerived*)pData;
+            return nv::Span<TDerived>(pTData, mPool.size());
+        }
+
+        constexpr bool IsValid(Handle<T> handle) const
+        {
+            return handle.mIndex < mSlotCount && GetEntry(handle.mIndex).mGeneration == handle.mGeneration;
+        }
+
+        constexpr T* Get(Handle<T> handle) const
+        {
+            assert(IsValid(handle));
+            return (T*)&mPool[GetEntry(handle.mIndex).mDense];
+        }
+
+        constexpr const TDerived* GetAsDerived(Handle<T> handle) const
+        {
+            assert(IsValid(handle));
+            return &mPool[GetEntry(handle.mIndex).mDense];
+        }
+
+        constexpr TDerived* GetAsDerived(Handle<T> handle)
+        {
+            assert(IsValid(handle));
+            return &mPool[GetEntry(handle.mIndex).mDense];
+        }
+
+        constexpr size_t Size() const
+        {
+            return mPool.size();
+        }
+
+        constexpr TDerived& operator[](size_t idx) { return mPool[idx]; }
+        constexpr const TDerived& operator[](size_t idx) const { return mPool[idx]; }
+
+        void Remove(Handle<T> handle)
+        {
+            if (!IsValid(handle))
+                return;
+
+            SparseEntry& entry = GetEntry(handle.mIndex);
+            const uint32_t idx = entry.mDense;
+            const uint32_t lastIdx = (uint32_t)mPool.size() - 1;
+            if (idx != lastIdx)
+            {
+                mPool[idx] = std::move(mPool[lastIdx]);
+                mDenseSlots[idx] = mDenseSlots[lastIdx];
+                GetEntry(mDenseSlots[idx]).mDense = idx;
+            }
+            mPool.pop_back();
+            mDenseSlots.pop_back();
+
+            // 0 is the null generation
+            entry.mDense = kInvalidDense;
+            entry.mGeneration = entry.mGeneration + 1 == 0 ? 1 : entry.mGeneration + 1;
+            mFreeSlots.push_back(handle.mIndex);
+        }
+
+        // Handle of the item at a dense index
+        Handle<T> GetHandle(size_t idx) const
+        {
+            Handle<T> handle;
+            handle.mIndex = mDenseSlots[idx];
+            handle.mGeneration = GetEntry(handle.mIndex).mGeneration;
+            return handle;
+        }
+
+        // Replaces the items with pData, each under the handle it was copied out with.
+        // Handles live before the copy and not in pHandles stop being valid.
+        void CopyToPool(const TDerived* pData, const Handle<T>* pHandles, size_t count)
+        {
+            for (uint32_t slot : mDenseSlots)
+            {
+                SparseEntry& entry = GetEntry(slot);
+                entry.mDense = kInvalidDense;
+                entry.mGeneration = entry.mGeneration + 1 == 0 ? 1 : entry.mGeneration + 1;
+            }
+
+            mPool.resize(count);
+            memcpy(mPool.data(), pData, count * sizeof(TDerived));
+
+            mDenseSlots.resize(count);
+            for (uint32_t i = 0; i < (uint32_t)count; ++i)
+            {
+                const uint32_t slot = pHandles[i].mIndex;
+                while (slot >= mPages.size() * kSparsePageSize)
+                    AddPage();
+                mSlotCount = std::max(mSlotCount, slot + 1);
+
+                GetEntry(slot) = { i, pHandles[i].mGeneration };
+                mDenseSlots[i] = slot;
+            }
+
+            mFreeSlots.clear();
+            for (uint32_t slot = mSlotCount; slot-- > 0;)
+            {
+                if (GetEntry(slot).mDense == kInvalidDense)
+                    mFreeSlots.push_back(slot);
+            }
+        }
+
+    private:
+        SparseEntry& GetEntry(uint32_t slot) const
+        {
+            return mPages[slot / kSparsePageSize][slot % kSparsePageSize];
+        }
+
+        void AddPage()
+        {
+            SparseEntry* pPage = (SparseEntry*)SystemAllocator::gPtr->Allocate(sizeof(SparseEntry) * kSparsePageSize);
+            for (uint32_t i = 0; i < kSparsePageSize; ++i)
+                pPage[i] = { kInvalidDense, 1 };
+            mPages.push_back(pPage);
+        }
+
+    private:
+        Storage                     mPool;
+        std::vector<uint32_t>       mDenseSlots;    // Sparse slot of the item in each dense index
+        std::vector<SparseEntry*>   mPages;         // kSparsePageSize entries each
+        std::vector<uint32_t>       mFreeSlots;
+        uint32_t                    mSlotCount = 0; // Slots handed out so far, free ones included
 
         friend class Serializer;
     };
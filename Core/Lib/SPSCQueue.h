@@ -0,0 +1,93 @@
+#ifndef NV_SPSC_QUEUE
+#define NV_SPSC_QUEUE
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace nv
+{
+    // Bounded lock-free ring for exactly one producer thread and one consumer thread,
+    // e.g. the main thread handing frame data to the render thread. Each side only
+    // writes its own index and keeps a cached copy of the other one, so the shared
+    // cache lines are only touched when the cached view says the ring is full or empty.
+    // Move only types are fine, a popped cell keeps the moved-from value until reused.
+    template<typename T, uint32_t TCapacity>
+    class SPSCQueue
+    {
+        static_assert((TCapacity & (TCapacity - 1)) == 0, "Capacity must be a power of two");
+        static_assert(std::is_default_constructible_v<T> && std::is_move_assignable_v<T>, "T must be default constructible and move assignable");
+
+        static constexpr size_t kMask = TCapacity - 1;
+
+    public:
+        SPSCQueue() = default;
+
+        SPSCQueue(const SPSCQueue&) = delete;
+        SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+        // Producer only. Returns false when the queue is full, item is left untouched.
+        bool TryPush(T&& item)
+        {
+            const size_t tail = mTail.load(std::memory_order_relaxed);
+            if (tail - mCachedHead == TCapacity)
+            {
+                mCachedHead = mHead.load(std::memory_order_acquire);
+                if (tail - mCachedHead == TCapacity)
+                    return false;
+            }
+
+            mCells[tail & kMask] = std::move(item);
+            mTail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool TryPush(const T& item)
+        {
+            T copy = item;
+            return TryPush(std::move(copy));
+        }
+
+        // Consumer only. Returns false when the queue is empty, outItem is left untouched.
+        bool TryPop(T& outItem)
+        {
+            const size_t head = mHead.load(std::memory_order_relaxed);
+            if (head == mCachedTail)
+            {
+                mCachedTail = mTail.load(std::memory_order_acquire);
+                if (head == mCachedTail)
+                    return false;
+            }
+
+            outItem = std::move(mCells[head & kMask]);
+            mHead.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Approximate unless called from the producer or consumer with the other side idle
+        size_t Size() const
+        {
+            const size_t tail = mTail.load(std::memory_order_acquire);
+            const size_t head = mHead.load(std::memory_order_acquire);
+            return tail > head ? tail - head : 0;
+        }
+
+        bool IsEmpty() const { return Size() == 0; }
+
+        static constexpr uint32_t Capacity() { return TCapacity; }
+
+    private:
+        static constexpr size_t kCacheLineSize = 64;
+
+        T                                           mCells[TCapacity] = {};
+        alignas(kCacheLineSize) std::atomic<size_t> mHead = 0;       // Written by the consumer
+        size_t                                      mCachedTail = 0; // Consumer's view of mTail
+        alignas(kCacheLineSize) std::atomic<size_t> mTail = 0;       // Written by the producer
+        size_t                                      mCachedHead = 0; // Producer's view of mHead
+    };
+}
+
+#endif // !NV_SPSC_QUEUE
@@ -16,8 +16,8 @@ namespace nv
     class Serializer
     {
     public:
-        template<typename T, typename TDerived>
-        static void Serialize(Pool<T, TDerived>& pool, std::ostream& o)
+        template<typename T, typename TDerived, uint32_t InitPoolCount, PoolBackend Backend>
+        static void Serialize(Pool<T, TDerived, InitPoolCount, Backend>& pool, std::ostream& o)
         {
             using namespace cereal;
             cereal::BinaryOutputArchive archive(o);
@@ -28,39 +28,117 @@ namespace nv
             archive(pool.mGenerations);
         }
 
-        template<typename T, typename TDerived>
-        static void Serialize(ContiguousPool<T, TDerived>& pool, std::ostream& o)
+        template<typename T, typename TDerived, uint32_t InitPoolCount, PoolBackend Backend>
+        static void Serialize(ContiguousPool<T, TDerived, InitPoolCount, Backend>& pool, std::ostream& o)
         {
             using namespace cereal;
             cereal::BinaryOutputArchive archive(o);
             archive(pool.mCapacity);
-            archive(pool.mPool);
+            if constexpr (Backend == PoolBackend::Virtual)
+            {
+                archive(make_size_tag(static_cast<size_type>(pool.mPool.size())));
+                for (auto& item : pool.mPool)
+                    archive(item);
+            }
+            else
+            {
+                archive(pool.mPool);
+            }
             archive(pool.mHandleIndexMap);
             archive(pool.mGenerations);
         }
 
-        template<typename T, typename TDerived>
-        static void Deserialize(Pool<T, TDerived>& pool, std::istream& i)
+        template<typename T, typename TDerived, uint32_t InitPoolCount, PoolBackend Backend>
+        static void Deserialize(Pool<T, TDerived, InitPoolCount, Backend>& pool, std::istream& i)
         {
             using namespace cereal;
             cereal::BinaryInputArchive archive(i);
-            archive(pool.mCapacity);
-            pool.GrowIfNeeded(pool.mCapacity);
+            uint32_t capacity = 0;
+            archive(capacity);
+            pool.GrowIfNeeded(capacity);
             archive(pool.mSize);
             archive(binary_data(pool.mBuffer, static_cast<std::size_t>(pool.mSize) * sizeof(TDerived)));
             archive(pool.mFreeIndices);
             archive(pool.mGenerations);
         }
 
-        template<typename T, typename TDerived>
-        static void Deserialize(ContiguousPool<T, TDerived>& pool, std::istream& i)
+        template<typename T, typename TDerived, uint32_t InitPoolCount, PoolBackend Backend>
+        static void Deserialize(ContiguousPool<T, TDerived, InitPoolCount, Backend>& pool, std::istream& i)
         {
             using namespace cereal;
             cereal::BinaryInputArchive archive(i);
             archive(pool.mCapacity);
-            archive(pool.mPool);
+            if constexpr (Backend == PoolBackend::Virtual)
+            {
+                size_type size = 0;
+                archive(make_size_tag(size));
+                pool.mPool.resize(static_cast<size_t>(size));
+                for (auto& item : pool.mPool)
+                    archive(item);
+            }
+            else
+            {
+                archive(pool.mPool);
+            }
             archive(pool.mHandleIndexMap);
             archive(pool.mGenerations);
+            pool.RebuildSlots();
+        }
+
+        template<typename T, typename TDerived, uint32_t InitPoolCount, PoolBackend Backend>
+        static void Serialize(SparseSetPool<T, TDerived, InitPoolCount, Backend>& pool, std::ostream& o)
+        {
+            using namespace cereal;
+            cereal::BinaryOutputArchive archive(o);
+            if constexpr (Backend == PoolBackend::Virtual)
+            {
+                archive(make_size_tag(static_cast<size_type>(pool.mPool.size())));
+                for (auto& item : pool.mPool)
+                    archive(item);
+            }
+            else
+            {
+                archive(pool.mPool);
+            }
+            archive(pool.mDenseSlots);
+            archive(pool.mFreeSlots);
+
+            std::vector<uint32_t> generations(pool.mSlotCount);
+            for (uint32_t slot = 0; slot < pool.mSlotCount; ++slot)
+                generations[slot] = pool.GetEntry(slot).mGeneration;
+            archive(generations);
+        }
+
+        template<typename T, typename TDerived, uint32_t InitPoolCount, PoolBackend Backend>
+        static void Deserialize(SparseSetPool<T, TDerived, InitPoolCount, Backend>& pool, std::istream& i)
+        {
+            using namespace cereal;
+            cereal::BinaryInputArchive archive(i);
+            if constexpr (Backend == PoolBackend::Virtual)
+            {
+                size_type size = 0;
+                archive(make_size_tag(size));
+                pool.mPool.resize(static_cast<size_t>(size));
+                for (auto& item : pool.mPool)
+                    archive(item);
+            }
+            else
+            {
+                archive(pool.mPool);
+            }
+            archive(pool.mDenseSlots);
+            archive(pool.mFreeSlots);
+
+            std::vector<uint32_t> generations;
+            archive(generations);
+            pool.mSlotCount = (uint32_t)generations.size();
+            while (pool.mPages.size() * kSparsePageSize < pool.mSlotCount)
+                pool.AddPage();
+
+            for (uint32_t slot = 0; slot < pool.mSlotCount; ++slot)
+                pool.GetEntry(slot) = { SparseSetPool<T, TDerived, InitPoolCount, Backend>::kInvalidDense, generations[slot] };
+            for (uint32_t index = 0; index < (uint32_t)pool.mDenseSlots.size(); ++index)
+                pool.GetEntry(pool.mDenseSlots[index]).mDense = index;
         }
     };
 }
\ No newline at end of file
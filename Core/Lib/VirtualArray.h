@@ -0,0 +1,111 @@
+#pragma once
+
+#include <Platform/VirtualMemory.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace nv
+{
+    constexpr size_t kVirtualArrayDefaultReserve = 1ull << 30;
+
+    // Reserves address space for its largest size up front and commits pages as it grows,
+    // so elements never move: growing costs page faults instead of a copy, and pointers stay
+    // valid until their element is removed. Has the part of std::vector's interface the
+    // pools use, so it can stand in for one.
+    template<typename T>
+    class VirtualArray
+    {
+    public:
+        explicit VirtualArray(size_t reserveSize = kVirtualArrayDefaultReserve) :
+            mReserveSize(reserveSize)
+        {
+        }
+
+        VirtualArray(const VirtualArray&) = delete;
+        VirtualArray& operator=(const VirtualArray&) = delete;
+
+        ~VirtualArray()
+        {
+            clear();
+            platform::ReleaseVirtualMemory(mpData, mReserveSize);
+        }
+
+        void reserve(size_t count)
+        {
+            if (count <= mCapacity)
+                return;
+
+            if (!mpData)
+            {
+                mpData = (T*)platform::ReserveVirtualMemory(mReserveSize);
+                assert(mpData);
+            }
+
+            // Whole pages get committed anyway, so the capacity takes all of them
+            const size_t pageSize = platform::GetPageSize();
+            const size_t bytes = std::min((count * sizeof(T) + pageSize - 1) & ~(pageSize - 1), mReserveSize);
+            assert(count <= GetMaxSize()); // Out of reserved address space
+
+            const size_t committed = mCapacity * sizeof(T);
+            const bool bCommitted = platform::CommitVirtualMemory((uint8_t*)mpData + committed, bytes - committed);
+            assert(bCommitted);
+            mCapacity = bytes / sizeof(T);
+        }
+
+        template<typename ...Args>
+        T& emplace_back(Args&&... args)
+        {
+            if (mSize == mCapacity)
+                reserve(std::max(mSize + 1, mCapacity * 2));
+
+            T* pItem = new (mpData + mSize) T(std::forward<Args>(args)...);
+            ++mSize;
+            return *pItem;
+        }
+
+        void push_back(const T& value) { emplace_back(value); }
+        void push_back(T&& value) { emplace_back(std::move(value)); }
+
+        void pop_back()
+        {
+            assert(mSize > 0);
+            mpData[--mSize].~T();
+        }
+
+        void resize(size_t count)
+        {
+            reserve(count);
+            while (mSize < count)
+                new (mpData + mSize++) T();
+            while (mSize > count)
+                mpData[--mSize].~T();
+        }
+
+        void clear() { resize(0); }
+
+        T&          operator[](size_t index) { return mpData[index]; }
+        const T&    operator[](size_t index) const { return mpData[index]; }
+        T&          at(size_t index) { assert(index < mSize); return mpData[index]; }
+        const T&    at(size_t index) const { assert(index < mSize); return mpData[index]; }
+        T&          back() { assert(mSize > 0); return mpData[mSize - 1]; }
+
+        T*          data() const { return mpData; }
+        T*          begin() const { return mpData; }
+        T*          end() const { return mpData + mSize; }
+        size_t      size() const { return mSize; }
+        size_t      capacity() const { return mCapacity; }
+        bool        empty() const { return mSize == 0; }
+
+        size_t      GetMaxSize() const { return mReserveSize / sizeof(T); }
+
+    private:
+        T*          mpData = nullptr;
+        size_t      mSize = 0;
+        size_t      mCapacity = 0;
+        size_t      mReserveSize;
+    };
+}
@@ -0,0 +1,119 @@
+#ifndef NV_WORK_STEALING_QUEUE
+#define NV_WORK_STEALING_QUEUE
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace nv
+{
+    constexpr uint32_t kWorkStealingQueueDefaultSize = 4096;
+
+    // Fixed capacity Chase-Lev deque.
+    // Only the owning thread may call Push() and Pop() (LIFO end), any other
+    // thread may call Steal() (FIFO end). Push() fails when the deque is full
+    // instead of growing, so callers must provide an overflow path.
+    // Reference: Le, Pop, Cohen, Nardelli - "Correct and Efficient Work-Stealing
+    // for Weak Memory Models" (PPoPP 2013)
+    template<typename T, uint32_t TCapacity = kWorkStealingQueueDefaultSize>
+    class WorkStealingQueue
+    {
+        static_assert((TCapacity & (TCapacity - 1)) == 0, "Capacity must be a power of two");
+        static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+        static constexpr int64_t kMask = TCapacity - 1;
+
+    public:
+        WorkStealingQueue() :
+            mTop(0),
+            mBottom(0)
+        {}
+
+        WorkStealingQueue(const WorkStealingQueue&) = delete;
+        WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+        // Owner thread only
+        bool Push(const T& item)
+        {
+            const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+            const int64_t top = mTop.load(std::memory_order_acquire);
+            if (bottom - top >= (int64_t)TCapacity)
+                return false;
+
+            mBuffer[bottom & kMask].store(item, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Owner thread only
+        bool Pop(T& outItem)
+        {
+            const int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+            mBottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = mTop.load(std::memory_order_relaxed);
+
+            if (top > bottom)
+            {
+                // Empty
+                mBottom.store(bottom + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            const T item = mBuffer[bottom & kMask].load(std::memory_order_relaxed);
+            if (top != bottom)
+            {
+                outItem = item;
+                return true;
+            }
+
+            // Last item, race against thieves
+            const bool bWon = mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            mBottom.store(bottom + 1, std::memory_order_relaxed);
+            if (bWon)
+                outItem = item;
+            return bWon;
+        }
+
+        // Any thread
+        bool Steal(T& outItem)
+        {
+            int64_t top = mTop.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t bottom = mBottom.load(std::memory_order_acquire);
+
+            if (top >= bottom)
+                return false;
+
+            const T item = mBuffer[top & kMask].load(std::memory_order_relaxed);
+            if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return false;
+
+            outItem = item;
+            return true;
+        }
+
+        size_t Size() const
+        {
+            const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+            const int64_t top = mTop.load(std::memory_order_relaxed);
+            return bottom > top ? (size_t)(bottom - top) : 0;
+        }
+
+        bool IsEmpty() const { return Size() == 0; }
+
+        static constexpr uint32_t Capacity() { return TCapacity; }
+
+    private:
+        static constexpr size_t kCacheLineSize = 64;
+
+        alignas(kCacheLineSize) std::atomic<int64_t>    mTop;
+        alignas(kCacheLineSize) std::atomic<int64_t>    mBottom;
+        alignas(kCacheLineSize) std::atomic<T>          mBuffer[TCapacity];
+    };
+}
+
+#endif // !NV_WORK_STEALING_QUEUE
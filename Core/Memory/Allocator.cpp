@@ -2,8 +2,13 @@
 
 #include "Allocator.h"
 #include "Memory/Memory.h"
+#include "Memory/TlsfAllocator.h"
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
+#include <algorithm>
+#include <bit>
+#include <malloc.h>
 
 
 #include <Debug/Profiler.h>
@@ -17,13 +22,54 @@ namespace nv
 {
     SystemAllocator gSysAllocator;
     SystemAllocator* SystemAllocator::gPtr = &gSysAllocator;
+    static std::atomic<uint64_t> gSysAllocationCount = 0;
+
+    // Created on first use and never destroyed, see InitSystemAllocator
+    static std::atomic<TlsfAllocator*> gpTlsfHeap = nullptr;
+    static std::atomic<bool> gbUseTlsfHeap = false;
+    alignas(TlsfAllocator) static Byte gTlsfHeapStorage[sizeof(TlsfAllocator)];
+
+    void InitSystemAllocator(SystemAllocatorBackend backend, size_t poolSize)
+    {
+        if (backend == SystemAllocatorBackend::Tlsf && !gpTlsfHeap.load(std::memory_order_acquire))
+            gpTlsfHeap.store(new (gTlsfHeapStorage) TlsfAllocator(poolSize), std::memory_order_release);
+
+        gbUseTlsfHeap.store(backend == SystemAllocatorBackend::Tlsf, std::memory_order_release);
+    }
+
+    static TlsfAllocator* GetTlsfHeapOf(void* ptr)
+    {
+        TlsfAllocator* pHeap = gpTlsfHeap.load(std::memory_order_acquire);
+        return pHeap && ptr && pHeap->Owns(ptr) ? pHeap : nullptr;
+    }
+
+    // Tracked sizes come from the heap, so a free can report what its allocation did without a lookup
+    static size_t GetUsableSize(void* ptr)
+    {
+        if (!ptr)
+            return 0;
+        if (TlsfAllocator* pHeap = GetTlsfHeapOf(ptr))
+            return pHeap->GetAllocationSize(ptr);
+#if NV_PLATFORM_WINDOWS
+        return _msize(ptr);
+#else
+        return malloc_usable_size(ptr);
+#endif
+    }
 
     void* SystemAllocator::Allocate(size_t size)
     {
-        void* ptr = malloc(size);
+        void* ptr = nullptr;
+        TlsfAllocator* pHeap = gbUseTlsfHeap.load(std::memory_order_acquire) ? gpTlsfHeap.load(std::memory_order_relaxed) : nullptr;
+        if (pHeap && size <= pHeap->GetPoolSize() / 2)
+            ptr = pHeap->Allocate(size);
+        else
+            ptr = malloc(size);
+
+        gSysAllocationCount.fetch_add(1, std::memory_order_relaxed);
         NV_MEM_ALLOC(ptr, size);
         if(nv::MemTracker::gPtr)
-            nv::MemTracker::gPtr->TrackSysAlloc(ptr, size);
+            nv::MemTracker::gPtr->TrackSysAlloc(ptr, GetUsableSize(ptr));
         return ptr;
     }
 
@@ -31,36 +77,287 @@ namespace nv
     {
         NV_MEM_FREE(ptr);
         if (nv::MemTracker::gPtr)
-            nv::MemTracker::gPtr->TrackSysFree(ptr);
-        free(ptr);
+            nv::MemTracker::gPtr->TrackSysFree(ptr, GetUsableSize(ptr));
+
+        if (TlsfAllocator* pHeap = GetTlsfHeapOf(ptr))
+            pHeap->Free(ptr);
+        else
+            free(ptr);
+    }
+
+    uint64_t SystemAllocator::GetAllocationCount()
+    {
+        return gSysAllocationCount.load(std::memory_order_relaxed);
     }
 
     void* SystemAllocator::Realloc(size_t size, void* ptr)
     {
-        auto buffer = realloc(ptr, size);
-        if (nv::MemTracker::gPtr)
+        // Memory stays in the heap it was allocated from
+        const size_t oldSize = GetUsableSize(ptr);
+        void* buffer = nullptr;
+        if (TlsfAllocator* pHeap = GetTlsfHeapOf(ptr))
+            buffer = pHeap->Realloc(size, ptr);
+        else if (!ptr)
+            buffer = Allocate(size);
+        else
+            buffer = realloc(ptr, size);
+
+        if (nv::MemTracker::gPtr && ptr)
         {
-            nv::MemTracker::gPtr->TrackSysFree(ptr);
-            nv::MemTracker::gPtr->TrackSysAlloc(buffer, size);
+            nv::MemTracker::gPtr->TrackSysFree(ptr, oldSize);
+            nv::MemTracker::gPtr->TrackSysAlloc(buffer, GetUsableSize(buffer));
         }
         return buffer;
     }
 
-    void* ArenaAllocator::Allocate(size_t size)
+    struct ArenaAllocator::Chunk
+    {
+        Chunk*  mpPrev;
+        Byte*   mpCurrent;
+        Byte*   mpEnd;
+        bool    mbExternal; // Caller's buffer, never freed
+
+        Byte*   Begin() { return (Byte*)(this + 1); }
+        size_t  Size() { return mpEnd - Begin(); }
+        size_t  Used() { return mpCurrent - Begin(); }
+        bool    Contains(const void* ptr) { return ptr >= Begin() && ptr <= mpEnd; }
+    };
+
+    static Byte* AlignPointer(Byte* ptr, size_t alignment)
+    {
+        return (Byte*)(((uintptr_t)ptr + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+
+    ArenaAllocator::ArenaAllocator(void* pBuffer, size_t capacity, IAllocator* allocator) :
+        mChunkSize(capacity),
+        mAllocator(allocator)
     {
-        // This allocator cannot grow
-        assert((mCurrent - mBuffer) + size <= mCapacity);
-        if ((mCurrent - mBuffer) + size > mCapacity)
+        Byte* pBegin = AlignPointer((Byte*)pBuffer, alignof(Chunk));
+        assert(pBuffer && pBegin + sizeof(Chunk) <= (Byte*)pBuffer + capacity);
+
+        mpHead = (Chunk*)pBegin;
+        mpHead->mpPrev = nullptr;
+        mpHead->mpCurrent = mpHead->Begin();
+        mpHead->mpEnd = (Byte*)pBuffer + capacity;
+        mpHead->mbExternal = true;
+    }
+
+    ArenaAllocator::~ArenaAllocator()
+    {
+        while (mpHead)
+        {
+            Chunk* pPrev = mpHead->mpPrev;
+            FreeChunk(mpHead);
+            mpHead = pPrev;
+        }
+
+        FreeChunk(mpSpare);
+        mpSpare = nullptr;
+    }
+
+    void* ArenaAllocator::Allocate(size_t size, size_t alignment)
+    {
+        assert((alignment & (alignment - 1)) == 0);
+        if (mpHead)
+        {
+            Byte* ptr = AlignPointer(mpHead->mpCurrent, alignment);
+            if (ptr + size <= mpHead->mpEnd)
+            {
+                mpHead->mpCurrent = ptr + size;
+                return ptr;
+            }
+        }
+
+        Chunk* pChunk = AddChunk(size, alignment);
+        if (!pChunk)
             return nullptr;
 
-        auto buffer = mCurrent;
-        mCurrent += size;
-        return buffer;
+        Byte* ptr = AlignPointer(pChunk->mpCurrent, alignment);
+        pChunk->mpCurrent = ptr + size;
+        return ptr;
+    }
+
+    ArenaAllocator::Chunk* ArenaAllocator::AddChunk(size_t size, size_t alignment)
+    {
+        const size_t required = size + alignment; // Worst case padding
+        Chunk* pChunk = nullptr;
+        if (mpSpare && mpSpare->Size() >= required)
+        {
+            pChunk = mpSpare;
+            mpSpare = nullptr;
+        }
+        else
+        {
+            // Fixed buffer arena without a backing allocator
+            assert(mAllocator);
+            if (!mAllocator)
+                return nullptr;
+
+            // Doubling keeps the chunk count logarithmic in the peak size
+            size_t chunkSize = mpHead ? std::max(mChunkSize, mpHead->Size() * 2) : mChunkSize;
+            chunkSize = std::max(chunkSize, required);
+
+            pChunk = (Chunk*)mAllocator->Allocate(sizeof(Chunk) + chunkSize);
+            if (!pChunk)
+                return nullptr;
+
+            pChunk->mpEnd = pChunk->Begin() + chunkSize;
+            pChunk->mbExternal = false;
+        }
+
+        pChunk->mpPrev = mpHead;
+        pChunk->mpCurrent = pChunk->Begin();
+        mpHead = pChunk;
+        return pChunk;
+    }
+
+    void ArenaAllocator::ReleaseChunk(Chunk* pChunk)
+    {
+        if (pChunk->mbExternal)
+            return;
+
+        if (mpSpare && mpSpare->Size() >= pChunk->Size())
+        {
+            FreeChunk(pChunk);
+            return;
+        }
+
+        FreeChunk(mpSpare);
+        mpSpare = pChunk;
+    }
+
+    void ArenaAllocator::FreeChunk(Chunk* pChunk)
+    {
+        if (pChunk && !pChunk->mbExternal)
+            mAllocator->Free(pChunk);
     }
 
     void ArenaAllocator::Reset()
     {
-        mCurrent = mBuffer;
+        Chunk* pKeep = mpSpare;
+        for (Chunk* pChunk = mpHead; pChunk; pChunk = pChunk->mpPrev)
+        {
+            if (!pKeep || pChunk->Size() > pKeep->Size())
+                pKeep = pChunk;
+        }
+
+        for (Chunk* pChunk = mpHead; pChunk;)
+        {
+            Chunk* pPrev = pChunk->mpPrev;
+            if (pChunk != pKeep)
+                FreeChunk(pChunk);
+            pChunk = pPrev;
+        }
+
+        if (mpSpare != pKeep)
+            FreeChunk(mpSpare);
+
+        mpSpare = nullptr;
+        mpHead = pKeep;
+        if (mpHead)
+        {
+            mpHead->mpPrev = nullptr;
+            mpHead->mpCurrent = mpHead->Begin();
+        }
+    }
+
+    ArenaAllocator::Marker ArenaAllocator::GetMarker() const
+    {
+        return Marker{ mpHead, mpHead ? mpHead->mpCurrent : nullptr };
+    }
+
+    void ArenaAllocator::Rewind(const Marker& marker)
+    {
+        while (mpHead && mpHead != marker.mpChunk)
+        {
+            Chunk* pPrev = mpHead->mpPrev;
+            ReleaseChunk(mpHead);
+            mpHead = pPrev;
+        }
+
+        // Marker from before a Reset, or from another arena
+        assert(mpHead == marker.mpChunk);
+        if (mpHead)
+        {
+            assert(mpHead->Contains(marker.mpCurrent) && marker.mpCurrent <= mpHead->mpCurrent);
+            mpHead->mpCurrent = marker.mpCurrent;
+        }
+    }
+
+    size_t ArenaAllocator::GetAllocatedSize() const
+    {
+        size_t size = 0;
+        for (Chunk* pChunk = mpHead; pChunk; pChunk = pChunk->mpPrev)
+            size += pChunk->Used();
+        return size;
+    }
+
+    size_t ArenaAllocator::GetCapacity() const
+    {
+        size_t capacity = mpSpare ? mpSpare->Size() : 0;
+        for (Chunk* pChunk = mpHead; pChunk; pChunk = pChunk->mpPrev)
+            capacity += pChunk->Size();
+        return capacity;
+    }
+
+    uint32_t ArenaAllocator::GetChunkCount() const
+    {
+        uint32_t count = 0;
+        for (Chunk* pChunk = mpHead; pChunk; pChunk = pChunk->mpPrev)
+            ++count;
+        return count;
+    }
+
+    void StackAllocator::Free(void* ptr)
+    {
+        for (Chunk* pChunk = mpHead; pChunk; pChunk = pChunk->mpPrev)
+        {
+            if (pChunk->Contains(ptr))
+            {
+                Rewind(Marker{ pChunk, (Byte*)ptr });
+                return;
+            }
+        }
+
+        assert(false); // Not from this allocator
+    }
+
+    static_assert(kAllocatorThreadSlots == 64, "Thread slots are handed out from a 64 bit mask");
+    static std::atomic<uint64_t> gAllocatorThreadSlotMask = 0;
+
+    struct AllocatorThreadSlot
+    {
+        uint32_t mIndex = kNoAllocatorThreadSlot;
+        bool     mbAcquired = false;
+
+        ~AllocatorThreadSlot()
+        {
+            if (mIndex != kNoAllocatorThreadSlot)
+                gAllocatorThreadSlotMask.fetch_and(~(1ull << mIndex), std::memory_order_release);
+            mIndex = kNoAllocatorThreadSlot; // Frees from later thread_local destructors skip the caches
+        }
+    };
+
+    static thread_local AllocatorThreadSlot tAllocatorThreadSlot;
+
+    uint32_t GetAllocatorThreadSlot()
+    {
+        if (!tAllocatorThreadSlot.mbAcquired)
+        {
+            tAllocatorThreadSlot.mbAcquired = true;
+            uint64_t mask = gAllocatorThreadSlotMask.load(std::memory_order_relaxed);
+            while (~mask)
+            {
+                const uint32_t index = (uint32_t)std::countr_zero(~mask);
+                if (gAllocatorThreadSlotMask.compare_exchange_weak(mask, mask | (1ull << index), std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    tAllocatorThreadSlot.mIndex = index;
+                    break;
+                }
+            }
+        }
+
+        return tAllocatorThreadSlot.mIndex;
     }
 
     void* Alloc(size_t size, IAllocator* alloc)
@@ -72,12 +369,14 @@ namespace nv
     {
         void* ptr = alloc->Allocate(size);
         if (nv::MemTracker::gPtr)
-            nv::MemTracker::gPtr->TrackSysAlloc(ptr, size);
+            nv::MemTracker::gPtr->TrackAllocTagged(ptr, size, tag);
         return ptr;
     }
 
     void Free(void* ptr, IAllocator* alloc)
     {
+        if (nv::MemTracker::gPtr)
+            nv::MemTracker::gPtr->TrackFree(ptr);
         alloc->Free(ptr);
     }
 }
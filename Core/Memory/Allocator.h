@@ -3,6 +3,9 @@
 #include <Lib/Assert.h>
 #include <Lib/Util.h>
 
+#include <cstddef>
+#include <cstdint>
+
 namespace nv
 {
     using Byte = unsigned char;
@@ -24,62 +27,106 @@ namespace nv
         void    Free(void* ptr) override;
         void*   Realloc(size_t size, void* ptr) override;
 
+        // Number of Allocate calls so far, to keep an eye on per frame mallocs
+        static uint64_t GetAllocationCount();
+
         static SystemAllocator* gPtr;
     };
 
     extern SystemAllocator gSysAllocator;
 
+    enum class SystemAllocatorBackend : uint8_t
+    {
+        Malloc,     // C runtime heap
+        Tlsf,       // TlsfAllocator with pools of the given size, requests above half a pool still go to malloc
+    };
+
+    // Selects where SystemAllocator, and so global new/delete, get memory from. Can be switched
+    // at any time: frees are routed by address, so memory allocated before the switch is
+    // still returned to the heap it came from. The TLSF heap is never torn down, globals and
+    // statics may still hold memory from it after DestroyContext.
+    void InitSystemAllocator(SystemAllocatorBackend backend, size_t poolSize = 64 * 1024 * 1024);
+
+    // Linear allocator over a chain of chunks. When the current chunk runs out a new one,
+    // at least twice as big, is taken from the backing allocator, so the arena never has to
+    // be sized up front. Individual frees are ignored; memory comes back through Rewind
+    // (usually via ArenaScope) or Reset.
+    // A caller provided buffer is used as the first chunk and never freed by the arena,
+    // without a backing allocator it's all there is and running out asserts.
     class ArenaAllocator : public IAllocator
     {
     public:
         static constexpr size_t kArenaDefaultSize = 1024;
+        static constexpr size_t kArenaDefaultAlignment = alignof(std::max_align_t);
 
-        ArenaAllocator(size_t capacity = kArenaDefaultSize, IAllocator* allocator = SystemAllocator::gPtr):
-            mBuffer(nullptr),
-            mCurrent(nullptr),
-            mCapacity(capacity),
-            mAllocator(allocator) 
+        struct Marker
+        {
+            void*   mpChunk = nullptr;
+            Byte*   mpCurrent = nullptr;
+        };
+
+        ArenaAllocator(size_t chunkSize = kArenaDefaultSize, IAllocator* allocator = SystemAllocator::gPtr) :
+            mChunkSize(chunkSize),
+            mAllocator(allocator)
         {
             assert(mAllocator);
-            mBuffer = (Byte*)allocator->Allocate(capacity);
-            assert(mBuffer);
-            mCurrent = mBuffer;
         }
 
-        // Provide buffer directly, decoupling buffer management
-        // from this allocator.
-        ArenaAllocator(void* pBuffer, size_t capacity):
-            mBuffer((Byte*)pBuffer),
-            mCurrent((Byte*)pBuffer),
-            mCapacity(capacity),
-            mAllocator(nullptr) 
-        {}
+        ArenaAllocator(void* pBuffer, size_t capacity, IAllocator* allocator = nullptr);
 
-        void*   Allocate(size_t size) override;
+        ArenaAllocator(const ArenaAllocator&) = delete;
+        ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+
+        ~ArenaAllocator();
+
+        void*   Allocate(size_t size) override { return Allocate(size, kArenaDefaultAlignment); }
+        void*   Allocate(size_t size, size_t alignment);
         void    Free(void* ptr) override { } // Do nothing
+
+        // Drops everything but the biggest chunk, which is kept for the next round.
         void    Reset() override;
 
-        constexpr size_t  GetAllocatedSize() const { return mCurrent - mBuffer; }
+        // Everything allocated after the marker is released by Rewind. Chunks it
+        // empties are kept as a spare (the biggest one) instead of being freed.
+        Marker  GetMarker() const;
+        void    Rewind(const Marker& marker);
 
-        ~ArenaAllocator() 
-        {
-            if (mBuffer)
-            {
-                if(mAllocator)
-                    mAllocator->Free(mBuffer);
-                mBuffer = nullptr;
-                mCurrent = nullptr;
-                mCapacity = 0;
-            }
-        }
+        size_t  GetAllocatedSize() const; // Bytes handed out since the last reset, padding included
+        size_t  GetCapacity() const;      // Bytes in all chunks, the spare included
+        uint32_t GetChunkCount() const;
 
     protected:
-        Byte*           mBuffer;
-        Byte*           mCurrent;
-        size_t          mCapacity;
+        struct Chunk;
+
+        Chunk*  AddChunk(size_t size, size_t alignment);
+        void    ReleaseChunk(Chunk* pChunk);
+        void    FreeChunk(Chunk* pChunk);
+
+        Chunk*          mpHead = nullptr;   // Chunk being allocated from, linked to the older ones
+        Chunk*          mpSpare = nullptr;
+        size_t          mChunkSize;
         IAllocator*     mAllocator;
     };
 
+    // Rewinds the arena to where it was when the scope was opened.
+    class ArenaScope
+    {
+    public:
+        ArenaScope(ArenaAllocator& arena) :
+            mArena(arena),
+            mMarker(arena.GetMarker())
+        {}
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+
+        ~ArenaScope() { mArena.Rewind(mMarker); }
+
+    private:
+        ArenaAllocator&         mArena;
+        ArenaAllocator::Marker  mMarker;
+    };
+
     class LocalAllocator : public IAllocator
     {
     public:
@@ -110,16 +157,24 @@ namespace nv
 
     using LinearAllocator = ArenaAllocator;
 
+    // Arena where Free(ptr) rewinds to ptr, releasing it and everything allocated after it.
     class StackAllocator : public ArenaAllocator
     {
     public:
-        virtual void Free(void* ptr) override
-        {
-            mCurrent = (Byte*)ptr;
-        }
+        using ArenaAllocator::ArenaAllocator;
+
+        virtual void Free(void* ptr) override;
     };
 
+    // Small dense per thread index for allocators keeping per thread caches in a fixed array.
+    // Slots are recycled when a thread exits, so whoever picks one up inherits what's cached
+    // under it. kNoAllocatorThreadSlot once all of them are taken or the thread is exiting.
+    constexpr uint32_t kAllocatorThreadSlots = 64;
+    constexpr uint32_t kNoAllocatorThreadSlot = ~0u;
+    uint32_t GetAllocatorThreadSlot();
+
     void*   Alloc(size_t size, IAllocator* alloc = SystemAllocator::gPtr);
+    // Counted under tag by the MemTracker until released with Free(ptr, alloc).
     void*   AllocTagged(const char* tag, IAllocator* alloc, size_t size);
     void    Free(void* ptr, IAllocator* alloc = SystemAllocator::gPtr);
 
@@ -137,7 +192,36 @@ namespace nv
         if (ptr)
         {
             ptr->~T();
-            alloc->Free(ptr);
+            Free(static_cast<void*>(ptr), alloc);   // Untracks tagged blocks
         }
     }
+
+    // Lets std containers charge their storage to a MemTracker tag, one of the named budgets usually.
+    template<typename T>
+    class TaggedStlAllocator
+    {
+    public:
+        using value_type = T;
+
+        TaggedStlAllocator(const char* tag, IAllocator* alloc = SystemAllocator::gPtr) :
+            mTag(tag),
+            mAllocator(alloc)
+        {}
+        template<typename U>
+        TaggedStlAllocator(const TaggedStlAllocator<U>& other) :
+            mTag(other.mTag),
+            mAllocator(other.mAllocator)
+        {}
+
+        T*      allocate(size_t count) { return (T*)AllocTagged(mTag, mAllocator, count * sizeof(T)); }
+        void    deallocate(T* ptr, size_t) { Free(static_cast<void*>(ptr), mAllocator); }
+
+        template<typename U>
+        bool    operator==(const TaggedStlAllocator<U>& other) const { return mAllocator == other.mAllocator; }
+        template<typename U>
+        bool    operator!=(const TaggedStlAllocator<U>& other) const { return mAllocator != other.mAllocator; }
+
+        const char*     mTag;
+        IAllocator*     mAllocator;
+    };
 }
\ No newline at end of file
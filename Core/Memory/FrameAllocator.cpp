@@ -0,0 +1,129 @@
+#include "pch.h"
+
+#include "FrameAllocator.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nv
+{
+    FrameAllocator gFrameAllocator;
+    FrameAllocator* FrameAllocator::gPtr = &gFrameAllocator;
+
+    namespace
+    {
+        struct ThreadFrameArenas
+        {
+            ArenaAllocator*     mpArenas[kFrameAllocatorBufferCount] = {};
+            uint64_t            mFrames[kFrameAllocatorBufferCount] = {}; // Frame each arena was last reset for
+
+            ThreadFrameArenas()
+            {
+                for (auto& frame : mFrames)
+                    frame = ~0ull;
+            }
+
+            ~ThreadFrameArenas()
+            {
+                for (ArenaAllocator* pArena : mpArenas)
+                    Free<ArenaAllocator>(pArena);
+            }
+        };
+
+        std::mutex                      gThreadArenasMutex;
+        std::vector<ThreadFrameArenas*> gThreadArenas;
+        std::atomic<uint32_t>           gArenaGeneration = 1; // Bumped by Destroy so threads drop their stale arenas
+
+        thread_local ThreadFrameArenas* tpArenas = nullptr;
+        thread_local uint32_t           tArenaGeneration = 0;
+
+        ThreadFrameArenas& GetThreadArenas()
+        {
+            const uint32_t generation = gArenaGeneration.load(std::memory_order_acquire);
+            if (tArenaGeneration != generation)
+            {
+                tpArenas = Alloc<ThreadFrameArenas>();
+                tArenaGeneration = generation;
+
+                std::unique_lock<std::mutex> lock(gThreadArenasMutex);
+                gThreadArenas.push_back(tpArenas);
+            }
+
+            return *tpArenas;
+        }
+    }
+
+    void* FrameAllocator::Allocate(size_t size)
+    {
+        const uint64_t state = mState.load(std::memory_order_acquire);
+        const uint32_t buffer = (uint32_t)(state & kBufferMask);
+        const uint64_t frame = state >> kBufferBits;
+
+        ThreadFrameArenas& arenas = GetThreadArenas();
+        ArenaAllocator*& pArena = arenas.mpArenas[buffer];
+        if (!pArena)
+            pArena = Alloc<ArenaAllocator>(SystemAllocator::gPtr, kFrameAllocatorArenaSize);
+
+        // Reset keeps the biggest chunk, so a buffer settles on one chunk sized for its peak frame
+        if (arenas.mFrames[buffer] != frame)
+        {
+            pArena->Reset();
+            arenas.mFrames[buffer] = frame;
+        }
+
+        return pArena->Allocate(size, kFrameAllocatorAlignment);
+    }
+
+    void FrameAllocator::BeginFrame()
+    {
+        const uint64_t state = mState.load(std::memory_order_relaxed);
+        const uint32_t current = (uint32_t)(state & kBufferMask);
+        const uint64_t frame = (state >> kBufferBits) + 1;
+        mBufferFrames[current] = frame;
+
+        for (;;)
+        {
+            uint32_t next = kFrameAllocatorBufferCount;
+            for (uint32_t buffer = 0; buffer < kFrameAllocatorBufferCount; ++buffer)
+            {
+                const bool bFree = (mBufferFrames[buffer] == 0 || mBufferFrames[buffer] + kFrameAllocatorLatency <= frame + 1)
+                    && buffer != current && mPins[buffer].load(std::memory_order_acquire) == 0;
+                if (bFree && (next == kFrameAllocatorBufferCount || mBufferFrames[buffer] > mBufferFrames[next]))
+                    next = buffer;
+            }
+
+            if (next != kFrameAllocatorBufferCount)
+            {
+                mState.store((frame << kBufferBits) | next, std::memory_order_release);
+                return;
+            }
+
+            // Everything else is pinned, wait for the render thread to let go of a frame
+            std::this_thread::yield();
+        }
+    }
+
+    uint32_t FrameAllocator::Pin()
+    {
+        const uint32_t buffer = GetBufferIndex();
+        mPins[buffer].fetch_add(1, std::memory_order_relaxed);
+        return buffer;
+    }
+
+    void FrameAllocator::Unpin(uint32_t buffer)
+    {
+        assert(mPins[buffer].load(std::memory_order_relaxed) > 0);
+        mPins[buffer].fetch_sub(1, std::memory_order_release);
+    }
+
+    void FrameAllocator::Destroy()
+    {
+        std::unique_lock<std::mutex> lock(gThreadArenasMutex);
+        for (ThreadFrameArenas* pArenas : gThreadArenas)
+            nv::Free<ThreadFrameArenas>(pArenas);
+
+        gThreadArenas.clear();
+        gArenaGeneration.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#ifndef NV_FRAME_ALLOCATOR
+#define NV_FRAME_ALLOCATOR
+
+#include <Memory/Allocator.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace nv
+{
+    // Frame buffers in rotation. Data handed to the render thread pins its buffer, so this
+    // has to stay above what can be alive at once: the queued frames plus the one being
+    // rendered (RenderDataArray::MAX_QUEUED_RENDER_DATA + 1), with a couple to spare.
+    constexpr uint32_t kFrameAllocatorBufferCount = 8;
+    // Frames unpinned memory stays valid for: the one it was allocated in and the next.
+    constexpr uint32_t kFrameAllocatorLatency = 2;
+    constexpr size_t   kFrameAllocatorArenaSize = 256 * 1024;
+    constexpr size_t   kFrameAllocatorAlignment = 16;
+
+    // Per thread linear scratch memory for data that only lives for a frame or is handed
+    // to another thread for a few. Each thread bumps through its own arena for the current
+    // buffer, nothing is locked or freed per allocation; a buffer is reset in one go when
+    // it's picked again, kFrameAllocatorLatency frames later at the earliest.
+    // Free is a no-op, so the allocator can be passed to nv::Vector or RenderData as is.
+    // Arenas grow past kFrameAllocatorArenaSize as needed and keep their peak size after a reset.
+    class FrameAllocator : public IAllocator
+    {
+    public:
+        void*       Allocate(size_t size) override;
+        void        Free(void* ptr) override {}
+
+        // Main thread, once per frame. Moves on to the most recently used buffer that is
+        // old enough and unpinned, so the rotation stays small and warm in cache.
+        void        BeginFrame();
+
+        // Keeps the current buffer out of the rotation until Unpin, for frame data that
+        // another thread holds on to for an unknown number of frames.
+        uint32_t    Pin();
+        void        Unpin(uint32_t buffer);
+
+        uint64_t    GetFrameIndex() const { return mState.load(std::memory_order_acquire) >> kBufferBits; }
+        uint32_t    GetBufferIndex() const { return (uint32_t)(mState.load(std::memory_order_acquire) & kBufferMask); }
+
+        // Frees every thread's arenas. Pins are kept, but nothing may touch frame memory afterwards.
+        void        Destroy();
+
+        static FrameAllocator* gPtr;
+
+    private:
+        static constexpr uint32_t kBufferBits = 8;
+        static constexpr uint64_t kBufferMask = (1ull << kBufferBits) - 1;
+        static_assert(kFrameAllocatorBufferCount <= kBufferMask);
+
+        std::atomic<uint64_t>   mState = 0; // Frame index << kBufferBits | buffer, read together by every thread
+        std::atomic<uint32_t>   mPins[kFrameAllocatorBufferCount] = {};
+        uint64_t                mBufferFrames[kFrameAllocatorBufferCount] = {}; // 1 + last frame each buffer was current, 0 if never. Main thread only
+    };
+
+    extern FrameAllocator gFrameAllocator;
+}
+
+#endif // !NV_FRAME_ALLOCATOR
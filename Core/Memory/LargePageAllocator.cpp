@@ -0,0 +1,109 @@
+#include "pch.h"
+
+#include "LargePageAllocator.h"
+
+#include <Platform/Thread.h>
+
+namespace nv
+{
+    LargePageAllocator gLargePageAllocator;
+    LargePageAllocator* LargePageAllocator::gPtr = &gLargePageAllocator;
+
+    // In front of every block, mMappedSize is 0 for blocks from the backing allocator
+    struct alignas(std::max_align_t) LargePageAllocator::Header
+    {
+        void*                   mpMapping;
+        size_t                  mMappedSize;
+        platform::LargePageMode mMode;
+    };
+
+    // Mappings all start on a large page boundary, so columns swept side by side would hit the same
+    // cache sets at every index. Blocks start a rotating number of cache lines in to spread them out.
+    constexpr size_t   kLargePageColorStride = 64 * 3;
+    constexpr uint32_t kLargePageColorCount = 32;
+
+    LargePageAllocator::LargePageAllocator(const LargePageDesc& desc, IAllocator* allocator) :
+        mAllocator(allocator),
+        mDesc(desc)
+    {
+        assert(mAllocator);
+    }
+
+    void* LargePageAllocator::Allocate(size_t size)
+    {
+        const LargePageDesc desc = GetDesc();
+        return Allocate(size, desc.mNumaNode, desc);
+    }
+
+    void* LargePageAllocator::Allocate(size_t size, uint32_t numaNode)
+    {
+        return Allocate(size, numaNode, GetDesc());
+    }
+
+    void* LargePageAllocator::Allocate(size_t size, uint32_t numaNode, const LargePageDesc& desc)
+    {
+        const size_t blockSize = size + sizeof(Header);
+
+        if (size < desc.mMinSize)
+        {
+            Header* pHeader = (Header*)mAllocator->Allocate(blockSize);
+            if (!pHeader)
+                return nullptr;
+
+            pHeader->mpMapping = nullptr;
+            pHeader->mMappedSize = 0;
+            pHeader->mMode = platform::LargePageMode::None;
+            return pHeader + 1;
+        }
+
+        if (numaNode == kLocalNumaNode)
+            numaNode = platform::GetCurrentNumaNode();
+
+        const size_t colorOffset = mColor.fetch_add(1, std::memory_order_relaxed) % kLargePageColorCount * kLargePageColorStride;
+        size_t mappedSize = blockSize + colorOffset;
+        platform::LargePageMode mode = platform::LargePageMode::None;
+        Byte* pMapping = (Byte*)platform::MapLargePages(mappedSize, desc.mMode, numaNode, &mode);
+        if (!pMapping)
+            return nullptr;
+
+        Header* pHeader = (Header*)(pMapping + colorOffset);
+        pHeader->mpMapping = pMapping;
+        pHeader->mMappedSize = mappedSize;
+        pHeader->mMode = mode;
+        mMappedSizes[(uint32_t)mode].fetch_add(mappedSize, std::memory_order_relaxed);
+        return pHeader + 1;
+    }
+
+    void LargePageAllocator::Free(void* ptr)
+    {
+        if (!ptr)
+            return;
+
+        Header* pHeader = (Header*)ptr - 1;
+        if (pHeader->mMappedSize == 0)
+        {
+            mAllocator->Free(pHeader);
+            return;
+        }
+
+        mMappedSizes[(uint32_t)pHeader->mMode].fetch_sub(pHeader->mMappedSize, std::memory_order_relaxed);
+        platform::UnmapLargePages(pHeader->mpMapping, pHeader->mMappedSize);
+    }
+
+    void LargePageAllocator::SetDesc(const LargePageDesc& desc)
+    {
+        std::scoped_lock lock(mDescMutex);
+        mDesc = desc;
+    }
+
+    LargePageDesc LargePageAllocator::GetDesc() const
+    {
+        std::scoped_lock lock(mDescMutex);
+        return mDesc;
+    }
+
+    size_t LargePageAllocator::GetMappedSize(platform::LargePageMode mode) const
+    {
+        return mMappedSizes[(uint32_t)mode].load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#ifndef NV_LARGE_PAGE_ALLOCATOR
+#define NV_LARGE_PAGE_ALLOCATOR
+
+#include <Memory/Allocator.h>
+#include <Platform/VirtualMemory.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace nv
+{
+    constexpr size_t   kLargePageMinSize = 1024 * 1024;    // Smaller requests go to the backing allocator
+    constexpr uint32_t kLocalNumaNode = ~0u - 1;            // Node of the thread that allocates
+
+    struct LargePageDesc
+    {
+        platform::LargePageMode mMode = platform::LargePageMode::Transparent;
+        uint32_t                mNumaNode = kLocalNumaNode; // Node index, kLocalNumaNode or platform::kAnyNumaNode
+        size_t                  mMinSize = kLargePageMinSize;
+    };
+
+    // Backs big buffers (store columns, BVH nodes, asset data) with their own mapping on large
+    // pages, so a sweep over them takes a TLB entry per 2 MB instead of per 4 KB. The pages
+    // prefer the NUMA node the desc asks for; with kLocalNumaNode that's the allocating
+    // thread's, so a buffer is best allocated by a worker of the node that will process it.
+    // If the OS has no large pages to give the mapping falls back to regular ones.
+    class LargePageAllocator : public IAllocator
+    {
+    public:
+        LargePageAllocator(const LargePageDesc& desc = {}, IAllocator* allocator = SystemAllocator::gPtr);
+
+        LargePageAllocator(const LargePageAllocator&) = delete;
+        LargePageAllocator& operator=(const LargePageAllocator&) = delete;
+
+        void*   Allocate(size_t size) override;
+        void*   Allocate(size_t size, uint32_t numaNode);
+        void    Free(void* ptr) override;
+
+        // Applies to allocations made from now on.
+        void    SetDesc(const LargePageDesc& desc);
+        LargePageDesc GetDesc() const;
+
+        // Bytes mapped for live allocations, by the page mode the OS granted.
+        size_t  GetMappedSize(platform::LargePageMode mode) const;
+
+        static LargePageAllocator* gPtr;
+
+    private:
+        struct Header;
+
+        void*   Allocate(size_t size, uint32_t numaNode, const LargePageDesc& desc);
+
+        IAllocator*             mAllocator;
+        mutable std::mutex      mDescMutex;
+        LargePageDesc           mDesc;
+        std::atomic<size_t>     mMappedSizes[(uint32_t)platform::LargePageMode::Explicit + 1] = {};
+        std::atomic<uint32_t>   mColor = 0;
+    };
+
+    extern LargePageAllocator gLargePageAllocator;
+
+    // Lets std containers keep their storage in LargePageAllocator::gPtr.
+    template<typename T>
+    class LargePageStlAllocator
+    {
+    public:
+        using value_type = T;
+
+        static_assert(alignof(T) <= alignof(std::max_align_t), "LargePageAllocator doesn't over-align");
+
+        LargePageStlAllocator() = default;
+        template<typename U>
+        LargePageStlAllocator(const LargePageStlAllocator<U>&) {}
+
+        T*      allocate(size_t count) { return (T*)LargePageAllocator::gPtr->Allocate(count * sizeof(T)); }
+        void    deallocate(T* ptr, size_t) { LargePageAllocator::gPtr->Free(ptr); }
+
+        template<typename U>
+        bool    operator==(const LargePageStlAllocator<U>&) const { return true; }
+        template<typename U>
+        bool    operator!=(const LargePageStlAllocator<U>&) const { return false; }
+    };
+
+    template<typename T>
+    using LargePageVector = std::vector<T, LargePageStlAllocator<T>>;
+}
+
+#endif // !NV_LARGE_PAGE_ALLOCATOR
@@ -0,0 +1,333 @@
+#include "pch.h"
+
+#include "Memory.h"
+#include <Engine/Log.h>
+#include <Lib/Map.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace nv
+{
+    static constexpr MemTracker::TagType kUntaggedTag = "Untagged";
+
+    struct alignas(64) MemTracker::CounterShard
+    {
+        std::atomic<int64_t>    mBytes = 0;
+        std::atomic<int64_t>    mSysBytes = 0;
+        std::atomic<int64_t>    mSysCount = 0;
+    };
+
+    struct alignas(64) MemTracker::TagEntry
+    {
+        std::atomic<TagType>    mTag = nullptr;
+        std::atomic<int64_t>    mBytes = 0;
+        std::atomic<int64_t>    mCount = 0;
+        std::atomic<uint64_t>   mTotalCount = 0;
+        std::atomic<int64_t>    mHighWater = 0;
+        std::atomic<size_t>     mSoftLimit = 0;
+        std::atomic<size_t>     mHardLimit = 0;
+        std::atomic<uint32_t>   mSoftExceededCount = 0;
+        std::atomic<uint32_t>   mHardExceededCount = 0;
+    };
+
+    struct MemTracker::PointerShard
+    {
+        struct Allocation
+        {
+            TagEntry*   mpTag;
+            size_t      mSize;
+        };
+
+        std::mutex                      mMutex;
+        HashMap<PtrType, Allocation>    mAllocations;
+    };
+
+    static uint64_t HashPointer(uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdull;
+        value ^= value >> 33;
+        return value;
+    }
+
+    MemTracker::MemTracker() :
+        mpCounters(new CounterShard[kShardCount]),
+        mpTags(new TagEntry[kMaxTags]),
+        mpPointers(new PointerShard[kShardCount])
+    {
+    }
+
+    MemTracker::~MemTracker()
+    {
+        // The arrays are system allocations themselves, nothing may be tracked from here on
+        mbEnableTracking.store(false, std::memory_order_relaxed);
+        delete[] mpPointers;
+        delete[] mpTags;
+        delete[] mpCounters;
+    }
+
+    MemTracker::CounterShard& MemTracker::GetThreadShard()
+    {
+        // Threads are spread round robin, so a handful of workers never share a shard
+        static std::atomic<uint32_t> sNextShard = 0;
+        thread_local uint32_t tShard = sNextShard.fetch_add(1, std::memory_order_relaxed) % kShardCount;
+        return mpCounters[tShard];
+    }
+
+    // Tags are hashed by name, so the same name at another address (a literal from another
+    // module) lands in the same entry. Within the probe pointers are compared first.
+    MemTracker::TagEntry* MemTracker::FindTag(TagType tag, bool bInsert) const
+    {
+        if (!tag)
+            tag = kUntaggedTag;
+
+        uint32_t index = 2166136261u; // FNV-1a
+        for (const char* pChar = tag; *pChar; ++pChar)
+            index = (index ^ (uint8_t)*pChar) * 16777619u;
+
+        for (uint32_t probe = 0; probe < kMaxTags; ++probe, ++index)
+        {
+            TagEntry& entry = mpTags[index % kMaxTags];
+            TagType current = entry.mTag.load(std::memory_order_acquire);
+            if (!current && !bInsert)
+                return nullptr;
+            if (!current && entry.mTag.compare_exchange_strong(current, tag, std::memory_order_acq_rel))
+                return &entry;
+
+            if (current == tag || strcmp(current, tag) == 0)
+                return &entry;
+        }
+
+        return nullptr; // Table full, only the totals see this tag
+    }
+
+    void MemTracker::TrackAlloc(void* ptr, size_t size)
+    {
+        TrackAllocTagged(ptr, size, nullptr);
+    }
+
+    void MemTracker::TrackAllocTagged(void* ptr, size_t size, TagType tag)
+    {
+#if NV_ENABLE_MEM_TRACKING
+        if (!ptr || !mbEnableTracking.load(std::memory_order_relaxed))
+            return;
+
+        GetThreadShard().mBytes.fetch_add((int64_t)size, std::memory_order_relaxed);
+
+        TagEntry* pTag = FindTag(tag);
+        if (pTag)
+        {
+            const int64_t previous = pTag->mBytes.fetch_add((int64_t)size, std::memory_order_relaxed);
+            const int64_t bytes = previous + (int64_t)size;
+            pTag->mCount.fetch_add(1, std::memory_order_relaxed);
+            pTag->mTotalCount.fetch_add(1, std::memory_order_relaxed);
+
+            int64_t highWater = pTag->mHighWater.load(std::memory_order_relaxed);
+            while (bytes > highWater && !pTag->mHighWater.compare_exchange_weak(highWater, bytes, std::memory_order_relaxed))
+                ;
+
+            // Only the allocation that takes the tag over a limit reports it
+            const int64_t softLimit = (int64_t)pTag->mSoftLimit.load(std::memory_order_relaxed);
+            const int64_t hardLimit = (int64_t)pTag->mHardLimit.load(std::memory_order_relaxed);
+            if (softLimit && previous <= softLimit && bytes > softLimit)
+                ReportBudget(*pTag, BudgetLevel::Soft);
+            if (hardLimit && previous <= hardLimit && bytes > hardLimit)
+                ReportBudget(*pTag, BudgetLevel::Hard);
+        }
+
+        PointerShard& shard = mpPointers[HashPointer((PtrType)ptr) % kShardCount];
+        std::unique_lock<std::mutex> lock(shard.mMutex);
+        shard.mAllocations[(PtrType)ptr] = { pTag, size };
+#endif
+    }
+
+    void MemTracker::TrackFree(void* ptr)
+    {
+#if NV_ENABLE_MEM_TRACKING
+        if (!ptr)
+            return;
+
+        PointerShard::Allocation allocation;
+        {
+            PointerShard& shard = mpPointers[HashPointer((PtrType)ptr) % kShardCount];
+            std::unique_lock<std::mutex> lock(shard.mMutex);
+            auto it = shard.mAllocations.find((PtrType)ptr);
+            if (it == shard.mAllocations.end())
+                return; // Allocated while tracking was off
+
+            allocation = it->second;
+            shard.mAllocations.erase(it);
+        }
+
+        GetThreadShard().mBytes.fetch_sub((int64_t)allocation.mSize, std::memory_order_relaxed);
+        if (allocation.mpTag)
+        {
+            allocation.mpTag->mBytes.fetch_sub((int64_t)allocation.mSize, std::memory_order_relaxed);
+            allocation.mpTag->mCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    void MemTracker::TrackSysAlloc(void* ptr, size_t size)
+    {
+#if NV_ENABLE_MEM_TRACKING
+        if (ptr && mbEnableTracking.load(std::memory_order_relaxed))
+        {
+            CounterShard& shard = GetThreadShard();
+            shard.mSysBytes.fetch_add((int64_t)size, std::memory_order_relaxed);
+            shard.mSysCount.fetch_add(1, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    void MemTracker::TrackSysFree(void* ptr, size_t size)
+    {
+#if NV_ENABLE_MEM_TRACKING
+        if (ptr && mbEnableTracking.load(std::memory_order_relaxed))
+        {
+            CounterShard& shard = GetThreadShard();
+            shard.mSysBytes.fetch_sub((int64_t)size, std::memory_order_relaxed);
+            shard.mSysCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    int64_t MemTracker::GetCurrentAllocatedBytes() const
+    {
+        int64_t bytes = 0;
+        for (uint32_t i = 0; i < kShardCount; ++i)
+            bytes += mpCounters[i].mBytes.load(std::memory_order_relaxed);
+        return bytes;
+    }
+
+    int64_t MemTracker::GetSystemAllocatedBytes() const
+    {
+        int64_t bytes = 0;
+        for (uint32_t i = 0; i < kShardCount; ++i)
+            bytes += mpCounters[i].mSysBytes.load(std::memory_order_relaxed);
+        return bytes;
+    }
+
+    int64_t MemTracker::GetSystemAllocationCount() const
+    {
+        int64_t count = 0;
+        for (uint32_t i = 0; i < kShardCount; ++i)
+            count += mpCounters[i].mSysCount.load(std::memory_order_relaxed);
+        return count;
+    }
+
+    uint32_t MemTracker::GetTopTags(TagStats* pStats, uint32_t count) const
+    {
+        // Gathered on the stack, dumping stats must not allocate
+        TagStats tags[kMaxTags];
+        uint32_t tagCount = 0;
+        for (uint32_t i = 0; i < kMaxTags; ++i)
+        {
+            const TagEntry& entry = mpTags[i];
+            if (entry.mTag.load(std::memory_order_acquire))
+                tags[tagCount++] = ReadStats(entry);
+        }
+
+        count = std::min(count, tagCount);
+        std::partial_sort(tags, tags + count, tags + tagCount, [](const TagStats& a, const TagStats& b) { return a.mBytes > b.mBytes; });
+        std::copy(tags, tags + count, pStats);
+        return count;
+    }
+
+    void MemTracker::LogTopTags(uint32_t count) const
+    {
+        TagStats tags[kMaxTags];
+        count = GetTopTags(tags, std::min(count, kMaxTags));
+
+        log::Info("[Memory] System: {} bytes in {} allocations", GetSystemAllocatedBytes(), GetSystemAllocationCount());
+        for (uint32_t i = 0; i < count; ++i)
+            log::Info("[Memory] {}: {} bytes in {} allocations ({} total)", tags[i].mTag, tags[i].mBytes, tags[i].mCount, tags[i].mTotalCount);
+    }
+
+    MemTracker::TagStats MemTracker::ReadStats(const TagEntry& entry)
+    {
+        TagStats stats;
+        stats.mTag = entry.mTag.load(std::memory_order_acquire);
+        stats.mBytes = entry.mBytes.load(std::memory_order_relaxed);
+        stats.mCount = entry.mCount.load(std::memory_order_relaxed);
+        stats.mTotalCount = entry.mTotalCount.load(std::memory_order_relaxed);
+        stats.mHighWater = entry.mHighWater.load(std::memory_order_relaxed);
+        stats.mSoftLimit = entry.mSoftLimit.load(std::memory_order_relaxed);
+        stats.mHardLimit = entry.mHardLimit.load(std::memory_order_relaxed);
+        stats.mSoftExceededCount = entry.mSoftExceededCount.load(std::memory_order_relaxed);
+        stats.mHardExceededCount = entry.mHardExceededCount.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    bool MemTracker::SetBudget(TagType tag, size_t softLimit, size_t hardLimit)
+    {
+        assert(!softLimit || !hardLimit || softLimit <= hardLimit);
+        TagEntry* pTag = FindTag(tag);
+        if (!pTag)
+            return false;
+
+        pTag->mSoftLimit.store(softLimit, std::memory_order_relaxed);
+        pTag->mHardLimit.store(hardLimit, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool MemTracker::GetTagStats(TagType tag, TagStats& stats) const
+    {
+        const TagEntry* pTag = FindTag(tag, false);
+        if (!pTag)
+            return false;
+
+        stats = ReadStats(*pTag);
+        return true;
+    }
+
+    uint32_t MemTracker::GetBudgets(TagStats* pStats, uint32_t count) const
+    {
+        uint32_t budgetCount = 0;
+        for (uint32_t i = 0; i < kMaxTags && budgetCount < count; ++i)
+        {
+            const TagEntry& entry = mpTags[i];
+            if (!entry.mTag.load(std::memory_order_acquire))
+                continue;
+
+            if (entry.mSoftLimit.load(std::memory_order_relaxed) || entry.mHardLimit.load(std::memory_order_relaxed))
+                pStats[budgetCount++] = ReadStats(entry);
+        }
+
+        return budgetCount;
+    }
+
+    void MemTracker::LogBudgets() const
+    {
+        TagStats budgets[kMaxTags];
+        const uint32_t count = GetBudgets(budgets, kMaxTags);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const TagStats& budget = budgets[i];
+            log::Info("[Memory] Budget {}: {} / {} bytes (hard {}), peak {}, over soft {}x, over hard {}x", budget.mTag, budget.mBytes,
+                budget.mSoftLimit, budget.mHardLimit, budget.mHighWater, budget.mSoftExceededCount, budget.mHardExceededCount);
+        }
+    }
+
+    void MemTracker::ReportBudget(TagEntry& entry, BudgetLevel level)
+    {
+        auto& exceededCount = level == BudgetLevel::Soft ? entry.mSoftExceededCount : entry.mHardExceededCount;
+        exceededCount.fetch_add(1, std::memory_order_relaxed);
+
+        const TagStats stats = ReadStats(entry);
+        if (BudgetCallback callback = mBudgetCallback.load(std::memory_order_acquire))
+        {
+            callback(stats, level);
+        }
+        else if (level == BudgetLevel::Soft)
+        {
+            log::Warn("[Memory] {} over its soft budget: {} of {} bytes", stats.mTag, stats.mBytes, stats.mSoftLimit);
+        }
+        else
+        {
+            log::Error("[Memory] {} over its hard budget: {} of {} bytes", stats.mTag, stats.mBytes, stats.mHardLimit);
+        }
+    }
+}
@@ -4,6 +4,8 @@
 #include <cstdio>
 #include "Allocator.h"
 
+#include <algorithm>
+
 #define _CRTDBG_MAP_ALLOC
 #include <cstdlib>
 #include <crtdbg.h>
@@ -46,20 +48,44 @@ namespace nv
         MemTracker::gPtr->TrackSysAlloc(MemTracker::gPtr, sizeof(MemTracker));
     }
 
+    void InitMemoryBudgets(MemTracker* pTracker)
+    {
+        constexpr size_t kMB = 1024 * 1024;
+        struct DefaultBudget
+        {
+            MemTracker::TagType mTag;
+            size_t              mSoftLimit;
+            size_t              mHardLimit;
+        };
+
+        static constexpr DefaultBudget kDefaultBudgets[] =
+        {
+            { kMemBudgetAssets,      1024 * kMB, 2048 * kMB },
+            { kMemBudgetRenderData,  64 * kMB,   128 * kMB },
+            { kMemBudgetFrameRecord, 512 * kMB,  1024 * kMB },
+        };
+
+        for (const DefaultBudget& budget : kDefaultBudgets)
+            pTracker->SetBudget(budget.mTag, budget.mSoftLimit, budget.mHardLimit);
+    }
+
     size_t GetCurrentAllocatedBytes()
     {
-        return MemTracker::gPtr->GetCurrentAllocatedBytes();
+        return (size_t)std::max<int64_t>(MemTracker::gPtr->GetCurrentAllocatedBytes(), 0);
     }
 
     size_t GetSystemAllocatedBytes()
     {
-        return MemTracker::gPtr->GetSystemAllocatedBytes();
+        return (size_t)std::max<int64_t>(MemTracker::gPtr->GetSystemAllocatedBytes(), 0);
     }
     
     void DestroyMemoryTracker(MemTracker* &memTracker)
     {
-        memTracker->~MemTracker();
-        free(memTracker);
+        MemTracker* pTracker = memTracker;
+        if (MemTracker::gPtr == pTracker)
+            MemTracker::gPtr = nullptr; // Freeing its arrays goes through the system allocator
+        pTracker->~MemTracker();
+        free(pTracker);
         memTracker = nullptr;
     }
 
@@ -78,66 +104,4 @@ namespace nv
     {
         return MemTracker::gPtr;
     }
-
-    void MemTracker::TrackAlloc(void* ptr, size_t size)
-    {
-#if NV_ENABLE_MEM_TRACKING
-        mBytesAllocated += size;
-        mPtrSizeMap[(PtrType)ptr] = size;
-#endif
-    }
-
-    void MemTracker::TrackAllocTagged(void* ptr, size_t size, TagType tag)
-    {
-#if NV_ENABLE_MEM_TRACKING
-        mTagSizeMap[(PtrType)ptr] = tag;
-        TrackAlloc(ptr, size);
-#endif
-    }
-
-    void MemTracker::TrackSysAlloc(void* ptr, size_t size)
-    {
-#if NV_ENABLE_MEM_TRACKING
-        if (mbEnableTracking)
-        {
-            SetEnableTracking(false);
-            mBytesSystemAllocated += size;
-            mSysPtrSizeMap[(PtrType)ptr] = size;
-            SetEnableTracking(true);
-        }
-#endif
-    }
-
-    void MemTracker::TrackFree(void* ptr)
-    {
-#if NV_ENABLE_MEM_TRACKING
-        const size_t size = mPtrSizeMap.at((PtrType)ptr);
-        const auto key = (PtrType)ptr;
-        mPtrSizeMap.erase((PtrType)ptr);
-        auto it = mTagSizeMap.find(key);
-        if (it != mTagSizeMap.end())
-            mTagSizeMap.erase(it);
-        mBytesAllocated -= size;
-#endif
-    }
-
-    void MemTracker::TrackSysFree(void* ptr)
-    {
-#if NV_ENABLE_MEM_TRACKING
-        if (mbEnableTracking)
-        {
-            SetEnableTracking(false);
-            auto it = mSysPtrSizeMap.find((PtrType)ptr);
-            if (it != mSysPtrSizeMap.end())
-            {
-                const size_t size = it->second;
-                mSysPtrSizeMap.erase((PtrType)ptr);
-                mBytesSystemAllocated -= size;
-            }
-
-            SetEnableTracking(true);
-        }
-#endif
-    }
 }
-
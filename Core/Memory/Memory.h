@@ -3,59 +3,115 @@
 #ifndef NV_MEMORY
 #define NV_MEMORY
 
+#ifndef NV_ENABLE_MEM_TRACKING
 #define NV_ENABLE_MEM_TRACKING 1
+#endif
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 
-#if NV_ENABLE_MEM_TRACKING
-#include <Lib/Map.h>
-#include <Lib/StringHash.h>
-#endif
-
 namespace nv
 {
+    // Cheap enough to leave on in profiling builds: system allocations only bump counters in
+    // the calling thread's shard, tags live in a fixed lock-free table. Only tagged allocations
+    // remember their pointer, in a table sharded by address, so a tagged free finds its tag.
     class MemTracker
     {
     public:
         using PtrType = uint64_t;
         using TagType = const char*;
+
+        static constexpr uint32_t kShardCount = 64;
+        static constexpr uint32_t kMaxTags = 256;
+
+        struct TagStats
+        {
+            TagType     mTag = nullptr;     // "Untagged" for TrackAlloc without a tag
+            int64_t     mBytes = 0;
+            int64_t     mCount = 0;
+            uint64_t    mTotalCount = 0;    // Allocations since the tag was first seen
+            int64_t     mHighWater = 0;     // Most live bytes seen at once
+            size_t      mSoftLimit = 0;     // 0 when the tag has no budget
+            size_t      mHardLimit = 0;
+            uint32_t    mSoftExceededCount = 0; // Times the limit was crossed going up
+            uint32_t    mHardExceededCount = 0;
+        };
+
+        enum class BudgetLevel : uint8_t
+        {
+            Soft,   // Worth a warning, usually a leak building up
+            Hard,   // The session is about to run out of memory
+        };
+
+        // Called on the allocating thread, right after the allocation that crossed the limit.
+        using BudgetCallback = void(*)(const TagStats& stats, BudgetLevel level);
+
     public:
-        MemTracker() :
-            mBytesAllocated(0),
-            mBytesSystemAllocated(0),
-            mbEnableTracking(true)
-        {}
+        MemTracker();
+        ~MemTracker();
+
+        MemTracker(const MemTracker&) = delete;
+        MemTracker& operator=(const MemTracker&) = delete;
 
         void TrackAlloc(void* ptr, size_t size);
         void TrackAllocTagged(void* ptr, size_t size, TagType tag);
-        void TrackSysAlloc(void* ptr, size_t size);
         void TrackFree(void* ptr);
-        void TrackSysFree(void* ptr);
-        void SetEnableTracking(bool bEnabled) { mbEnableTracking = bEnabled; }
+        // Sizes have to match between the two, SystemAllocator passes the usable size of the block.
+        void TrackSysAlloc(void* ptr, size_t size);
+        void TrackSysFree(void* ptr, size_t size);
+        void SetEnableTracking(bool bEnabled) { mbEnableTracking.store(bEnabled, std::memory_order_relaxed); }
+
+        // System numbers are net since the tracker was created, frees of older blocks can take them below zero.
+        int64_t GetCurrentAllocatedBytes() const;
+        int64_t GetSystemAllocatedBytes() const;
+        int64_t GetSystemAllocationCount() const;
+
+        // Copies out up to count tags with the most live bytes, biggest first. Counters are read
+        // one by one while other threads keep allocating, so the numbers are only roughly coherent.
+        uint32_t GetTopTags(TagStats* pStats, uint32_t count) const;
+        void     LogTopTags(uint32_t count) const;
 
-        constexpr uint64_t GetCurrentAllocatedBytes() { return mBytesAllocated; }
-        constexpr uint64_t GetSystemAllocatedBytes() { return mBytesSystemAllocated; }
+        // A budget puts limits on a tag's live bytes, 0 for no limit. Allocations are never
+        // refused, crossing a limit calls the budget callback, or logs when there is none.
+        bool     SetBudget(TagType tag, size_t softLimit, size_t hardLimit);
+        void     SetBudgetCallback(BudgetCallback callback) { mBudgetCallback.store(callback, std::memory_order_release); }
+        bool     GetTagStats(TagType tag, TagStats& stats) const;
+        uint32_t GetBudgets(TagStats* pStats, uint32_t count) const; // Tags with a limit, in table order
+        void     LogBudgets() const;
 
         static MemTracker* gPtr;
     private:
-        uint64_t mBytesAllocated;
-        uint64_t mBytesSystemAllocated;
-#if NV_ENABLE_MEM_TRACKING
-        bool mbEnableTracking;
-        HashMap<PtrType,        size_t>     mPtrSizeMap;
-        HashMap<PtrType,        size_t>     mSysPtrSizeMap;
-        HashMap<PtrType,       TagType>     mTagSizeMap;
-#endif
+        struct CounterShard;
+        struct TagEntry;
+        struct PointerShard;
+
+        CounterShard&   GetThreadShard();
+        TagEntry*       FindTag(TagType tag, bool bInsert = true) const;
+        void            ReportBudget(TagEntry& entry, BudgetLevel level);
+        static TagStats ReadStats(const TagEntry& entry);
+
+        std::atomic<bool>   mbEnableTracking = true;
+        std::atomic<BudgetCallback> mBudgetCallback = nullptr;
+        CounterShard*       mpCounters = nullptr;   // kShardCount, picked per thread
+        TagEntry*           mpTags = nullptr;       // kMaxTags, open addressing on the FNV-1a hash of the tag name
+        PointerShard*       mpPointers = nullptr;   // kShardCount, picked by address
     };
 
+    // Named budgets, charged by allocating with AllocTagged(kMemBudgetAssets, ...).
+    constexpr MemTracker::TagType kMemBudgetAssets = "Assets";
+    constexpr MemTracker::TagType kMemBudgetRenderData = "RenderData";
+    constexpr MemTracker::TagType kMemBudgetFrameRecord = "FrameRecord";
+
     void            InitMemoryTracker();
+    void            InitMemoryBudgets(MemTracker* pTracker = MemTracker::gPtr); // Default limits for the named budgets
     MemTracker*&    GetMemoryTracker();
     void            DestroyMemoryTracker(MemTracker*& memTracker = GetMemoryTracker());
     void            SetMemoryTracker(MemTracker* memTracker);
     void            EnableLeakDetection();
-    
+
     size_t          GetCurrentAllocatedBytes();
     size_t          GetSystemAllocatedBytes();
 }
 
-#endif
\ No newline at end of file
+#endif
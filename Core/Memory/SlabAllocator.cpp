@@ -0,0 +1,433 @@
+#include "pch.h"
+
+#include "SlabAllocator.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+namespace nv
+{
+    SlabAllocator gSlabAllocator;
+    SlabAllocator* SlabAllocator::gPtr = &gSlabAllocator;
+
+    struct SlabAllocator::Magazine
+    {
+        Magazine*   mpNext;                 // In the depot's full or empty list
+        Magazine*   mpNextAllocated;        // Every magazine ever made, for Destroy
+        uint32_t    mCount;
+        void*       mpRounds[kSlabMagazineSize];
+    };
+
+    struct SlabAllocator::ThreadCache
+    {
+        Magazine*   mpLoaded[kSlabClassCount];
+        Magazine*   mpPrevious[kSlabClassCount];
+    };
+
+    namespace
+    {
+        // Sits in the first object of every slab, which is why objects start one class size in
+        struct SlabHeader
+        {
+            uint32_t    mSizeClass;
+        };
+
+        static_assert(sizeof(SlabHeader) <= kSlabMinSize, "Slab header must fit in the smallest class");
+        static_assert(std::has_single_bit(kSlabSize), "Slabs are found by masking the object address");
+        static_assert((kSlabMinSize << (kSlabClassCount - 1)) == kSlabMaxSize, "Class count must cover kSlabMaxSize");
+
+        constexpr size_t kRegionSize = kSlabsPerRegion * kSlabSize;
+
+        SlabHeader* GetSlabHeader(const void* ptr)
+        {
+            return (SlabHeader*)((uintptr_t)ptr & ~(uintptr_t)(kSlabSize - 1));
+        }
+    }
+
+    SlabAllocator::SlabAllocator(IAllocator* allocator)
+        : mAllocator(allocator)
+    {
+    }
+
+    SlabAllocator::~SlabAllocator()
+    {
+        Destroy();
+    }
+
+    uint32_t SlabAllocator::GetSizeClass(size_t size)
+    {
+        if (size > kSlabMaxSize)
+            return kSlabClassCount;
+        if (size <= kSlabMinSize)
+            return 0;
+        return (uint32_t)(std::bit_width(size - 1) - std::countr_zero(kSlabMinSize));
+    }
+
+    void* SlabAllocator::Allocate(size_t size)
+    {
+        const uint32_t classIndex = GetSizeClass(size);
+        if (classIndex == kSlabClassCount)
+            return mAllocator->Allocate(size);
+
+        ThreadCache* pCache = GetThreadCache();
+        if (!pCache)
+        {
+            SizeClass& sizeClass = mClasses[classIndex];
+            std::unique_lock<std::mutex> lock(sizeClass.mMutex);
+            return AllocateLocked(sizeClass, classIndex);
+        }
+
+        Magazine*& pLoaded = pCache->mpLoaded[classIndex];
+        if (pLoaded->mCount == 0)
+        {
+            Magazine*& pPrevious = pCache->mpPrevious[classIndex];
+            if (pPrevious->mCount > 0)
+            {
+                std::swap(pLoaded, pPrevious);
+            }
+            else
+            {
+                // Both empty: the previous one goes back, the loaded one becomes the previous
+                Magazine* pFull = ExchangeFull(classIndex, pPrevious);
+                pPrevious = pLoaded;
+                pLoaded = pFull;
+            }
+        }
+
+        if (pLoaded->mCount == 0)
+            return nullptr;
+        return pLoaded->mpRounds[--pLoaded->mCount];
+    }
+
+    void SlabAllocator::Free(void* ptr)
+    {
+        if (!ptr)
+            return;
+
+        if (!Owns(ptr))
+        {
+            mAllocator->Free(ptr);
+            return;
+        }
+
+        const uint32_t classIndex = GetSlabHeader(ptr)->mSizeClass;
+        assert(classIndex < kSlabClassCount);
+        assert(((uintptr_t)ptr & (GetClassSize(classIndex) - 1)) == 0);
+
+        ThreadCache* pCache = GetThreadCache();
+        if (!pCache)
+        {
+            SizeClass& sizeClass = mClasses[classIndex];
+            std::unique_lock<std::mutex> lock(sizeClass.mMutex);
+            *(void**)ptr = sizeClass.mpFreeList;
+            sizeClass.mpFreeList = ptr;
+            return;
+        }
+
+        Magazine*& pLoaded = pCache->mpLoaded[classIndex];
+        if (pLoaded->mCount == kSlabMagazineSize)
+        {
+            Magazine*& pPrevious = pCache->mpPrevious[classIndex];
+            if (pPrevious->mCount == 0)
+            {
+                std::swap(pLoaded, pPrevious);
+            }
+            else if (Magazine* pEmpty = ExchangeEmpty(classIndex, pPrevious))
+            {
+                pPrevious = pLoaded;
+                pLoaded = pEmpty;
+            }
+            else
+            {
+                SizeClass& sizeClass = mClasses[classIndex];
+                std::unique_lock<std::mutex> lock(sizeClass.mMutex);
+                *(void**)ptr = sizeClass.mpFreeList;
+                sizeClass.mpFreeList = ptr;
+                return;
+            }
+        }
+
+        pLoaded->mpRounds[pLoaded->mCount++] = ptr;
+    }
+
+    void SlabAllocator::FlushThreadCache()
+    {
+        const uint32_t slot = GetAllocatorThreadSlot();
+        if (slot == kNoAllocatorThreadSlot)
+            return;
+
+        ThreadCache* pCache = mpCaches[slot].load(std::memory_order_acquire);
+        if (!pCache)
+            return;
+
+        for (uint32_t classIndex = 0; classIndex < kSlabClassCount; ++classIndex)
+        {
+            for (Magazine** ppMagazine : { &pCache->mpLoaded[classIndex], &pCache->mpPrevious[classIndex] })
+            {
+                if ((*ppMagazine)->mCount == 0)
+                    continue;
+                if (Magazine* pEmpty = ExchangeEmpty(classIndex, *ppMagazine))
+                    *ppMagazine = pEmpty;
+            }
+        }
+    }
+
+    void SlabAllocator::Destroy()
+    {
+        for (auto& pCache : mpCaches)
+        {
+            if (ThreadCache* pOld = pCache.exchange(nullptr, std::memory_order_acq_rel))
+                mAllocator->Free(pOld);
+        }
+
+        for (SizeClass& sizeClass : mClasses)
+        {
+            std::unique_lock<std::mutex> lock(sizeClass.mMutex);
+            sizeClass.mpFull = nullptr;
+            sizeClass.mpEmpty = nullptr;
+            sizeClass.mpFreeList = nullptr;
+            sizeClass.mpCurrent = nullptr;
+            sizeClass.mpEnd = nullptr;
+        }
+
+        std::unique_lock<std::mutex> lock(mSlabMutex);
+        while (mpMagazines)
+        {
+            Magazine* pNext = mpMagazines->mpNextAllocated;
+            mAllocator->Free(mpMagazines);
+            mpMagazines = pNext;
+        }
+
+        RegionTable* pTable = mpRegionTable.exchange(nullptr, std::memory_order_acq_rel);
+        if (pTable)
+        {
+            for (uint32_t i = 0; i < pTable->mCount; ++i)
+                mAllocator->Free(pTable->mRegions[i].mpMemory);
+        }
+
+        while (pTable)
+        {
+            RegionTable* pRetired = pTable->mpRetired;
+            mAllocator->Free(pTable);
+            pTable = pRetired;
+        }
+
+        mpSlabs = nullptr;
+        mpSlabsEnd = nullptr;
+    }
+
+    bool SlabAllocator::Owns(const void* ptr) const
+    {
+        const RegionTable* pTable = mpRegionTable.load(std::memory_order_acquire);
+        if (!pTable)
+            return false;
+
+        // Last region starting at or before ptr
+        uint32_t begin = 0;
+        uint32_t end = pTable->mCount;
+        while (begin < end)
+        {
+            const uint32_t mid = (begin + end) / 2;
+            if (pTable->mRegions[mid].mpBegin <= (const Byte*)ptr)
+                begin = mid + 1;
+            else
+                end = mid;
+        }
+
+        if (begin == 0)
+            return false;
+
+        const Byte* pRegion = pTable->mRegions[begin - 1].mpBegin;
+        return (const Byte*)ptr < pRegion + kRegionSize;
+    }
+
+    size_t SlabAllocator::GetCapacity() const
+    {
+        std::unique_lock<std::mutex> lock(mSlabMutex);
+        const RegionTable* pTable = mpRegionTable.load(std::memory_order_relaxed);
+        if (!pTable)
+            return 0;
+        return pTable->mCount * kRegionSize - (size_t)(mpSlabsEnd - mpSlabs);
+    }
+
+    size_t SlabAllocator::GetDepotObjectCount(uint32_t sizeClass) const
+    {
+        assert(sizeClass < kSlabClassCount);
+        const SizeClass& depot = mClasses[sizeClass];
+        std::unique_lock<std::mutex> lock(depot.mMutex);
+
+        size_t count = 0;
+        for (const Magazine* pMagazine = depot.mpFull; pMagazine; pMagazine = pMagazine->mpNext)
+            count += pMagazine->mCount;
+        return count;
+    }
+
+    SlabAllocator::Magazine* SlabAllocator::ExchangeFull(uint32_t classIndex, Magazine* pEmpty)
+    {
+        assert(pEmpty->mCount == 0);
+        SizeClass& sizeClass = mClasses[classIndex];
+        std::unique_lock<std::mutex> lock(sizeClass.mMutex);
+
+        if (Magazine* pFull = sizeClass.mpFull)
+        {
+            sizeClass.mpFull = pFull->mpNext;
+            pEmpty->mpNext = sizeClass.mpEmpty;
+            sizeClass.mpEmpty = pEmpty;
+            return pFull;
+        }
+
+        // Nothing parked, load the empty one straight from the slabs
+        while (pEmpty->mCount < kSlabMagazineSize)
+        {
+            void* ptr = AllocateLocked(sizeClass, classIndex);
+            if (!ptr)
+                break;
+            pEmpty->mpRounds[pEmpty->mCount++] = ptr;
+        }
+
+        return pEmpty;
+    }
+
+    SlabAllocator::Magazine* SlabAllocator::ExchangeEmpty(uint32_t classIndex, Magazine* pFull)
+    {
+        assert(pFull->mCount > 0);
+        SizeClass& sizeClass = mClasses[classIndex];
+        std::unique_lock<std::mutex> lock(sizeClass.mMutex);
+
+        Magazine* pEmpty = sizeClass.mpEmpty;
+        if (pEmpty)
+        {
+            sizeClass.mpEmpty = pEmpty->mpNext;
+        }
+        else
+        {
+            // Without a spare magazine the caller keeps the full one
+            pEmpty = AllocateMagazine();
+            if (!pEmpty)
+                return nullptr;
+        }
+
+        pFull->mpNext = sizeClass.mpFull;
+        sizeClass.mpFull = pFull;
+        return pEmpty;
+    }
+
+    void* SlabAllocator::AllocateLocked(SizeClass& sizeClass, uint32_t classIndex)
+    {
+        if (void* ptr = sizeClass.mpFreeList)
+        {
+            sizeClass.mpFreeList = *(void**)ptr;
+            return ptr;
+        }
+
+        const size_t size = GetClassSize(classIndex);
+        if (sizeClass.mpCurrent == sizeClass.mpEnd)
+        {
+            Byte* pSlab = AllocateSlab();
+            if (!pSlab)
+                return nullptr;
+
+            ((SlabHeader*)pSlab)->mSizeClass = classIndex;
+            sizeClass.mpCurrent = pSlab + size;
+            sizeClass.mpEnd = pSlab + kSlabSize;
+        }
+
+        void* ptr = sizeClass.mpCurrent;
+        sizeClass.mpCurrent += size;
+        return ptr;
+    }
+
+    Byte* SlabAllocator::AllocateSlab()
+    {
+        std::unique_lock<std::mutex> lock(mSlabMutex);
+        if (mpSlabs == mpSlabsEnd)
+        {
+            // One spare slab of slack to align the region
+            void* pMemory = mAllocator->Allocate(kRegionSize + kSlabSize);
+            if (!pMemory)
+                return nullptr;
+
+            Byte* pBegin = (Byte*)(((uintptr_t)pMemory + kSlabSize - 1) & ~(uintptr_t)(kSlabSize - 1));
+
+            RegionTable* pOld = mpRegionTable.load(std::memory_order_relaxed);
+            const uint32_t oldCount = pOld ? pOld->mCount : 0;
+            RegionTable* pTable = (RegionTable*)mAllocator->Allocate(offsetof(RegionTable, mRegions) + (oldCount + 1) * sizeof(Region));
+            if (!pTable)
+            {
+                mAllocator->Free(pMemory);
+                return nullptr;
+            }
+
+            // Old tables may still be read by Owns on other threads, they are only freed by Destroy
+            uint32_t insert = 0;
+            while (insert < oldCount && pOld->mRegions[insert].mpBegin < pBegin)
+                ++insert;
+
+            for (uint32_t i = 0; i < insert; ++i)
+                pTable->mRegions[i] = pOld->mRegions[i];
+            pTable->mRegions[insert] = { pBegin, pMemory };
+            for (uint32_t i = insert; i < oldCount; ++i)
+                pTable->mRegions[i + 1] = pOld->mRegions[i];
+
+            pTable->mCount = oldCount + 1;
+            pTable->mpRetired = pOld;
+            mpRegionTable.store(pTable, std::memory_order_release);
+
+            mpSlabs = pBegin;
+            mpSlabsEnd = pBegin + kRegionSize;
+        }
+
+        Byte* pSlab = mpSlabs;
+        mpSlabs += kSlabSize;
+        return pSlab;
+    }
+
+    SlabAllocator::Magazine* SlabAllocator::AllocateMagazine()
+    {
+        Magazine* pMagazine = (Magazine*)mAllocator->Allocate(sizeof(Magazine));
+        if (!pMagazine)
+            return nullptr;
+
+        pMagazine->mpNext = nullptr;
+        pMagazine->mCount = 0;
+
+        std::unique_lock<std::mutex> lock(mSlabMutex);
+        pMagazine->mpNextAllocated = mpMagazines;
+        mpMagazines = pMagazine;
+        return pMagazine;
+    }
+
+    SlabAllocator::ThreadCache* SlabAllocator::GetThreadCache()
+    {
+        const uint32_t slot = GetAllocatorThreadSlot();
+        if (slot == kNoAllocatorThreadSlot)
+            return nullptr;
+
+        ThreadCache* pCache = mpCaches[slot].load(std::memory_order_acquire);
+        if (!pCache)
+        {
+            // Only the slot's owner creates its cache. A slot outlives its thread, so the
+            // next thread to get it picks up the cached objects as they are.
+            pCache = (ThreadCache*)mAllocator->Allocate(sizeof(ThreadCache));
+            if (!pCache)
+                return nullptr;
+
+            for (uint32_t classIndex = 0; classIndex < kSlabClassCount; ++classIndex)
+            {
+                pCache->mpLoaded[classIndex] = AllocateMagazine();
+                pCache->mpPrevious[classIndex] = AllocateMagazine();
+                if (!pCache->mpLoaded[classIndex] || !pCache->mpPrevious[classIndex])
+                {
+                    mAllocator->Free(pCache);
+                    return nullptr;
+                }
+            }
+
+            mpCaches[slot].store(pCache, std::memory_order_release);
+        }
+
+        return pCache;
+    }
+}
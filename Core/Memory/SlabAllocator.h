@@ -0,0 +1,107 @@
+#pragma once
+
+#ifndef NV_SLAB_ALLOCATOR
+#define NV_SLAB_ALLOCATOR
+
+#include <Memory/Allocator.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace nv
+{
+    // Power of two classes from kSlabMinSize to kSlabMaxSize, bigger requests go to the backing allocator.
+    constexpr size_t   kSlabMinSize = 16;
+    constexpr size_t   kSlabMaxSize = 1024;
+    constexpr uint32_t kSlabClassCount = 7;
+    constexpr size_t   kSlabSize = 64 * 1024;           // Objects of one class, aligned to its size
+    constexpr uint32_t kSlabsPerRegion = 16;            // Slabs taken from the backing allocator at once
+    constexpr uint32_t kSlabMagazineSize = 64;          // Objects moved between a thread and the depot at once
+
+    // Small object allocator in the style of Bonwick's magazines. Each thread keeps a loaded
+    // and a previous magazine per size class and only talks to the shared depot once both are
+    // empty (or full), swapping a whole magazine under the class lock. The depot fills new
+    // magazines by carving slabs; memory is kept until Destroy, so a class stays at its peak.
+    // Free finds the class from the slab header, objects are at least kSlabMinSize aligned.
+    //
+    //  SlabAllocator& slab = *SlabAllocator::gPtr;
+    //  Handler* pHandler = Alloc<Handler>(&slab, args...);
+    //  Free<Handler>(pHandler, &slab);
+    class SlabAllocator : public IAllocator
+    {
+    public:
+        SlabAllocator(IAllocator* allocator = SystemAllocator::gPtr);
+        ~SlabAllocator();
+
+        SlabAllocator(const SlabAllocator&) = delete;
+        SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+        void*   Allocate(size_t size) override;
+        void    Free(void* ptr) override;
+
+        // Hands the calling thread's magazines back to the depot.
+        void    FlushThreadCache();
+        // Frees every slab and magazine. No thread may use the allocator anymore.
+        void    Destroy();
+
+        bool    Owns(const void* ptr) const;
+
+        size_t  GetCapacity() const;                    // Bytes of slabs carved so far
+        size_t  GetDepotObjectCount(uint32_t sizeClass) const; // Objects parked in full depot magazines
+
+        static uint32_t GetSizeClass(size_t size);      // kSlabClassCount for sizes above kSlabMaxSize
+        static constexpr size_t GetClassSize(uint32_t sizeClass) { return kSlabMinSize << sizeClass; }
+
+        static SlabAllocator* gPtr;
+
+    private:
+        struct Magazine;
+        struct ThreadCache;
+
+        struct Region
+        {
+            Byte*   mpBegin;                    // First slab, kSlabSize aligned
+            void*   mpMemory;                   // As returned by the backing allocator
+        };
+
+        // Copied on every new region so Owns can search it without a lock
+        struct RegionTable
+        {
+            RegionTable*    mpRetired;          // Previous, smaller table, freed on Destroy
+            uint32_t        mCount;
+            Region          mRegions[1];        // Sorted by mpBegin, mCount of them
+        };
+
+        struct alignas(64) SizeClass
+        {
+            mutable std::mutex  mMutex;
+            Magazine*           mpFull = nullptr;
+            Magazine*           mpEmpty = nullptr;
+            void*               mpFreeList = nullptr;   // Objects freed by threads without a cache
+            Byte*               mpCurrent = nullptr;    // Bump pointer in the slab being carved
+            Byte*               mpEnd = nullptr;
+        };
+
+        Magazine*       ExchangeFull(uint32_t sizeClass, Magazine* pEmpty);
+        Magazine*       ExchangeEmpty(uint32_t sizeClass, Magazine* pFull);
+        void*           AllocateLocked(SizeClass& sizeClass, uint32_t classIndex);
+        Byte*           AllocateSlab();
+        Magazine*       AllocateMagazine();
+        ThreadCache*    GetThreadCache();
+
+        IAllocator*                 mAllocator;
+        SizeClass                   mClasses[kSlabClassCount];
+
+        mutable std::mutex          mSlabMutex;         // Regions, spare slabs and the magazine list
+        Byte*                       mpSlabs = nullptr;  // Next uncarved slab in the newest region
+        Byte*                       mpSlabsEnd = nullptr;
+        Magazine*                   mpMagazines = nullptr;
+        std::atomic<RegionTable*>   mpRegionTable = nullptr;
+        std::atomic<ThreadCache*>   mpCaches[kAllocatorThreadSlots] = {};
+    };
+
+    extern SlabAllocator gSlabAllocator;
+}
+
+#endif // !NV_SLAB_ALLOCATOR
@@ -0,0 +1,494 @@
+#include "pch.h"
+
+#include "TlsfAllocator.h"
+
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+
+namespace nv
+{
+    // Physical blocks sit back to back in a pool, each one knows its size and the block
+    // before it, so neighbours can be merged in O(1). The free list links overlap the
+    // payload, a block in use only pays for the first two fields.
+    struct TlsfAllocator::Block
+    {
+        static constexpr size_t kFreeBit = 1;
+
+        Block*  mpPrevPhys;
+        size_t  mSize;          // Payload bytes | kFreeBit
+        Block*  mpNextFree;
+        Block*  mpPrevFree;
+
+        size_t  GetSize() const { return mSize & ~kFreeBit; }
+        bool    IsFree() const { return mSize & kFreeBit; }
+        void    SetSize(size_t size) { mSize = size | (mSize & kFreeBit); }
+        void    SetFree(bool bFree) { mSize = bFree ? (mSize | kFreeBit) : (mSize & ~kFreeBit); }
+
+        Byte*   GetPayload() { return (Byte*)this + kHeaderSize; }
+        Block*  GetNextPhys() { return (Block*)(GetPayload() + GetSize()); }
+
+        static Block* FromPayload(const void* ptr) { return (Block*)((Byte*)ptr - kHeaderSize); }
+
+        static constexpr size_t kHeaderSize = 2 * sizeof(void*);
+        static constexpr size_t kMinSize = 2 * sizeof(void*); // Room for the free list links
+    };
+
+    static_assert(sizeof(void*) * 2 <= kTlsfAlignment, "Block header must keep payloads aligned");
+
+    struct TlsfAllocator::ThreadCache
+    {
+        uint32_t    mCounts[kCacheClassCount];
+        Block*      mpBlocks[kCacheClassCount][kTlsfCacheDepth];
+    };
+
+    namespace
+    {
+        constexpr uint32_t kCacheRefillCount = kTlsfCacheDepth / 2;
+
+        size_t AlignSize(size_t size)
+        {
+            return (size + kTlsfAlignment - 1) & ~(kTlsfAlignment - 1);
+        }
+    }
+
+    // Below kSmallBlockSize the second level splits the range linearly in kTlsfAlignment steps
+    void TlsfAllocator::MapSize(size_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+    {
+        if (size < kSmallBlockSize)
+        {
+            firstLevel = 0;
+            secondLevel = (uint32_t)(size / kTlsfAlignment);
+            return;
+        }
+
+        const uint32_t highBit = (uint32_t)std::bit_width(size) - 1;
+        secondLevel = (uint32_t)(size >> (highBit - kSecondLevelLog2)) ^ kSecondLevelCount;
+        firstLevel = highBit - (kSmallBlockShift - 1);
+    }
+
+    TlsfAllocator::TlsfAllocator(size_t poolSize) :
+        mPoolSize(AlignSize(poolSize))
+    {
+        assert(mPoolSize >= kSmallBlockSize);
+    }
+
+    TlsfAllocator::~TlsfAllocator()
+    {
+        Destroy();
+    }
+
+    void* TlsfAllocator::Allocate(size_t size)
+    {
+        size = size < Block::kMinSize ? Block::kMinSize : AlignSize(size);
+        if (size <= kTlsfCachedMaxSize)
+        {
+            if (ThreadCache* pCache = GetThreadCache())
+            {
+                const uint32_t sizeClass = (uint32_t)(size / kTlsfAlignment) - 1;
+                uint32_t& count = pCache->mCounts[sizeClass];
+                if (count == 0)
+                {
+                    // Refill half the depth in one go, the rest is left for frees to land in
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    while (count < kCacheRefillCount)
+                    {
+                        Block* pBlock = AllocateLocked(size);
+                        if (!pBlock)
+                            break;
+                        pCache->mpBlocks[sizeClass][count++] = pBlock;
+                    }
+                }
+
+                if (count > 0)
+                    return pCache->mpBlocks[sizeClass][--count]->GetPayload();
+                return nullptr;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        Block* pBlock = AllocateLocked(size);
+        return pBlock ? pBlock->GetPayload() : nullptr;
+    }
+
+    void TlsfAllocator::Free(void* ptr)
+    {
+        if (!ptr)
+            return;
+
+        Block* pBlock = Block::FromPayload(ptr);
+        assert(Owns(ptr) && !pBlock->IsFree());
+
+        const size_t size = pBlock->GetSize();
+        if (size <= kTlsfCachedMaxSize)
+        {
+            if (ThreadCache* pCache = GetThreadCache())
+            {
+                const uint32_t sizeClass = (uint32_t)(size / kTlsfAlignment) - 1;
+                if (pCache->mCounts[sizeClass] == kTlsfCacheDepth)
+                    FlushCache(*pCache, sizeClass, kTlsfCacheDepth / 2);
+
+                pCache->mpBlocks[sizeClass][pCache->mCounts[sizeClass]++] = pBlock;
+                return;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        FreeLocked(pBlock);
+    }
+
+    void* TlsfAllocator::Realloc(size_t size, void* ptr)
+    {
+        if (!ptr)
+            return Allocate(size);
+
+        if (size == 0)
+        {
+            Free(ptr);
+            return nullptr;
+        }
+
+        Block* pBlock = Block::FromPayload(ptr);
+        const size_t oldSize = pBlock->GetSize();
+        const size_t newSize = size < Block::kMinSize ? Block::kMinSize : AlignSize(size);
+        if (newSize <= oldSize)
+            return ptr;
+
+        // Grow into the next block when it's free, cached blocks are never free on the heap
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            Block* pNext = pBlock->GetNextPhys();
+            if (pNext->IsFree() && oldSize + Block::kHeaderSize + pNext->GetSize() >= newSize)
+            {
+                RemoveFreeBlock(pNext);
+                pBlock->SetSize(oldSize + Block::kHeaderSize + pNext->GetSize());
+                pBlock->GetNextPhys()->mpPrevPhys = pBlock;
+                SplitBlock(pBlock, newSize);
+                mAllocatedSize += pBlock->GetSize() - oldSize;
+                return ptr;
+            }
+        }
+
+        void* pNew = Allocate(size);
+        if (pNew)
+        {
+            memcpy(pNew, ptr, oldSize);
+            Free(ptr);
+        }
+        return pNew;
+    }
+
+    void TlsfAllocator::FlushThreadCache()
+    {
+        const uint32_t slot = GetAllocatorThreadSlot();
+        if (slot == kNoAllocatorThreadSlot)
+            return;
+
+        if (ThreadCache* pCache = mpCaches[slot].load(std::memory_order_acquire))
+        {
+            for (uint32_t sizeClass = 0; sizeClass < kCacheClassCount; ++sizeClass)
+                FlushCache(*pCache, sizeClass, pCache->mCounts[sizeClass]);
+        }
+    }
+
+    void TlsfAllocator::Destroy()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        const uint32_t poolCount = mPoolCount.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < poolCount; ++i)
+        {
+            free(mPools[i].mpMemory);
+            mPools[i] = {};
+        }
+
+        mPoolCount.store(0, std::memory_order_release);
+        for (auto& pCache : mpCaches)
+            pCache.store(nullptr, std::memory_order_relaxed);
+
+        mAllocatedSize = 0;
+        mFirstLevelMap = 0;
+        memset(mSecondLevelMap, 0, sizeof(mSecondLevelMap));
+        memset(mpFreeLists, 0, sizeof(mpFreeLists));
+    }
+
+    bool TlsfAllocator::Owns(const void* ptr) const
+    {
+        const uint32_t poolCount = mPoolCount.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < poolCount; ++i)
+        {
+            if (ptr >= mPools[i].mpBegin && ptr < mPools[i].mpEnd)
+                return true;
+        }
+
+        return false;
+    }
+
+    size_t TlsfAllocator::GetAllocationSize(const void* ptr) const
+    {
+        return Block::FromPayload(ptr)->GetSize();
+    }
+
+    size_t TlsfAllocator::GetAllocatedSize() const
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        return mAllocatedSize;
+    }
+
+    size_t TlsfAllocator::GetCapacity() const
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        size_t capacity = 0;
+        const uint32_t poolCount = mPoolCount.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < poolCount; ++i)
+            capacity += mPools[i].mpEnd - mPools[i].mpBegin;
+        return capacity;
+    }
+
+    bool TlsfAllocator::CheckIntegrity() const
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+
+        size_t freeBlocks = 0;
+        const uint32_t poolCount = mPoolCount.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < poolCount; ++i)
+        {
+            Block* pPrev = nullptr;
+            Block* pBlock = (Block*)mPools[i].mpBegin;
+            while (pBlock->GetSize() != 0) // The sentinel at the end of a pool is empty
+            {
+                if (pBlock->mpPrevPhys != pPrev || (Byte*)pBlock->GetNextPhys() >= mPools[i].mpEnd)
+                    return false;
+                if (pBlock->IsFree() && ((pPrev && pPrev->IsFree()) || pBlock->GetNextPhys()->IsFree()))
+                    return false; // Missed a merge
+
+                freeBlocks += pBlock->IsFree();
+                pPrev = pBlock;
+                pBlock = pBlock->GetNextPhys();
+            }
+
+            if (pBlock->mpPrevPhys != pPrev)
+                return false;
+        }
+
+        size_t listedBlocks = 0;
+        for (uint32_t firstLevel = 0; firstLevel < kFirstLevelCount; ++firstLevel)
+        {
+            if (((mFirstLevelMap >> firstLevel) & 1) != (mSecondLevelMap[firstLevel] != 0))
+                return false;
+
+            for (uint32_t secondLevel = 0; secondLevel < kSecondLevelCount; ++secondLevel)
+            {
+                Block* pBlock = mpFreeLists[firstLevel][secondLevel];
+                if (((mSecondLevelMap[firstLevel] >> secondLevel) & 1) != (pBlock != nullptr))
+                    return false;
+
+                for (; pBlock; pBlock = pBlock->mpNextFree)
+                {
+                    uint32_t blockFirstLevel, blockSecondLevel;
+                    MapSize(pBlock->GetSize(), blockFirstLevel, blockSecondLevel);
+                    if (!pBlock->IsFree() || blockFirstLevel != firstLevel || blockSecondLevel != secondLevel)
+                        return false;
+                    ++listedBlocks;
+                }
+            }
+        }
+
+        return listedBlocks == freeBlocks;
+    }
+
+    TlsfAllocator::Block* TlsfAllocator::AllocateLocked(size_t size)
+    {
+        Block* pBlock = FindFreeBlock(size);
+        if (!pBlock)
+        {
+            if (!AddPool(size))
+                return nullptr;
+
+            pBlock = FindFreeBlock(size);
+            assert(pBlock);
+        }
+
+        RemoveFreeBlock(pBlock);
+        SplitBlock(pBlock, size);
+        pBlock->SetFree(false);
+        mAllocatedSize += pBlock->GetSize();
+        return pBlock;
+    }
+
+    void TlsfAllocator::FreeLocked(Block* pBlock)
+    {
+        mAllocatedSize -= pBlock->GetSize();
+        pBlock->SetFree(true);
+
+        Block* pPrev = pBlock->mpPrevPhys;
+        if (pPrev && pPrev->IsFree())
+        {
+            RemoveFreeBlock(pPrev);
+            pPrev->SetSize(pPrev->GetSize() + Block::kHeaderSize + pBlock->GetSize());
+            pBlock = pPrev;
+        }
+
+        Block* pNext = pBlock->GetNextPhys();
+        if (pNext->IsFree())
+        {
+            RemoveFreeBlock(pNext);
+            pBlock->SetSize(pBlock->GetSize() + Block::kHeaderSize + pNext->GetSize());
+        }
+
+        pBlock->GetNextPhys()->mpPrevPhys = pBlock;
+        InsertFreeBlock(pBlock);
+    }
+
+    bool TlsfAllocator::AddPool(size_t size)
+    {
+        const uint32_t poolCount = mPoolCount.load(std::memory_order_relaxed);
+        assert(poolCount < kTlsfMaxPools);
+        if (poolCount == kTlsfMaxPools)
+            return false;
+
+        // FindFreeBlock rounds the request up to the next second level bin, leave room for that
+        size_t blockSize = AlignSize(size + (size >> kSecondLevelLog2));
+        const size_t poolBlockSize = mPoolSize - 2 * Block::kHeaderSize;
+        blockSize = blockSize > poolBlockSize ? blockSize : poolBlockSize;
+
+        // Straight from the CRT, the allocator can sit behind SystemAllocator itself
+        const size_t poolSize = blockSize + 2 * Block::kHeaderSize;
+        Byte* pMemory = (Byte*)malloc(poolSize + kTlsfAlignment);
+        if (!pMemory)
+            return false;
+
+        Pool& pool = mPools[poolCount];
+        pool.mpMemory = pMemory;
+        pool.mpBegin = (Byte*)(((uintptr_t)pMemory + kTlsfAlignment - 1) & ~(uintptr_t)(kTlsfAlignment - 1));
+        pool.mpEnd = pool.mpBegin + poolSize;
+
+        Block* pBlock = (Block*)pool.mpBegin;
+        pBlock->mpPrevPhys = nullptr;
+        pBlock->mSize = blockSize | Block::kFreeBit;
+
+        Block* pSentinel = pBlock->GetNextPhys();
+        pSentinel->mpPrevPhys = pBlock;
+        pSentinel->mSize = 0;
+
+        InsertFreeBlock(pBlock);
+        mPoolCount.store(poolCount + 1, std::memory_order_release);
+        return true;
+    }
+
+    TlsfAllocator::Block* TlsfAllocator::FindFreeBlock(size_t size)
+    {
+        // Round up to the next bin so any block in it fits
+        if (size >= kSmallBlockSize)
+            size += ((size_t)1 << (std::bit_width(size) - 1 - kSecondLevelLog2)) - 1;
+
+        uint32_t firstLevel, secondLevel;
+        MapSize(size, firstLevel, secondLevel);
+        if (firstLevel >= kFirstLevelCount)
+            return nullptr;
+
+        uint32_t secondLevelMap = mSecondLevelMap[firstLevel] & (~0u << secondLevel);
+        if (!secondLevelMap)
+        {
+            const uint32_t firstLevelMap = firstLevel + 1 < kFirstLevelCount ? mFirstLevelMap & (~0u << (firstLevel + 1)) : 0;
+            if (!firstLevelMap)
+                return nullptr;
+
+            firstLevel = (uint32_t)std::countr_zero(firstLevelMap);
+            secondLevelMap = mSecondLevelMap[firstLevel];
+        }
+
+        secondLevel = (uint32_t)std::countr_zero(secondLevelMap);
+        return mpFreeLists[firstLevel][secondLevel];
+    }
+
+    void TlsfAllocator::InsertFreeBlock(Block* pBlock)
+    {
+        uint32_t firstLevel, secondLevel;
+        MapSize(pBlock->GetSize(), firstLevel, secondLevel);
+        assert(firstLevel < kFirstLevelCount);
+
+        Block*& pHead = mpFreeLists[firstLevel][secondLevel];
+        pBlock->mpPrevFree = nullptr;
+        pBlock->mpNextFree = pHead;
+        if (pHead)
+            pHead->mpPrevFree = pBlock;
+        pHead = pBlock;
+
+        mFirstLevelMap |= 1u << firstLevel;
+        mSecondLevelMap[firstLevel] |= 1u << secondLevel;
+    }
+
+    void TlsfAllocator::RemoveFreeBlock(Block* pBlock)
+    {
+        uint32_t firstLevel, secondLevel;
+        MapSize(pBlock->GetSize(), firstLevel, secondLevel);
+
+        if (pBlock->mpPrevFree)
+            pBlock->mpPrevFree->mpNextFree = pBlock->mpNextFree;
+        if (pBlock->mpNextFree)
+            pBlock->mpNextFree->mpPrevFree = pBlock->mpPrevFree;
+
+        Block*& pHead = mpFreeLists[firstLevel][secondLevel];
+        if (pHead == pBlock)
+        {
+            pHead = pBlock->mpNextFree;
+            if (!pHead)
+            {
+                mSecondLevelMap[firstLevel] &= ~(1u << secondLevel);
+                if (!mSecondLevelMap[firstLevel])
+                    mFirstLevelMap &= ~(1u << firstLevel);
+            }
+        }
+    }
+
+    // Gives the tail of pBlock back to the heap if it's big enough to be a block of its own.
+    // The next physical block is never free here, so the remainder doesn't need merging.
+    void TlsfAllocator::SplitBlock(Block* pBlock, size_t size)
+    {
+        const size_t blockSize = pBlock->GetSize();
+        if (blockSize < size + Block::kHeaderSize + Block::kMinSize)
+            return;
+
+        Block* pRemainder = (Block*)(pBlock->GetPayload() + size);
+        pRemainder->mpPrevPhys = pBlock;
+        pRemainder->mSize = (blockSize - size - Block::kHeaderSize) | Block::kFreeBit;
+        pRemainder->GetNextPhys()->mpPrevPhys = pRemainder;
+        pBlock->SetSize(size);
+        InsertFreeBlock(pRemainder);
+    }
+
+    TlsfAllocator::ThreadCache* TlsfAllocator::GetThreadCache()
+    {
+        const uint32_t slot = GetAllocatorThreadSlot();
+        if (slot == kNoAllocatorThreadSlot)
+            return nullptr;
+
+        ThreadCache* pCache = mpCaches[slot].load(std::memory_order_acquire);
+        if (!pCache)
+        {
+            // Only the slot's owner creates its cache, the lock is for the heap
+            std::unique_lock<std::mutex> lock(mMutex);
+            Block* pBlock = AllocateLocked(AlignSize(sizeof(ThreadCache)));
+            if (!pBlock)
+                return nullptr;
+
+            pCache = (ThreadCache*)pBlock->GetPayload();
+            memset(pCache->mCounts, 0, sizeof(pCache->mCounts));
+            mpCaches[slot].store(pCache, std::memory_order_release);
+        }
+
+        return pCache;
+    }
+
+    void TlsfAllocator::FlushCache(ThreadCache& cache, uint32_t sizeClass, uint32_t count)
+    {
+        if (count == 0)
+            return;
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        uint32_t& cached = cache.mCounts[sizeClass];
+        assert(count <= cached);
+        for (uint32_t i = 0; i < count; ++i)
+            FreeLocked(cache.mpBlocks[sizeClass][--cached]);
+    }
+}
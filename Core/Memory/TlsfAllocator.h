@@ -0,0 +1,102 @@
+#pragma once
+
+#ifndef NV_TLSF_ALLOCATOR
+#define NV_TLSF_ALLOCATOR
+
+#include <Memory/Allocator.h>
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+
+namespace nv
+{
+    constexpr size_t   kTlsfDefaultPoolSize = 64 * 1024 * 1024;
+    constexpr size_t   kTlsfAlignment = 16;
+    constexpr uint32_t kTlsfMaxPools = 32;
+    // Blocks up to kTlsfCachedMaxSize are kept in per thread caches, kTlsfCacheDepth per size class.
+    constexpr size_t   kTlsfCachedMaxSize = 256;
+    constexpr uint32_t kTlsfCacheDepth = 32;
+
+    // Two-Level Segregated Fit allocator. Free blocks are binned by the position of their
+    // highest bit (first level) and 32 linear subdivisions below it (second level); two
+    // bitmap scans find a fitting bin, so allocating and freeing are O(1) with neighbours
+    // coalesced immediately. Memory comes from pools of mPoolSize, a new one is added when
+    // no bin fits, so a request bigger than the pool size gets a pool of its own.
+    // Small blocks go through a per thread cache first and only take the heap lock to
+    // refill or flush a batch. Pointers are kTlsfAlignment aligned.
+    class TlsfAllocator : public IAllocator
+    {
+    public:
+        TlsfAllocator(size_t poolSize = kTlsfDefaultPoolSize);
+        ~TlsfAllocator();
+
+        TlsfAllocator(const TlsfAllocator&) = delete;
+        TlsfAllocator& operator=(const TlsfAllocator&) = delete;
+
+        void*   Allocate(size_t size) override;
+        void*   Realloc(size_t size, void* ptr) override;
+        void    Free(void* ptr) override;
+
+        // Returns the calling thread's cached blocks to the heap.
+        void    FlushThreadCache();
+        // Frees every pool. No thread may use the allocator anymore, caches included.
+        void    Destroy();
+
+        bool    Owns(const void* ptr) const;
+        size_t  GetAllocationSize(const void* ptr) const; // Usable bytes of the block behind ptr
+
+        size_t  GetPoolSize() const { return mPoolSize; }
+        size_t  GetAllocatedSize() const;   // Block bytes handed out, thread cached ones included
+        size_t  GetCapacity() const;        // Bytes in all pools
+        uint32_t GetPoolCount() const { return mPoolCount.load(std::memory_order_acquire); }
+
+        // Walks every pool and free list, for tests and debugging.
+        bool    CheckIntegrity() const;
+
+    private:
+        static constexpr uint32_t kSecondLevelLog2 = 5;
+        static constexpr uint32_t kSecondLevelCount = 1u << kSecondLevelLog2;
+        static constexpr uint32_t kFirstLevelCount = 32;
+        static constexpr uint32_t kSmallBlockShift = std::countr_zero(kTlsfAlignment) + kSecondLevelLog2;
+        static constexpr size_t   kSmallBlockSize = (size_t)1 << kSmallBlockShift;
+        static constexpr uint32_t kCacheClassCount = (uint32_t)(kTlsfCachedMaxSize / kTlsfAlignment);
+
+        struct Block;
+        struct ThreadCache;
+
+        struct Pool
+        {
+            Byte*   mpMemory = nullptr;
+            Byte*   mpBegin = nullptr;
+            Byte*   mpEnd = nullptr;
+        };
+
+        static void MapSize(size_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+        Block*  AllocateLocked(size_t size);
+        void    FreeLocked(Block* pBlock);
+        bool    AddPool(size_t size);
+
+        Block*  FindFreeBlock(size_t size);
+        void    InsertFreeBlock(Block* pBlock);
+        void    RemoveFreeBlock(Block* pBlock);
+        void    SplitBlock(Block* pBlock, size_t size);
+
+        ThreadCache* GetThreadCache();
+        void    FlushCache(ThreadCache& cache, uint32_t sizeClass, uint32_t count);
+
+        mutable std::mutex          mMutex;
+        size_t                      mPoolSize;
+        size_t                      mAllocatedSize = 0;
+        uint32_t                    mFirstLevelMap = 0;
+        uint32_t                    mSecondLevelMap[kFirstLevelCount] = {};
+        Block*                      mpFreeLists[kFirstLevelCount][kSecondLevelCount] = {};
+        Pool                        mPools[kTlsfMaxPools];
+        std::atomic<uint32_t>       mPoolCount = 0; // Pools are published in order, Owns reads them without the lock
+        std::atomic<ThreadCache*>   mpCaches[kAllocatorThreadSlots] = {};
+    };
+}
+
+#endif // !NV_TLSF_ALLOCATOR
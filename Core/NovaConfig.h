@@ -4,9 +4,21 @@
 #pragma once
 
 #ifndef NV_PLATFORM_WINDOWS
+#ifdef _WIN32
 #define NV_PLATFORM_WINDOWS 1
+#else
+#define NV_PLATFORM_WINDOWS 0
+#endif
 #endif  
 
+#ifndef NV_PLATFORM_LINUX
+#ifdef __linux__
+#define NV_PLATFORM_LINUX 1
+#else
+#define NV_PLATFORM_LINUX 0
+#endif
+#endif
+
 #ifndef NV_RENDERER_DX12
 #define NV_RENDERER_DX12 1
 #endif  
@@ -23,6 +35,14 @@
 #define NV_ENABLE_DEBUG_UI 1
 #endif 
 
+#ifndef NV_ENABLE_SYSTEM_VALIDATION
+#ifdef _DEBUG
+#define NV_ENABLE_SYSTEM_VALIDATION 1 // Checks systems only touch the components they declared
+#else
+#define NV_ENABLE_SYSTEM_VALIDATION 0
+#endif
+#endif
+
 #ifndef NV_ENABLE_VLD
 #define NV_ENABLE_VLD 0 // Enables Visual Leak Detector. Affects performance, only use for debugging.
 #endif 
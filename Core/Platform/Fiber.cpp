@@ -0,0 +1,173 @@
+#include "pch.h"
+
+#include <Platform/Fiber.h>
+
+#include <cassert>
+#include <cstdint>
+
+#if NV_PLATFORM_WINDOWS
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+namespace nv::platform
+{
+    struct Fiber
+    {
+#if NV_PLATFORM_WINDOWS
+        void*       mpNative = nullptr;
+#else
+        ucontext_t  mContext = {};
+#endif
+        FiberFn     mFn = nullptr;
+        void*       mpUserData = nullptr;
+    };
+
+#if NV_PLATFORM_WINDOWS
+    static void WINAPI FiberEntry(void* pParameter)
+    {
+        Fiber* pFiber = (Fiber*)pParameter;
+        pFiber->mFn(pFiber->mpUserData);
+        assert(false); // Fibers must switch away instead of returning
+    }
+
+    Fiber* ConvertThreadToFiber()
+    {
+        Fiber* pFiber = new Fiber();
+        pFiber->mpNative = ::ConvertThreadToFiberEx(nullptr, FIBER_FLAG_FLOAT_SWITCH);
+        return pFiber;
+    }
+
+    void ConvertFiberToThread(Fiber* pThreadFiber)
+    {
+        ::ConvertFiberToThread();
+        delete pThreadFiber;
+    }
+
+    Fiber* CreateFiber(void* pStack, size_t stackSize, FiberFn fn, void* pUserData)
+    {
+        Fiber* pFiber = new Fiber();
+        pFiber->mFn = fn;
+        pFiber->mpUserData = pUserData;
+        pFiber->mpNative = ::CreateFiberEx(0, stackSize, FIBER_FLAG_FLOAT_SWITCH, FiberEntry, pFiber);
+        assert(pFiber->mpNative);
+        return pFiber;
+    }
+
+    void DestroyFiber(Fiber* pFiber)
+    {
+        ::DeleteFiber(pFiber->mpNative);
+        delete pFiber;
+    }
+
+    void SwitchFiber(Fiber* pFrom, Fiber* pTo)
+    {
+        ::SwitchToFiber(pTo->mpNative);
+    }
+
+    // Windows fibers own their stacks (CreateFiberEx reserves them with a guard page),
+    // the pool only keeps the requested size.
+    bool FiberStackPool::Init(uint32_t stackCount, size_t stackSize)
+    {
+        mStackCount = stackCount;
+        mStackSize = stackSize;
+        return true;
+    }
+
+    void FiberStackPool::Destroy()
+    {
+        mStackCount = 0;
+    }
+
+    void* FiberStackPool::GetStack(uint32_t index) const
+    {
+        return nullptr;
+    }
+#else
+    // makecontext only passes ints, the fiber pointer is split in two halves
+    static void FiberEntry(uint32_t high, uint32_t low)
+    {
+        Fiber* pFiber = (Fiber*)(((uintptr_t)high << 32) | (uintptr_t)low);
+        pFiber->mFn(pFiber->mpUserData);
+        assert(false); // Fibers must switch away instead of returning
+    }
+
+    Fiber* ConvertThreadToFiber()
+    {
+        return new Fiber(); // Context is filled in by the first switch away
+    }
+
+    void ConvertFiberToThread(Fiber* pThreadFiber)
+    {
+        delete pThreadFiber;
+    }
+
+    Fiber* CreateFiber(void* pStack, size_t stackSize, FiberFn fn, void* pUserData)
+    {
+        assert(pStack);
+        Fiber* pFiber = new Fiber();
+        pFiber->mFn = fn;
+        pFiber->mpUserData = pUserData;
+
+        getcontext(&pFiber->mContext);
+        pFiber->mContext.uc_stack.ss_sp = pStack;
+        pFiber->mContext.uc_stack.ss_size = stackSize;
+        pFiber->mContext.uc_link = nullptr;
+
+        const uintptr_t address = (uintptr_t)pFiber;
+        makecontext(&pFiber->mContext, (void(*)())FiberEntry, 2, (uint32_t)(address >> 32), (uint32_t)address);
+        return pFiber;
+    }
+
+    void DestroyFiber(Fiber* pFiber)
+    {
+        delete pFiber;
+    }
+
+    void SwitchFiber(Fiber* pFrom, Fiber* pTo)
+    {
+        swapcontext(&pFrom->mContext, &pTo->mContext);
+    }
+
+    bool FiberStackPool::Init(uint32_t stackCount, size_t stackSize)
+    {
+        const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        mGuardSize = pageSize;
+        mStackSize = (stackSize + pageSize - 1) & ~(pageSize - 1);
+        mStackCount = stackCount;
+        mReservedSize = (mStackSize + mGuardSize) * stackCount;
+
+        // Pages are only backed once a fiber touches them
+        void* pMemory = mmap(nullptr, mReservedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (pMemory == MAP_FAILED)
+        {
+            mStackCount = 0;
+            return false;
+        }
+
+        mpMemory = (uint8_t*)pMemory;
+        for (uint32_t i = 0; i < stackCount; ++i)
+            mprotect(mpMemory + i * (mStackSize + mGuardSize), mGuardSize, PROT_NONE); // Stacks grow down into it
+
+        return true;
+    }
+
+    void FiberStackPool::Destroy()
+    {
+        if (mpMemory)
+            munmap(mpMemory, mReservedSize);
+
+        mpMemory = nullptr;
+        mStackCount = 0;
+    }
+
+    void* FiberStackPool::GetStack(uint32_t index) const
+    {
+        assert(index < mStackCount);
+        return mpMemory + index * (mStackSize + mGuardSize) + mGuardSize;
+    }
+#endif
+}
@@ -0,0 +1,56 @@
+#ifndef NV_PLATFORM_FIBER
+#define NV_PLATFORM_FIBER
+
+#pragma once
+
+#include <NovaConfig.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nv::platform
+{
+    // Cooperative user mode threads: Win32 fibers on Windows, ucontext elsewhere.
+    // A fiber can be resumed on a different thread than it was suspended on.
+    struct Fiber;
+    using FiberFn = void(*)(void* pUserData);
+
+    // The calling thread becomes a fiber so it can switch to others and back.
+    Fiber*  ConvertThreadToFiber();
+    void    ConvertFiberToThread(Fiber* pThreadFiber);
+
+    // fn must never return, switch away instead. pStack can be null on Windows,
+    // the OS allocates fiber stacks there and only stackSize is used.
+    Fiber*  CreateFiber(void* pStack, size_t stackSize, FiberFn fn, void* pUserData);
+    void    DestroyFiber(Fiber* pFiber);
+
+    // Suspends pFrom (the running fiber) and resumes pTo. Returns when something switches back to pFrom.
+    void    SwitchFiber(Fiber* pFrom, Fiber* pTo);
+
+    // Fixed size fiber stacks carved out of one reservation, each with a no access
+    // guard page below it so an overflow faults instead of corrupting a neighbour.
+    class FiberStackPool
+    {
+    public:
+        FiberStackPool() = default;
+        FiberStackPool(const FiberStackPool&) = delete;
+        FiberStackPool& operator=(const FiberStackPool&) = delete;
+        ~FiberStackPool() { Destroy(); }
+
+        bool    Init(uint32_t stackCount, size_t stackSize);
+        void    Destroy();
+
+        void*   GetStack(uint32_t index) const;
+        size_t  GetStackSize() const { return mStackSize; }
+        uint32_t GetStackCount() const { return mStackCount; }
+
+    private:
+        uint8_t*    mpMemory = nullptr;
+        size_t      mReservedSize = 0;
+        size_t      mStackSize = 0;
+        size_t      mGuardSize = 0;
+        uint32_t    mStackCount = 0;
+    };
+}
+
+#endif // !NV_PLATFORM_FIBER
@@ -0,0 +1,434 @@
+#include "pch.h"
+
+#include <Platform/Thread.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#if NV_PLATFORM_WINDOWS
+#include <Windows.h>
+#include <Lib/Util.h>
+#elif NV_PLATFORM_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#endif
+
+namespace nv::platform
+{
+    static CpuTopology GetFlatTopology()
+    {
+        const uint32_t count = std::max(std::thread::hardware_concurrency(), 1u);
+
+        CpuTopology topology;
+        topology.mLogicalCores.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            auto& core = topology.mLogicalCores[i];
+            core.mId = i;
+            core.mPhysicalCore = i;
+            core.mGroup = (uint16_t)(i / 64);
+            core.mGroupIndex = (uint16_t)(i % 64);
+        }
+
+        topology.mPhysicalCoreCount = count;
+        topology.mPackageCount = 1;
+        topology.mNumaNodeCount = 1;
+        return topology;
+    }
+
+    static void FinalizeTopology(CpuTopology& topology)
+    {
+        auto& cores = topology.mLogicalCores;
+        std::sort(cores.begin(), cores.end(), [](const LogicalCore& a, const LogicalCore& b) { return a.mId < b.mId; });
+
+        std::vector<uint32_t> physicalCores, packages, nodes;
+        for (const auto& core : cores)
+        {
+            physicalCores.push_back(core.mPhysicalCore);
+            packages.push_back(core.mPackage);
+            nodes.push_back(core.mNumaNode);
+        }
+
+        auto countUnique = [](std::vector<uint32_t>& values)
+        {
+            std::sort(values.begin(), values.end());
+            return (uint32_t)(std::unique(values.begin(), values.end()) - values.begin());
+        };
+
+        topology.mPhysicalCoreCount = countUnique(physicalCores);
+        topology.mPackageCount = countUnique(packages);
+        topology.mNumaNodeCount = countUnique(nodes);
+    }
+
+#if NV_PLATFORM_LINUX
+    static bool ReadFirstLine(const std::string& path, std::string& outLine)
+    {
+        std::ifstream file(path);
+        if (!file)
+            return false;
+
+        std::getline(file, outLine);
+        return true;
+    }
+
+    static uint32_t ReadUInt(const std::string& path, uint32_t defaultValue)
+    {
+        std::string line;
+        if (!ReadFirstLine(path, line) || line.empty())
+            return defaultValue;
+
+        return (uint32_t)std::strtoul(line.c_str(), nullptr, 10);
+    }
+
+    // "0-3,8,10-11"
+    static std::vector<uint32_t> ParseCpuList(const std::string& text)
+    {
+        std::vector<uint32_t> ids;
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            size_t end = text.find(',', pos);
+            if (end == std::string::npos)
+                end = text.size();
+
+            const std::string token = text.substr(pos, end - pos);
+            if (!token.empty() && isdigit((unsigned char)token[0]))
+            {
+                char* pEnd = nullptr;
+                const uint32_t first = (uint32_t)std::strtoul(token.c_str(), &pEnd, 10);
+                const uint32_t last = *pEnd == '-' ? (uint32_t)std::strtoul(pEnd + 1, nullptr, 10) : first;
+                for (uint32_t id = first; id <= last; ++id)
+                    ids.push_back(id);
+            }
+
+            pos = end + 1;
+        }
+
+        return ids;
+    }
+
+    CpuTopology ReadSysfsTopology(const char* pSysfsRoot)
+    {
+        namespace fs = std::filesystem;
+
+        const std::string root = pSysfsRoot;
+        const std::string cpuRoot = root + "/cpu";
+
+        std::string online;
+        if (!ReadFirstLine(cpuRoot + "/online", online))
+            return GetFlatTopology();
+
+        const auto cpuIds = ParseCpuList(online);
+        if (cpuIds.empty())
+            return GetFlatTopology();
+
+        std::map<uint32_t, uint32_t> cpuToNode;
+        std::error_code error;
+        for (const auto& entry : fs::directory_iterator(root + "/node", error))
+        {
+            const std::string name = entry.path().filename().string();
+            if (name.size() <= 4 || name.compare(0, 4, "node") != 0 || !isdigit((unsigned char)name[4]))
+                continue;
+
+            std::string cpuList;
+            if (!ReadFirstLine(entry.path().string() + "/cpulist", cpuList))
+                continue;
+
+            const uint32_t node = (uint32_t)std::strtoul(name.c_str() + 4, nullptr, 10);
+            for (uint32_t id : ParseCpuList(cpuList))
+                cpuToNode[id] = node;
+        }
+
+        CpuTopology topology;
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> physicalCores; // (package, core id) -> dense index
+        for (uint32_t id : cpuIds)
+        {
+            const std::string topologyPath = cpuRoot + "/cpu" + std::to_string(id) + "/topology";
+
+            LogicalCore core;
+            core.mId = id;
+            core.mPackage = ReadUInt(topologyPath + "/physical_package_id", 0);
+            core.mGroup = (uint16_t)(id / 64);
+            core.mGroupIndex = (uint16_t)(id % 64);
+
+            const uint32_t coreId = ReadUInt(topologyPath + "/core_id", id);
+            const auto key = std::make_pair(core.mPackage, coreId);
+            auto it = physicalCores.find(key);
+            if (it == physicalCores.end())
+                it = physicalCores.emplace(key, (uint32_t)physicalCores.size()).first;
+            core.mPhysicalCore = it->second;
+
+            std::string siblingList;
+            if (ReadFirstLine(topologyPath + "/thread_siblings_list", siblingList))
+            {
+                const auto siblings = ParseCpuList(siblingList);
+                const auto sibling = std::find(siblings.begin(), siblings.end(), id);
+                if (sibling != siblings.end())
+                    core.mSmtIndex = (uint32_t)(sibling - siblings.begin());
+            }
+
+            const auto node = cpuToNode.find(id);
+            core.mNumaNode = node != cpuToNode.end() ? node->second : 0;
+
+            topology.mLogicalCores.push_back(core);
+        }
+
+        FinalizeTopology(topology);
+        return topology;
+    }
+
+    // Drops the cores the process isn't allowed to run on (taskset, cgroup cpusets)
+    static void RestrictToAffinity(CpuTopology& topology)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) != 0)
+            return;
+
+        std::vector<LogicalCore> allowed;
+        for (const auto& core : topology.mLogicalCores)
+        {
+            if (core.mId < CPU_SETSIZE && CPU_ISSET(core.mId, &set))
+                allowed.push_back(core);
+        }
+
+        if (allowed.empty())
+            return;
+
+        topology.mLogicalCores = std::move(allowed);
+        FinalizeTopology(topology);
+    }
+#endif
+
+    CpuTopology DiscoverCpuTopology()
+    {
+#if NV_PLATFORM_WINDOWS
+        DWORD length = 0;
+        GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+        if (length == 0)
+            return GetFlatTopology();
+
+        std::vector<uint8_t> buffer(length);
+        if (!GetLogicalProcessorInformationEx(RelationAll, (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)buffer.data(), &length))
+            return GetFlatTopology();
+
+        auto toId = [](WORD group, uint32_t bit) { return (uint32_t)group * 64 + bit; };
+
+        CpuTopology topology;
+        std::map<uint32_t, uint32_t> cpuToNode;
+        std::map<uint32_t, uint32_t> cpuToPackage;
+        uint32_t physicalCore = 0;
+        uint32_t package = 0;
+
+        for (size_t offset = 0; offset < length;)
+        {
+            const auto* pInfo = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)(buffer.data() + offset);
+            offset += pInfo->Size;
+
+            switch (pInfo->Relationship)
+            {
+            case RelationProcessorCore:
+            {
+                uint32_t smtIndex = 0;
+                for (WORD g = 0; g < pInfo->Processor.GroupCount; ++g)
+                {
+                    const GROUP_AFFINITY& affinity = pInfo->Processor.GroupMask[g];
+                    for (uint32_t bit = 0; bit < 64; ++bit)
+                    {
+                        if ((affinity.Mask & (1ull << bit)) == 0)
+                            continue;
+
+                        LogicalCore core;
+                        core.mId = toId(affinity.Group, bit);
+                        core.mPhysicalCore = physicalCore;
+                        core.mSmtIndex = smtIndex++;
+                        core.mGroup = affinity.Group;
+                        core.mGroupIndex = (uint16_t)bit;
+                        topology.mLogicalCores.push_back(core);
+                    }
+                }
+                physicalCore++;
+                break;
+            }
+            case RelationProcessorPackage:
+            {
+                for (WORD g = 0; g < pInfo->Processor.GroupCount; ++g)
+                {
+                    const GROUP_AFFINITY& affinity = pInfo->Processor.GroupMask[g];
+                    for (uint32_t bit = 0; bit < 64; ++bit)
+                    {
+                        if (affinity.Mask & (1ull << bit))
+                            cpuToPackage[toId(affinity.Group, bit)] = package;
+                    }
+                }
+                package++;
+                break;
+            }
+            case RelationNumaNode:
+            {
+                const GROUP_AFFINITY& affinity = pInfo->NumaNode.GroupMask;
+                for (uint32_t bit = 0; bit < 64; ++bit)
+                {
+                    if (affinity.Mask & (1ull << bit))
+                        cpuToNode[toId(affinity.Group, bit)] = pInfo->NumaNode.NodeNumber;
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        if (topology.mLogicalCores.empty())
+            return GetFlatTopology();
+
+        for (auto& core : topology.mLogicalCores)
+        {
+            core.mPackage = cpuToPackage[core.mId];
+            core.mNumaNode = cpuToNode[core.mId];
+        }
+
+        FinalizeTopology(topology);
+        return topology;
+#elif NV_PLATFORM_LINUX
+        CpuTopology topology = ReadSysfsTopology("/sys/devices/system");
+        RestrictToAffinity(topology);
+        return topology;
+#else
+        return GetFlatTopology();
+#endif
+    }
+
+    const CpuTopology& GetCpuTopology()
+    {
+        static const CpuTopology topology = DiscoverCpuTopology();
+        return topology;
+    }
+
+    static std::vector<LogicalCore> GetSpreadOrder(std::vector<LogicalCore> cores)
+    {
+        // Rank of each physical core within its NUMA node
+        std::map<uint32_t, std::map<uint32_t, uint32_t>> nodeCoreRanks;
+        for (const auto& core : cores)
+            nodeCoreRanks[core.mNumaNode].emplace(core.mPhysicalCore, 0);
+
+        for (auto& [node, ranks] : nodeCoreRanks)
+        {
+            uint32_t rank = 0;
+            for (auto& [physicalCore, coreRank] : ranks)
+                coreRank = rank++;
+        }
+
+        // First hardware thread of every core before any sibling, alternating nodes
+        auto key = [&](const LogicalCore& core)
+        {
+            return std::make_tuple(core.mSmtIndex, nodeCoreRanks[core.mNumaNode][core.mPhysicalCore], core.mNumaNode, core.mId);
+        };
+
+        std::sort(cores.begin(), cores.end(), [&](const LogicalCore& a, const LogicalCore& b) { return key(a) < key(b); });
+        return cores;
+    }
+
+    std::vector<LogicalCore> GetThreadPlacement(const CpuTopology& topology, ThreadPlacement placement)
+    {
+        std::vector<LogicalCore> cores = topology.mLogicalCores;
+
+        switch (placement)
+        {
+        case ThreadPlacement::Compact:
+            std::sort(cores.begin(), cores.end(), [](const LogicalCore& a, const LogicalCore& b)
+            {
+                return std::tie(a.mNumaNode, a.mPhysicalCore, a.mSmtIndex, a.mId) < std::tie(b.mNumaNode, b.mPhysicalCore, b.mSmtIndex, b.mId);
+            });
+            return cores;
+
+        case ThreadPlacement::Spread:
+            return GetSpreadOrder(std::move(cores));
+
+        case ThreadPlacement::ReserveCoreZero:
+        {
+            if (cores.empty())
+                return cores;
+
+            // Left to the main thread and the OS, nothing is pinned there
+            const uint32_t reserved = cores.front().mPhysicalCore;
+            std::vector<LogicalCore> remaining;
+            for (const auto& core : cores)
+            {
+                if (core.mPhysicalCore != reserved)
+                    remaining.push_back(core);
+            }
+
+            return GetSpreadOrder(remaining.empty() ? std::move(cores) : std::move(remaining));
+        }
+
+        case ThreadPlacement::None:
+        default:
+            return {};
+        }
+    }
+
+    void SetCurrentThreadName(const char* pName)
+    {
+#if NV_PLATFORM_WINDOWS
+        SetThreadDescription(GetCurrentThread(), ToWString(pName).c_str());
+#elif NV_PLATFORM_LINUX
+        char name[16] = {};
+        strncpy(name, pName, sizeof(name) - 1);
+        pthread_setname_np(pthread_self(), name);
+#endif
+    }
+
+    bool SetCurrentThreadAffinity(const LogicalCore& core)
+    {
+#if NV_PLATFORM_WINDOWS
+        GROUP_AFFINITY affinity = {};
+        affinity.Group = core.mGroup;
+        affinity.Mask = 1ull << core.mGroupIndex;
+        return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+#elif NV_PLATFORM_LINUX
+        if (core.mId >= CPU_SETSIZE)
+            return false;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core.mId, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+    void RaiseCurrentThreadPriority()
+    {
+#if NV_PLATFORM_WINDOWS
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+#endif
+        // Raising priority needs CAP_SYS_NICE on Linux, workers stay at the default there
+    }
+
+    uint32_t GetCurrentNumaNode()
+    {
+#if NV_PLATFORM_WINDOWS
+        PROCESSOR_NUMBER processor = {};
+        GetCurrentProcessorNumberEx(&processor);
+        USHORT node = 0;
+        return GetNumaProcessorNodeEx(&processor, &node) ? (uint32_t)node : 0;
+#elif NV_PLATFORM_LINUX
+        unsigned cpu = 0, node = 0;
+        return syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 ? node : 0;
+#else
+        return 0;
+#endif
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef NV_PLATFORM_THREAD
+#define NV_PLATFORM_THREAD
+
+#pragma once
+
+#include <NovaConfig.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace nv::platform
+{
+    struct LogicalCore
+    {
+        uint32_t mId            = 0;    // OS processor number
+        uint32_t mPhysicalCore  = 0;    // Dense index shared by SMT siblings
+        uint32_t mSmtIndex      = 0;    // 0 for the first hardware thread of a physical core
+        uint32_t mPackage       = 0;
+        uint32_t mNumaNode      = 0;
+        uint16_t mGroup         = 0;    // Windows processor group, 0 elsewhere
+        uint16_t mGroupIndex    = 0;    // Processor number within the group
+    };
+
+    struct CpuTopology
+    {
+        std::vector<LogicalCore>    mLogicalCores; // Sorted by mId
+        uint32_t                    mPhysicalCoreCount = 0;
+        uint32_t                    mPackageCount = 0;
+        uint32_t                    mNumaNodeCount = 0;
+    };
+
+    enum class ThreadPlacement : uint8_t
+    {
+        None,               // Let the OS schedule worker threads
+        Compact,            // Fill a NUMA node's cores (and their SMT siblings) before moving on
+        Spread,             // One thread per physical core, round robin over NUMA nodes, SMT siblings last
+        ReserveCoreZero,    // Spread, but keep workers off the first physical core, left to the main thread and the OS
+    };
+
+    // Queried once and cached. Falls back to one flat node of hardware_concurrency
+    // cores if the OS doesn't tell us more.
+    const CpuTopology&  GetCpuTopology();
+    CpuTopology         DiscoverCpuTopology();
+
+#if NV_PLATFORM_LINUX
+    // Reads <root>/cpu/cpuN/topology/* and <root>/node/nodeK/cpulist, root is normally /sys/devices/system.
+    CpuTopology         ReadSysfsTopology(const char* pSysfsRoot);
+#endif
+
+    // Logical cores in the order worker threads should be pinned to them. Thread i
+    // goes to result[i % result.size()]. Empty for ThreadPlacement::None.
+    std::vector<LogicalCore> GetThreadPlacement(const CpuTopology& topology, ThreadPlacement placement);
+
+    // Names longer than 15 characters are truncated on Linux.
+    void SetCurrentThreadName(const char* pName);
+    bool SetCurrentThreadAffinity(const LogicalCore& core);
+    void RaiseCurrentThreadPriority();
+    // NUMA node of the core the calling thread runs on right now, 0 if unknown.
+    uint32_t GetCurrentNumaNode();
+}
+
+#endif // !NV_PLATFORM_THREAD
@@ -0,0 +1,281 @@
+#include "pch.h"
+
+#include <Platform/VirtualMemory.h>
+
+#if NV_PLATFORM_WINDOWS
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#if NV_PLATFORM_LINUX
+#include <sys/syscall.h>
+#endif
+#include <cstdio>
+#include <fstream>
+#include <string>
+#endif
+
+namespace nv::platform
+{
+    // Commits round out to whole pages, decommits round in so they never take a neighbour's page
+    static void GetPageRange(void* ptr, size_t size, bool bRoundOut, uintptr_t& begin, uintptr_t& end)
+    {
+        const uintptr_t pageMask = GetPageSize() - 1;
+        begin = bRoundOut ? (uintptr_t)ptr & ~pageMask : ((uintptr_t)ptr + pageMask) & ~pageMask;
+        end = bRoundOut ? ((uintptr_t)ptr + size + pageMask) & ~pageMask : ((uintptr_t)ptr + size) & ~pageMask;
+    }
+
+    static size_t RoundUp(size_t size, size_t pageSize)
+    {
+        return (size + pageSize - 1) / pageSize * pageSize;
+    }
+
+#if NV_PLATFORM_WINDOWS
+    size_t GetPageSize()
+    {
+        static const size_t sPageSize = []()
+        {
+            SYSTEM_INFO info = {};
+            ::GetSystemInfo(&info);
+            return (size_t)info.dwPageSize;
+        }();
+        return sPageSize;
+    }
+
+    void* ReserveVirtualMemory(size_t size)
+    {
+        return ::VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+    }
+
+    bool CommitVirtualMemory(void* ptr, size_t size)
+    {
+        if (size == 0)
+            return true;
+
+        uintptr_t begin, end;
+        GetPageRange(ptr, size, true, begin, end);
+        return ::VirtualAlloc((void*)begin, end - begin, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+    }
+
+    void DecommitVirtualMemory(void* ptr, size_t size)
+    {
+        uintptr_t begin, end;
+        GetPageRange(ptr, size, false, begin, end);
+        if (begin < end)
+            ::VirtualFree((void*)begin, end - begin, MEM_DECOMMIT);
+    }
+
+    void ReleaseVirtualMemory(void* ptr, size_t size)
+    {
+        if (ptr)
+            ::VirtualFree(ptr, 0, MEM_RELEASE);
+    }
+
+    size_t GetLargePageSize()
+    {
+        static const size_t sLargePageSize = (size_t)::GetLargePageMinimum();
+        return sLargePageSize;
+    }
+
+    // Large pages need SeLockMemoryPrivilege held by the account and enabled in the process token
+    static bool EnableLockMemoryPrivilege()
+    {
+        static const bool sbEnabled = []()
+        {
+            HANDLE token = nullptr;
+            if (!::OpenProcessToken(::GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+                return false;
+
+            TOKEN_PRIVILEGES privileges = {};
+            privileges.PrivilegeCount = 1;
+            privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+            // AdjustTokenPrivileges succeeds with ERROR_NOT_ALL_ASSIGNED when the account lacks the privilege
+            const bool bEnabled = ::LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+                && ::AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+                && ::GetLastError() == ERROR_SUCCESS;
+
+            ::CloseHandle(token);
+            return bEnabled;
+        }();
+        return sbEnabled;
+    }
+
+    void* MapLargePages(size_t& size, LargePageMode mode, uint32_t numaNode, LargePageMode* pMode)
+    {
+        const DWORD node = numaNode == kAnyNumaNode ? NUMA_NO_PREFERRED_NODE : (DWORD)numaNode;
+        const size_t largePageSize = GetLargePageSize();
+
+        if (mode == LargePageMode::Explicit && largePageSize && EnableLockMemoryPrivilege())
+        {
+            const size_t largeSize = RoundUp(size, largePageSize);
+            void* ptr = ::VirtualAllocExNuma(::GetCurrentProcess(), nullptr, largeSize,
+                MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, node);
+            if (ptr)
+            {
+                size = largeSize;
+                if (pMode)
+                    *pMode = LargePageMode::Explicit;
+                return ptr;
+            }
+        }
+
+        // Windows has no transparent large pages, anything else gets regular ones
+        const size_t mappedSize = RoundUp(size, GetPageSize());
+        void* ptr = ::VirtualAllocExNuma(::GetCurrentProcess(), nullptr, mappedSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+        if (!ptr)
+            return nullptr;
+
+        size = mappedSize;
+        if (pMode)
+            *pMode = LargePageMode::None;
+        return ptr;
+    }
+
+    void UnmapLargePages(void* ptr, size_t size)
+    {
+        if (ptr)
+            ::VirtualFree(ptr, 0, MEM_RELEASE);
+    }
+#else
+    size_t GetPageSize()
+    {
+        static const size_t sPageSize = (size_t)sysconf(_SC_PAGESIZE);
+        return sPageSize;
+    }
+
+    void* ReserveVirtualMemory(size_t size)
+    {
+        void* ptr = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    bool CommitVirtualMemory(void* ptr, size_t size)
+    {
+        if (size == 0)
+            return true;
+
+        uintptr_t begin, end;
+        GetPageRange(ptr, size, true, begin, end);
+        return mprotect((void*)begin, end - begin, PROT_READ | PROT_WRITE) == 0;
+    }
+
+    void DecommitVirtualMemory(void* ptr, size_t size)
+    {
+        uintptr_t begin, end;
+        GetPageRange(ptr, size, false, begin, end);
+        if (begin < end)
+        {
+            madvise((void*)begin, end - begin, MADV_DONTNEED);
+            mprotect((void*)begin, end - begin, PROT_NONE);
+        }
+    }
+
+    void ReleaseVirtualMemory(void* ptr, size_t size)
+    {
+        if (ptr)
+            munmap(ptr, size);
+    }
+
+    size_t GetLargePageSize()
+    {
+        static const size_t sLargePageSize = []()
+        {
+            std::ifstream meminfo("/proc/meminfo");
+            std::string line;
+            while (std::getline(meminfo, line))
+            {
+                size_t sizeKB = 0;
+                if (sscanf(line.c_str(), "Hugepagesize: %zu kB", &sizeKB) == 1)
+                    return sizeKB * 1024;
+            }
+            return (size_t)0;
+        }();
+        return sLargePageSize;
+    }
+
+    // Preferred rather than bound, a full node spills over to the others instead of failing the page fault.
+    // Has to happen before the first touch.
+    static void PreferNumaNode(void* ptr, size_t size, uint32_t numaNode)
+    {
+#if NV_PLATFORM_LINUX
+        constexpr int kMpolPreferred = 1;
+        unsigned long nodeMask = 0;
+        if (numaNode == kAnyNumaNode || numaNode >= sizeof(nodeMask) * 8)
+            return;
+
+        nodeMask = 1ul << numaNode;
+        syscall(SYS_mbind, ptr, size, kMpolPreferred, &nodeMask, sizeof(nodeMask) * 8 + 1, 0);
+#endif
+    }
+
+    void* MapLargePages(size_t& size, LargePageMode mode, uint32_t numaNode, LargePageMode* pMode)
+    {
+        const size_t largePageSize = GetLargePageSize();
+        const size_t pageSize = GetPageSize();
+        if (largePageSize <= pageSize)
+            mode = LargePageMode::None;
+
+        void* ptr = MAP_FAILED;
+        size_t mappedSize = 0;
+
+#if NV_PLATFORM_LINUX
+        if (mode == LargePageMode::Explicit)
+        {
+            // Fails unless hugetlb pages were reserved (vm.nr_hugepages)
+            mappedSize = RoundUp(size, largePageSize);
+            ptr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr == MAP_FAILED)
+                mode = LargePageMode::Transparent;
+        }
+
+        if (mode == LargePageMode::Transparent)
+        {
+            // THP only backs large page aligned ranges, so map one large page extra and trim it to align the start.
+            // A tail smaller than a large page stays on regular pages.
+            mappedSize = RoundUp(size, pageSize);
+            uint8_t* pRaw = (uint8_t*)mmap(nullptr, mappedSize + largePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (pRaw != (uint8_t*)MAP_FAILED)
+            {
+                uint8_t* pBegin = (uint8_t*)RoundUp((uintptr_t)pRaw, largePageSize);
+                const size_t head = pBegin - pRaw;
+                if (head)
+                    munmap(pRaw, head);
+                munmap(pBegin + mappedSize, largePageSize - head);
+
+                ptr = pBegin;
+                if (madvise(ptr, mappedSize, MADV_HUGEPAGE) != 0)
+                    mode = LargePageMode::None; // Kernel without THP, the mapping is still good
+            }
+            else
+            {
+                mode = LargePageMode::None;
+            }
+        }
+#else
+        mode = LargePageMode::None;
+#endif
+
+        if (ptr == MAP_FAILED)
+        {
+            mappedSize = RoundUp(size, pageSize);
+            ptr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED)
+                return nullptr;
+        }
+
+        PreferNumaNode(ptr, mappedSize, numaNode);
+
+        size = mappedSize;
+        if (pMode)
+            *pMode = mode;
+        return ptr;
+    }
+
+    void UnmapLargePages(void* ptr, size_t size)
+    {
+        if (ptr)
+            munmap(ptr, size);
+    }
+#endif
+}
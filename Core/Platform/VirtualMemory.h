@@ -0,0 +1,42 @@
+#ifndef NV_PLATFORM_VIRTUALMEMORY
+#define NV_PLATFORM_VIRTUALMEMORY
+
+#pragma once
+
+#include <NovaConfig.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nv::platform
+{
+    enum class LargePageMode : uint8_t
+    {
+        None,           // Regular pages
+        Transparent,    // Large page aligned and left to the kernel to back (Linux THP), regular pages on Windows
+        Explicit,       // Locked large pages, needs reserved hugetlb pages (Linux) or the lock pages privilege (Windows)
+    };
+
+    constexpr uint32_t kAnyNumaNode = ~0u;
+
+    size_t  GetPageSize();
+    size_t  GetLargePageSize();     // 0 when the OS doesn't have large pages
+
+    // Reserves address space only, nothing in it can be touched until committed. nullptr on failure.
+    void*   ReserveVirtualMemory(size_t size);
+    // Makes [ptr, ptr + size) readable and writable, rounded out to whole pages. New pages read as zero.
+    bool    CommitVirtualMemory(void* ptr, size_t size);
+    // Hands the pages back to the OS, the range stays reserved.
+    void    DecommitVirtualMemory(void* ptr, size_t size);
+    // ptr and size as passed to and returned from ReserveVirtualMemory.
+    void    ReleaseVirtualMemory(void* ptr, size_t size);
+
+    // Reserves and commits in one go, preferring numaNode's memory unless it's kAnyNumaNode. size is rounded
+    // up to what was mapped. Explicit falls back to Transparent and that to None when the OS refuses, the
+    // mode that was used goes to pMode. nullptr on failure.
+    void*   MapLargePages(size_t& size, LargePageMode mode, uint32_t numaNode, LargePageMode* pMode = nullptr);
+    // ptr and size as returned from MapLargePages.
+    void    UnmapLargePages(void* ptr, size_t size);
+}
+
+#endif // !NV_PLATFORM_VIRTUALMEMORY
@@ -4,8 +4,11 @@
 #include <Animation/Animation.h>
 #include <Components/Renderable.h>
 #include <Renderer/ResourceManager.h>
+#include <Engine/EntityCommandBuffer.h>
 #include <Engine/JobSystem.h>
+#include <Engine/Query.h>
 #include <Debug/Profiler.h>
+#include <Memory/FrameAllocator.h>
 
 namespace nv::graphics::animation
 {
@@ -34,73 +37,89 @@ namespace nv::graphics::animation
 		if (!pComponentPool)
 			return;
 
-		auto pRenderablePool = ecs::gComponentManager.GetPool<Renderable>();
-        ecs::EntityComponents<Renderable> renderables;
-		pRenderablePool->GetEntityComponents(renderables);
-
-		for (uint32_t i=0;i<renderables.Size();++i)
+		// Runs wide, the component changes are deferred to the sync point after this system.
+		// The instances are registered right away, the flag tells the renderer they're there.
+		ecs::Query<Renderable>().ForEachChunk([&](const auto& chunk)
 		{
-			auto data = renderables[i];
-			if (data.mpComponent->mMesh.IsNull())
-				continue;
-
-			auto mpMesh = gResourceManager->GetMesh(data.mpComponent->mMesh);
-            if (!mpMesh)
-                continue;
-
-			if (mpMesh->HasBones() && !data.mpEntity->Has<AnimationComponent>())
+			ecs::EntityCommandBuffer& commands = ecs::gEntityCommands.GetBuffer();
+			chunk.ForEach([&](Handle<ecs::Entity> entity, Renderable& renderable)
 			{
-				data.mpEntity->Add<AnimationComponent>();
-				gAnimManager.Register(renderables.mEntities[i], mpMesh);
-                data.mpComponent->mFlags = (RenderableFlags)(data.mpComponent->mFlags | RENDERABLE_FLAG_ANIMATED);
-			}
-			else if (!mpMesh->HasBones() && data.mpEntity->Has<AnimationComponent>())
-			{
-				data.mpEntity->Remove<AnimationComponent>();
-                gAnimManager.Unregister(renderables.mEntities[i]);
-                data.mpComponent->mFlags = (RenderableFlags)(data.mpComponent->mFlags & ~RENDERABLE_FLAG_ANIMATED);
-			}
-		}
-
-		nv::Vector<Handle<jobs::Job>> jobHandles;
+				if (renderable.mMesh.IsNull())
+					return;
+
+				auto mpMesh = gResourceManager->GetMesh(renderable.mMesh);
+				if (!mpMesh)
+					return;
+
+				const bool bAnimated = pComponentPool->Contains(entity);
+				if (mpMesh->HasBones() && !bAnimated)
+				{
+					commands.Add<AnimationComponent>(chunk.GetIndex(), entity);
+					gAnimManager.Lock();
+					gAnimManager.Register(entity, mpMesh);
+					gAnimManager.Unlock();
+					renderable.mFlags = (RenderableFlags)(renderable.mFlags | RENDERABLE_FLAG_ANIMATED);
+				}
+				else if (!mpMesh->HasBones() && bAnimated)
+				{
+					commands.Remove<AnimationComponent>(chunk.GetIndex(), entity);
+					gAnimManager.Lock();
+					gAnimManager.Unregister(entity);
+					gAnimManager.Unlock();
+					renderable.mFlags = (RenderableFlags)(renderable.mFlags & ~RENDERABLE_FLAG_ANIMATED);
+				}
+			});
+		});
+
+		struct BoneTransformWork
+		{
+			AnimationComponent*		mpComponent;
+			size_t					mInstanceIndex;
+			const Animation*		mpAnimation;
+			const MeshAnimNodeData*	mpNodeData;
+			const MeshBoneDesc*		mpBoneDesc;
+		};
+
+		std::vector<BoneTransformWork> work;
 		AnimInstanceVector& animInstances = *animInstanceAllocator.CreateInstance();
-        ecs::EntityComponents<AnimationComponent> components;
-        pComponentPool->GetEntityComponents(components);
+		ecs::Query<AnimationComponent, const Renderable> query;
+		nv::Vector<Handle<ecs::Entity>> entities((uint32_t)query.GetMaxCount(), FrameAllocator::gPtr);
+		work.reserve(query.GetMaxCount());
 
-		for (size_t i = 0; i < components.mComponents.size(); ++i)
+		// Lookups stay on this thread, only the bone transforms go wide
+		query.ForEach([&](Handle<ecs::Entity> entityHandle, AnimationComponent& comp, const Renderable& renderable)
 		{
-			AnimationComponent* pComp = components.mComponents[i];
-			if (!pComp->mIsPlaying)
+			// Unregistered above, the component goes at the sync point
+			if (!renderable.HasFlag(RENDERABLE_FLAG_ANIMATED))
 				return;
 
-			Handle<ecs::Entity> entityHandle = components.mEntities[i];
-			auto pEntity = ecs::gEntityManager.GetEntity(entityHandle);
-			auto& instanceData = gAnimManager.GetInstance(entityHandle);
-			auto meshHandle = pEntity->Get<components::Renderable>()->mMesh;
-			auto pMesh = graphics::gResourceManager->GetMesh(meshHandle);
-
-			pComp->mTotalTime += deltaTime * pComp->mAnimationSpeed;
-			auto& instance = gAnimManager.GetInstance(entityHandle);
-			auto& animation = gAnimManager.GetAnimation(pComp->mCurrentAnimationIndex);
-			auto& nodeData = gAnimManager.GetMeshAnimNodeData(meshHandle);
-			auto& boneDesc = pMesh->GetBoneData();
+			const size_t instanceIndex = entities.size();
+			entities.Push(entityHandle);
 
 			auto& copyInstance = animInstances.Emplace();
-			copyInstance = instance;
+			copyInstance = gAnimManager.GetInstance(entityHandle);
 
-			BoneTransform(*pComp, copyInstance, animation, nodeData, boneDesc);
+			if (!comp.mIsPlaying)
+				return;
 
-			//auto handle = jobs::Execute([&](void*)
-			//{
-			//	BoneTransform(*pComp, copyInstance, animation, nodeData, boneDesc);
-			//});
+			auto meshHandle = renderable.mMesh;
+			auto pMesh = graphics::gResourceManager->GetMesh(meshHandle);
 
-			//jobHandles.Push(handle);
-		}
+			comp.mTotalTime += deltaTime * comp.mAnimationSpeed;
+			auto& animation = gAnimManager.GetAnimation(comp.mCurrentAnimationIndex);
+			auto& nodeData = gAnimManager.GetMeshAnimNodeData(meshHandle);
+			auto& boneDesc = pMesh->GetBoneData();
+
+			work.push_back({ &comp, instanceIndex, &animation, &nodeData, &boneDesc });
+		});
 
-		for (auto& handle : jobHandles)
 		{
-			//jobs::Wait(handle);
+			NV_EVENT("AnimationSystem/BoneTransform");
+			jobs::ParallelFor(0, work.size(), 1, [&](size_t index)
+			{
+				const BoneTransformWork& item = work[index];
+				BoneTransform(*item.mpComponent, animInstances[item.mInstanceIndex], *item.mpAnimation, *item.mpNodeData, *item.mpBoneDesc);
+			});
 		}
 
 		{
@@ -110,9 +129,9 @@ namespace nv::graphics::animation
 			// data and then update it in one go below.
 			NV_EVENT("AnimationSystem/CopyAnimInstanceData");
 			gAnimManager.Lock();
-			for (size_t i = 0; i < components.mEntities.size(); ++i)
+			for (size_t i = 0; i < entities.size(); ++i)
 			{
-				auto& instance = gAnimManager.GetInstance(components.mEntities[i]);
+				auto& instance = gAnimManager.GetInstance(entities[i]);
 				instance = animInstances[i];
 			}
 			gAnimManager.Unlock();
@@ -123,6 +142,11 @@ namespace nv::graphics::animation
 	{
 	}
 
+	void AnimationSystem::DeclareAccess(SystemAccess& access) const
+	{
+		access.Write<Renderable, AnimationComponent>();
+	}
+
 	void BoneTransform(const AnimationComponent& animComponent, AnimationInstanceData& instanceData, const Animation& animation, const MeshAnimNodeData& nodeData, const MeshBoneDesc& boneDesc)
 	{
 		NV_EVENT("AnimationSystem/BoneTransform");
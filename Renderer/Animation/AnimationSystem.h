@@ -11,6 +11,7 @@ namespace nv::graphics::animation
         void Init() override;
         void Update(float deltaTime, float totalTime) override;
         void Destroy() override;
+        void DeclareAccess(SystemAccess& access) const override;
 
     private:
     };
@@ -6,14 +6,13 @@
 
 namespace nv::graphics::bvh
 {
-    void GetTriangulatedMesh(const Mesh* mesh, TriangulatedMesh& outMesh)
+    void GetTriangulatedMesh(const MeshDesc& desc, TriangulatedMesh& outMesh)
     {
         using namespace math;
 
-        outMesh.Tris.resize(mesh->GetIndexCount() / 3);
-        outMesh.TriExs.resize(mesh->GetIndexCount() / 3);
+        outMesh.Tris.resize(desc.mIndices.size() / 3);
+        outMesh.TriExs.resize(desc.mIndices.size() / 3);
 
-        const auto& desc = mesh->GetDesc();
         for (uint32_t i = 0; i < desc.mIndices.size(); i += 3)
         {
             const uint32_t idx0 = desc.mIndices[i];
@@ -231,9 +230,9 @@ namespace nv::graphics::bvh
         Subdivide(rightChildIdx, bvhData, triMesh);
     }
 
-    void BuildBVH(const Mesh* mesh, BVHData& outBvh, TriangulatedMesh& triMesh)
+    void BuildBVH(const MeshDesc& desc, BVHData& outBvh, TriangulatedMesh& triMesh)
     {
-        GetTriangulatedMesh(mesh, triMesh);
+        GetTriangulatedMesh(desc, triMesh);
 
         const auto triCount = triMesh.Tris.size();
         outBvh.mBvhNodes.resize(triMesh.Tris.size() * 2);
@@ -1,13 +1,14 @@
 #pragma once
 
 #include <Math/Math.h>
+#include <Memory/LargePageAllocator.h>
 #include <Interop/ShaderInteropTypes.h>
 
 /// BVH Reference Code: https://jacco.ompf2.com/2022/06/03/how-to-build-a-bvh-part-9a-to-the-gpu/
 
 namespace nv::graphics
 {
-    class Mesh;
+    struct MeshDesc;
 }
 
 namespace nv::graphics::bvh
@@ -111,10 +112,10 @@ namespace nv::graphics::bvh
     struct BVHData
     {
         uint32_t* triIdx = nullptr;
-        std::vector<uint32_t> TriIdx;
+        LargePageVector<uint32_t> TriIdx;
         uint32_t  nodesUsed = 2;
         TriangulatedMesh* mesh = nullptr;
-        std::vector<BVHNode> mBvhNodes;
+        LargePageVector<BVHNode> mBvhNodes;  // Walked at random by every ray, large pages keep it TLB friendly
     };
 
     struct BVHInstance
@@ -170,6 +171,6 @@ namespace nv::graphics::bvh
         uint32_t BlasCount  = 0;
     };
 
-    void BuildBVH(const Mesh* mesh, BVHData& outBvh, TriangulatedMesh& triMesh);
+    void BuildBVH(const MeshDesc& desc, BVHData& outBvh, TriangulatedMesh& triMesh);
     void BuildTLAS(Span<graphics::BVHInstance> bvhInstances, Span<graphics::AABB> aabbs, TLAS& outTlas);
 }
\ No newline at end of file
@@ -55,7 +55,7 @@ namespace nv::graphics
         Pool<Shader, ShaderDX12>                mShaders;
         Pool<PipelineState, PipelineStateDX12>  mPipelineStates;
         Pool<Texture, TextureDX12>              mTextures;
-        Pool<Mesh, MeshDX12>                    mMeshes;
+        Pool<Mesh, MeshDX12, kPoolInitDefaultSize, PoolBackend::Virtual> mMeshes; // Never relocates, renderer keeps Mesh* across async loads
         Pool<Context, ContextDX12>              mContexts;
         DeviceDX12*                             mDevice;
         friend class RendererDX12;
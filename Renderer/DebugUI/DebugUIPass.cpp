@@ -456,7 +456,7 @@ namespace nv::graphics
         ImGui::Begin("Animation", &open);
         auto names = gAnimManager.GetAnimationNames();
         Entity* pEntity = gEntityManager.GetEntity(gSelectedEntity);
-        AnimationComponent* pAnimComp = pEntity->Has<AnimationComponent>() ? pEntity->Get<AnimationComponent>() : nullptr;
+        AnimationComponent* pAnimComp = pEntity->Has<AnimationComponent>() ? pEntity->GetMut<AnimationComponent>() : nullptr;
 
         static const char* currentAnim = NULL;
 
@@ -5,6 +5,7 @@
 #include <Renderer/ConstantBufferPool.h>
 #include <Renderer/Device.h>
 #include <Engine/EntityComponent.h>
+#include <Engine/Query.h>
 #include <Components/Renderable.h>
 #include <Components/Material.h>
 #include <Animation/Animation.h>
@@ -30,62 +31,75 @@ namespace nv::graphics
 
     void RenderDataArray::QueueRenderData()
     {
-        constexpr size_t MAX_QUEUED_RENDER_DATA = 3;
+        // Entities are created on the main thread only, so nothing outgrows the cache while the jobs fill it
+        const uint32_t version = ecs::GetComponentVersion();
+        const size_t entityCount = ecs::gEntityManager.GetEntitySpan().Size();
+        if (mTransformCache.size() < entityCount)
+            mTransformCache.resize(entityCount);
+
+        // Every transform is cached, not just the renderable ones, so an entity that gets its Renderable
+        // later is already there. FramePreSystem only copies PrevTransform for entities that moved,
+        // so a still entity drops out of this the frame after it settles.
+        ecs::Query<const Position, const Rotation, const Scale, const PrevTransform,
+            ecs::Changed<Position, Rotation, Scale, PrevTransform>> moved(mTransformVersion);
+        moved.ForEachChunk([this](const auto& chunk)
         {
-            mRenderDataQueue.Lock();
-            if (mRenderDataQueue.Size() > MAX_QUEUED_RENDER_DATA)
+            chunk.ForEach([this](Handle<ecs::Entity> entity, const Position& pos, const Rotation& rotation, const Scale& scale, const PrevTransform& prevTransform)
             {
-                // Ensure data in queue is fresh by dequeuing old data if we're at threshold.
-                // TODO: Test with more objects.
-                RenderData renderData;
-                mRenderDataQueue.PopUnsafe(renderData);
+                const Transform transform = { pos.mPosition, rotation.mRotation, scale.mScale };
+
+                CachedTransform& cached = mTransformCache[entity.mIndex];
+                cached.mEntity = entity;
+                cached.mWorld = transform.GetTransformMatrixTransposed();
+                cached.mPrevWorld = prevTransform.GetTransformMatrixTransposed();
+            });
+        });
+        mTransformVersion = version;
+
+        // Joined per entity, the pools are swap-removed independently so their indices don't line up
+        RenderData renderData;
+        ecs::Query<const components::Renderable, const Position, const Rotation, const Scale, const PrevTransform> query;
+        const size_t count = query.Gather([&renderData](size_t count)
+        {
+            if (count > 0)
+                renderData.Init(count, FrameAllocator::gPtr);
+        },
+        [this, &renderData](size_t slot, Handle<ecs::Entity> entity, const components::Renderable& renderable,
+            const Position&, const Rotation&, const Scale&, const PrevTransform&)
+        {
+            const CachedTransform& cached = mTransformCache[entity.mIndex];
+            assert(cached.mEntity == entity);
+
+            auto rd = renderData[slot];
+            rd.mObjectData.World = cached.mWorld;
+            rd.mObjectData.PrevWorld = cached.mPrevWorld;
+            rd.mpMesh = gResourceManager->GetMesh(renderable.mMesh);
+            rd.mpMaterial = gResourceManager->GetMaterial(renderable.mMaterial);
+            if (renderable.HasFlag(components::RENDERABLE_FLAG_ANIMATED))
+            {
+                auto& instance = animation::gAnimManager.GetInstance(entity.mHandle);
+                rd.mpBones = &instance.mArmatureConstantBuffer;
             }
-            mRenderDataQueue.Unlock();
-        }
+        });
 
-        nv::Vector<Handle<ecs::Entity>> entityList;
-        ecs::gEntityManager.GetEntities(entityList);
-        Span<Handle<ecs::Entity>> entities = entityList.Span();
-        if (entities[0] == ecs::gEntityManager.GetRootEntity())
-            entities = entities.Slice(1, entities.Size());
-
-        auto renderables = ecs::gComponentManager.GetComponents<components::Renderable>();
-
-        if (renderables.Size() > 0)
+        if (count > 0)
         {
-            RenderData renderData(renderables.Size());
+            // Render thread is a full queue behind, drop this frame. It catches
+            // up to the newest data on its next pop so what's queued stays fresh.
+            mRenderDataQueue.TryPush(std::move(renderData));
+        }
+    }
 
-            auto positions = ecs::gComponentManager.GetComponents<Position>();
-            auto scales = ecs::gComponentManager.GetComponents<Scale>();
-            auto rotations = ecs::gComponentManager.GetComponents<Rotation>();
-            auto prevTransforms = ecs::gComponentManager.GetComponents<PrevTransform>();
+    bool RenderDataArray::PopRenderData(RenderData& out)
+    {
+        if (!mRenderDataQueue.TryPop(out))
+            return false;
 
-            for (size_t i = 0; i < renderables.Size(); ++i)
-            {
-                auto& renderable = renderables[i];
-                auto mesh = gResourceManager->GetMesh(renderable.mMesh);
-                auto mat = gResourceManager->GetMaterial(renderable.mMaterial);
-                auto& prevTransform = prevTransforms[i];
-
-                auto pos = &positions[i];
-                auto scale = &scales[i];
-                auto rotation = &rotations[i];
-                TransformRef transform = { pos->mPosition, rotation->mRotation, scale->mScale };
-
-                auto rd = renderData[i];
-                rd.mObjectData.World = transform.GetTransformMatrixTransposed();
-                rd.mObjectData.PrevWorld = prevTransform.GetTransformMatrixTransposed();
-                rd.mpMesh = mesh;
-                rd.mpMaterial = mat;
-                if (renderable.HasFlag(components::RENDERABLE_FLAG_ANIMATED))
-                {
-                    auto& instance = animation::gAnimManager.GetInstance(entities[i]);
-                    rd.mpBones = &instance.mArmatureConstantBuffer;
-                }
-            }
+        // Stale frames are freed here instead of on the main thread
+        while (mRenderDataQueue.TryPop(out)) {}
 
-            mRenderDataQueue.Push(renderData);
-        }
+        mCurrentRenderData = &out;
+        return true;
     }
 
     void RenderDataArray::GenerateDescriptors(RenderData& rd)
@@ -3,10 +3,18 @@
 #include <Renderer/CommonDefines.h>
 #include <Lib/Handle.h>
 #include <Lib/Vector.h>
-#include <Lib/ConcurrentQueue.h>
+#include <Lib/SPSCQueue.h>
+#include <Memory/FrameAllocator.h>
+#include <Memory/Memory.h>
 #include <Engine/Transform.h>
 #include <Interop/ShaderInteropTypes.h>
 #include <atomic>
+#include <vector>
+
+namespace nv::ecs
+{
+    struct Entity;
+}
 
 namespace nv::graphics
 {
@@ -32,24 +40,31 @@ namespace nv::graphics
 
     struct RenderData
     {
+        static constexpr uint32_t kNotPinned = ~0u;
+
         size_t          mSize;
         Mesh**          mppMeshes;
         MaterialInstance**      mppMaterials;
         ObjectData*     mpObjectData;
         PerArmature**   mppBones;
+        IAllocator*     mpAllocator;
+        uint32_t        mFrameBuffer; // Frame allocator buffer kept alive while this is
 
         RenderData():
             mSize(0),
             mppMaterials(nullptr),
             mppMeshes(nullptr),
             mpObjectData(nullptr),
-            mppBones(nullptr)
+            mppBones(nullptr),
+            mpAllocator(SystemAllocator::gPtr),
+            mFrameBuffer(kNotPinned)
         {}
 
-        RenderData(size_t size)
-            : mSize(size)
+        RenderData(size_t size, IAllocator* allocator = SystemAllocator::gPtr)
+            : mSize(size),
+            mFrameBuffer(kNotPinned)
         {
-            Init(size);
+            Init(size, allocator);
         }
 
         RenderData(RenderData&& p) noexcept :
@@ -57,13 +72,16 @@ namespace nv::graphics
             mppMeshes(p.mppMeshes),
             mppMaterials(p.mppMaterials),
             mpObjectData(p.mpObjectData),
-            mppBones(p.mppBones)
+            mppBones(p.mppBones),
+            mpAllocator(p.mpAllocator),
+            mFrameBuffer(p.mFrameBuffer)
         {
             p.mSize = 0;
             p.mppMaterials = nullptr;
             p.mppMeshes = nullptr;
             p.mpObjectData = nullptr;
             p.mppBones = nullptr;
+            p.mFrameBuffer = kNotPinned;
         }
 
         RenderData& operator=(const RenderData& rhs) = delete;
@@ -76,12 +94,15 @@ namespace nv::graphics
             mppMaterials = rhs.mppMaterials;
             mpObjectData = rhs.mpObjectData;
             mppBones = rhs.mppBones;
+            mpAllocator = rhs.mpAllocator;
+            mFrameBuffer = rhs.mFrameBuffer;
 
             rhs.mSize = 0;
             rhs.mppMaterials = nullptr;
             rhs.mppMeshes = nullptr;
             rhs.mpObjectData = nullptr;
             rhs.mppBones = nullptr;
+            rhs.mFrameBuffer = kNotPinned;
             return *this;
         }
 
@@ -100,13 +121,19 @@ namespace nv::graphics
             return RenderObject{ .mpMesh = mppMeshes[mSize - 1], .mpMaterial = mppMaterials[mSize - 1], .mObjectData = mpObjectData[mSize - 1], .mpBones = mppBones[mSize - 1] };
         }
 
-        void Init(size_t size)
+        // Arrays from the frame allocator pin its current buffer, so they stay valid
+        // on the render thread until this is cleared, however many frames that takes.
+        void Init(size_t size, IAllocator* allocator = SystemAllocator::gPtr)
         {
             mSize = size;
-            mppMeshes = (Mesh**)Alloc(sizeof(Mesh*) * size);
-            mppMaterials = (MaterialInstance**)Alloc(sizeof(MaterialInstance*) * size);
-            mpObjectData = (ObjectData*)Alloc(sizeof(ObjectData) * size);
-            mppBones = (PerArmature**)Alloc(sizeof(PerArmature*) * size);
+            mpAllocator = allocator;
+            if (allocator == FrameAllocator::gPtr)
+                mFrameBuffer = FrameAllocator::gPtr->Pin();
+
+            mppMeshes = (Mesh**)AllocTagged(kMemBudgetRenderData, allocator, sizeof(Mesh*) * size);
+            mppMaterials = (MaterialInstance**)AllocTagged(kMemBudgetRenderData, allocator, sizeof(MaterialInstance*) * size);
+            mpObjectData = (ObjectData*)AllocTagged(kMemBudgetRenderData, allocator, sizeof(ObjectData) * size);
+            mppBones = (PerArmature**)AllocTagged(kMemBudgetRenderData, allocator, sizeof(PerArmature*) * size);
 
             memset(mppMeshes, 0, sizeof(Mesh*) * size);
             memset(mppMaterials, 0, sizeof(MaterialInstance*) * size);
@@ -123,10 +150,10 @@ namespace nv::graphics
                 assert(mpObjectData);
                 assert(mppBones);
 
-                Free(mppMeshes);
-                Free(mppMaterials);
-                Free(mpObjectData);
-                Free(mppBones);
+                Free(mppMeshes, mpAllocator);
+                Free(mppMaterials, mpAllocator);
+                Free(mpObjectData, mpAllocator);
+                Free(mppBones, mpAllocator);
 
                 mSize = 0;
                 mppMeshes = nullptr;
@@ -134,6 +161,12 @@ namespace nv::graphics
                 mpObjectData = nullptr;
                 mppBones = nullptr;
             }
+
+            if (mFrameBuffer != kNotPinned)
+            {
+                FrameAllocator::gPtr->Unpin(mFrameBuffer);
+                mFrameBuffer = kNotPinned;
+            }
         }
 
         ~RenderData()
@@ -146,17 +179,31 @@ namespace nv::graphics
     {
         using CBV = ConstantBufferView;
         static constexpr uint32_t MAX_RENDER_BUFFER = 2;
+        static constexpr uint32_t MAX_QUEUED_RENDER_DATA = 4;
+
+        // Main thread produces, render thread consumes
+        using RenderDataQueue = SPSCQueue<RenderData, MAX_QUEUED_RENDER_DATA>;
+
+        // World matrices by entity index, QueueRenderData only rebuilds the ones whose transform changed
+        struct CachedTransform
+        {
+            Handle<ecs::Entity>         mEntity;
+            float4x4                    mWorld;
+            float4x4                    mPrevWorld;
+        };
 
         RenderDescriptors               mRenderDescriptors;
-        ConcurrentQueue<RenderData>     mRenderDataQueue;
+        RenderDataQueue                 mRenderDataQueue;
         uint32_t                        mRenderThreadId;
         RenderData*                     mCurrentRenderData;
+        std::vector<CachedTransform>    mTransformCache;
+        uint32_t                        mTransformVersion = 0;  // Component version of the last rebuild
 
         RenderDataArray();
         void Clear(); // Switch buffer and clears non current buffer
 
         void QueueRenderData();
-        bool PopRenderData(RenderData& out) { if (mRenderDataQueue.IsEmpty()) return false; mRenderDataQueue.Pop(out); mCurrentRenderData = &out; return true; }
+        bool PopRenderData(RenderData& out); // Render thread only, skips to the newest queued data
         void GenerateDescriptors(RenderData& rd);
 
         // Get data from "current" buffer
@@ -234,7 +234,7 @@ namespace nv::graphics
                 NV_THREAD("RenderThread");
                 RenderThreadJob(ctx);
             }
-        });
+        }, jobs::JobPriority::LongRunning);
     }
 
     void RenderSystem::Update(float deltaTime, float totalTime)
@@ -242,6 +242,12 @@ namespace nv::graphics
         mRenderData.QueueRenderData();
     }
 
+    void RenderSystem::DeclareAccess(SystemAccess& access) const
+    {
+        // The bones come from the animation instances, AnimationSystem writes Renderable so it won't overlap
+        access.Read<components::Renderable, Position, Rotation, Scale, PrevTransform>();
+    }
+
     void RenderSystem::Destroy()
     {
         gContext.mpInstance->Notify();
@@ -287,11 +293,9 @@ namespace nv::graphics
             if (!mPsoReloadQueue.IsEmpty())
             {
                 gRenderer->WaitForAllFrames();
-                while (!mPsoReloadQueue.IsEmpty())
-                {
-                    auto pso = mPsoReloadQueue.Pop();
+                Handle<PipelineState> pso;
+                while (mPsoReloadQueue.TryPop(pso))
                     Reload(pso);
-                }
             }
 
             UpdateRenderData(); // Generates descriptors
@@ -45,6 +45,7 @@ namespace nv::graphics
         void Update(float deltaTime, float totalTime) override;
         void Destroy() override;
         void OnReload() override;
+        void DeclareAccess(SystemAccess& access) const override;
 
         void QueueReload(Handle<PipelineState> pso);
         void Reload(Handle<PipelineState> pso);
@@ -5,6 +5,8 @@
 #include <Renderer/Context.h>
 #include <Components/Material.h>
 #include <Renderer/Device.h>
+#include <Renderer/Mesh.h>
+#include <BVH/BVH.h>
 
 #include <AssetManager.h>
 #include <Types/TextureAsset.h>
@@ -179,26 +181,44 @@ namespace nv::graphics
 
     void ResourceManager::ProcessAsyncLoadQueue()
     {
-        using namespace asset;
+        HandleQueue<Mesh> meshQueue;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            meshQueue.swap(mMeshQueue);
+            mTextureQueue.clear();
+        }
 
-        std::unique_lock<std::mutex> lock(mMutex);
+        // Only queues the file reads, the rest of each pipeline runs on workers
+        for (auto& mesh : meshQueue)
+            LoadMeshAsync(mesh.mHandle, mesh.mResID).Detach();
+    }
 
-        for (auto& mesh : mMeshQueue)
+    Task<> ResourceManager::LoadMeshAsync(Handle<Mesh> handle, ResID id)
+    {
+        using namespace asset;
+
+        Asset* asset = co_await asset::LoadAsset(AssetID{ ASSET_MESH, id });
+        if (!asset)
         {
-            log::Info("[ResourceManager] Async Loading mesh: {}", StringDB::Get().GetString(mesh.mResID).c_str());
-            auto asset = asset::gpAssetManager->GetAsset(asset::AssetID{ asset::ASSET_MESH, mesh.mResID });
-            auto meshAsset = asset->DeserializeTo<asset::MeshAsset>();
-            CreateMesh(mesh.mHandle, meshAsset.GetData());
-            meshAsset.Register(mesh.mHandle);
+            log::Error("[ResourceManager] Async load failed for mesh: {}", StringDB::Get().GetString(id).c_str());
+            co_return;
         }
 
-        for (auto& tex : mTextureQueue)
+        log::Info("[ResourceManager] Async Loading mesh: {}", StringDB::Get().GetString(id).c_str());
+        auto meshAsset = asset->DeserializeTo<MeshAsset>();
+
+        // Built from the asset's copy of the data, the mesh pool is only touched under mMutex
+        bvh::BVHData bvhData;
         {
-           
+            bvh::TriangulatedMesh triMesh;
+            bvh::BuildBVH(meshAsset.GetData(), bvhData, triMesh);
         }
 
-        mMeshQueue.clear();
-        mTextureQueue.clear();
+        std::scoped_lock lock(mUploadMutex, mMutex);
+        CreateMesh(handle, meshAsset.GetData());
+        if (Mesh* pMesh = GetMesh(handle))
+            pMesh->GetBVH() = std::move(bvhData);
+        meshAsset.Register(handle);
     }
 
     uint32_t ResourceManager::GetAsyncLoadQueueSize() const
@@ -2,6 +2,7 @@
 
 #include <Lib/Handle.h>
 #include <Lib/Pool.h>
+#include <Engine/Task.h>
 #include <Renderer/CommonDefines.h>
 #include <AssetBase.h>
 
@@ -101,10 +102,15 @@ namespace nv::graphics
         void                            ProcessAsyncLoadQueue();
         uint32_t                        GetAsyncLoadQueueSize() const;
 
+    private:
+        // Read file -> deserialize -> create -> build BVH -> register, one task per mesh
+        Task<>                          LoadMeshAsync(Handle<Mesh> handle, ResID id);
+
     private:
         HandleQueue<Mesh>               mMeshQueue;
         HandleQueue<Texture>            mTextureQueue;
         std::mutex                      mMutex;
+        std::mutex                      mUploadMutex; // Mesh pipelines create GPU resources from several workers
 
     private:
         Pool<MaterialInstance> mMaterialPool;
@@ -11,22 +11,12 @@ namespace nv::graphics
     {
     }
 
-    Handle<jobs::Job> mAsyncLoadJob = Null<jobs::Job>();
-
     void ResourceSystem::Update(float deltaTime, float totalTime)
     {
-        if (nv::jobs::IsFinished(mAsyncLoadJob))
-        {
-            mAsyncLoadJob = Null<jobs::Job>();
-        }
-
-        if (gResourceManager->GetAsyncLoadQueueSize() > 0 && mAsyncLoadJob.IsNull())
+        if (gResourceManager->GetAsyncLoadQueueSize() > 0)
         {
-            mAsyncLoadJob = nv::jobs::Execute([](void* pContext)
-            {
-                NV_EVENT("ResourceSystem/AsyncLoadJob");
-                gResourceManager->ProcessAsyncLoadQueue();
-            });
+            NV_EVENT("ResourceSystem/AsyncLoad");
+            gResourceManager->ProcessAsyncLoadQueue();
         }
     }
 }
\ No newline at end of file
@@ -16,6 +16,7 @@ namespace nv::sim
         using FInit = decltype(NVSimInit)*;
         using FTick = decltype(NVSimTick)*;
         using FTickState = decltype(NVSimTickState)*;
+        using FGetMemBudgets = decltype(NVSimGetMemBudgets)*;
 
 
     public:
@@ -37,11 +38,13 @@ namespace nv::sim
             SimInit = (FInit)GetProcAddress(mInstance, "NVSimInit");
             Tick = (FTick)GetProcAddress(mInstance, "NVSimTick");
             TickState = (FTickState)GetProcAddress(mInstance, "NVSimTickState");
+            GetMemBudgets = (FGetMemBudgets)GetProcAddress(mInstance, "NVSimGetMemBudgets");
         }
 
         FInit SimInit;
         FTick Tick;
         FTickState TickState;
+        FGetMemBudgets GetMemBudgets;
 
     private:
         HINSTANCE mInstance;
@@ -50,6 +53,25 @@ namespace nv::sim
 
 namespace nv
 {
+    constexpr float kBudgetReportInterval = 10.0f; // Seconds
+
+    static void LogMemBudgets(sim::SimulationAPI& simApi)
+    {
+        if (!simApi.GetMemBudgets)
+            return;
+
+        MemTracker::TagStats budgets[16];
+        const uint32_t count = simApi.GetMemBudgets(budgets, _countof(budgets));
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const MemTracker::TagStats& budget = budgets[i];
+            if (budget.mHardExceededCount > 0)
+                log::Error("[TestBed] {}: {} bytes, peak {}, over hard budget {}x", budget.mTag, budget.mBytes, budget.mHighWater, budget.mHardExceededCount);
+            else
+                log::Info("[TestBed] {}: {} bytes, peak {}, soft budget {}", budget.mTag, budget.mBytes, budget.mHighWater, budget.mSoftLimit);
+        }
+    }
+
     void TestRunner::Run()
     {
         nv::Timer timer;
@@ -59,11 +81,18 @@ namespace nv
         simApi.SimInit();
         
         timer.Start();
+        float nextBudgetReport = kBudgetReportInterval;
 
         while (true)
         {
             timer.Tick();
             simApi.Tick(timer.DeltaTime, timer.TotalTime);
+
+            if (timer.TotalTime >= nextBudgetReport)
+            {
+                LogMemBudgets(simApi);
+                nextBudgetReport = timer.TotalTime + kBudgetReportInterval;
+            }
         }
         
     }
@@ -10,6 +10,12 @@ static SysMgrUniquePtr spSystemManager = nullptr;
 
 void NVSimInit()
 {
+    if (!nv::MemTracker::gPtr)
+    {
+        nv::InitMemoryTracker();
+        nv::InitMemoryBudgets();
+    }
+
     spSystemManager = std::make_unique<nv::SystemManager>();
     spSystemManager->CreateSystem<nv::SimDriver>();
     spSystemManager->InitSystems();
@@ -24,3 +30,8 @@ int NVSimTickState()
 {
     return 0;
 }
+
+uint32_t NVSimGetMemBudgets(nv::MemTracker::TagStats* pBudgets, uint32_t count)
+{
+    return nv::MemTracker::gPtr ? nv::MemTracker::gPtr->GetBudgets(pBudgets, count) : 0;
+}
\ No newline at end of file
@@ -6,9 +6,13 @@
 #define DLL_EXPORT __declspec(dllimport) 
 #endif
 
+#include <Memory/Memory.h>
+
 extern "C"
 {
 	DLL_EXPORT void NVSimInit();
 	DLL_EXPORT void NVSimTick(float deltaTime, float totalTime);
 	DLL_EXPORT int  NVSimTickState();
+	// Copies out up to count memory budgets with their live bytes and high-water marks
+	DLL_EXPORT uint32_t NVSimGetMemBudgets(nv::MemTracker::TagStats* pBudgets, uint32_t count);
 }
\ No newline at end of file
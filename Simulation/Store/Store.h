@@ -6,6 +6,8 @@
 #include <memory>
 #include <unordered_map>
 #include <Math/Math.h>
+#include <Engine/JobSystem.h>
+#include <Memory/LargePageAllocator.h>
 
 namespace nv::sim
 {
@@ -79,7 +81,7 @@ namespace nv::sim
 
         constexpr void Invoke(TStore& dataStore, size_t start = 0, size_t end = 0)
         {
-            dataStore.ForEach(&TProcessor::Process, *(TProcessor*)this);
+            dataStore.ForEach(&TProcessor::Process, *(TProcessor*)this, start, end);
         }
     };
 
@@ -141,6 +143,12 @@ namespace nv::sim
         using NthType = std::tuple_element<N, Instance>::type;
         using IndexType = NthType<0>;
 
+        // Columns hold up to a million agents and are swept every tick, so they live on large pages
+        template<typename T>
+        using Column = LargePageVector<T>;
+
+        static constexpr size_t kForEachGrain = 4096;
+
     public:
         void Init() override {}
 
@@ -179,16 +187,16 @@ namespace nv::sim
         }
 
         template<typename T>
-        constexpr std::vector<T>& Get()
+        constexpr Column<T>& Get()
         {
-            std::vector<T>& items = std::get<std::vector<T>>(mDataArrays);
+            Column<T>& items = std::get<Column<T>>(mDataArrays);
             return items;
         }
 
         template<typename T>
         constexpr std::span<T> GetSpan()
         {
-            std::vector<T>& items = std::get<std::vector<T>>(mDataArrays);
+            Column<T>& items = std::get<Column<T>>(mDataArrays);
             return std::span<T> { items.data(), items.size() };
         }
 
@@ -205,40 +213,51 @@ namespace nv::sim
             return spans;
         }
 
+        // ForEach spreads the range over the job system, fn is called concurrently
+        // and must only touch the instance it is handed.
         template<typename... T, typename TFunc>
-        constexpr void ForEach(TFunc fn, size_t start = 0, size_t end = 0)
+        void ForEach(TFunc fn, size_t start = 0, size_t end = 0)
         {
             const size_t size = GetSize();
             end = end == 0 ? size : end;
 
-            for (size_t i = start; i < end; ++i)
+            jobs::ParallelFor(start, end, kForEachGrain, [&](size_t first, size_t last)
             {
-                fn(Get<T>(i)...);
-            }
+                for (size_t i = first; i < last; ++i)
+                {
+                    fn(Get<T>(i)...);
+                }
+            });
         }
 
         template<typename... T>
-        constexpr void ForEach(TsFunc<T&...> fn, size_t start = 0, size_t end = 0)
+        void ForEach(TsFunc<T&...> fn, size_t start = 0, size_t end = 0)
         {
             const size_t size = GetSize();
             end = end == 0 ? size : end;
 
-            for (size_t i = start; i < end; ++i)
+            jobs::ParallelFor(start, end, kForEachGrain, [&](size_t first, size_t last)
             {
-                fn(Get<T>(i)...);
-            }
+                for (size_t i = first; i < last; ++i)
+                {
+                    fn(Get<T>(i)...);
+                }
+            });
         }
 
         template<typename... T, typename TProcessor>
-        constexpr void ForEach(TProcFunc<TProcessor, T&...> fn, TProcessor& processor, size_t start = 0, size_t end = 0)
+        void ForEach(TProcFunc<TProcessor, T&...> fn, TProcessor& processor, size_t start = 0, size_t end = 0)
         {
             const size_t size = GetSize();
             end = end == 0 ? size : end;
 
-            for (size_t i = start; i < end; ++i)
+            jobs::ParallelFor(start, end, kForEachGrain, [&](size_t first, size_t last)
             {
-                (processor.*fn)(Get<T>(i)...);
-            }
+                for (size_t i = first; i < last; ++i)
+                {
+                    (processor.*fn)(Get<T>(i)...);
+                }
+            });
         }
 
         template<typename... T, typename TProcessor>
@@ -275,7 +294,7 @@ namespace nv::sim
 
         constexpr InstRef Find(IndexType key)
         {
-            const std::vector<IndexType>& keys = Get<IndexType>();
+            const Column<IndexType>& keys = Get<IndexType>();
             auto it = std::find(keys.begin(), keys.end(), key);
             const size_t idx = std::distance(keys.begin(), it);
             return GetInstanceRef(idx);
@@ -304,7 +323,7 @@ namespace nv::sim
         template<typename T>
         constexpr T& Get(size_t idx)
         {
-            std::vector<T>& v = Get<T>();
+            Column<T>& v = Get<T>();
             T& val = v[idx];
             return val;
         }
@@ -331,7 +350,7 @@ namespace nv::sim
 
         constexpr void Erase(IndexType index)
         {
-            const std::vector<IndexType>& keys = Get<IndexType>();
+            const Column<IndexType>& keys = Get<IndexType>();
             auto it = std::find(keys.begin(), keys.end(), index);
             if (it == keys.end())
                 return;
@@ -385,13 +404,13 @@ namespace nv::sim
         }
 
         template<typename T>
-        void Set(size_t idx, std::vector<T>& v, Instance& instance)
+        void Set(size_t idx, Column<T>& v, Instance& instance)
         {
             std::get<T>(instance) = v[idx];
         }
 
     private:
-        std::tuple<std::vector<Types>...> mDataArrays;
+        std::tuple<Column<Types>...> mDataArrays;
         std::unordered_map<StringID, std::unique_ptr<BaseProcessor>> mProcessors;
         std::unordered_map<StringID, std::unique_ptr<BaseBatchProcessor>> mBatchProcessors;
     };
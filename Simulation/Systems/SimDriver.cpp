@@ -112,7 +112,8 @@ namespace nv
 
         mTimer = sim::SimTimer{ .mDay = 1,  .mMonth = 1, .mYear = 2020, .mSimSpeed = SimSpeed::SIMSPEED_NORMAL };
 
-        jobs::InitJobSystem(4);
+        // Headless, take every core except the one the main thread ticks on
+        jobs::InitJobSystem(jobs::JobSystemDesc{ .mPlacement = platform::ThreadPlacement::ReserveCoreZero });
         RunStoreTests();
 
         mAgentManager = std::make_unique<AgentManager>();
@@ -0,0 +1,1119 @@
+#include "pch.h"
+#include "TestCommon.h"
+
+#include <Engine/Archetype.h>
+#include <Engine/EntityComponent.h>
+#include <Engine/JobSystem.h>
+#include <Engine/Log.h>
+#include <Engine/Query.h>
+#include <Engine/System.h>
+#include <Engine/Transform.h>
+#include <Lib/ConcurrentQueue.h>
+#include <Lib/MPMCQueue.h>
+#include <Lib/SPSCQueue.h>
+#include <Memory/FrameAllocator.h>
+#include <Memory/LargePageAllocator.h>
+#include <Memory/SlabAllocator.h>
+#include <Memory/TlsfAllocator.h>
+
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <numeric>
+#include <random>
+
+#if NV_PLATFORM_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace nv::tests
+{
+    using BenchClock = std::chrono::high_resolution_clock;
+
+    static double ElapsedMs(BenchClock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+    }
+
+    static std::vector<uint32_t> GetBenchThreadCounts()
+    {
+        std::vector<uint32_t> counts;
+        const uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        for (uint32_t count = 1; count < maxThreads; count *= 2)
+            counts.push_back(count);
+        counts.push_back(maxThreads);
+        return counts;
+    }
+
+    TEST_F(Benchmarks, DISABLED_JobSystemEmptyJobThroughput)
+    {
+        constexpr uint32_t kJobCount = 200'000;
+
+        for (uint32_t threadCount : GetBenchThreadCounts())
+        {
+            ScopedJobSystem jobSystem(threadCount);
+            std::atomic<uint32_t> counter = 0;
+
+            // Submitted from the main thread (injection path)
+            auto start = BenchClock::now();
+            for (uint32_t i = 0; i < kJobCount; ++i)
+                jobs::Execute([&](void*) { counter++; });
+
+            while (counter.load() < kJobCount)
+                std::this_thread::yield();
+            const double externalMs = ElapsedMs(start);
+
+            jobs::Wait();
+
+            // Submitted from within a worker (worker deque + stealing path)
+            counter = 0;
+            start = BenchClock::now();
+            jobs::Execute([&](void*)
+            {
+                for (uint32_t i = 0; i < kJobCount; ++i)
+                    jobs::Execute([&](void*) { counter++; });
+            });
+
+            while (counter.load() < kJobCount)
+                std::this_thread::yield();
+            const double internalMs = ElapsedMs(start);
+
+            jobs::Wait();
+
+            log::Info("[Bench] EmptyJob threads={} main-submit={:.0f} jobs/s worker-submit={:.0f} jobs/s",
+                threadCount, kJobCount / (externalMs / 1000.0), kJobCount / (internalMs / 1000.0));
+            EXPECT_EQ(counter.load(), kJobCount);
+        }
+    }
+
+    TEST_F(Benchmarks, DISABLED_JobSystemFanOutFanInLatency)
+    {
+        constexpr uint32_t kRounds = 2000;
+        constexpr uint32_t kFanOut = 64;
+
+        for (uint32_t threadCount : GetBenchThreadCounts())
+        {
+            ScopedJobSystem jobSystem(threadCount);
+            std::vector<double> latencies;
+            latencies.reserve(kRounds);
+
+            for (uint32_t round = 0; round < kRounds; ++round)
+            {
+                std::atomic<uint32_t> remaining = kFanOut;
+                const auto start = BenchClock::now();
+                for (uint32_t i = 0; i < kFanOut; ++i)
+                    jobs::Execute([&](void*) { remaining--; });
+
+                while (remaining.load() > 0)
+                    std::this_thread::yield();
+
+                latencies.push_back(ElapsedMs(start) * 1000.0);
+
+                if (round % 64 == 0)
+                    jobs::GarbageCollect();
+            }
+
+            jobs::Wait();
+            std::sort(latencies.begin(), latencies.end());
+            const double median = latencies[latencies.size() / 2];
+            const double p99 = latencies[(latencies.size() * 99) / 100];
+
+            log::Info("[Bench] FanOut/FanIn x{} threads={} median={:.1f}us p99={:.1f}us",
+                kFanOut, threadCount, median, p99);
+        }
+    }
+
+    TEST_F(Benchmarks, DISABLED_JobSystemSustainedSubmitRate)
+    {
+        // Submits for a second straight, well past the ring size, so slots are recycled constantly
+        constexpr double kTargetJobsPerSecond = 1'000'000.0;
+
+        for (uint32_t threadCount : GetBenchThreadCounts())
+        {
+            ScopedJobSystem jobSystem(threadCount);
+            std::atomic<uint64_t> counter = 0;
+            uint64_t submitted = 0;
+
+            const auto start = BenchClock::now();
+            while (ElapsedMs(start) < 1000.0)
+            {
+                for (uint32_t i = 0; i < 1024; ++i)
+                    jobs::Execute([&](void*) { counter++; });
+                submitted += 1024;
+            }
+
+            jobs::Wait();
+            const double seconds = ElapsedMs(start) / 1000.0;
+            const double jobsPerSecond = submitted / seconds;
+
+            log::Info("[Bench] SustainedSubmit threads={} jobs={} rate={:.0f} jobs/s", threadCount, submitted, jobsPerSecond);
+            EXPECT_EQ(counter.load(), submitted);
+            EXPECT_GE(jobsPerSecond, kTargetJobsPerSecond);
+        }
+    }
+
+    TEST_F(Benchmarks, DISABLED_ParallelForScaling)
+    {
+        // Compute bound kernel over a DataStore sized array, reported as speedup over 1 thread
+        constexpr size_t kCount = 1'000'000;
+        constexpr uint32_t kRepeats = 10;
+        std::vector<float> values(kCount, 1.0f);
+
+        auto kernel = [&](size_t start, size_t end)
+        {
+            for (size_t i = start; i < end; ++i)
+            {
+                float v = values[i];
+                for (uint32_t k = 0; k < 32; ++k)
+                    v = v * 0.999f + 0.001f;
+                values[i] = v;
+            }
+        };
+
+        double baseForMs = 0.0;
+        double baseReduceMs = 0.0;
+        for (uint32_t threadCount : GetBenchThreadCounts())
+        {
+            ScopedJobSystem jobSystem(threadCount);
+
+            auto start = BenchClock::now();
+            for (uint32_t r = 0; r < kRepeats; ++r)
+                jobs::ParallelFor(0, kCount, 0, kernel);
+            const double forMs = ElapsedMs(start) / kRepeats;
+
+            double result = 0.0;
+            start = BenchClock::now();
+            for (uint32_t r = 0; r < kRepeats; ++r)
+            {
+                result += jobs::ParallelReduce<double>(0, kCount, 0, 0.0,
+                    [&](size_t first, size_t last)
+                    {
+                        double partial = 0.0;
+                        for (size_t i = first; i < last; ++i)
+                            partial += values[i] * values[i];
+                        return partial;
+                    },
+                    [](double a, double b) { return a + b; });
+            }
+            const double reduceMs = ElapsedMs(start) / kRepeats;
+
+            if (baseForMs == 0.0)
+            {
+                baseForMs = forMs;
+                baseReduceMs = reduceMs;
+            }
+
+            log::Info("[Bench] ParallelFor threads={} {:.2f}ms speedup={:.2f}x | ParallelReduce {:.2f}ms speedup={:.2f}x (checksum {:.1f})",
+                threadCount, forMs, baseForMs / forMs, reduceMs, baseReduceMs / reduceMs, result);
+        }
+    }
+
+    // Pushes 0..itemCount-1 from the producers, returns the time until the consumers popped everything
+    template<typename TPush, typename TPop>
+    static double RunQueueContention(uint32_t producers, uint32_t consumers, uint32_t itemCount, TPush&& push, TPop&& pop)
+    {
+        std::atomic<uint32_t> consumed = 0;
+        std::atomic<uint64_t> sum = 0;
+        std::vector<std::thread> threads;
+
+        const auto start = BenchClock::now();
+        for (uint32_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]()
+            {
+                for (uint32_t i = p; i < itemCount; i += producers)
+                {
+                    while (!push(i))
+                        std::this_thread::yield();
+                }
+            });
+        }
+
+        for (uint32_t c = 0; c < consumers; ++c)
+        {
+            threads.emplace_back([&]()
+            {
+                uint64_t localSum = 0;
+                uint32_t value = 0;
+                while (consumed.load(std::memory_order_relaxed) < itemCount)
+                {
+                    if (pop(value))
+                    {
+                        localSum += value;
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else
+                        std::this_thread::yield();
+                }
+                sum += localSum;
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        const double elapsedMs = ElapsedMs(start);
+        EXPECT_EQ(sum.load(), (uint64_t)itemCount * (itemCount - 1) / 2);
+        return elapsedMs;
+    }
+
+    TEST_F(Benchmarks, DISABLED_QueueContention)
+    {
+        constexpr uint32_t kItemCount = 2'000'000;
+        constexpr uint32_t kRingSize = 1024;
+        auto rate = [](double ms) { return kItemCount / (ms / 1000.0) / 1'000'000.0; };
+
+        for (uint32_t threadCount : GetBenchThreadCounts())
+        {
+            const uint32_t producers = std::max(threadCount / 2, 1u);
+            const uint32_t consumers = std::max(threadCount - producers, 1u);
+
+            ConcurrentQueue<uint32_t> mutexQueue;
+            const double mutexMs = RunQueueContention(producers, consumers, kItemCount,
+                [&](uint32_t value) { mutexQueue.Push(value); return true; },
+                [&](uint32_t& value) { return mutexQueue.TryPop(value); });
+
+            auto ring = std::make_unique<MPMCQueue<uint32_t, kRingSize>>();
+            const double ringMs = RunQueueContention(producers, consumers, kItemCount,
+                [&](uint32_t value) { return ring->TryPush(value); },
+                [&](uint32_t& value) { return ring->TryPop(value); });
+
+            log::Info("[Bench] Queue {}P/{}C mutex={:.1f} Mops/s mpmc={:.1f} Mops/s",
+                producers, consumers, rate(mutexMs), rate(ringMs));
+        }
+
+        // Main thread -> render thread handoff
+        ConcurrentQueue<uint32_t> mutexQueue;
+        const double mutexMs = RunQueueContention(1, 1, kItemCount,
+            [&](uint32_t value) { mutexQueue.Push(value); return true; },
+            [&](uint32_t& value) { return mutexQueue.TryPop(value); });
+
+        auto spsc = std::make_unique<SPSCQueue<uint32_t, kRingSize>>();
+        const double spscMs = RunQueueContention(1, 1, kItemCount,
+            [&](uint32_t value) { return spsc->TryPush(value); },
+            [&](uint32_t& value) { return spsc->TryPop(value); });
+
+        log::Info("[Bench] Queue 1P/1C mutex={:.1f} Mops/s spsc={:.1f} Mops/s", rate(mutexMs), rate(spscMs));
+    }
+
+    static uint64_t SumTree(uint32_t depth, uint64_t value)
+    {
+        if (depth == 0)
+        {
+            // A little leaf work so waits actually have something to wait for
+            for (uint32_t k = 0; k < 256; ++k)
+                value = value * 6364136223846793005ull + 1442695040888963407ull;
+            return value & 0xFF;
+        }
+
+        uint64_t left = 0;
+        auto leftJob = jobs::Execute([&left, depth, value](void*) { left = SumTree(depth - 1, value * 2); });
+        const uint64_t right = SumTree(depth - 1, value * 2 + 1);
+        jobs::Wait(leftJob);
+        return left + right;
+    }
+
+    TEST_F(Benchmarks, DISABLED_FiberWaitDeepTree)
+    {
+        // Many dependency trees in flight at once, every node waits on its children.
+        // Helping waits nest the children on the waiting stack, fibers suspend instead.
+        constexpr uint32_t kDepth = 10;
+        constexpr uint32_t kTrees = 64;
+        constexpr uint32_t kRounds = 10;
+
+        for (uint32_t threadCount : GetBenchThreadCounts())
+        {
+            for (bool bUseFibers : { false, true })
+            {
+                ScopedJobSystem jobSystem(jobs::JobSystemDesc{ .mWorkerCount = threadCount, .mbUseFibers = bUseFibers });
+                std::vector<double> latencies;
+                latencies.reserve(kTrees * kRounds);
+
+                const auto start = BenchClock::now();
+                for (uint32_t round = 0; round < kRounds; ++round)
+                {
+                    std::vector<Handle<jobs::Job>> roots(kTrees);
+                    std::vector<std::atomic<double>> finishedMs(kTrees);
+                    const auto submit = BenchClock::now();
+                    for (uint32_t t = 0; t < kTrees; ++t)
+                    {
+                        roots[t] = jobs::Execute([&, t](void*)
+                        {
+                            SumTree(kDepth, t);
+                            finishedMs[t] = ElapsedMs(submit);
+                        });
+                    }
+
+                    jobs::Wait();
+                    for (auto& ms : finishedMs)
+                        latencies.push_back(ms.load());
+                }
+
+                const double totalMs = ElapsedMs(start);
+                std::sort(latencies.begin(), latencies.end());
+                const double nodes = (double)kRounds * kTrees * ((2u << kDepth) - 1);
+
+                log::Info("[Bench] DeepTree threads={} fibers={} nodes={:.0f}/s root median={:.2f}ms p99={:.2f}ms",
+                    threadCount, bUseFibers, nodes / (totalMs / 1000.0), latencies[latencies.size() / 2], latencies[(latencies.size() * 99) / 100]);
+            }
+        }
+    }
+
+    struct InFlightFrameData
+    {
+        void*       mArrays[4];
+        uint32_t    mPin;
+    };
+
+    static void ReleaseFrameTemporaries(IAllocator* pAllocator, std::vector<InFlightFrameData>& inFlight)
+    {
+        InFlightFrameData& frame = inFlight.front();
+        for (void* pArray : frame.mArrays)
+            pAllocator->Free(pArray);
+
+        if (frame.mPin != ~0u)
+            FrameAllocator::gPtr->Unpin(frame.mPin);
+        inFlight.erase(inFlight.begin());
+    }
+
+    // Mimics the per frame temporaries of RenderDataArray::QueueRenderData and AnimationSystem::Update:
+    // a growing entity list, entity/component lists and the four render data arrays, which are
+    // handed to a "render thread" that lets go of them a couple of frames later.
+    static void SimulateFrameTemporaries(IAllocator* pAllocator, uint32_t entityCount, std::vector<InFlightFrameData>& inFlight)
+    {
+        constexpr size_t kRenderLatency = 2;
+
+        nv::Vector<uint64_t> entityList(pAllocator);
+        nv::Vector<uint64_t> entities(pAllocator);
+        nv::Vector<void*> components(pAllocator);
+        for (uint32_t i = 0; i < entityCount; ++i)
+        {
+            entityList.Push(i);
+            entities.Push(i);
+            components.Push(&entityList[0]);
+        }
+
+        InFlightFrameData frame = {};
+        frame.mPin = pAllocator == FrameAllocator::gPtr ? FrameAllocator::gPtr->Pin() : ~0u;
+        const size_t sizes[] = { sizeof(void*), sizeof(void*), sizeof(float) * 32, sizeof(void*) }; // Mesh, material, ObjectData, bones
+        for (size_t i = 0; i < std::size(sizes); ++i)
+        {
+            frame.mArrays[i] = pAllocator->Allocate(sizes[i] * entityCount);
+            memset(frame.mArrays[i], 0, sizes[i] * entityCount);
+        }
+        inFlight.push_back(frame);
+
+        while (inFlight.size() > kRenderLatency)
+            ReleaseFrameTemporaries(pAllocator, inFlight);
+    }
+
+    TEST_F(Benchmarks, DISABLED_FrameAllocatorMallocsPerFrame)
+    {
+        constexpr uint32_t kFrameCount = 600;
+
+        for (uint32_t entityCount : { 256u, 1024u, 4096u })
+        {
+            auto run = [&](IAllocator* pAllocator)
+            {
+                std::vector<InFlightFrameData> inFlight;
+                for (uint32_t frame = 0; frame <= kFrameAllocatorBufferCount; ++frame) // Warm up, arenas are created and grown lazily
+                {
+                    FrameAllocator::gPtr->BeginFrame();
+                    SimulateFrameTemporaries(pAllocator, entityCount, inFlight);
+                }
+
+                const uint64_t mallocs = SystemAllocator::GetAllocationCount();
+                const auto start = BenchClock::now();
+                for (uint32_t frame = 0; frame < kFrameCount; ++frame)
+                {
+                    FrameAllocator::gPtr->BeginFrame();
+                    SimulateFrameTemporaries(pAllocator, entityCount, inFlight);
+                }
+
+                const double frameUs = ElapsedMs(start) * 1000.0 / kFrameCount;
+                const double mallocsPerFrame = (double)(SystemAllocator::GetAllocationCount() - mallocs) / kFrameCount;
+
+                while (!inFlight.empty())
+                    ReleaseFrameTemporaries(pAllocator, inFlight);
+
+                return std::make_pair(mallocsPerFrame, frameUs);
+            };
+
+            const auto [sysMallocs, sysUs] = run(SystemAllocator::gPtr);
+            const auto [frameMallocs, frameUs] = run(FrameAllocator::gPtr);
+            log::Info("[Bench] FrameTemporaries entities={} malloc: {:.1f} mallocs/frame {:.1f}us | frame allocator: {:.1f} mallocs/frame {:.1f}us",
+                entityCount, sysMallocs, sysUs, frameMallocs, frameUs);
+
+            // Arenas grow during the warmup and keep their size, even past kFrameAllocatorArenaSize
+            EXPECT_EQ(frameMallocs, 0.0);
+        }
+    }
+
+    struct AllocationEvent
+    {
+        uint32_t    mSlot;
+        uint32_t    mSize;  // 0 frees the slot
+    };
+
+    // Stands in for SystemAllocator::gPtr, which global new/delete go through, and records every
+    // allocation and free made while it's installed. Its own bookkeeping isn't recorded.
+    class RecordingAllocator : public SystemAllocator
+    {
+    public:
+        void* Allocate(size_t size) override
+        {
+            void* ptr = gSysAllocator.Allocate(size);
+            Record(ptr, size);
+            return ptr;
+        }
+
+        void Free(void* ptr) override
+        {
+            Record(ptr, 0);
+            gSysAllocator.Free(ptr);
+        }
+
+        void* Realloc(size_t size, void* ptr) override
+        {
+            Record(ptr, 0);
+            void* pNew = gSysAllocator.Realloc(size, ptr);
+            Record(pNew, size);
+            return pNew;
+        }
+
+        std::vector<AllocationEvent>        mEvents;
+        uint32_t                            mSlotCount = 0;
+
+    private:
+        void Record(void* ptr, size_t size)
+        {
+            if (tbRecording || !ptr)
+                return;
+
+            tbRecording = true;
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (size)
+            {
+                mSlots[ptr] = mSlotCount;
+                mEvents.push_back({ mSlotCount++, (uint32_t)size });
+            }
+            else if (auto it = mSlots.find(ptr); it != mSlots.end())
+            {
+                mEvents.push_back({ it->second, 0 });
+                mSlots.erase(it);
+            }
+            tbRecording = false;
+        }
+
+        std::mutex                          mMutex;
+        std::unordered_map<void*, uint32_t> mSlots;
+        static thread_local bool            tbRecording;
+    };
+
+    thread_local bool RecordingAllocator::tbRecording = false;
+
+    // One frame's worth of what the App does through the system allocator: the render and
+    // animation temporaries, a name lookup table rebuilt by a system, and jobs building
+    // small per entity lists.
+    static void SimulateAppFrame(uint32_t entityCount, std::vector<InFlightFrameData>& inFlight)
+    {
+        SimulateFrameTemporaries(SystemAllocator::gPtr, entityCount, inFlight);
+
+        HashMap<uint64_t, std::string> names;
+        for (uint32_t i = 0; i < entityCount; i += 4)
+            names[i] = "Entity_" + std::to_string(i) + "_MeshRenderer";
+
+        constexpr uint32_t kBatchSize = 64;
+        std::vector<nv::Vector<uint32_t>> children(entityCount / kBatchSize);
+        jobs::ParallelFor(0, children.size(), 1, [&](size_t batch)
+        {
+            nv::Vector<uint32_t> list;
+            for (uint32_t i = 0; i < kBatchSize; i += 1 + (i & 3))
+                list.Push((uint32_t)(batch * kBatchSize + i));
+            children[batch] = std::move(list);
+        });
+    }
+
+    static double ReplayTrace(IAllocator* pAllocator, const RecordingAllocator& trace, uint32_t rounds)
+    {
+        std::vector<void*> slots(trace.mSlotCount, nullptr);
+        const auto start = BenchClock::now();
+        for (uint32_t round = 0; round < rounds; ++round)
+        {
+            for (const AllocationEvent& event : trace.mEvents)
+            {
+                void*& ptr = slots[event.mSlot];
+                if (event.mSize)
+                {
+                    ptr = pAllocator->Allocate(event.mSize);
+                    *(volatile uint8_t*)ptr = 1;
+                }
+                else
+                {
+                    pAllocator->Free(ptr);
+                    ptr = nullptr;
+                }
+            }
+
+            // Whatever outlived the recording is released before the next round
+            for (void*& ptr : slots)
+            {
+                pAllocator->Free(ptr);
+                ptr = nullptr;
+            }
+        }
+
+        return ElapsedMs(start) * 1'000'000.0 / ((double)rounds * trace.mEvents.size());
+    }
+
+    TEST_F(Benchmarks, DISABLED_TlsfAllocatorFrameTrace)
+    {
+        constexpr uint32_t kTraceFrames = 4;
+        constexpr uint32_t kRounds = 200;
+
+        // Record a few frames after a warmup one
+        RecordingAllocator trace;
+        {
+            std::vector<InFlightFrameData> inFlight;
+            SimulateAppFrame(4096, inFlight);
+
+            SystemAllocator* pSystem = SystemAllocator::gPtr;
+            SystemAllocator::gPtr = &trace;
+            for (uint32_t frame = 0; frame < kTraceFrames; ++frame)
+                SimulateAppFrame(4096, inFlight);
+            SystemAllocator::gPtr = pSystem;
+
+            while (!inFlight.empty())
+                ReleaseFrameTemporaries(SystemAllocator::gPtr, inFlight);
+        }
+        ASSERT_FALSE(trace.mEvents.empty());
+
+        size_t frees = 0;
+        for (const AllocationEvent& event : trace.mEvents)
+            frees += event.mSize == 0;
+        log::Info("[Bench] FrameTrace {} frames: {} allocations, {} frees", kTraceFrames, trace.mSlotCount, frees);
+
+        for (uint32_t threadCount : GetBenchThreadCounts())
+        {
+            TlsfAllocator tlsf(16 * 1024 * 1024);
+            auto run = [&](IAllocator* pAllocator)
+            {
+                std::vector<double> nsPerOp(threadCount);
+                std::vector<std::thread> threads;
+                for (uint32_t thread = 0; thread < threadCount; ++thread)
+                    threads.emplace_back([&, thread]() { nsPerOp[thread] = ReplayTrace(pAllocator, trace, kRounds); });
+
+                for (auto& thread : threads)
+                    thread.join();
+                return *std::max_element(nsPerOp.begin(), nsPerOp.end());
+            };
+
+            const double mallocNs = run(SystemAllocator::gPtr);
+            const double tlsfNs = run(&tlsf);
+            log::Info("[Bench] FrameTrace threads={} malloc: {:.1f}ns/op | tlsf: {:.1f}ns/op, {} pools",
+                threadCount, mallocNs, tlsfNs, tlsf.GetPoolCount());
+
+            EXPECT_TRUE(tlsf.CheckIntegrity());
+        }
+    }
+
+    // Alloc/free pairs with a small window of live objects per thread, sizes cycling through every class
+    static double RunSmallObjectPairs(IAllocator* pAllocator, uint32_t threadCount, uint32_t pairCount)
+    {
+        constexpr uint32_t kWindow = 256;
+        std::vector<std::thread> threads;
+        const auto start = BenchClock::now();
+        for (uint32_t thread = 0; thread < threadCount; ++thread)
+        {
+            threads.emplace_back([=]()
+            {
+                void* window[kWindow] = {};
+                for (uint32_t i = 0; i < pairCount / threadCount; ++i)
+                {
+                    void*& ptr = window[i % kWindow];
+                    pAllocator->Free(ptr);
+                    ptr = pAllocator->Allocate(kSlabMinSize << (i % kSlabClassCount));
+                    *(volatile uint8_t*)ptr = 1;
+                }
+
+                for (void* ptr : window)
+                    pAllocator->Free(ptr);
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+        return ElapsedMs(start) * 1'000'000.0 / pairCount;
+    }
+
+    TEST_F(Benchmarks, DISABLED_SlabAllocatorVsSystem)
+    {
+        constexpr uint32_t kPairCount = 10'000'000;
+        constexpr uint32_t kThreadCount = 8;
+
+        SlabAllocator slab;
+        RunSmallObjectPairs(&slab, kThreadCount, kPairCount / 10); // Carve the slabs up front
+
+        const double systemNs = RunSmallObjectPairs(SystemAllocator::gPtr, kThreadCount, kPairCount);
+        const double slabNs = RunSmallObjectPairs(&slab, kThreadCount, kPairCount);
+        log::Info("[Bench] SmallObjects {} pairs threads={} system: {:.1f}ns/pair | slab: {:.1f}ns/pair, {} KB of slabs",
+            kPairCount, kThreadCount, systemNs, slabNs, slab.GetCapacity() / 1024);
+    }
+
+#if NV_PLATFORM_LINUX
+    // dTLB load misses of the calling thread, Stop returns -1 if perf events aren't allowed
+    class TlbMissCounter
+    {
+    public:
+        TlbMissCounter()
+        {
+            perf_event_attr attr = {};
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            mFd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+
+        ~TlbMissCounter()
+        {
+            if (mFd >= 0)
+                close(mFd);
+        }
+
+        void Start()
+        {
+            if (mFd < 0)
+                return;
+            ioctl(mFd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(mFd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+
+        int64_t Stop()
+        {
+            int64_t count = -1;
+            if (mFd < 0)
+                return count;
+            ioctl(mFd, PERF_EVENT_IOC_DISABLE, 0);
+            return read(mFd, &count, sizeof(count)) == sizeof(count) ? count : -1;
+        }
+
+    private:
+        int mFd = -1;
+    };
+#else
+    // Hardware counters need ETW on Windows, not worth it for a benchmark
+    class TlbMissCounter
+    {
+    public:
+        void    Start() {}
+        int64_t Stop() { return -1; }
+    };
+#endif
+
+    static std::string FormatTlbMisses(int64_t misses, size_t count)
+    {
+        return misses < 0 ? std::string("n/a") : fmt::format("{:.3f}/agent", (double)misses / count);
+    }
+
+    // Same columns as the simulation's AgentStore, each in its own buffer
+    struct AgentColumns
+    {
+        AgentColumns(LargePageAllocator& allocator, size_t count) :
+            mAllocator(allocator),
+            mIds((uint64_t*)allocator.Allocate(count * sizeof(uint64_t))),
+            mStates((uint8_t*)allocator.Allocate(count)),
+            mLocations((uint8_t*)allocator.Allocate(count)),
+            mAges((float*)allocator.Allocate(count * sizeof(float))),
+            mSatisfactions((float*)allocator.Allocate(count * sizeof(float))),
+            mPositions((float*)allocator.Allocate(count * 3 * sizeof(float))),
+            mWealth((uint32_t*)allocator.Allocate(count * sizeof(uint32_t)))
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                mIds[i] = i + 1;
+                mAges[i] = (float)(i % 80);
+                mPositions[i * 3] = (float)i;
+            }
+        }
+
+        ~AgentColumns()
+        {
+            for (void* ptr : { (void*)mIds, (void*)mStates, (void*)mLocations, (void*)mAges, (void*)mSatisfactions, (void*)mPositions, (void*)mWealth })
+                mAllocator.Free(ptr);
+        }
+
+        void Update(size_t i)
+        {
+            if (mIds[i] == 0)
+                mStates[i] = 1;
+            mAges[i] += 1.f / 365.f;
+            mSatisfactions[i] = mSatisfactions[i] * 0.99f + (mLocations[i] == 2 ? 0.01f : 0.f);
+            mPositions[i * 3] += 0.1f;
+            mWealth[i] += mStates[i];
+        }
+
+        LargePageAllocator& mAllocator;
+        uint64_t*           mIds;
+        uint8_t*            mStates;
+        uint8_t*            mLocations;
+        float*              mAges;
+        float*              mSatisfactions;
+        float*              mPositions;     // xyz
+        uint32_t*           mWealth;
+    };
+
+    TEST_F(Benchmarks, DISABLED_LargePageAgentSweep)
+    {
+        // RunStoreTests sized store. The linear sweep is what processors do every tick, the shuffled
+        // one is agents being looked up by id and is where the TLB reach of large pages shows
+        constexpr size_t kAgentCount = 1'000'000;
+        constexpr uint32_t kRepeats = 20;
+
+        std::vector<uint32_t> order(kAgentCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+        const uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+        ScopedJobSystem jobSystem(threadCount);
+        TlbMissCounter tlbMisses;
+
+        using platform::LargePageMode;
+        const std::pair<LargePageMode, const char*> modes[] =
+        {
+            { LargePageMode::None, "4K pages" },
+            { LargePageMode::Transparent, "transparent" },
+            { LargePageMode::Explicit, "explicit" },
+        };
+
+        for (const auto& [mode, pName] : modes)
+        {
+            LargePageAllocator allocator({ .mMode = mode, .mNumaNode = platform::GetCurrentNumaNode() });
+            AgentColumns agents(allocator, kAgentCount);
+            const size_t largePageBytes = allocator.GetMappedSize(LargePageMode::Transparent) + allocator.GetMappedSize(LargePageMode::Explicit);
+
+            tlbMisses.Start();
+            auto start = BenchClock::now();
+            for (uint32_t r = 0; r < kRepeats; ++r)
+            {
+                for (size_t i = 0; i < kAgentCount; ++i)
+                    agents.Update(i);
+            }
+            const double linearMs = ElapsedMs(start) / kRepeats;
+            const int64_t linearMisses = tlbMisses.Stop();
+
+            tlbMisses.Start();
+            start = BenchClock::now();
+            for (uint32_t r = 0; r < kRepeats; ++r)
+            {
+                for (uint32_t i : order)
+                    agents.Update(i);
+            }
+            const double shuffledMs = ElapsedMs(start) / kRepeats;
+            const int64_t shuffledMisses = tlbMisses.Stop();
+
+            start = BenchClock::now();
+            for (uint32_t r = 0; r < kRepeats; ++r)
+            {
+                jobs::ParallelFor(0, kAgentCount, 4096, [&](size_t first, size_t last)
+                {
+                    for (size_t i = first; i < last; ++i)
+                        agents.Update(i);
+                });
+            }
+            const double parallelMs = ElapsedMs(start) / kRepeats;
+
+            log::Info("[Bench] LargePageAgentSweep {} ({} MB on large pages): linear {:.2f}ms, {:.0f}M agents/s, dTLB misses {} | "
+                "shuffled {:.2f}ms, dTLB misses {} | parallel threads={} {:.2f}ms",
+                pName, largePageBytes >> 20, linearMs, kAgentCount / linearMs / 1000.0, FormatTlbMisses(linearMisses, kAgentCount * kRepeats),
+                shuffledMs, FormatTlbMisses(shuffledMisses, kAgentCount * kRepeats), threadCount, parallelMs);
+        }
+    }
+
+    // Moves an object and rebuilds its world matrix, what a transform pass does per entity
+    static float UpdateTransform(Position& position, Rotation& rotation, Scale& scale, PrevTransform& prev)
+    {
+        prev.mPosition = position.mPosition;
+        prev.mRotation = rotation.mRotation;
+        prev.mScale = scale.mScale;
+        position.mPosition.x += 0.01f;
+
+        const TransformRef transform = { position.mPosition, rotation.mRotation, scale.mScale };
+        return transform.GetTransformMatrix()._41;
+    }
+
+    TEST_F(Benchmarks, DISABLED_ArchetypeTransformSweep)
+    {
+        constexpr uint32_t kEntityCount = 100'000;
+        constexpr uint32_t kRepeats = 20;
+
+        std::vector<Handle<ecs::Entity>> entities(kEntityCount);
+        ecs::ArchetypeStorage storage;
+        for (auto& handle : entities)
+        {
+            handle = ecs::gEntityManager.Create();
+            ecs::Entity* pEntity = ecs::gEntityManager.GetEntity(handle);
+            pEntity->AttachTransform();
+            pEntity->Add<PrevTransform>();
+
+            storage.Add<Position>(handle);
+            storage.Add<Rotation>(handle)->mRotation = float4(0, 0, 0, 1);
+            storage.Add<Scale>(handle)->mScale = float3(1, 1, 1);
+            storage.Add<PrevTransform>(handle);
+        }
+
+        // Current layout, looking every component up through the entity
+        float checksum = 0.f;
+        auto start = BenchClock::now();
+        for (uint32_t r = 0; r < kRepeats; ++r)
+        {
+            for (auto handle : entities)
+            {
+                ecs::Entity* pEntity = ecs::gEntityManager.GetEntity(handle);
+                checksum += UpdateTransform(*pEntity->GetMut<Position>(), *pEntity->GetMut<Rotation>(), *pEntity->GetMut<Scale>(), *pEntity->GetMut<PrevTransform>());
+            }
+        }
+        const double lookupMs = ElapsedMs(start) / kRepeats;
+
+        // Current layout walked by index, as RenderDataArray does. Only right while the pools line up.
+        start = BenchClock::now();
+        for (uint32_t r = 0; r < kRepeats; ++r)
+        {
+            auto positions = ecs::gComponentManager.GetComponents<Position>();
+            auto rotations = ecs::gComponentManager.GetComponents<Rotation>();
+            auto scales = ecs::gComponentManager.GetComponents<Scale>();
+            auto prevTransforms = ecs::gComponentManager.GetComponents<PrevTransform>();
+            for (size_t i = 0; i < positions.Size(); ++i)
+                checksum += UpdateTransform(positions[i], rotations[i], scales[i], prevTransforms[i]);
+        }
+        const double spanMs = ElapsedMs(start) / kRepeats;
+
+        const ecs::ComponentMask mask = ecs::GetComponentMask<Position, Rotation, Scale, PrevTransform>();
+        start = BenchClock::now();
+        for (uint32_t r = 0; r < kRepeats; ++r)
+        {
+            for (const ecs::Archetype* pArchetype : storage.GetArchetypes())
+            {
+                if (!pArchetype->HasAll(mask))
+                    continue;
+
+                for (uint32_t c = 0; c < pArchetype->GetChunkCount(); ++c)
+                {
+                    const ecs::ArchetypeChunk& chunk = pArchetype->GetChunk(c);
+                    Position* pPositions = pArchetype->GetColumn<Position>(chunk);
+                    Rotation* pRotations = pArchetype->GetColumn<Rotation>(chunk);
+                    Scale* pScales = pArchetype->GetColumn<Scale>(chunk);
+                    PrevTransform* pPrevTransforms = pArchetype->GetColumn<PrevTransform>(chunk);
+                    for (uint32_t i = 0; i < chunk.mCount; ++i)
+                        checksum += UpdateTransform(pPositions[i], pRotations[i], pScales[i], pPrevTransforms[i]);
+                }
+            }
+        }
+        const double chunkMs = ElapsedMs(start) / kRepeats;
+
+        log::Info("[Bench] TransformSweep {} entities: entity lookups {:.2f}ms | pool spans {:.2f}ms | archetype chunks {:.2f}ms ({} per chunk), checksum {}",
+            kEntityCount, lookupMs, spanMs, chunkMs, storage.GetArchetypes()[0]->GetChunkCapacity(), checksum);
+
+        for (auto handle : entities)
+        {
+            ecs::Entity* pEntity = ecs::gEntityManager.GetEntity(handle);
+            pEntity->Remove<Position>();
+            pEntity->Remove<Rotation>();
+            pEntity->Remove<Scale>();
+            pEntity->Remove<PrevTransform>();
+            ecs::gEntityManager.Remove(handle);
+        }
+    }
+
+    TEST_F(Benchmarks, DISABLED_QueryJoin)
+    {
+        constexpr uint32_t kEntityCount = 100'000;
+        constexpr uint32_t kRepeats = 20;
+
+        std::vector<Handle<ecs::Entity>> entities(kEntityCount);
+        for (uint32_t i = 0; i < kEntityCount; ++i)
+        {
+            entities[i] = ecs::gEntityManager.Create();
+            ecs::Entity* pEntity = ecs::gEntityManager.GetEntity(entities[i]);
+            pEntity->Add<Position>();
+            pEntity->Add<Scale>()->mScale = float3(1, 1, 1);
+            if (i % 2)
+                pEntity->Add<Rotation>()->mRotation = float4(0, 0, 0, 1);
+        }
+
+        // What systems did so far: collect one pool and look the rest up through each entity
+        float checksum = 0.f;
+        auto start = BenchClock::now();
+        for (uint32_t r = 0; r < kRepeats; ++r)
+        {
+            ecs::EntityComponents<Position> positions;
+            ecs::gComponentManager.GetPool<Position>()->GetEntityComponents(positions);
+            for (size_t i = 0; i < positions.Size(); ++i)
+            {
+                auto instance = positions[i];
+                if (!instance.mpEntity->Has<Rotation>())
+                    continue;
+
+                instance.mpComponent->mPosition.x += instance.mpEntity->Get<Rotation>()->mRotation.w * instance.mpEntity->Get<Scale>()->mScale.x;
+                checksum += instance.mpComponent->mPosition.x;
+            }
+        }
+        const double lookupMs = ElapsedMs(start) / kRepeats;
+
+        ecs::Query<Position, const Rotation, const Scale> query;
+        start = BenchClock::now();
+        for (uint32_t r = 0; r < kRepeats; ++r)
+        {
+            query.ForEach([&](Position& position, const Rotation& rotation, const Scale& scale)
+            {
+                position.mPosition.x += rotation.mRotation.w * scale.mScale.x;
+                checksum += position.mPosition.x;
+            });
+        }
+        const double queryMs = ElapsedMs(start) / kRepeats;
+
+        std::atomic<uint64_t> chunkChecksum = 0;
+        start = BenchClock::now();
+        for (uint32_t r = 0; r < kRepeats; ++r)
+        {
+            query.ForEachChunk([&](const auto& chunk)
+            {
+                float sum = 0.f;
+                chunk.ForEach([&](Position& position, const Rotation& rotation, const Scale& scale)
+                {
+                    position.mPosition.x += rotation.mRotation.w * scale.mScale.x;
+                    sum += position.mPosition.x;
+                });
+                chunkChecksum.fetch_add((uint64_t)sum, std::memory_order_relaxed);
+            });
+        }
+        const double chunkMs = ElapsedMs(start) / kRepeats;
+
+        log::Info("[Bench] QueryJoin {} entities: entity lookups {:.2f}ms | query {:.2f}ms | ForEachChunk {:.2f}ms on {} workers, checksum {} {}",
+            kEntityCount, lookupMs, queryMs, chunkMs, jobs::GetWorkerCount(), checksum, chunkChecksum.load());
+
+        for (auto handle : entities)
+        {
+            ecs::Entity* pEntity = ecs::gEntityManager.GetEntity(handle);
+            pEntity->Remove<Position>();
+            pEntity->Remove<Rotation>();
+            pEntity->Remove<Scale>();
+            ecs::gEntityManager.Remove(handle);
+        }
+    }
+
+    struct PoolBenchComponent
+    {
+        float mValues[4] = {};
+    };
+
+    // Same handles for both pools, looked up and removed in one shuffled order
+    template<typename TPool>
+    static void BenchPoolOps(const char* pName, uint32_t count)
+    {
+        TPool pool;
+        std::vector<Handle<PoolBenchComponent>> handles(count);
+        auto start = BenchClock::now();
+        for (uint32_t i = 0; i < count; ++i)
+            handles[i] = pool.Create(PoolBenchComponent{ { (float)i } });
+        const double insertMs = ElapsedMs(start);
+
+        std::shuffle(handles.begin(), handles.end(), std::mt19937(42));
+        float checksum = 0.f;
+        start = BenchClock::now();
+        for (auto handle : handles)
+            checksum += pool.GetAsDerived(handle)->mValues[0];
+        const double lookupMs = ElapsedMs(start);
+
+        start = BenchClock::now();
+        for (const PoolBenchComponent& item : pool.Span())
+            checksum += item.mValues[0];
+        const double iterateMs = ElapsedMs(start);
+
+        start = BenchClock::now();
+        for (auto handle : handles)
+            pool.Remove(handle);
+        const double removeMs = ElapsedMs(start);
+
+        log::Info("[Bench] {} {} items: insert {:.2f}ms | random lookup {:.2f}ms | iterate {:.2f}ms | random remove {:.2f}ms, checksum {}",
+            pName, count, insertMs, lookupMs, iterateMs, removeMs, checksum);
+    }
+
+    TEST_F(Benchmarks, DISABLED_SparseSetPool)
+    {
+        constexpr uint32_t kCount = 1'000'000;
+
+        BenchPoolOps<ContiguousPool<PoolBenchComponent, PoolBenchComponent, kPoolInitDefaultSize, PoolBackend::Virtual>>("ContiguousPool", kCount);
+        BenchPoolOps<SparseSetPool<PoolBenchComponent, PoolBenchComponent, kPoolInitDefaultSize, PoolBackend::Virtual>>("SparseSetPool", kCount);
+    }
+
+    // Stand-ins for the renderer and game components, Tests only links Core
+    struct BenchRenderable {};
+    struct BenchAnimation {};
+    struct BenchCamera {};
+    struct BenchPlayer {};
+
+    template<uint32_t Index>
+    class BenchSystem : public ISystem
+    {
+    public:
+        using DeclareFn = void (*)(SystemAccess&);
+
+        BenchSystem(DeclareFn pDeclare, double workMs, const bool* pbDeclare) :
+            mpDeclare(pDeclare), mWorkMs(workMs), mpbDeclare(pbDeclare) {}
+
+        void Update(float deltaTime, float totalTime) override
+        {
+            const auto start = BenchClock::now();
+            while (ElapsedMs(start) < mWorkMs) {}
+        }
+
+        void DeclareAccess(SystemAccess& access) const override
+        {
+            if (*mpbDeclare)
+                mpDeclare(access);
+        }
+
+    private:
+        DeclareFn   mpDeclare;
+        double      mWorkMs;
+        const bool* mpbDeclare;
+    };
+
+    // The App's systems in registration order with the accesses they declare, each busy for a
+    // fixed time. Undeclared, every system runs on its own as before the scheduler.
+    TEST_F(Benchmarks, DISABLED_SystemScheduler)
+    {
+        constexpr uint32_t kFrames = 200;
+        constexpr double kWorkMs = 0.5;
+
+        bool bDeclare = false;
+        SystemManager sysMan;
+        sysMan.CreateSystem<BenchSystem<0>>([](SystemAccess& access) { access.Read<BenchRenderable, Position, Rotation, Scale, PrevTransform>(); }, kWorkMs, &bDeclare);     // Render
+        sysMan.CreateSystem<BenchSystem<1>>([](SystemAccess& access) { access.Write<BenchRenderable, BenchAnimation>(); }, kWorkMs, &bDeclare);                              // Animation
+        sysMan.CreateSystem<BenchSystem<2>>([](SystemAccess& access) { access.Read<Position, Rotation, Scale>().Write<PrevTransform>(); }, kWorkMs, &bDeclare);             // FramePre
+        sysMan.CreateSystem<BenchSystem<3>>([](SystemAccess& access) { access.Write<Position, Rotation, Scale, BenchCamera>(); }, kWorkMs, &bDeclare);                      // Camera
+        sysMan.CreateSystem<BenchSystem<4>>([](SystemAccess& access) { access.Exclusive(); }, kWorkMs, &bDeclare);                                                          // Driver
+        sysMan.CreateSystem<BenchSystem<5>>([](SystemAccess& access) { access.Write<Position, Rotation, Scale, BenchAnimation, BenchPlayer>(); }, kWorkMs, &bDeclare);      // Player
+
+        for (bool bDeclared : { false, true })
+        {
+            bDeclare = bDeclared;
+            sysMan.UpdateSystems(0.f, 0.f);
+
+            const auto start = BenchClock::now();
+            for (uint32_t frame = 0; frame < kFrames; ++frame)
+                sysMan.UpdateSystems(0.f, 0.f);
+
+            log::Info("[Bench] SystemScheduler {}: {:.3f} ms/frame, workers {}", bDeclared ? "declared" : "sequential", ElapsedMs(start) / kFrames, jobs::GetWorkerCount());
+        }
+    }
+}
@@ -1,6 +1,29 @@
 #include "pch.h"
 #include "TestCommon.h"
 
+#include <Lib/InlineFunction.h>
+#include <Lib/MPMCQueue.h>
+#include <Lib/SPSCQueue.h>
+#include <Memory/FrameAllocator.h>
+#include <Memory/LargePageAllocator.h>
+#include <Memory/SlabAllocator.h>
+#include <Memory/TlsfAllocator.h>
+#include <Platform/Thread.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+
+#if NV_PLATFORM_LINUX
+#include <sched.h>
+#include <filesystem>
+#include <fstream>
+#endif
+
 namespace nv::tests
 {
     TEST_F(CoreTests, BasicMemTest)
@@ -218,6 +241,93 @@ namespace nv::tests
         EXPECT_FLOAT_EQ(comPool.GetAsDerived(h3)->mMuliplier, 8.f);
     }
 
+    TEST_F(CoreTests, ContiguousPoolRemoveTest)
+    {
+        using namespace nv;
+
+        ContiguousPool<IComponent, TestComponent> comPool;
+        std::vector<Handle<IComponent>> handles;
+        for (uint32_t i = 0; i < 6; ++i)
+            handles.push_back(comPool.Create(TestComponent{ .mSpeed = (float)i }));
+
+        // Item 5 is moved into slot 1, then becomes the last item and is moved again
+        comPool.Remove(handles[1]);
+        for (uint32_t i = 4; i >= 2; --i)
+            comPool.Remove(handles[i]);
+        comPool.Remove(handles[0]);
+
+        EXPECT_EQ(comPool.Size(), 1);
+        EXPECT_FALSE(comPool.IsValid(handles[1]));
+        EXPECT_TRUE(comPool.IsValid(handles[5]));
+        EXPECT_FLOAT_EQ(comPool.GetAsDerived(handles[5])->mSpeed, 5.f);
+
+        // Moved items keep their handle, so reused slots can't hand out one that's live
+        ContiguousPool<IComponent, TestComponent> reusePool;
+        auto a = reusePool.Create(TestComponent{ .mSpeed = 1.f });
+        auto b = reusePool.Create(TestComponent{ .mSpeed = 2.f });
+        reusePool.Remove(b);
+        auto c = reusePool.Create(TestComponent{ .mSpeed = 3.f });
+        reusePool.Remove(a);
+        auto d = reusePool.Create(TestComponent{ .mSpeed = 4.f });
+
+        EXPECT_NE(c.mHandle, d.mHandle);
+        EXPECT_FALSE(reusePool.IsValid(a));
+        EXPECT_FALSE(reusePool.IsValid(b));
+        ASSERT_TRUE(reusePool.IsValid(c));
+        ASSERT_TRUE(reusePool.IsValid(d));
+        EXPECT_FLOAT_EQ(reusePool.GetAsDerived(c)->mSpeed, 3.f);
+        EXPECT_FLOAT_EQ(reusePool.GetAsDerived(d)->mSpeed, 4.f);
+
+        reusePool.Remove(c);
+        EXPECT_FALSE(reusePool.IsValid(c));
+        ASSERT_TRUE(reusePool.IsValid(d));
+        EXPECT_EQ(reusePool.Size(), 1);
+        EXPECT_FLOAT_EQ(reusePool.GetAsDerived(d)->mSpeed, 4.f);
+    }
+
+    TEST_F(CoreTests, SparseSetPoolTest)
+    {
+        using namespace nv;
+
+        SparseSetPool<IComponent, TestComponent> comPool;
+        std::vector<Handle<IComponent>> handles;
+        for (uint32_t i = 0; i < 6; ++i)
+            handles.push_back(comPool.Create(TestComponent{ .mSpeed = (float)i }));
+
+        // Same swap-removes as ContiguousPoolRemoveTest
+        comPool.Remove(handles[1]);
+        for (uint32_t i = 4; i >= 2; --i)
+            comPool.Remove(handles[i]);
+        comPool.Remove(handles[0]);
+
+        EXPECT_EQ(comPool.Size(), 1);
+        EXPECT_FALSE(comPool.IsValid(handles[1]));
+        EXPECT_TRUE(comPool.IsValid(handles[5]));
+        EXPECT_FLOAT_EQ(comPool.GetAsDerived(handles[5])->mSpeed, 5.f);
+        EXPECT_FLOAT_EQ(comPool[0].mSpeed, 5.f);
+
+        // A reused slot gets a new generation, the old handle stays invalid
+        auto reused = comPool.Create(TestComponent{ .mSpeed = 6.f });
+        EXPECT_FALSE(reused.IsNull());
+        EXPECT_FALSE(comPool.IsValid(handles[0]));
+        EXPECT_TRUE(comPool.IsValid(reused));
+        EXPECT_FLOAT_EQ(comPool.GetAsDerived(reused)->mSpeed, 6.f);
+
+        // Past the first sparse page
+        for (uint32_t i = 0; i < kSparsePageSize * 2; ++i)
+            handles.push_back(comPool.Create(TestComponent{ .mSpeed = (float)i }));
+        for (uint32_t i = 6; i < handles.size(); i += 2)
+            comPool.Remove(handles[i]);
+
+        EXPECT_EQ(comPool.Size(), 2 + kSparsePageSize);
+        for (uint32_t i = 6; i < handles.size(); ++i)
+        {
+            EXPECT_EQ(comPool.IsValid(handles[i]), i % 2 == 1);
+            if (i % 2 == 1)
+                EXPECT_FLOAT_EQ(comPool.GetAsDerived(handles[i])->mSpeed, (float)(i - 6));
+        }
+    }
+
     TEST_F(CoreTests, PoolGrowTest)
     {
         using namespace nv;
@@ -248,6 +358,97 @@ namespace nv::tests
         comPool.Destroy();
     }
 
+    TEST_F(CoreTests, VirtualPoolGrowTest)
+    {
+        using namespace nv;
+
+        // Pointers taken before growing stay valid, the storage is never moved
+        Pool<IComponent, TestComponent, 2, PoolBackend::Virtual> comPool;
+        comPool.Init();
+        auto h1 = comPool.Insert({ .mSpeed = 1.5f, .mMuliplier = 1.f });
+        TestComponent* pFirst = comPool.GetAsDerived(h1);
+        const TestComponent* pData = comPool.Data();
+
+        constexpr uint32_t kCount = 100000;
+        for (uint32_t i = 1; i < kCount; ++i)
+            comPool.Create(TestComponent{ .mSpeed = (float)i, .mMuliplier = 2.f });
+
+        EXPECT_EQ(comPool.Size(), kCount);
+        EXPECT_GE(comPool.Capacity(), kCount);
+        EXPECT_EQ(comPool.Data(), pData);
+        EXPECT_EQ(comPool.GetAsDerived(h1), pFirst);
+        EXPECT_FLOAT_EQ(pFirst->mSpeed, 1.5f);
+        EXPECT_FLOAT_EQ(comPool.Span()[kCount - 1].mSpeed, (float)(kCount - 1));
+        comPool.Destroy();
+
+        ContiguousPool<IComponent, TestComponent, kPoolInitDefaultSize, PoolBackend::Virtual> contiguous;
+        auto c1 = contiguous.Insert({ .mSpeed = 1.5f, .mMuliplier = 1.f });
+        auto c2 = contiguous.Create(TestComponent{ .mSpeed = 2.5f, .mMuliplier = 2.f });
+        TestComponent* pSecond = contiguous.GetAsDerived(c2);
+        for (uint32_t i = 2; i < kCount; ++i)
+            contiguous.Create(TestComponent{ .mSpeed = (float)i, .mMuliplier = 2.f });
+
+        EXPECT_EQ(contiguous.Size(), kCount);
+        EXPECT_EQ(contiguous.GetAsDerived(c2), pSecond);
+        EXPECT_FLOAT_EQ(pSecond->mSpeed, 2.5f);
+
+        // Removing still swaps the last element into the hole
+        contiguous.Remove(c1);
+        EXPECT_FALSE(contiguous.IsValid(c1));
+        EXPECT_EQ(contiguous.Size(), kCount - 1);
+        EXPECT_FLOAT_EQ(contiguous[0].mSpeed, (float)(kCount - 1));
+        EXPECT_EQ(contiguous.GetAsDerived(c2), pSecond);
+
+        VirtualArray<uint64_t> values(1024 * 1024);
+        EXPECT_EQ(values.GetMaxSize(), 128u * 1024);
+        values.resize(values.GetMaxSize());
+        EXPECT_EQ(values[values.size() - 1], 0u);
+        values.clear();
+        EXPECT_TRUE(values.empty());
+    }
+
+    TEST_F(CoreTests, LargePageAllocatorTest)
+    {
+        using namespace nv;
+        using platform::LargePageMode;
+
+        // Whatever the OS grants, every mode hands back usable, zeroed memory
+        const LargePageMode modes[] = { LargePageMode::None, LargePageMode::Transparent, LargePageMode::Explicit };
+        for (LargePageMode mode : modes)
+        {
+            LargePageAllocator allocator({ .mMode = mode, .mNumaNode = platform::GetCurrentNumaNode() });
+            constexpr size_t kSize = 3 * 1024 * 1024 + 100;
+            uint32_t* pValues = (uint32_t*)allocator.Allocate(kSize);
+            ASSERT_NE(pValues, nullptr);
+            EXPECT_EQ((uintptr_t)pValues % alignof(std::max_align_t), 0u);
+            EXPECT_EQ(pValues[kSize / sizeof(uint32_t) - 1], 0u);
+            for (size_t i = 0; i < kSize / sizeof(uint32_t); ++i)
+                pValues[i] = (uint32_t)i;
+
+            size_t mapped = 0;
+            for (LargePageMode granted : modes)
+                mapped += allocator.GetMappedSize(granted);
+            EXPECT_GE(mapped, kSize);
+            if (mode == LargePageMode::None)
+                EXPECT_EQ(allocator.GetMappedSize(LargePageMode::None), mapped);
+
+            allocator.Free(pValues);
+            EXPECT_EQ(allocator.GetMappedSize(LargePageMode::None) + allocator.GetMappedSize(LargePageMode::Transparent)
+                + allocator.GetMappedSize(LargePageMode::Explicit), 0u);
+
+            // Below the minimum size the backing allocator serves it
+            void* pSmall = allocator.Allocate(64);
+            ASSERT_NE(pSmall, nullptr);
+            EXPECT_EQ(allocator.GetMappedSize(LargePageMode::None), 0u);
+            allocator.Free(pSmall);
+        }
+
+        LargePageVector<uint64_t> column;
+        for (uint64_t i = 0; i < 500'000; ++i)
+            column.push_back(i);
+        EXPECT_EQ(column[499'999], 499'999u);
+    }
+
     TEST_F(CoreTests, StringHashTest)
     {
         using namespace nv;
@@ -300,4 +501,808 @@ namespace nv::tests
         auto testSystemRef2 = (TestSystem*)sysMan.GetSystem(TypeNameID<TestSystem>());
         EXPECT_FLOAT_EQ(testSystemRef->mSpeed, 2.f);
     }
+
+    struct ScheduleSpeed {};
+    struct ScheduleHeading {};
+
+    struct ScheduleTrace
+    {
+        static constexpr uint32_t kSystemCount = 5;
+
+        std::atomic<uint32_t>   mClock = 0;
+        uint32_t                mStart[kSystemCount] = {};
+        uint32_t                mEnd[kSystemCount] = {};
+    };
+
+    template<uint32_t Index>
+    class ScheduleTestSystem : public ISystem
+    {
+    public:
+        using DeclareFn = void (*)(SystemAccess&);
+
+        ScheduleTestSystem(ScheduleTrace* pTrace, DeclareFn pDeclare) :
+            mpTrace(pTrace), mpDeclare(pDeclare) {}
+
+        void Update(float deltaTime, float totalTime) override
+        {
+            mpTrace->mStart[Index] = mpTrace->mClock++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            mpTrace->mEnd[Index] = mpTrace->mClock++;
+        }
+
+        void DeclareAccess(SystemAccess& access) const override
+        {
+            if (mpDeclare)
+                mpDeclare(access);
+        }
+
+    private:
+        ScheduleTrace*  mpTrace;
+        DeclareFn       mpDeclare;
+    };
+
+    TEST_F(CoreTests, SystemSchedulerTest)
+    {
+        ScheduleTrace trace;
+        SystemManager sysMan;
+        sysMan.CreateSystem<ScheduleTestSystem<0>>(&trace, [](SystemAccess& access) { access.Write<ScheduleSpeed>(); });
+        sysMan.CreateSystem<ScheduleTestSystem<1>>(&trace, [](SystemAccess& access) { access.Read<ScheduleSpeed>(); });
+        sysMan.CreateSystem<ScheduleTestSystem<2>>(&trace, [](SystemAccess& access) { access.Write<ScheduleHeading>(); });
+        sysMan.CreateSystem<ScheduleTestSystem<3>>(&trace, [](SystemAccess& access) { access.Read<ScheduleHeading>().After<ScheduleTestSystem<4>>(); });
+        sysMan.CreateSystem<ScheduleTestSystem<4>>(&trace, nullptr);
+
+        const auto before = [&trace](uint32_t a, uint32_t b) { return trace.mEnd[a] < trace.mStart[b]; };
+        for (uint32_t frame = 0; frame < 10; ++frame)
+        {
+            trace.mClock = 0;
+            sysMan.UpdateSystems(0.f, 0.f);
+
+            // Reader after writer, and 3 after 4 although it was added first
+            EXPECT_TRUE(before(0, 1));
+            EXPECT_TRUE(before(2, 3));
+            EXPECT_TRUE(before(4, 3));
+
+            // Declaring nothing runs alone
+            for (uint32_t i = 0; i < 4; ++i)
+                EXPECT_TRUE(before(i, 4) || before(4, i));
+        }
+    }
+
+    TEST_F(CoreTests, InlineFunctionTest)
+    {
+        using namespace nv;
+        using Fn = InlineFunction<int(int), 32>;
+
+        int base = 10;
+        Fn add = [&base](int value) { return base + value; };
+        EXPECT_TRUE((bool)add);
+        EXPECT_EQ(add(5), 15);
+
+        // Moving transfers the captured state and leaves the source empty
+        Fn moved = std::move(add);
+        EXPECT_FALSE((bool)add);
+        EXPECT_EQ(moved(1), 11);
+
+        static int sDestroyed = 0;
+        struct Tracked
+        {
+            int mValue = 3;
+            Tracked() = default;
+            Tracked(Tracked&& other) noexcept : mValue(other.mValue) {}
+            ~Tracked() { sDestroyed++; }
+            int operator()(int value) const { return mValue * value; }
+        };
+
+        {
+            Fn tracked = Tracked();
+            sDestroyed = 0;
+            EXPECT_EQ(tracked(2), 6);
+        }
+        EXPECT_EQ(sDestroyed, 1);
+
+        Fn empty = (int(*)(int))nullptr;
+        EXPECT_FALSE((bool)empty);
+    }
+
+    TEST_F(CoreTests, BoundedQueueTest)
+    {
+        // Move only items survive a round trip, a full ring rejects without consuming the item
+        SPSCQueue<std::unique_ptr<int>, 2> spsc;
+        EXPECT_TRUE(spsc.TryPush(std::make_unique<int>(1)));
+        EXPECT_TRUE(spsc.TryPush(std::make_unique<int>(2)));
+        auto rejected = std::make_unique<int>(3);
+        EXPECT_FALSE(spsc.TryPush(std::move(rejected)));
+        EXPECT_TRUE(rejected);
+
+        std::unique_ptr<int> item;
+        EXPECT_TRUE(spsc.TryPop(item));
+        EXPECT_EQ(*item, 1);
+        EXPECT_TRUE(spsc.TryPop(item));
+        EXPECT_EQ(*item, 2);
+        EXPECT_FALSE(spsc.TryPop(item));
+        EXPECT_TRUE(spsc.IsEmpty());
+
+        // Every pushed value comes out exactly once with producers and consumers racing
+        constexpr uint32_t kItemCount = 100'000;
+        constexpr uint32_t kThreadCount = 2;
+        auto ring = std::make_unique<MPMCQueue<uint32_t, 64>>();
+        std::atomic<uint32_t> consumed = 0;
+        std::atomic<uint64_t> sum = 0;
+
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < kThreadCount; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                for (uint32_t i = t; i < kItemCount; i += kThreadCount)
+                {
+                    while (!ring->TryPush(i))
+                        std::this_thread::yield();
+                }
+            });
+
+            threads.emplace_back([&]()
+            {
+                uint32_t value = 0;
+                while (consumed.load() < kItemCount)
+                {
+                    if (ring->TryPop(value))
+                    {
+                        sum += value;
+                        consumed++;
+                    }
+                    else
+                        std::this_thread::yield();
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        EXPECT_EQ(sum.load(), (uint64_t)kItemCount * (kItemCount - 1) / 2);
+        EXPECT_TRUE(ring->IsEmpty());
+    }
+
+    TEST_F(CoreTests, ArenaAllocatorTest)
+    {
+        ArenaAllocator arena(256);
+
+        // Grows past the chunk size instead of running out
+        uint8_t* pFirst = (uint8_t*)arena.Allocate(200);
+        uint8_t* pBig = (uint8_t*)arena.Allocate(1000);
+        ASSERT_NE(pFirst, nullptr);
+        ASSERT_NE(pBig, nullptr);
+        pBig[999] = 1;
+        EXPECT_EQ(arena.GetChunkCount(), 2u);
+        EXPECT_GE(arena.GetCapacity(), 1200u);
+
+        void* pAligned = arena.Allocate(8, 64);
+        EXPECT_EQ((uintptr_t)pAligned % 64, 0u);
+        EXPECT_EQ((uintptr_t)arena.Allocate(1) % ArenaAllocator::kArenaDefaultAlignment, 0u);
+
+        // Rewinding releases everything after the marker, the emptied chunk is reused as the spare
+        const ArenaAllocator::Marker marker = arena.GetMarker();
+        const size_t allocated = arena.GetAllocatedSize();
+        const uint32_t chunks = arena.GetChunkCount();
+        const uint64_t mallocs = SystemAllocator::GetAllocationCount();
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            ArenaScope scope(arena);
+            arena.Allocate(4096);
+            EXPECT_EQ(arena.GetChunkCount(), chunks + 1);
+        }
+        EXPECT_EQ(arena.GetAllocatedSize(), allocated);
+        EXPECT_EQ(arena.GetChunkCount(), chunks);
+        EXPECT_EQ(SystemAllocator::GetAllocationCount(), mallocs + 1);
+
+        void* pAfter = arena.Allocate(16);
+        arena.Rewind(marker);
+        EXPECT_EQ(arena.Allocate(16), pAfter);
+
+        // Reset keeps only the biggest chunk
+        arena.Reset();
+        EXPECT_EQ(arena.GetChunkCount(), 1u);
+        EXPECT_EQ(arena.GetAllocatedSize(), 0u);
+        EXPECT_GE(arena.GetCapacity(), 4096u);
+        const uint64_t resetMallocs = SystemAllocator::GetAllocationCount();
+        arena.Allocate(4096);
+        EXPECT_EQ(SystemAllocator::GetAllocationCount(), resetMallocs);
+
+        // A caller buffer is used first and never freed, a backing allocator takes over when it's full
+        alignas(16) Byte buffer[512];
+        ArenaAllocator bufferArena(buffer, sizeof(buffer), SystemAllocator::gPtr);
+        uint8_t* pInBuffer = (uint8_t*)bufferArena.Allocate(64);
+        EXPECT_TRUE(pInBuffer >= buffer && pInBuffer + 64 <= buffer + sizeof(buffer));
+        uint8_t* pOutside = (uint8_t*)bufferArena.Allocate(1024);
+        EXPECT_TRUE(pOutside < buffer || pOutside >= buffer + sizeof(buffer));
+        bufferArena.Reset();
+        EXPECT_EQ(bufferArena.GetChunkCount(), 1u);
+
+        // Stack frees pop back to the freed allocation, across chunks too
+        StackAllocator stack(128);
+        void* pBottom = stack.Allocate(32);
+        void* pTop = stack.Allocate(32);
+        stack.Free(pTop);
+        EXPECT_EQ(stack.Allocate(32), pTop);
+        stack.Allocate(512);
+        EXPECT_EQ(stack.GetChunkCount(), 2u);
+        stack.Free(pBottom);
+        EXPECT_EQ(stack.GetChunkCount(), 1u);
+        EXPECT_EQ(stack.GetAllocatedSize(), 0u);
+    }
+
+    TEST_F(CoreTests, TlsfAllocatorTest)
+    {
+        constexpr size_t kPoolSize = 1024 * 1024;
+        TlsfAllocator allocator(kPoolSize);
+
+        // Random sizes across the cached, small and large bins, freed in random order
+        std::mt19937 random(42);
+        std::vector<std::pair<uint8_t*, size_t>> live;
+        for (uint32_t i = 0; i < 20000; ++i)
+        {
+            if (live.empty() || random() % 3 != 0)
+            {
+                const size_t size = random() % 8 == 0 ? random() % 16384 : random() % 300;
+                uint8_t* ptr = (uint8_t*)allocator.Allocate(size);
+                ASSERT_NE(ptr, nullptr);
+                EXPECT_EQ((uintptr_t)ptr % kTlsfAlignment, 0u);
+                memset(ptr, (uint8_t)size, size);
+                live.emplace_back(ptr, size);
+            }
+            else
+            {
+                const size_t index = random() % live.size();
+                auto [ptr, size] = live[index];
+                for (size_t byte = 0; byte < size; byte += 61)
+                    ASSERT_EQ(ptr[byte], (uint8_t)size);
+                allocator.Free(ptr);
+                live[index] = live.back();
+                live.pop_back();
+            }
+        }
+        EXPECT_TRUE(allocator.CheckIntegrity());
+
+        for (auto [ptr, size] : live)
+            allocator.Free(ptr);
+        allocator.FlushThreadCache();
+        EXPECT_LT(allocator.GetAllocatedSize(), 8192u); // Only the thread's cache itself
+        EXPECT_TRUE(allocator.CheckIntegrity());
+
+        // Everything merged back, so a block of almost the whole pool fits without a new pool
+        const uint32_t pools = allocator.GetPoolCount();
+        void* pMost = allocator.Allocate(kPoolSize / 2);
+        EXPECT_EQ(allocator.GetPoolCount(), pools);
+        allocator.Free(pMost);
+
+        // Requests bigger than a pool get one of their own
+        uint8_t* pHuge = (uint8_t*)allocator.Allocate(kPoolSize * 3);
+        ASSERT_NE(pHuge, nullptr);
+        pHuge[kPoolSize * 3 - 1] = 1;
+        EXPECT_TRUE(allocator.Owns(pHuge));
+        EXPECT_GE(allocator.GetCapacity(), kPoolSize * 4);
+        allocator.Free(pHuge);
+
+        // Realloc keeps the contents, growing in place when the next block is free
+        uint32_t* pValues = (uint32_t*)allocator.Allocate(1024 * sizeof(uint32_t));
+        for (uint32_t i = 0; i < 1024; ++i)
+            pValues[i] = i;
+        pValues = (uint32_t*)allocator.Realloc(4096 * sizeof(uint32_t), pValues);
+        for (uint32_t i = 0; i < 1024; ++i)
+            ASSERT_EQ(pValues[i], i);
+        allocator.Free(pValues);
+        EXPECT_TRUE(allocator.CheckIntegrity());
+
+        // Blocks freed on another thread land in that thread's cache and are handed out from there
+        constexpr uint32_t kThreadCount = 4;
+        constexpr uint32_t kPerThread = 2000;
+        std::vector<void*> shared(kThreadCount * kPerThread);
+        std::vector<std::thread> threads;
+        for (uint32_t thread = 0; thread < kThreadCount; ++thread)
+        {
+            threads.emplace_back([&, thread]()
+            {
+                for (uint32_t i = 0; i < kPerThread; ++i)
+                {
+                    shared[thread * kPerThread + i] = allocator.Allocate(16 + (i % 16) * 16);
+                    memset(shared[thread * kPerThread + i], (int)thread, 16);
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        threads.clear();
+
+        std::set<void*> unique(shared.begin(), shared.end());
+        EXPECT_EQ(unique.size(), shared.size());
+
+        for (uint32_t thread = 0; thread < kThreadCount; ++thread)
+        {
+            threads.emplace_back([&, thread]()
+            {
+                // Free the next thread's blocks
+                const uint32_t other = (thread + 1) % kThreadCount;
+                for (uint32_t i = 0; i < kPerThread; ++i)
+                    allocator.Free(shared[other * kPerThread + i]);
+                allocator.FlushThreadCache();
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        EXPECT_TRUE(allocator.CheckIntegrity());
+
+        // Routed through SystemAllocator, pointers from before a switch go back where they came from
+        void* pMalloced = SystemAllocator::gPtr->Allocate(64);
+        InitSystemAllocator(SystemAllocatorBackend::Tlsf, kPoolSize);
+        void* pTlsf = SystemAllocator::gPtr->Allocate(64);
+        void* pLarge = SystemAllocator::gPtr->Allocate(kPoolSize);
+        SystemAllocator::gPtr->Free(pMalloced);
+        InitSystemAllocator(SystemAllocatorBackend::Malloc);
+        pTlsf = SystemAllocator::gPtr->Realloc(128, pTlsf);
+        SystemAllocator::gPtr->Free(pTlsf);
+        SystemAllocator::gPtr->Free(pLarge);
+    }
+
+    TEST_F(CoreTests, SlabAllocatorTest)
+    {
+        EXPECT_EQ(SlabAllocator::GetSizeClass(1), 0u);
+        EXPECT_EQ(SlabAllocator::GetSizeClass(16), 0u);
+        EXPECT_EQ(SlabAllocator::GetSizeClass(17), 1u);
+        EXPECT_EQ(SlabAllocator::GetSizeClass(64), 2u);
+        EXPECT_EQ(SlabAllocator::GetSizeClass(1024), kSlabClassCount - 1);
+        EXPECT_EQ(SlabAllocator::GetSizeClass(1025), kSlabClassCount);
+
+        SlabAllocator allocator;
+
+        // Objects are aligned to their class and keep their contents
+        std::vector<std::pair<uint8_t*, size_t>> live;
+        for (uint32_t i = 0; i < 5000; ++i)
+        {
+            const size_t size = 1 + (i * 37) % kSlabMaxSize;
+            uint8_t* ptr = (uint8_t*)allocator.Allocate(size);
+            ASSERT_NE(ptr, nullptr);
+            EXPECT_TRUE(allocator.Owns(ptr));
+            EXPECT_EQ((uintptr_t)ptr % SlabAllocator::GetClassSize(SlabAllocator::GetSizeClass(size)), 0u);
+            memset(ptr, (uint8_t)i, size);
+            live.emplace_back(ptr, size);
+        }
+        for (uint32_t i = 0; i < live.size(); ++i)
+        {
+            auto [ptr, size] = live[i];
+            ASSERT_EQ(ptr[0], (uint8_t)i);
+            ASSERT_EQ(ptr[size - 1], (uint8_t)i);
+            allocator.Free(ptr);
+        }
+
+        // Freed objects are reused before new slabs get carved
+        const size_t capacity = allocator.GetCapacity();
+        for (auto& [ptr, size] : live)
+            ptr = (uint8_t*)allocator.Allocate(size);
+        EXPECT_EQ(allocator.GetCapacity(), capacity);
+        for (auto [ptr, size] : live)
+            allocator.Free(ptr);
+
+        // Bigger requests go to the backing allocator
+        void* pLarge = allocator.Allocate(kSlabMaxSize + 1);
+        EXPECT_FALSE(allocator.Owns(pLarge));
+        allocator.Free(pLarge);
+
+        // Objects freed on another thread end up in the depot once that thread flushes
+        constexpr uint32_t kThreadCount = 4;
+        constexpr uint32_t kPerThread = 4000;
+        std::vector<void*> shared(kThreadCount * kPerThread);
+        std::vector<std::thread> threads;
+        for (uint32_t thread = 0; thread < kThreadCount; ++thread)
+        {
+            threads.emplace_back([&, thread]()
+            {
+                for (uint32_t i = 0; i < kPerThread; ++i)
+                {
+                    shared[thread * kPerThread + i] = allocator.Allocate(48);
+                    memset(shared[thread * kPerThread + i], (int)thread, 48);
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        threads.clear();
+
+        std::set<void*> unique(shared.begin(), shared.end());
+        EXPECT_EQ(unique.size(), shared.size());
+
+        const uint32_t sizeClass = SlabAllocator::GetSizeClass(48);
+        const size_t depotCount = allocator.GetDepotObjectCount(sizeClass);
+        for (uint32_t thread = 0; thread < kThreadCount; ++thread)
+        {
+            threads.emplace_back([&, thread]()
+            {
+                const uint32_t other = (thread + 1) % kThreadCount;
+                for (uint32_t i = 0; i < kPerThread; ++i)
+                    allocator.Free(shared[other * kPerThread + i]);
+                allocator.FlushThreadCache();
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        EXPECT_GE(allocator.GetDepotObjectCount(sizeClass), depotCount + shared.size());
+
+        // Usable through the typed helpers like any other IAllocator
+        struct Node
+        {
+            Node*       mpNext;
+            uint64_t    mValue;
+        };
+        Node* pNode = Alloc<Node>(&allocator, nullptr, 7ull);
+        EXPECT_TRUE(allocator.Owns(pNode));
+        EXPECT_EQ(pNode->mValue, 7u);
+        Free<Node>(pNode, &allocator);
+
+        allocator.Destroy();
+        EXPECT_EQ(allocator.GetCapacity(), 0u);
+        EXPECT_FALSE(allocator.Owns(pNode));
+    }
+
+    TEST_F(CoreTests, MemTrackerTest)
+    {
+        MemTracker tracker;
+
+        // System counters from many threads at once, the sizes have to match up on free
+        constexpr uint32_t kThreadCount = 8;
+        constexpr uint32_t kPerThread = 10000;
+        std::vector<std::thread> threads;
+        for (uint32_t thread = 0; thread < kThreadCount; ++thread)
+        {
+            threads.emplace_back([&, thread]()
+            {
+                for (uint32_t i = 0; i < kPerThread; ++i)
+                {
+                    void* ptr = (void*)(uintptr_t)(((thread * kPerThread + i) + 1) * 16);
+                    tracker.TrackSysAlloc(ptr, 32);
+                    if (i % 2)
+                        tracker.TrackSysFree(ptr, 32);
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        threads.clear();
+
+        EXPECT_EQ(tracker.GetSystemAllocatedBytes(), (int64_t)kThreadCount * kPerThread / 2 * 32);
+        EXPECT_EQ(tracker.GetSystemAllocationCount(), (int64_t)kThreadCount * kPerThread / 2);
+
+        // Tagged allocations, freed from other threads than the ones that made them
+        std::vector<std::vector<uint8_t>> buffers(kThreadCount * 64);
+        for (auto& buffer : buffers)
+            buffer.resize(8);
+
+        const std::string meshTag = "Mesh";
+        for (uint32_t thread = 0; thread < kThreadCount; ++thread)
+        {
+            threads.emplace_back([&, thread]()
+            {
+                for (uint32_t i = 0; i < 64; ++i)
+                {
+                    void* ptr = buffers[thread * 64 + i].data();
+                    if (i % 4 == 0)
+                        tracker.TrackAllocTagged(ptr, 1000, "Texture");
+                    else if (i % 4 == 1)
+                        tracker.TrackAllocTagged(ptr, 10, meshTag.c_str()); // Same name, other address
+                    else if (i % 4 == 2)
+                        tracker.TrackAllocTagged(ptr, 10, "Mesh");
+                    else
+                        tracker.TrackAlloc(ptr, 1);
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        threads.clear();
+
+        MemTracker::TagStats tags[4];
+        ASSERT_EQ(tracker.GetTopTags(tags, 4), 3u);
+        EXPECT_STREQ(tags[0].mTag, "Texture");
+        EXPECT_EQ(tags[0].mBytes, (int64_t)kThreadCount * 16 * 1000);
+        EXPECT_STREQ(tags[1].mTag, "Mesh");
+        EXPECT_EQ(tags[1].mCount, (int64_t)kThreadCount * 32);
+        EXPECT_STREQ(tags[2].mTag, "Untagged");
+        EXPECT_EQ(tracker.GetCurrentAllocatedBytes(), (int64_t)kThreadCount * (16 * 1000 + 32 * 10 + 16));
+
+        for (uint32_t thread = 0; thread < kThreadCount; ++thread)
+        {
+            threads.emplace_back([&, thread]()
+            {
+                const uint32_t other = (thread + 1) % kThreadCount;
+                for (uint32_t i = 0; i < 64; ++i)
+                    tracker.TrackFree(buffers[other * 64 + i].data());
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        tracker.TrackFree(&tracker); // Never tracked
+        EXPECT_EQ(tracker.GetCurrentAllocatedBytes(), 0);
+        ASSERT_EQ(tracker.GetTopTags(tags, 1), 1u);
+        EXPECT_EQ(tags[0].mBytes, 0);
+        EXPECT_EQ(tags[0].mTotalCount, (uint64_t)kThreadCount * 16);
+
+        // AllocTagged reports to the global tracker
+        if (MemTracker::gPtr)
+        {
+            void* ptr = AllocTagged("CoreTests", SystemAllocator::gPtr, 4096);
+            MemTracker::TagStats top;
+            ASSERT_EQ(MemTracker::gPtr->GetTopTags(&top, 1), 1u);
+            EXPECT_STREQ(top.mTag, "CoreTests");
+            Free(ptr, SystemAllocator::gPtr);
+
+            // Typed frees and tagged containers give the bytes back too
+            MemTracker::TagStats stats;
+            uint64_t* pValue = (uint64_t*)AllocTagged("CoreTests", SystemAllocator::gPtr, sizeof(uint64_t));
+            Free(pValue, SystemAllocator::gPtr);
+            ASSERT_TRUE(MemTracker::gPtr->GetTagStats("CoreTests", stats));
+            EXPECT_EQ(stats.mBytes, 0);
+
+            {
+                std::vector<uint32_t, TaggedStlAllocator<uint32_t>> values(TaggedStlAllocator<uint32_t>("CoreTests"));
+                values.resize(256);
+                ASSERT_TRUE(MemTracker::gPtr->GetTagStats("CoreTests", stats));
+                EXPECT_EQ(stats.mBytes, (int64_t)(256 * sizeof(uint32_t)));
+            }
+            ASSERT_TRUE(MemTracker::gPtr->GetTagStats("CoreTests", stats));
+            EXPECT_EQ(stats.mBytes, 0);
+        }
+    }
+
+    TEST_F(CoreTests, MemBudgetTest)
+    {
+        MemTracker tracker;
+        EXPECT_TRUE(tracker.SetBudget(kMemBudgetAssets, 1000, 2000));
+        InitMemoryBudgets(&tracker);
+        EXPECT_TRUE(tracker.SetBudget(kMemBudgetAssets, 1000, 2000));
+
+        static std::atomic<uint32_t> sSoftReports;
+        static std::atomic<uint32_t> sHardReports;
+        sSoftReports = 0;
+        sHardReports = 0;
+        tracker.SetBudgetCallback([](const MemTracker::TagStats& stats, MemTracker::BudgetLevel level)
+        {
+            EXPECT_STREQ(stats.mTag, kMemBudgetAssets);
+            (level == MemTracker::BudgetLevel::Soft ? sSoftReports : sHardReports)++;
+        });
+
+        // Reported once per crossing, not for every allocation above the limit
+        uint8_t blocks[8][1] = {};
+        for (uint32_t i = 0; i < 3; ++i)
+            tracker.TrackAllocTagged(blocks[i], 400, kMemBudgetAssets);
+        EXPECT_EQ(sSoftReports, 1u);
+        EXPECT_EQ(sHardReports, 0u);
+
+        tracker.TrackAllocTagged(blocks[3], 1000, kMemBudgetAssets);
+        tracker.TrackAllocTagged(blocks[4], 10, kMemBudgetAssets);
+        EXPECT_EQ(sSoftReports, 1u);
+        EXPECT_EQ(sHardReports, 1u);
+
+        // Dropping back under and crossing again reports again, the high-water mark stays
+        for (uint32_t i = 0; i < 5; ++i)
+            tracker.TrackFree(blocks[i]);
+        tracker.TrackAllocTagged(blocks[5], 1500, kMemBudgetAssets);
+        EXPECT_EQ(sSoftReports, 2u);
+
+        MemTracker::TagStats stats;
+        ASSERT_TRUE(tracker.GetTagStats(kMemBudgetAssets, stats));
+        EXPECT_EQ(stats.mBytes, 1500);
+        EXPECT_EQ(stats.mHighWater, 2210);
+        EXPECT_EQ(stats.mSoftExceededCount, 2u);
+        EXPECT_EQ(stats.mHardExceededCount, 1u);
+        EXPECT_FALSE(tracker.GetTagStats("NeverSeen", stats));
+
+        // Every named budget is listed, the same name from another buffer finds the same one
+        MemTracker::TagStats budgets[MemTracker::kMaxTags];
+        EXPECT_EQ(tracker.GetBudgets(budgets, MemTracker::kMaxTags), 3u);
+        const std::string renderData = kMemBudgetRenderData;
+        tracker.TrackAllocTagged(blocks[6], 64, renderData.c_str());
+        ASSERT_TRUE(tracker.GetTagStats(kMemBudgetRenderData, stats));
+        EXPECT_EQ(stats.mBytes, 64);
+        EXPECT_GT(stats.mSoftLimit, 0u);
+
+        tracker.TrackFree(blocks[5]);
+        tracker.TrackFree(blocks[6]);
+        EXPECT_EQ(tracker.GetCurrentAllocatedBytes(), 0);
+    }
+
+    TEST_F(CoreTests, FrameAllocatorTest)
+    {
+        FrameAllocator& allocator = *FrameAllocator::gPtr;
+        allocator.BeginFrame();
+
+        // Aligned bump allocations, an unpinned buffer comes back reset kFrameAllocatorLatency frames later
+        const uint32_t firstBuffer = allocator.GetBufferIndex();
+        void* pFirst = allocator.Allocate(3);
+        void* pSecond = allocator.Allocate(5);
+        EXPECT_EQ((uintptr_t)pFirst % kFrameAllocatorAlignment, 0u);
+        EXPECT_EQ((uintptr_t)pSecond % kFrameAllocatorAlignment, 0u);
+        EXPECT_EQ((uint8_t*)pSecond - (uint8_t*)pFirst, (ptrdiff_t)kFrameAllocatorAlignment);
+
+        for (uint32_t i = 0; i < kFrameAllocatorLatency; ++i)
+        {
+            allocator.BeginFrame();
+            EXPECT_EQ(allocator.GetBufferIndex() == firstBuffer, i == kFrameAllocatorLatency - 1);
+        }
+        EXPECT_EQ(allocator.Allocate(16), pFirst);
+
+        // A pinned buffer is skipped until it's released
+        const uint32_t pinned = allocator.Pin();
+        uint32_t* pPinnedData = (uint32_t*)allocator.Allocate(sizeof(uint32_t));
+        *pPinnedData = 0xC0FFEE;
+        for (uint32_t i = 0; i < kFrameAllocatorBufferCount * 2; ++i)
+        {
+            allocator.BeginFrame();
+            EXPECT_NE(allocator.GetBufferIndex(), pinned);
+            allocator.Allocate(64);
+        }
+        EXPECT_EQ(*pPinnedData, 0xC0FFEEu);
+        allocator.Unpin(pinned);
+
+        // Vectors grow in the frame buffer without touching malloc, oversized requests still work
+        allocator.BeginFrame();
+        const uint64_t mallocs = SystemAllocator::GetAllocationCount();
+        {
+            nv::Vector<uint32_t> values(FrameAllocator::gPtr);
+            for (uint32_t i = 0; i < 1000; ++i)
+                values.Push(i);
+            EXPECT_EQ(values[999], 999u);
+        }
+        EXPECT_EQ(SystemAllocator::GetAllocationCount(), mallocs);
+
+        uint8_t* pLarge = (uint8_t*)allocator.Allocate(kFrameAllocatorArenaSize * 2);
+        ASSERT_NE(pLarge, nullptr);
+        pLarge[kFrameAllocatorArenaSize * 2 - 1] = 1;
+
+        // Every thread bumps its own arena
+        constexpr size_t kCount = 4096;
+        std::vector<uint64_t*> pointers(kCount);
+        jobs::ParallelFor(0, kCount, 16, [&](size_t i)
+        {
+            pointers[i] = (uint64_t*)allocator.Allocate(sizeof(uint64_t));
+            *pointers[i] = i;
+        });
+
+        std::set<uint64_t*> unique(pointers.begin(), pointers.end());
+        EXPECT_EQ(unique.size(), kCount);
+        for (size_t i = 0; i < kCount; ++i)
+            EXPECT_EQ(*pointers[i], i);
+    }
+
+    // 2 NUMA nodes, 4 physical cores each, 2 hardware threads per core.
+    // Numbered like Linux does: cpu0-7 are the first threads, cpu8-15 their siblings.
+    static platform::CpuTopology MakeTestTopology()
+    {
+        platform::CpuTopology topology;
+        for (uint32_t smt = 0; smt < 2; ++smt)
+        {
+            for (uint32_t physical = 0; physical < 8; ++physical)
+            {
+                platform::LogicalCore core;
+                core.mId = smt * 8 + physical;
+                core.mPhysicalCore = physical;
+                core.mSmtIndex = smt;
+                core.mNumaNode = physical / 4;
+                core.mPackage = physical / 4;
+                topology.mLogicalCores.push_back(core);
+            }
+        }
+
+        topology.mPhysicalCoreCount = 8;
+        topology.mPackageCount = 2;
+        topology.mNumaNodeCount = 2;
+        return topology;
+    }
+
+    TEST_F(CoreTests, ThreadPlacementTest)
+    {
+        using namespace platform;
+        const CpuTopology topology = MakeTestTopology();
+
+        EXPECT_TRUE(GetThreadPlacement(topology, ThreadPlacement::None).empty());
+
+        // Compact: siblings next to each other, node 0 filled before node 1
+        const auto compact = GetThreadPlacement(topology, ThreadPlacement::Compact);
+        ASSERT_EQ(compact.size(), 16);
+        EXPECT_EQ(compact[0].mId, 0);
+        EXPECT_EQ(compact[1].mId, 8);
+        for (uint32_t i = 0; i < 8; ++i)
+            EXPECT_EQ(compact[i].mNumaNode, 0);
+
+        // Spread: every physical core once before any sibling, alternating nodes
+        const auto spread = GetThreadPlacement(topology, ThreadPlacement::Spread);
+        ASSERT_EQ(spread.size(), 16);
+        std::set<uint32_t> physicalCores;
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            EXPECT_EQ(spread[i].mSmtIndex, 0);
+            EXPECT_EQ(spread[i].mNumaNode, i % 2);
+            physicalCores.insert(spread[i].mPhysicalCore);
+        }
+        EXPECT_EQ(physicalCores.size(), 8);
+
+        // Reserve: physical core 0 (cpu0 and cpu8) is left to the main thread
+        const auto reserved = GetThreadPlacement(topology, ThreadPlacement::ReserveCoreZero);
+        ASSERT_EQ(reserved.size(), 14);
+        for (const auto& core : reserved)
+            EXPECT_NE(core.mPhysicalCore, 0);
+        EXPECT_EQ(reserved[0].mPhysicalCore, 1);
+        EXPECT_EQ(reserved[1].mNumaNode, 1);
+
+        // A single core machine has nothing to reserve
+        CpuTopology single;
+        single.mLogicalCores.resize(1);
+        EXPECT_EQ(GetThreadPlacement(single, ThreadPlacement::ReserveCoreZero).size(), 1);
+    }
+
+    TEST_F(CoreTests, CpuTopologyTest)
+    {
+        const auto& topology = platform::GetCpuTopology();
+        ASSERT_FALSE(topology.mLogicalCores.empty());
+        EXPECT_LE(topology.mPhysicalCoreCount, topology.mLogicalCores.size());
+        EXPECT_GE(topology.mNumaNodeCount, 1);
+
+        for (size_t i = 1; i < topology.mLogicalCores.size(); ++i)
+            EXPECT_LT(topology.mLogicalCores[i - 1].mId, topology.mLogicalCores[i].mId);
+
+#if NV_PLATFORM_LINUX
+        // Only the cores the process may run on
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        ASSERT_EQ(sched_getaffinity(0, sizeof(set), &set), 0);
+        for (const auto& core : topology.mLogicalCores)
+            EXPECT_TRUE(CPU_ISSET(core.mId, &set));
+#endif
+
+        platform::SetCurrentThreadName("NovaCoreTests");
+    }
+
+#if NV_PLATFORM_LINUX
+    TEST_F(CoreTests, SysfsTopologyTest)
+    {
+        namespace fs = std::filesystem;
+        const fs::path root = fs::temp_directory_path() / "nv_sysfs_test";
+        fs::remove_all(root);
+
+        auto write = [&](const fs::path& path, const char* pText)
+        {
+            fs::create_directories((root / path).parent_path());
+            std::ofstream(root / path) << pText << "\n";
+        };
+
+        // 2 cores with 2 threads each, cpu1 is offline, node1 owns core 1
+        write("cpu/online", "0,2-3");
+        const char* coreIds[] = { "0", "1", "0", "1" };
+        const char* siblings[] = { "0,2", "1,3", "0,2", "1,3" };
+        for (uint32_t cpu = 0; cpu < 4; ++cpu)
+        {
+            const fs::path topologyPath = fs::path("cpu") / ("cpu" + std::to_string(cpu)) / "topology";
+            write(topologyPath / "core_id", coreIds[cpu]);
+            write(topologyPath / "physical_package_id", "0");
+            write(topologyPath / "thread_siblings_list", siblings[cpu]);
+        }
+        write("node/node0/cpulist", "0,2");
+        write("node/node1/cpulist", "1,3");
+
+        const auto topology = platform::ReadSysfsTopology(root.string().c_str());
+        fs::remove_all(root);
+
+        ASSERT_EQ(topology.mLogicalCores.size(), 3);
+        EXPECT_EQ(topology.mPhysicalCoreCount, 2);
+        EXPECT_EQ(topology.mNumaNodeCount, 2);
+
+        const auto& cpu0 = topology.mLogicalCores[0];
+        const auto& cpu2 = topology.mLogicalCores[1];
+        const auto& cpu3 = topology.mLogicalCores[2];
+        EXPECT_EQ(cpu2.mId, 2);
+        EXPECT_EQ(cpu0.mPhysicalCore, cpu2.mPhysicalCore);
+        EXPECT_EQ(cpu2.mSmtIndex, 1);
+        EXPECT_EQ(cpu3.mNumaNode, 1);
+        EXPECT_NE(cpu3.mPhysicalCore, cpu0.mPhysicalCore);
+    }
+#endif
 }
\ No newline at end of file
@@ -2,9 +2,14 @@
 #include "pch.h"
 #include "TestCommon.h"
 
+#include <Engine/Archetype.h>
+#include <Engine/EntityCommandBuffer.h>
 #include <Engine/EntityComponent.h>
+#include <Engine/Query.h>
 #include <Types/Serializers.h>
 
+#include <sstream>
+
 namespace nv::tests
 {
     using namespace ecs;
@@ -31,6 +36,99 @@ namespace nv::tests
         }
     };
 
+    struct QueryValue : public IComponent
+    {
+        uint32_t mValue = 0;
+
+        template<class Archive>
+        void serialize(Archive& archive)
+        {
+        }
+    };
+
+    struct QueryOther : public IComponent
+    {
+        uint32_t mValue = 0;
+
+        template<class Archive>
+        void serialize(Archive& archive)
+        {
+        }
+    };
+
+    struct QueryHidden : public IComponent
+    {
+        template<class Archive>
+        void serialize(Archive& archive)
+        {
+        }
+    };
+
+    struct GatherMesh : public IComponent
+    {
+        uint32_t mMesh = 0;
+
+        template<class Archive>
+        void serialize(Archive& archive)
+        {
+        }
+    };
+
+    struct CommandValue : public IComponent
+    {
+        uint32_t mValue = 0;
+
+        template<class Archive>
+        void serialize(Archive& archive)
+        {
+        }
+    };
+
+    struct CommandTag : public IComponent
+    {
+        template<class Archive>
+        void serialize(Archive& archive)
+        {
+        }
+    };
+
+    struct ChangedValue : public IComponent
+    {
+        uint32_t mValue = 0;
+
+        template<class Archive>
+        void serialize(Archive& archive)
+        {
+        }
+    };
+
+    struct ChangedOther : public IComponent
+    {
+        template<class Archive>
+        void serialize(Archive& archive)
+        {
+        }
+    };
+
+    struct SparseValue : public IComponent
+    {
+        uint32_t mValue = 0;
+
+        template<class Archive>
+        void serialize(Archive& archive)
+        {
+        }
+    };
+}
+
+namespace nv::ecs
+{
+    template<>
+    constexpr ComponentStorage kComponentStorage<tests::SparseValue> = ComponentStorage::SparseSet;
+}
+
+namespace nv::tests
+{
     class AutoEntityManagerInit
     {
     public:
@@ -77,7 +175,7 @@ namespace nv::tests
         EXPECT_TRUE(entity1 != nullptr);
 
         entity1->Add<AComponent>();
-        AComponent* comp = entity1->Get<AComponent>();
+        AComponent* comp = entity1->GetMut<AComponent>();
         EXPECT_TRUE(comp != nullptr);
         comp->mSpeed = 1.f;
         comp->mMuliplier = 2.f;
@@ -120,4 +218,477 @@ namespace nv::tests
             EXPECT_NEAR(comp->mMuliplier, 2.f, FLT_EPSILON);
         }
     }
-}
\ No newline at end of file
+
+    TEST_F(EntityComponentTests, ArchetypeStorageTest)
+    {
+        INIT_ENTITYMGR;
+        constexpr uint32_t TEST_COUNT = 5000;
+        std::vector<Handle<Entity>> entities;
+
+        ArchetypeStorage storage;
+        for (uint32_t i = 0; i < TEST_COUNT; ++i)
+        {
+            auto e = entities.emplace_back(gEntityManager.Create());
+            storage.Add<AComponent>(e)->mSpeed = (float)i;
+            if (i % 2)
+                storage.Add<BComponent>(e)->mString = std::to_string(i);
+        }
+
+        EXPECT_EQ(storage.GetEntityCount(), TEST_COUNT);
+        EXPECT_EQ(storage.GetArchetypes().size(), 2);
+
+        // Migrations and removals swap rows around, every entity must still find its own data
+        for (uint32_t i = 0; i < TEST_COUNT; i += 4)
+            storage.Remove<AComponent>(entities[i]);
+        for (uint32_t i = 1; i < TEST_COUNT; i += 6)
+            storage.RemoveEntity(entities[i]);
+
+        size_t liveCount = 0;
+        for (uint32_t i = 0; i < TEST_COUNT; ++i)
+        {
+            const auto e = entities[i];
+            const bool bRemoved = i % 6 == 1;
+            const bool bHasA = !bRemoved && i % 4 != 0;
+            const bool bHasB = !bRemoved && i % 2 == 1;
+            liveCount += bHasA || bHasB;
+
+            EXPECT_EQ(storage.Has<AComponent>(e), bHasA);
+            EXPECT_EQ(storage.Has<BComponent>(e), bHasB);
+            if (bHasA)
+                EXPECT_NEAR(storage.Get<AComponent>(e)->mSpeed, (float)i, FLT_EPSILON);
+            if (bHasB)
+                EXPECT_EQ(storage.Get<BComponent>(e)->mString, std::to_string(i));
+        }
+        EXPECT_EQ(storage.GetEntityCount(), liveCount);
+
+        // Chunks stay packed and every row points back at its entity
+        size_t rowCount = 0;
+        for (const Archetype* pArchetype : storage.GetArchetypes())
+        {
+            for (uint32_t c = 0; c < pArchetype->GetChunkCount(); ++c)
+            {
+                const ArchetypeChunk& chunk = pArchetype->GetChunk(c);
+                if (c + 1 < pArchetype->GetChunkCount())
+                    EXPECT_EQ(chunk.mCount, pArchetype->GetChunkCapacity());
+
+                for (uint32_t row = 0; row < chunk.mCount; ++row)
+                    EXPECT_EQ(storage.GetMask(pArchetype->GetEntities(chunk)[row]), pArchetype->GetMask());
+                rowCount += chunk.mCount;
+            }
+        }
+        EXPECT_EQ(rowCount, liveCount);
+
+        // The pool hands the freed index straight back, with a new generation the old row doesn't match
+        gEntityManager.Remove(entities[3]);
+        auto reused = gEntityManager.Create();
+        ASSERT_EQ(reused.mIndex, entities[3].mIndex);
+        EXPECT_FALSE(storage.Has<BComponent>(reused));
+        storage.Add<AComponent>(reused)->mSpeed = -1.f;
+        EXPECT_FALSE(storage.Has<BComponent>(entities[3]));
+        EXPECT_NEAR(storage.Get<AComponent>(reused)->mSpeed, -1.f, FLT_EPSILON);
+        EXPECT_EQ(storage.GetEntityCount(), liveCount);
+    }
+
+    TEST_F(EntityComponentTests, QueryTest)
+    {
+        INIT_ENTITYMGR;
+        constexpr uint32_t TEST_COUNT = 3000;
+        std::vector<Handle<Entity>> entities;
+
+        for (uint32_t i = 0; i < TEST_COUNT; ++i)
+        {
+            auto e = entities.emplace_back(gEntityManager.Create());
+            auto entity = gEntityManager.GetEntity(e);
+            entity->Add<QueryValue>()->mValue = i;
+            if (i % 2)
+                entity->Add<QueryOther>()->mValue = i;
+            if (i % 5 == 0)
+                entity->Add<QueryHidden>();
+        }
+
+        // Swap-removes leave the pools in different orders
+        for (uint32_t i = 0; i < TEST_COUNT; i += 7)
+            gEntityManager.GetEntity(entities[i])->Remove<QueryValue>();
+        for (uint32_t i = 1; i < TEST_COUNT; i += 9)
+            gEntityManager.GetEntity(entities[i])->Remove<QueryOther>();
+
+        auto matches = [](uint32_t i) { return i % 7 != 0 && i % 2 == 1 && i % 9 != 1 && i % 5 != 0; };
+        uint32_t expectedCount = 0;
+        for (uint32_t i = 0; i < TEST_COUNT; ++i)
+            expectedCount += matches(i);
+
+        Query<QueryValue, const QueryOther, Without<QueryHidden>> query;
+        uint32_t count = 0;
+        query.ForEach([&](Handle<Entity> e, QueryValue& value, const QueryOther& other)
+        {
+            EXPECT_EQ(value.mValue, other.mValue);
+            EXPECT_TRUE(matches(value.mValue));
+            EXPECT_EQ(entities[value.mValue], e);
+            ++count;
+        });
+        EXPECT_EQ(count, expectedCount);
+
+        std::atomic<uint32_t> chunkCount = 0;
+        query.ForEachChunk([&](const auto& chunk)
+        {
+            chunk.ForEach([&](QueryValue& value, const QueryOther&)
+            {
+                value.mValue += TEST_COUNT;
+                chunkCount.fetch_add(1, std::memory_order_relaxed);
+            });
+        }, 64);
+        EXPECT_EQ(chunkCount.load(), expectedCount);
+
+        for (uint32_t i = 0; i < TEST_COUNT; ++i)
+        {
+            if (i % 7 == 0)
+                continue;
+
+            const uint32_t expected = matches(i) ? i + TEST_COUNT : i;
+            EXPECT_EQ(gEntityManager.GetEntity(entities[i])->Get<QueryValue>()->mValue, expected);
+        }
+
+        uint32_t withoutCount = 0;
+        Query<const QueryValue, Without<QueryOther>>().ForEach([&](const QueryValue& value)
+        {
+            const uint32_t i = value.mValue % TEST_COUNT;
+            EXPECT_TRUE(i % 2 == 0 || i % 9 == 1);
+            ++withoutCount;
+        });
+        EXPECT_GT(withoutCount, 0u);
+    }
+
+    TEST_F(EntityComponentTests, QueryGatherTest)
+    {
+        INIT_ENTITYMGR;
+        constexpr uint32_t TEST_COUNT = 2000;
+        constexpr uint32_t REUSE_COUNT = TEST_COUNT / 4;
+        std::vector<Handle<Entity>> entities;
+
+        auto create = [&](uint32_t mesh)
+        {
+            Transform transform;
+            transform.mPosition.x = (float)mesh;
+            auto e = entities.emplace_back(gEntityManager.Create());
+            auto entity = gEntityManager.GetEntity(e);
+            entity->AttachTransform(transform);
+            entity->Add<PrevTransform>()->mPosition.x = (float)mesh - 1;
+            entity->Add<GatherMesh>()->mMesh = mesh;
+        };
+
+        for (uint32_t i = 0; i < TEST_COUNT; ++i)
+            create(i);
+
+        // Removed entities take their components along, the pools are swap-removed
+        // independently and the freed handles are reused
+        for (uint32_t i = 0; i < TEST_COUNT; i += 3)
+            gEntityManager.Remove(entities[i]);
+        for (uint32_t i = 1; i < TEST_COUNT; i += 5)
+        {
+            if (i % 3 != 0)
+                gEntityManager.GetEntity(entities[i])->Remove<PrevTransform>();
+        }
+        for (uint32_t i = 0; i < REUSE_COUNT; ++i)
+            create(TEST_COUNT + i);
+
+        auto matches = [](uint32_t mesh) { return mesh >= TEST_COUNT || (mesh % 3 != 0 && mesh % 5 != 1); };
+        size_t expectedCount = 0;
+        for (uint32_t i = 0; i < TEST_COUNT + REUSE_COUNT; ++i)
+            expectedCount += matches(i);
+
+        EXPECT_FALSE(gComponentManager.GetPool<GatherMesh>()->Contains(entities[0]));
+        EXPECT_FALSE(gEntityManager.GetEntity(entities[1])->Has<PrevTransform>());
+
+        Query<const GatherMesh, Position, Rotation, Scale, const PrevTransform> query;
+        std::vector<uint32_t> order;
+        query.ForEach([&](const GatherMesh& mesh, Position&, Rotation&, Scale&, const PrevTransform&)
+        {
+            order.push_back(mesh.mMesh);
+        });
+        EXPECT_EQ(order.size(), expectedCount);
+
+        for (size_t chunkSize : { size_t(7), size_t(64), kQueryChunkSize })
+        {
+            std::vector<uint32_t> meshes;
+            std::vector<float> worldX;
+            std::vector<float> prevX;
+            std::vector<Handle<Entity>> owners;
+            const size_t count = query.Gather([&](size_t count)
+            {
+                meshes.resize(count);
+                worldX.resize(count);
+                prevX.resize(count);
+                owners.resize(count);
+            },
+            [&](size_t slot, Handle<Entity> e, const GatherMesh& mesh, Position& pos, Rotation& rotation, Scale& scale, const PrevTransform& prevTransform)
+            {
+                TransformRef transform = { pos.mPosition, rotation.mRotation, scale.mScale };
+                meshes[slot] = mesh.mMesh;
+                worldX[slot] = transform.GetTransformMatrix()._41;
+                prevX[slot] = prevTransform.mPosition.x;
+                owners[slot] = e;
+            }, chunkSize);
+
+            // Same slots as the serial walk, each filled from one entity
+            ASSERT_EQ(count, expectedCount);
+            EXPECT_EQ(meshes, order);
+            for (size_t slot = 0; slot < count; ++slot)
+            {
+                EXPECT_TRUE(matches(meshes[slot]));
+                EXPECT_EQ(owners[slot], entities[meshes[slot]]);
+                EXPECT_EQ(worldX[slot], (float)meshes[slot]);
+                EXPECT_EQ(prevX[slot], (float)meshes[slot] - 1);
+            }
+        }
+    }
+
+    TEST_F(EntityComponentTests, EntityCommandBufferTest)
+    {
+        INIT_ENTITYMGR;
+        constexpr uint32_t TEST_COUNT = 2000;
+        constexpr uint32_t CREATE_STRIDE = 50;
+        constexpr uint32_t CREATED_VALUE = 100000;
+        std::vector<Handle<Entity>> entities;
+
+        for (uint32_t i = 0; i < TEST_COUNT; ++i)
+        {
+            auto e = entities.emplace_back(gEntityManager.Create());
+            gEntityManager.GetEntity(e)->Add<CommandValue>()->mValue = i;
+        }
+
+        // Recorded from the workers, nothing changes until playback
+        Query<const CommandValue>().ForEachChunk([](const auto& chunk)
+        {
+            EntityCommandBuffer& commands = gEntityCommands.GetBuffer();
+            chunk.ForEach([&](Handle<Entity> entity, const CommandValue& value)
+            {
+                const uint64_t key = chunk.GetIndex();
+                switch (value.mValue % 4)
+                {
+                case 0: commands.Destroy(key, entity); break;
+                case 1: commands.Add<CommandTag>(key, entity); break;
+                case 2: commands.Set(key, entity, CommandValue{ {}, value.mValue + TEST_COUNT }); break;
+                case 3: commands.Remove<CommandValue>(key, entity); break;
+                }
+
+                if (value.mValue % CREATE_STRIDE == 0)
+                {
+                    const Handle<Entity> created = commands.Create(key);
+                    EXPECT_TRUE(EntityCommandBuffer::IsPlaceholder(created));
+                    commands.Add(key, created, CommandValue{ {}, CREATED_VALUE + value.mValue });
+                    commands.Add<CommandTag>(key, created);
+                }
+            });
+        }, 64);
+
+        EXPECT_FALSE(gEntityCommands.IsEmpty());
+        EXPECT_EQ(gComponentManager.GetPool<CommandValue>()->Size(), TEST_COUNT);
+        gEntityCommands.Playback();
+        EXPECT_TRUE(gEntityCommands.IsEmpty());
+
+        for (uint32_t i = 0; i < TEST_COUNT; ++i)
+        {
+            Entity* pEntity = gEntityManager.GetEntity(entities[i]);
+            EXPECT_EQ(pEntity == nullptr, i % 4 == 0);
+            if (!pEntity)
+                continue;
+
+            const CommandValue* pValue = gComponentManager.GetPool<CommandValue>()->Find(entities[i]);
+            EXPECT_EQ(gComponentManager.GetPool<CommandTag>()->Contains(entities[i]), i % 4 == 1);
+            EXPECT_EQ(pValue == nullptr, i % 4 == 3);
+            if (pValue)
+                EXPECT_EQ(pValue->mValue, i % 4 == 2 ? i + TEST_COUNT : i);
+        }
+
+        // Created in sort key order, whichever worker recorded them
+        std::vector<std::pair<uint32_t, Handle<Entity>>> created;
+        Query<const CommandValue, const CommandTag>().ForEach([&](Handle<Entity> entity, const CommandValue& value, const CommandTag&)
+        {
+            if (value.mValue >= CREATED_VALUE)
+                created.push_back({ value.mValue - CREATED_VALUE, entity });
+        });
+
+        ASSERT_EQ(created.size(), TEST_COUNT / CREATE_STRIDE);
+        std::sort(created.begin(), created.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (size_t i = 0; i < created.size(); ++i)
+        {
+            EXPECT_EQ(created[i].first, i * CREATE_STRIDE);
+            if (i > 0)
+                EXPECT_LT(created[i - 1].second.mIndex, created[i].second.mIndex);
+        }
+    }
+
+    TEST_F(EntityComponentTests, ChangedQueryTest)
+    {
+        INIT_ENTITYMGR;
+        constexpr uint32_t TEST_COUNT = 2000;
+        std::vector<Handle<Entity>> entities;
+
+        for (uint32_t i = 0; i < TEST_COUNT; ++i)
+        {
+            auto e = entities.emplace_back(gEntityManager.Create());
+            auto entity = gEntityManager.GetEntity(e);
+            entity->Add<ChangedValue>()->mValue = i;
+            if (i % 2 == 0)
+                entity->Add<ChangedOther>();
+        }
+
+        auto countChanged = [](uint32_t since, auto&& matches)
+        {
+            uint32_t count = 0;
+            Query<const ChangedValue, Changed<ChangedValue, ChangedOther>>(since).ForEach([&](const ChangedValue& value)
+            {
+                EXPECT_TRUE(matches(value.mValue));
+                ++count;
+            });
+            return count;
+        };
+
+        // Everything was written while being created
+        EXPECT_EQ(countChanged(0, [](uint32_t) { return true; }), TEST_COUNT);
+
+        // Reading doesn't count as a write
+        const uint32_t since = AdvanceComponentVersion();
+        Query<const ChangedValue, const ChangedOther>().ForEach([](const ChangedValue&, const ChangedOther&) {});
+        for (uint32_t i = 0; i < TEST_COUNT; ++i)
+            gEntityManager.GetEntity(entities[i])->Get<ChangedValue>();
+        EXPECT_EQ(countChanged(since, [](uint32_t) { return false; }), 0u);
+        EXPECT_LT(gComponentManager.GetPool<ChangedValue>()->GetVersion(), since);
+
+        // Mutable access does, whether or not anything is assigned
+        for (uint32_t i = 0; i < TEST_COUNT; i += 3)
+            gEntityManager.GetEntity(entities[i])->GetMut<ChangedValue>();
+        Query<ChangedValue, const ChangedOther>().ForEach([](ChangedValue&, const ChangedOther&) {});
+
+        auto written = [](uint32_t i) { return i % 3 == 0 || i % 2 == 0; };
+        uint32_t expectedCount = 0;
+        for (uint32_t i = 0; i < TEST_COUNT; ++i)
+            expectedCount += written(i);
+
+        EXPECT_EQ(countChanged(since, written), expectedCount);
+        EXPECT_EQ(gComponentManager.GetPool<ChangedValue>()->GetVersion(), since);
+        EXPECT_LT(gComponentManager.GetPool<ChangedOther>()->GetVersion(), since);
+
+        // Versions follow the components the removals move
+        for (uint32_t i = 1; i < TEST_COUNT; i += 10)
+        {
+            gEntityManager.GetEntity(entities[i])->Remove<ChangedValue>();
+            expectedCount -= written(i);
+        }
+        EXPECT_EQ(countChanged(since, [&](uint32_t i) { return written(i) && i % 10 != 1; }), expectedCount);
+
+        // A later version skips what came before it, deferred writes count too
+        const uint32_t next = AdvanceComponentVersion();
+        EXPECT_EQ(countChanged(next, [](uint32_t) { return false; }), 0u);
+
+        gEntityCommands.GetBuffer().Set(0, entities[5], ChangedValue{ {}, 5 });
+        gEntityCommands.Playback();
+        EXPECT_EQ(countChanged(next, [](uint32_t i) { return i == 5; }), 1u);
+    }
+
+    TEST_F(EntityComponentTests, FrameRecordVersionTest)
+    {
+        INIT_ENTITYMGR;
+        Entity* entity = gEntityManager.GetEntity(gEntityManager.Create());
+        ChangedValue* pKept = entity->Add<ChangedValue>();
+        IComponentPool* pool = gComponentManager.GetPool<ChangedValue>();
+
+        // Same rule as the frame recorder, a pool whose version didn't move isn't stored again
+        std::vector<std::string> frames;
+        uint32_t pushedVersion = 0;
+        const auto push = [&]()
+        {
+            std::string& frame = frames.emplace_back();
+            if (frames.size() > 1 && pool->GetVersion() == pushedVersion)
+                return;
+
+            std::ostringstream stream;
+            pool->SerializeForFrame(stream);
+            frame = stream.str();
+            pushedVersion = pool->GetVersion();
+        };
+        const auto pop = [&]()
+        {
+            for (auto frame = frames.rbegin(); frame != frames.rend(); ++frame)
+            {
+                if (!frame->empty())
+                {
+                    std::istringstream stream(*frame);
+                    pool->DeserializeForFrame(stream);
+                    break;
+                }
+            }
+            frames.pop_back();
+            return entity->Get<ChangedValue>()->mValue;
+        };
+
+        pKept->mValue = 1;
+        push();
+
+        // Writes through a kept pointer aren't seen, the frame would restore a stale value
+        AdvanceComponentVersion();
+        pKept->mValue = 2;
+        EXPECT_EQ(pool->GetVersion(), pushedVersion);
+
+        AdvanceComponentVersion();
+        entity->GetMut<ChangedValue>()->mValue = 3;
+        push();
+        EXPECT_FALSE(frames.back().empty());
+
+        AdvanceComponentVersion();
+        entity->GetMut<ChangedValue>()->mValue = 4;
+        EXPECT_EQ(pop(), 3u);
+        EXPECT_EQ(pop(), 1u);
+        EXPECT_TRUE(frames.empty());
+    }
+
+    // A frame restored after components came and went keeps the handles it was pushed with
+    template<typename TComp>
+    void CheckFrameRestoresHandles()
+    {
+        Entity* a = gEntityManager.GetEntity(gEntityManager.Create());
+        Entity* b = gEntityManager.GetEntity(gEntityManager.Create());
+        Entity* c = gEntityManager.GetEntity(gEntityManager.Create());
+        a->Add<TComp>()->mValue = 1;
+        b->Add<TComp>()->mValue = 2;
+
+        constexpr StringID compId = GetComponentID<TComp>();
+        const uint64_t handleA = gComponentManager.GetEntityComponentMap(a->mHandle).at(compId);
+        ComponentPool<TComp>* pool = gComponentManager.GetPool<TComp>();
+        const size_t size = pool->Size();
+
+        std::ostringstream out;
+        pool->SerializeForFrame(out);
+
+        // a's component is removed and b's moved into its place, c reuses the slot
+        a->Remove<TComp>();
+        c->Add<TComp>()->mValue = 3;
+        const uint64_t handleC = gComponentManager.GetEntityComponentMap(c->mHandle).at(compId);
+        b->GetMut<TComp>()->mValue = 4;
+
+        std::istringstream in(out.str());
+        pool->DeserializeForFrame(in);
+
+        EXPECT_EQ(pool->Size(), size);
+        EXPECT_EQ(b->Get<TComp>()->mValue, 2u);
+        ASSERT_TRUE(pool->IsValid(handleA));
+        EXPECT_EQ(pool->GetComponent(handleA)->template As<TComp>()->mValue, 1u);
+        ASSERT_NE(pool->Find(a->mHandle), nullptr);
+        EXPECT_EQ(pool->Find(a->mHandle)->mValue, 1u);
+        EXPECT_FALSE(pool->IsValid(handleC));
+
+        // Slots not in the frame are handed out again
+        Entity* d = gEntityManager.GetEntity(gEntityManager.Create());
+        d->Add<TComp>()->mValue = 5;
+        EXPECT_EQ(d->Get<TComp>()->mValue, 5u);
+        EXPECT_EQ(b->Get<TComp>()->mValue, 2u);
+        EXPECT_EQ(pool->Find(a->mHandle)->mValue, 1u);
+    }
+
+    TEST_F(EntityComponentTests, FrameRestoreHandlesTest)
+    {
+        INIT_ENTITYMGR;
+        CheckFrameRestoresHandles<ChangedValue>();
+        CheckFrameRestoresHandles<SparseValue>();
+    }
+}
@@ -0,0 +1,682 @@
+#include "pch.h"
+#include "TestCommon.h"
+
+#include <Engine/JobSystem.h>
+#include <Engine/Task.h>
+#include <Engine/Log.h>
+#include <Memory/Allocator.h>
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+
+namespace nv::tests
+{
+    TEST_F(JobSystemTests, ExecuteManyJobs)
+    {
+        constexpr uint32_t kJobCount = 10000;
+        std::atomic<uint32_t> counter = 0;
+
+        std::vector<Handle<jobs::Job>> handles;
+        handles.reserve(kJobCount);
+        for (uint32_t i = 0; i < kJobCount; ++i)
+        {
+            handles.push_back(jobs::Execute([&](void*) { counter++; }));
+        }
+
+        for (auto handle : handles)
+            jobs::Wait(handle);
+
+        EXPECT_EQ(counter.load(), kJobCount);
+    }
+
+    TEST_F(JobSystemTests, NestedFanOut)
+    {
+        constexpr uint32_t kParentCount = 16;
+        constexpr uint32_t kChildCount = 256;
+        std::atomic<uint32_t> counter = 0;
+
+        for (uint32_t i = 0; i < kParentCount; ++i)
+        {
+            jobs::Execute([&](void*)
+            {
+                // Children land on the worker's own deque and get stolen by idle workers
+                for (uint32_t c = 0; c < kChildCount; ++c)
+                    jobs::Execute([&](void*) { counter++; });
+            });
+        }
+
+        while (counter.load() < kParentCount * kChildCount)
+            std::this_thread::yield();
+
+        jobs::Wait();
+        EXPECT_EQ(counter.load(), kParentCount * kChildCount);
+    }
+
+    TEST_F(JobSystemTests, DependencyChain)
+    {
+        std::atomic<uint32_t> order = 0;
+        uint32_t first = 0, second = 0, third = 0;
+
+        auto a = jobs::Execute([&](void*)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            first = ++order;
+        });
+
+        Handle<jobs::Job> aDeps[] = { a };
+        auto b = jobs::Execute([&](void*) { second = ++order; }, { aDeps, 1 });
+
+        Handle<jobs::Job> bDeps[] = { b };
+        auto c = jobs::Execute([&](void*) { third = ++order; }, { bDeps, 1 });
+
+        jobs::Wait(c);
+        EXPECT_EQ(first, 1u);
+        EXPECT_EQ(second, 2u);
+        EXPECT_EQ(third, 3u);
+    }
+
+    TEST_F(JobSystemTests, DependencyAlreadyFinished)
+    {
+        auto a = jobs::Execute([](void*) {});
+        jobs::Wait(a);
+
+        std::atomic<bool> bRan = false;
+        Handle<jobs::Job> deps[] = { a, Null<jobs::Job>() };
+        auto b = jobs::Execute([&](void*) { bRan = true; }, { deps, 2 });
+        jobs::Wait(b);
+        EXPECT_TRUE(bRan.load());
+    }
+
+    TEST_F(JobSystemTests, JobGraphDiamond)
+    {
+        constexpr uint32_t kWidth = 32;
+        std::atomic<uint32_t> rootCount = 0;
+        std::atomic<uint32_t> midCount = 0;
+        uint32_t midSeenBySink = 0;
+        std::atomic<bool> bRootBeforeMid = true;
+
+        jobs::JobGraph graph;
+        auto root = graph.Add([&](void*)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            rootCount++;
+        });
+
+        std::vector<jobs::JobGraph::Node> mids;
+        for (uint32_t i = 0; i < kWidth; ++i)
+        {
+            mids.push_back(graph.Add([&](void*)
+            {
+                if (rootCount.load() != 1)
+                    bRootBeforeMid = false;
+                midCount++;
+            }, { root }));
+        }
+
+        auto sink = graph.Add([&](void*) { midSeenBySink = midCount.load(); });
+        for (auto mid : mids)
+            graph.AddDependency(sink, mid);
+
+        auto done = graph.Submit();
+        jobs::Wait(done);
+
+        EXPECT_TRUE(jobs::IsFinished(graph.GetHandle(sink)));
+        EXPECT_TRUE(bRootBeforeMid.load());
+        EXPECT_EQ(midSeenBySink, kWidth);
+
+        // Submitting hands the functions over, reuse goes through Clear
+        graph.Clear();
+        std::atomic<bool> bReused = false;
+        graph.Add([&](void*) { bReused = true; });
+        jobs::Wait(graph.Submit());
+        EXPECT_TRUE(bReused.load());
+    }
+
+    TEST_F(JobSystemTests, WideFanIn)
+    {
+        constexpr uint32_t kWidth = 100;
+        std::atomic<uint32_t> counter = 0;
+        uint32_t seenByJoin = 0;
+
+        std::vector<Handle<jobs::Job>> handles;
+        for (uint32_t i = 0; i < kWidth; ++i)
+        {
+            handles.push_back(jobs::Execute([&](void*)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                counter++;
+            }));
+        }
+
+        // More dependencies than a job holds inline, goes through join jobs
+        auto join = jobs::Execute([&](void*) { seenByJoin = counter.load(); }, { handles.data(), handles.size() });
+        jobs::Wait(join);
+        EXPECT_EQ(seenByJoin, kWidth);
+    }
+
+    TEST_F(JobSystemTests, RecycledHandleReadsFinished)
+    {
+        auto handle = jobs::Execute([](void*) {});
+        jobs::Wait(handle);
+
+        // Wrap the ring so the slot gets reused by a newer job
+        std::atomic<bool> bRelease = false;
+        std::vector<Handle<jobs::Job>> handles;
+        for (uint32_t i = 0; i < jobs::kMaxJobsInFlight; ++i)
+        {
+            handles.push_back(jobs::Execute([&](void*)
+            {
+                while (!bRelease.load())
+                    std::this_thread::yield();
+            }));
+        }
+
+        EXPECT_TRUE(jobs::IsFinished(handle));
+        EXPECT_TRUE(std::find(handles.begin(), handles.end(), handle) == handles.end());
+
+        bRelease = true;
+        jobs::Wait();
+        for (auto h : handles)
+            EXPECT_TRUE(jobs::IsFinished(h));
+    }
+
+    TEST_F(JobSystemTests, StressMillionJobs)
+    {
+        // Well past the ring size, from the main thread and from workers, with dependencies mixed in
+        constexpr uint32_t kBatchCount = 100;
+        constexpr uint32_t kBatchSize = 10000;
+        std::atomic<uint32_t> counter = 0;
+        std::atomic<uint32_t> ordered = 0;
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t batch = 0; batch < kBatchCount; ++batch)
+        {
+            if (batch % 2 == 0)
+            {
+                Handle<jobs::Job> previous;
+                for (uint32_t i = 0; i < kBatchSize; ++i)
+                {
+                    if (i % 64 == 0)
+                    {
+                        Handle<jobs::Job> deps[] = { previous };
+                        previous = jobs::Execute([&](void*) { counter++; ordered++; }, { deps, 1 });
+                    }
+                    else
+                        jobs::Execute([&](void*) { counter++; });
+                }
+            }
+            else
+            {
+                jobs::Execute([&](void*)
+                {
+                    for (uint32_t i = 1; i < kBatchSize; ++i)
+                        jobs::Execute([&](void*) { counter++; });
+                    counter++;
+                });
+            }
+        }
+
+        jobs::Wait();
+        const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        log::Info("[JobSystemTests] {} jobs in {:.3f}s ({:.0f} jobs/s)", kBatchCount * kBatchSize, seconds, (kBatchCount * kBatchSize) / seconds);
+
+        EXPECT_EQ(counter.load(), kBatchCount * kBatchSize);
+        EXPECT_EQ(ordered.load(), (kBatchCount / 2) * ((kBatchSize + 63) / 64));
+    }
+
+    TEST_F(JobSystemTests, ParallelForVisitsEachIndexOnce)
+    {
+        constexpr size_t kCount = 100'003;
+        std::vector<std::atomic<uint32_t>> visits(kCount);
+
+        jobs::ParallelFor(0, kCount, 1000, [&](size_t i) { visits[i]++; });
+        jobs::ParallelFor(3, kCount, 0, [&](size_t start, size_t end)
+        {
+            for (size_t i = start; i < end; ++i)
+                visits[i]++;
+        });
+
+        for (size_t i = 0; i < kCount; ++i)
+            EXPECT_EQ(visits[i].load(), i < 3 ? 1u : 2u);
+
+        // Empty ranges don't call anything
+        bool bCalled = false;
+        jobs::ParallelFor(10, 10, 1, [&](size_t) { bCalled = true; });
+        EXPECT_FALSE(bCalled);
+    }
+
+    TEST_F(JobSystemTests, ParallelForNested)
+    {
+        constexpr size_t kOuter = 32;
+        constexpr size_t kInner = 1000;
+        std::atomic<uint64_t> sum = 0;
+
+        jobs::ParallelFor(0, kOuter, 1, [&](size_t)
+        {
+            jobs::ParallelFor(0, kInner, 64, [&](size_t i) { sum += i; });
+        });
+
+        EXPECT_EQ(sum.load(), kOuter * (kInner * (kInner - 1) / 2));
+    }
+
+    TEST_F(JobSystemTests, ParallelReduceSum)
+    {
+        constexpr size_t kCount = 1'000'000;
+        const uint64_t sum = jobs::ParallelReduce<uint64_t>(0, kCount, 0, 0,
+            [](size_t start, size_t end)
+            {
+                uint64_t partial = 0;
+                for (size_t i = start; i < end; ++i)
+                    partial += i;
+                return partial;
+            },
+            [](uint64_t a, uint64_t b) { return a + b; });
+
+        EXPECT_EQ(sum, (uint64_t)kCount * (kCount - 1) / 2);
+
+        const uint64_t empty = jobs::ParallelReduce<uint64_t>(5, 5, 1, 7,
+            [](size_t, size_t) { return (uint64_t)1; },
+            [](uint64_t a, uint64_t b) { return a + b; });
+        EXPECT_EQ(empty, 7u);
+    }
+
+    TEST_F(JobSystemTests, WaitFromJobOnSingleWorker)
+    {
+        // The child can only run on the waiting worker itself
+        ScopedJobSystem jobSystem(1);
+        std::atomic<uint32_t> depth = 0;
+
+        auto root = jobs::Execute([&](void*)
+        {
+            auto child = jobs::Execute([&](void*)
+            {
+                auto grandChild = jobs::Execute([&](void*) { depth++; });
+                jobs::Wait(grandChild);
+                depth++;
+            });
+            jobs::Wait(child);
+            depth++;
+        });
+
+        jobs::Wait(root);
+        EXPECT_EQ(depth.load(), 3u);
+    }
+
+    static void ParallelQuickSort(int32_t* pData, size_t count)
+    {
+        constexpr size_t kSerialCutoff = 256;
+        if (count <= kSerialCutoff)
+        {
+            std::sort(pData, pData + count);
+            return;
+        }
+
+        const int32_t pivot = pData[count / 2];
+        int32_t* pMid = std::partition(pData, pData + count, [pivot](int32_t v) { return v < pivot; });
+        int32_t* pUpper = std::partition(pMid, pData + count, [pivot](int32_t v) { return v == pivot; });
+
+        const size_t lowerCount = pMid - pData;
+        auto lower = jobs::Execute([=](void*) { ParallelQuickSort(pData, lowerCount); });
+        ParallelQuickSort(pUpper, (pData + count) - pUpper);
+        jobs::Wait(lower);
+    }
+
+    TEST_F(JobSystemTests, ParallelQuickSort)
+    {
+        ScopedJobSystem jobSystem(4);
+        constexpr size_t kCount = 500'000;
+
+        std::vector<int32_t> values(kCount);
+        uint32_t state = 12345;
+        for (auto& value : values)
+        {
+            state = state * 1664525u + 1013904223u;
+            value = (int32_t)(state >> 8) % 100'000;
+        }
+
+        std::vector<int32_t> expected = values;
+        std::sort(expected.begin(), expected.end());
+
+        auto root = jobs::Execute([&](void*) { ParallelQuickSort(values.data(), values.size()); });
+        jobs::Wait(root);
+
+        EXPECT_TRUE(values == expected);
+    }
+
+    struct BvhPrimitive
+    {
+        float mCenter[3];
+        uint32_t mId;
+    };
+
+    struct BvhStats
+    {
+        std::atomic<uint32_t> mNodes = 0;
+        std::atomic<uint32_t> mLeaves = 0;
+        std::atomic<uint32_t> mLeafPrimitives = 0;
+        std::atomic<uint32_t> mMaxDepth = 0;
+    };
+
+    static void SubdivideBvh(BvhPrimitive* pPrims, size_t count, uint32_t depth, BvhStats& stats)
+    {
+        constexpr size_t kMaxLeafSize = 4;
+        stats.mNodes++;
+
+        uint32_t maxDepth = stats.mMaxDepth.load();
+        while (depth > maxDepth && !stats.mMaxDepth.compare_exchange_weak(maxDepth, depth));
+
+        if (count <= kMaxLeafSize)
+        {
+            stats.mLeaves++;
+            stats.mLeafPrimitives += (uint32_t)count;
+            return;
+        }
+
+        // Median split along the longest axis of the centroid bounds
+        float minBounds[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float maxBounds[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (uint32_t axis = 0; axis < 3; ++axis)
+            {
+                minBounds[axis] = std::min(minBounds[axis], pPrims[i].mCenter[axis]);
+                maxBounds[axis] = std::max(maxBounds[axis], pPrims[i].mCenter[axis]);
+            }
+        }
+
+        uint32_t splitAxis = 0;
+        for (uint32_t axis = 1; axis < 3; ++axis)
+        {
+            if (maxBounds[axis] - minBounds[axis] > maxBounds[splitAxis] - minBounds[splitAxis])
+                splitAxis = axis;
+        }
+
+        const size_t half = count / 2;
+        std::nth_element(pPrims, pPrims + half, pPrims + count, [splitAxis](const BvhPrimitive& a, const BvhPrimitive& b)
+        {
+            return a.mCenter[splitAxis] < b.mCenter[splitAxis];
+        });
+
+        auto left = jobs::Execute([=, &stats](void*) { SubdivideBvh(pPrims, half, depth + 1, stats); });
+        SubdivideBvh(pPrims + half, count - half, depth + 1, stats);
+        jobs::Wait(left);
+    }
+
+    TEST_F(JobSystemTests, RecursiveBvhSubdivide)
+    {
+        ScopedJobSystem jobSystem(4);
+        constexpr uint32_t kPrimitiveCount = 100'000;
+
+        std::vector<BvhPrimitive> prims(kPrimitiveCount);
+        uint32_t state = 777;
+        auto random = [&state]()
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return (state & 0xFFFF) / 65535.0f * 100.0f;
+        };
+
+        for (uint32_t i = 0; i < kPrimitiveCount; ++i)
+            prims[i] = { { random(), random(), random() }, i };
+
+        BvhStats stats;
+        auto root = jobs::Execute([&](void*) { SubdivideBvh(prims.data(), prims.size(), 0, stats); });
+        jobs::Wait(root);
+
+        // Every primitive ends up in exactly one leaf of a balanced binary tree
+        EXPECT_EQ(stats.mLeafPrimitives.load(), kPrimitiveCount);
+        EXPECT_EQ(stats.mNodes.load(), stats.mLeaves.load() * 2 - 1);
+        EXPECT_LE(stats.mMaxDepth.load(), 15u);
+
+        std::vector<bool> seen(kPrimitiveCount, false);
+        for (const auto& prim : prims)
+            seen[prim.mId] = true;
+        EXPECT_TRUE(std::find(seen.begin(), seen.end(), false) == seen.end());
+    }
+
+    TEST_F(JobSystemTests, PriorityOrder)
+    {
+        // One worker, held busy while the queues fill up
+        ScopedJobSystem jobSystem(1);
+        std::atomic<bool> bRelease = false;
+        std::atomic<bool> bBlockerRunning = false;
+        std::atomic<uint32_t> order = 0;
+        uint32_t criticalOrder = 0, backgroundOrder = 0;
+        std::vector<uint32_t> normalOrders(100);
+
+        jobs::Execute([&](void*)
+        {
+            bBlockerRunning = true;
+            while (!bRelease.load())
+                std::this_thread::yield();
+        });
+
+        while (!bBlockerRunning.load())
+            std::this_thread::yield();
+
+        auto background = jobs::Execute([&](void*) { backgroundOrder = order++; }, jobs::JobPriority::Background);
+        for (auto& normalOrder : normalOrders)
+            jobs::Execute([&](void*) { normalOrder = order++; });
+        jobs::Execute([&](void*) { criticalOrder = order++; }, jobs::JobPriority::Critical);
+
+        bRelease = true;
+        jobs::Wait(background);
+        jobs::Wait();
+
+        EXPECT_EQ(criticalOrder, 0u);
+        EXPECT_EQ(backgroundOrder, (uint32_t)normalOrders.size() + 1);
+        for (uint32_t i = 0; i < normalOrders.size(); ++i)
+            EXPECT_EQ(normalOrders[i], i + 1);
+    }
+
+    TEST_F(JobSystemTests, LongRunningKeepsWorkersFree)
+    {
+        ScopedJobSystem jobSystem(1);
+        constexpr uint32_t kLongJobCount = 3;
+        std::atomic<bool> bRelease = false;
+        std::atomic<uint32_t> runningLongJobs = 0;
+
+        std::vector<Handle<jobs::Job>> longJobs;
+        for (uint32_t i = 0; i < kLongJobCount; ++i)
+        {
+            longJobs.push_back(jobs::Execute([&](void*)
+            {
+                runningLongJobs++;
+                while (!bRelease.load())
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }, jobs::JobPriority::LongRunning));
+        }
+
+        // All of them get a thread of their own, none of them takes the only worker
+        while (runningLongJobs.load() < kLongJobCount)
+            std::this_thread::yield();
+
+        std::atomic<uint32_t> counter = 0;
+        jobs::ParallelFor(0, 1000, 10, [&](size_t) { counter++; });
+        auto frameJob = jobs::Execute([&](void*) { counter++; }, jobs::JobPriority::Critical);
+        jobs::Wait(frameJob);
+        EXPECT_EQ(counter.load(), 1001u);
+
+        for (auto handle : longJobs)
+            EXPECT_FALSE(jobs::IsFinished(handle));
+
+        // Wait() leaves them out, it would never return otherwise
+        jobs::Wait();
+        EXPECT_FALSE(jobs::IsFinished(longJobs[0]));
+
+        // Long running jobs can still be chained with normal ones
+        Handle<jobs::Job> deps[] = { longJobs[0] };
+        std::atomic<bool> bContinued = false;
+        auto continuation = jobs::Execute([&](void*) { bContinued = true; }, { deps, 1 });
+
+        bRelease = true;
+        jobs::Wait(continuation);
+        EXPECT_TRUE(bContinued.load());
+        jobs::Wait();
+    }
+
+    TEST_F(JobSystemTests, FiberWaitSuspendsJob)
+    {
+        // With one worker the child has to run while the root is waiting. With fibers
+        // that happens on another fiber stack rather than nested under the root's Wait.
+        // (An awaited job still on top of the own deque is just called inline, so queue another one after it.)
+        ScopedJobSystem jobSystem(jobs::JobSystemDesc{ .mWorkerCount = 1, .mbUseFibers = true });
+        uintptr_t rootStack = 0;
+        uintptr_t childStack = 0;
+
+        auto root = jobs::Execute([&](void*)
+        {
+            int rootLocal = 0;
+            rootStack = (uintptr_t)&rootLocal;
+
+            auto child = jobs::Execute([&](void*)
+            {
+                int childLocal = 0;
+                childStack = (uintptr_t)&childLocal;
+            });
+
+            jobs::Execute([](void*) {});
+
+            jobs::Wait(child);
+            EXPECT_TRUE(jobs::IsFinished(child));
+        });
+
+        jobs::Wait(root);
+        ASSERT_NE(childStack, 0u);
+
+        const uintptr_t distance = rootStack > childStack ? rootStack - childStack : childStack - rootStack;
+        EXPECT_GT(distance, 64u * 1024u);
+    }
+
+    static uint32_t CountTreeLeaves(uint32_t depth)
+    {
+        if (depth == 0)
+            return 1;
+
+        uint32_t left = 0;
+        uint32_t right = 0;
+        auto leftJob = jobs::Execute([&, depth](void*) { left = CountTreeLeaves(depth - 1); });
+        auto rightJob = jobs::Execute([&, depth](void*) { right = CountTreeLeaves(depth - 1); });
+        jobs::Wait(leftJob);
+        jobs::Wait(rightJob);
+        return left + right;
+    }
+
+    TEST_F(JobSystemTests, FiberDeepDependencyTree)
+    {
+        constexpr uint32_t kDepth = 12;
+
+        for (uint32_t threadCount : { 1u, 4u })
+        {
+            ScopedJobSystem jobSystem(jobs::JobSystemDesc{ .mWorkerCount = threadCount, .mbUseFibers = true });
+
+            uint32_t leaves = 0;
+            auto root = jobs::Execute([&](void*) { leaves = CountTreeLeaves(kDepth); });
+            jobs::Wait(root);
+            EXPECT_EQ(leaves, 1u << kDepth);
+
+            // Recursive fork/join and ParallelFor keep working on top of suspending waits
+            std::vector<int32_t> values(100'000);
+            for (size_t i = 0; i < values.size(); ++i)
+                values[i] = (int32_t)((i * 7919) % values.size());
+
+            auto sort = jobs::Execute([&](void*) { ParallelQuickSort(values.data(), values.size()); });
+            jobs::Wait(sort);
+            EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+
+            std::atomic<uint64_t> sum = 0;
+            jobs::ParallelFor(0, 10'000, 64, [&](size_t i) { sum += i; });
+            EXPECT_EQ(sum.load(), 10'000ull * 9'999ull / 2);
+        }
+    }
+
+    static Task<uint32_t> AddOnWorker(uint32_t a, uint32_t b)
+    {
+        co_await jobs::Schedule();
+        co_return a + b;
+    }
+
+    static Task<uint32_t> SumChain(uint32_t count)
+    {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < count; ++i)
+            sum = co_await AddOnWorker(sum, i);
+
+        co_return sum;
+    }
+
+    TEST_F(JobSystemTests, TaskChainResumesOnJobs)
+    {
+        for (uint32_t threadCount : { 1u, 4u })
+        {
+            ScopedJobSystem jobSystem(threadCount);
+            EXPECT_EQ(SyncWait(SumChain(1000)), 1000u * 999u / 2);
+
+            // Tasks are lazy, nothing runs until awaited
+            std::atomic<uint32_t> started = 0;
+            auto lazy = [&]() -> Task<> { started++; co_return; };
+            {
+                Task<> task = lazy();
+                EXPECT_EQ(started.load(), 0u);
+            }
+            EXPECT_EQ(started.load(), 0u);
+        }
+    }
+
+    TEST_F(JobSystemTests, TaskAwaitsJobAndDetaches)
+    {
+        constexpr uint32_t kTaskCount = 512;
+        std::atomic<uint32_t> counter = 0;
+        std::atomic<uint32_t> finished = 0;
+
+        auto producer = jobs::Execute([&](void*) { counter += kTaskCount; });
+        auto consumer = [&](Handle<jobs::Job> dependency) -> Task<>
+        {
+            co_await jobs::Schedule(dependency);
+            EXPECT_GE(counter.load(), kTaskCount); // Resumed after the job finished
+            co_await jobs::Schedule(jobs::JobPriority::Background);
+            finished++;
+        };
+
+        for (uint32_t i = 0; i < kTaskCount; ++i)
+            consumer(producer).Detach();
+
+        while (finished.load() < kTaskCount)
+        {
+            if (!jobs::RunPendingJob())
+                std::this_thread::yield();
+        }
+
+        jobs::Wait();
+        EXPECT_EQ(finished.load(), kTaskCount);
+    }
+
+    TEST_F(JobSystemTests, TaskFrameAllocatorHook)
+    {
+        struct CountingAllocator : IAllocator
+        {
+            void* Allocate(size_t size) override { mAllocs++; return SystemAllocator::gPtr->Allocate(size); }
+            void  Free(void* ptr) override { mFrees++; SystemAllocator::gPtr->Free(ptr); }
+
+            std::atomic<uint32_t> mAllocs = 0;
+            std::atomic<uint32_t> mFrees = 0;
+        };
+
+        CountingAllocator allocator;
+        jobs::SetTaskFrameAllocator(&allocator);
+        EXPECT_EQ(jobs::GetTaskFrameAllocator(), &allocator);
+
+        Task<uint32_t> pending = SumChain(10);
+        jobs::SetTaskFrameAllocator(nullptr); // Frames go back to where they came from
+
+        EXPECT_EQ(SyncWait(std::move(pending)), 45u);
+        EXPECT_EQ(SyncWait(SumChain(10)), 45u);
+        pending = Task<uint32_t>();
+
+        EXPECT_EQ(allocator.mAllocs.load(), 1u);
+        EXPECT_EQ(allocator.mFrees.load(), 1u);
+    }
+}
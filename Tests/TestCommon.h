@@ -3,6 +3,7 @@
 #include "pch.h"
 #include <Lib/StringHash.h>
 #include <Engine/System.h>
+#include <Engine/JobSystem.h>
 
 namespace nv::tests
 {
@@ -49,4 +50,74 @@ namespace nv::tests
             nv::DestroyContext();
         }
     };
+
+    class JobSystemTests : public ::testing::Test
+    {
+    public:
+        void SetUp() override
+        {
+        }
+
+        void TearDown() override
+        {
+        }
+
+        static void SetUpTestSuite()
+        {
+            nv::InitContext(nullptr);
+        }
+
+        static void TearDownTestSuite()
+        {
+            nv::DestroyContext();
+        }
+    };
+
+    // Benchmarks are disabled by default, run them with:
+    // Tests.exe --gtest_also_run_disabled_tests --gtest_filter=Benchmarks.*
+    class Benchmarks : public ::testing::Test
+    {
+    public:
+        void SetUp() override
+        {
+        }
+
+        void TearDown() override
+        {
+        }
+
+        static void SetUpTestSuite()
+        {
+            nv::InitContext(nullptr);
+        }
+
+        static void TearDownTestSuite()
+        {
+            nv::DestroyContext();
+        }
+    };
+
+    // Swaps the global job system for one with the given worker count
+    // and restores the default one when the test is done.
+    class ScopedJobSystem
+    {
+    public:
+        ScopedJobSystem(uint32_t threadCount)
+        {
+            jobs::DestroyJobSystem();
+            jobs::InitJobSystem(threadCount);
+        }
+
+        ScopedJobSystem(const jobs::JobSystemDesc& desc)
+        {
+            jobs::DestroyJobSystem();
+            jobs::InitJobSystem(desc);
+        }
+
+        ~ScopedJobSystem()
+        {
+            jobs::DestroyJobSystem();
+            jobs::InitJobSystem(NV_JOB_WORKER_THREAD_COUNT);
+        }
+    };
 }
\ No newline at end of file